@@ -0,0 +1,159 @@
+// bench_main.cpp
+// GPIO dispatch benchmarks for lib/esperto on SimulatedGpioBackend (ESP-IDF linux target)
+// Author: ESPerto Contributors
+// License: MIT
+//
+// Edges are injected on the simulator's virtual clock; the cost reported is the host time
+// spent in the dispatch path, so a slower hot path shows up as a regression here before
+// anyone gets a scope on a board. Lines starting with "BENCH" are meant to be diffed
+// between commits.
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+}
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gpio.hpp"
+#include "simulated_gpio_backend.hpp"
+#include "task.hpp"
+
+using namespace esperto;
+
+static constexpr int Warmups = 2;
+static constexpr int Repetitions = 15;
+static constexpr UBaseType_t BenchPriority = 10;
+static constexpr int Batch = 1000;
+static constexpr esperto::uint64 EdgeSpacingNs = 10000;
+
+struct Result {
+    const char* name;
+    double medianNs;
+    double p90Ns;
+    double minNs;
+};
+
+// body() runs one batch of `operations` and returns its cost in nanoseconds
+template <typename Body>
+static Result measure(const char* name, int operations, Body body) {
+    for (int i = 0; i < Warmups; ++i) {
+        body();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(Repetitions);
+    for (int i = 0; i < Repetitions; ++i) {
+        samples.push_back(static_cast<double>(body()) / operations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.medianNs = samples[samples.size() / 2];
+    result.p90Ns = samples[(samples.size() * 9) / 10];
+    result.minNs = samples.front();
+    printf("%-28s %12.0f %12.0f %12.0f\n", result.name, result.medianNs, result.p90Ns, result.minNs);
+    return result;
+}
+
+// Immediate mode: the handler runs the callback in "interrupt" context
+static Result benchImmediate(SimulatedGpioBackend& simulator, Gpio& input) {
+    static std::atomic<int> calls{0};
+    input.enableInterrupt(GPIO_INTR_ANYEDGE, [](Gpio&) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+    });
+    Result result = measure("immediate dispatch", Batch, [&simulator]() {
+        simulator.resetStatistics();
+        simulator.injectSquareWave(GPIO_NUM_4, simulator.now() + EdgeSpacingNs, EdgeSpacingNs, Batch);
+        simulator.runAll();
+        return static_cast<double>(simulator.getStatistics().dispatchTotalNs);
+    });
+    input.disableInterrupt();
+    return result;
+}
+
+// Deferred mode: ISR-side cost (capture and ring push), then edge to callback on the dispatcher task
+static void benchDeferred(SimulatedGpioBackend& simulator, Gpio& input, std::vector<Result>& results) {
+    static std::atomic<int> calls{0};
+    input.enableDeferredInterrupt(GPIO_INTR_ANYEDGE, [](Gpio&, const GpioEvent&) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    results.push_back(measure("deferred ISR push", Batch, [&simulator]() {
+        int target = calls.load() + Batch;
+        simulator.resetStatistics();
+        simulator.injectSquareWave(GPIO_NUM_4, simulator.now() + EdgeSpacingNs, EdgeSpacingNs, Batch);
+        simulator.runAll();
+        while (calls.load() < target) {
+            Task::delayTicks(1);
+        }
+        return static_cast<double>(simulator.getStatistics().dispatchTotalNs);
+    }));
+
+    results.push_back(measure("deferred edge to callback", Batch, [&simulator]() {
+        int target = calls.load() + Batch;
+        simulator.injectSquareWave(GPIO_NUM_4, simulator.now() + EdgeSpacingNs, EdgeSpacingNs, Batch);
+        esperto::int64 start = esp_timer_get_time();
+        simulator.runAll();
+        while (calls.load() < target) {
+            Task::yield();
+        }
+        return static_cast<double>(esp_timer_get_time() - start) * 1000.0;
+    }));
+
+    input.disableInterrupt();
+}
+
+// Edges closer than the interrupt latency merge into one interrupt, as on the chip
+static void benchBurst(SimulatedGpioBackend& simulator, Gpio& input) {
+    input.enableInterrupt(GPIO_INTR_ANYEDGE, [](Gpio&) {});
+    simulator.resetStatistics();
+    simulator.injectSquareWave(GPIO_NUM_4, simulator.now() + EdgeSpacingNs, 500, Batch);
+    simulator.runAll();
+    input.disableInterrupt();
+
+    SimulatedGpioBackend::Statistics stats = simulator.getStatistics();
+    printf("BENCH burst (500 ns spacing) edges=%llu interrupts=%llu dropped=%llu\n",
+           static_cast<unsigned long long>(stats.edges), static_cast<unsigned long long>(stats.interrupts),
+           static_cast<unsigned long long>(stats.droppedEdges));
+}
+
+extern "C" void app_main(void)
+{
+    vTaskPrioritySet(nullptr, BenchPriority);
+
+    static SimulatedGpioBackend simulator;
+    GpioBackend::use(simulator);
+
+    // Below the benchmark task: the ring fills during runAll() and drains afterwards
+    GpioDispatcher::Config dispatcherConfig;
+    dispatcherConfig.priority = BenchPriority - 1;
+    GpioDispatcher::instance().configure(dispatcherConfig);
+
+    Gpio input(GPIO_NUM_4);
+    input.setDirection(GPIO_MODE_INPUT);
+
+    printf("esperto gpio benchmarks: %d repetitions of %d edges, %d ns interrupt latency (virtual)\n",
+           Repetitions, Batch, static_cast<int>(SimulatedGpioBackend::Config().interruptLatencyNs));
+    printf("%-28s %12s %12s %12s\n", "benchmark (ns/edge)", "median", "p90", "min");
+
+    std::vector<Result> results;
+    results.push_back(benchImmediate(simulator, input));
+    benchDeferred(simulator, input, results);
+
+    printf("\n");
+    for (const Result& result : results) {
+        printf("BENCH %s median_ns=%.0f p90_ns=%.0f min_ns=%.0f\n", result.name, result.medianNs, result.p90Ns, result.minNs);
+    }
+    benchBurst(simulator, input);
+
+    GpioDispatcher::Statistics dispatcher = GpioDispatcher::instance().getStatistics();
+    printf("BENCH dispatcher dropped=%lu high_water=%lu\n", static_cast<unsigned long>(dispatcher.dropped),
+           static_cast<unsigned long>(dispatcher.highWater));
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,138 @@
+// bench_main.cpp
+// MQTT publishing benchmarks for lib/esperto against a local broker (ESP-IDF linux target)
+// Author: ESPerto Contributors
+// License: MIT
+//
+// Publishes CONFIG_BENCH_MQTT_MESSAGES small messages to a broker on the host (for example
+// `mosquitto -p 1883`) and reports messages per second, measured until flush() sees every
+// message written (QoS0) or acknowledged (QoS1). `per_write` is the batching factor: messages
+// per TCP write. The spool benchmark fills the spool while the broker port is unreachable,
+// then measures how fast a second client drains it. Lines starting with "BENCH" are meant to
+// be diffed between commits.
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+}
+#include <cstdio>
+#include <cstdlib>
+#include "mqtt_client.hpp"
+#include "task.hpp"
+
+using namespace esperto;
+
+static constexpr size_t MessageSize = 32;
+static constexpr esperto::uint32 Messages = CONFIG_BENCH_MQTT_MESSAGES;
+static const char* Topic = "esperto/bench";
+static const char* SpoolPath = "/tmp/esperto_mqtt_bench.spool";
+
+static esperto::uint8 s_payload[MessageSize];
+
+static MqttClient::Config baseConfig() {
+    MqttClient::Config config;
+    config.host = CONFIG_BENCH_MQTT_HOST;
+    config.port = CONFIG_BENCH_MQTT_PORT;
+    config.clientId = "esperto-bench";
+    config.queueLength = 256;
+    config.pollMs = 1;
+    return config;
+}
+
+static bool waitConnected(MqttClient& client) {
+    for (int i = 0; i < 500 && !client.isConnected(); ++i) {
+        Task::delay(10);
+    }
+    return client.isConnected();
+}
+
+static void report(const char* name, esperto::uint32 messages, esperto::int64 elapsedUs,
+                   const MqttClient::Statistics& stats) {
+    double rate = elapsedUs > 0 ? static_cast<double>(messages) * 1e6 / static_cast<double>(elapsedUs) : 0.0;
+    double perWrite = stats.writes > 0 ? static_cast<double>(stats.published) / static_cast<double>(stats.writes) : 0.0;
+    printf("BENCH %s msgs_per_s=%.0f per_write=%.1f retransmits=%u dropped=%u ms=%lld\n", name, rate, perWrite,
+           static_cast<unsigned>(stats.retransmits), static_cast<unsigned>(stats.dropped),
+           static_cast<long long>(elapsedUs / 1000));
+}
+
+static void benchPublish(const char* name, MqttClient::QoS qos, esperto::uint32 batchBytes,
+                         esperto::uint32 maxInFlight) {
+    MqttClient::Config config = baseConfig();
+    config.batchBytes = batchBytes;
+    config.maxInFlight = maxInFlight;
+    MqttClient client(config);
+    if (!client.start() || !waitConnected(client)) {
+        printf("%s: no connection to %s:%d\n", name, CONFIG_BENCH_MQTT_HOST, CONFIG_BENCH_MQTT_PORT);
+        return;
+    }
+
+    esperto::int64 start = esp_timer_get_time();
+    for (esperto::uint32 i = 0; i < Messages; ++i) {
+        client.publish(Topic, s_payload, sizeof(s_payload), qos, false, InfiniteTimeout);
+    }
+    bool flushed = client.flush(60000);
+    esperto::int64 elapsed = esp_timer_get_time() - start;
+    report(name, Messages, elapsed, client.getStatistics());
+    if (!flushed) {
+        printf("%s: flush timed out\n", name);
+    }
+    client.stop();
+}
+
+static void benchSpoolDrain() {
+    remove(SpoolPath);
+
+    // Port 1 refuses connections, so everything published goes to the spool
+    MqttClient::Config offlineConfig = baseConfig();
+    offlineConfig.port = 1;
+    offlineConfig.reconnectMinMs = 60000;
+    offlineConfig.spoolPath = SpoolPath;
+    offlineConfig.spoolMaxBytes = Messages * (MessageSize + 32);
+    MqttClient offline(offlineConfig);
+    offline.start();
+    for (esperto::uint32 i = 0; i < Messages; ++i) {
+        offline.publish(Topic, s_payload, sizeof(s_payload), MqttClient::QoS::AtLeastOnce, false, InfiniteTimeout);
+    }
+    // Wait for the client task to move the queue into the spool
+    while (offline.getStatistics().spooled + offline.getStatistics().dropped < Messages) {
+        Task::delay(10);
+    }
+    offline.stop();
+
+    MqttClient::Config config = baseConfig();
+    config.spoolPath = SpoolPath;
+    config.spoolMaxBytes = offlineConfig.spoolMaxBytes;
+    MqttClient client(config);
+    esperto::int64 start = esp_timer_get_time();
+    client.start();
+    bool flushed = client.flush(60000);
+    esperto::int64 elapsed = esp_timer_get_time() - start;
+    report("spool_drain_qos1", static_cast<esperto::uint32>(client.getStatistics().unspooled), elapsed,
+           client.getStatistics());
+    if (!flushed) {
+        printf("spool_drain_qos1: flush timed out\n");
+    }
+    client.stop();
+    remove(SpoolPath);
+}
+
+extern "C" void app_main(void)
+{
+    for (size_t i = 0; i < sizeof(s_payload); ++i) {
+        s_payload[i] = static_cast<esperto::uint8>('a' + i % 26);
+    }
+
+    printf("esperto mqtt benchmarks: %u messages of %u bytes per run, broker %s:%d\n",
+           static_cast<unsigned>(Messages), static_cast<unsigned>(MessageSize), CONFIG_BENCH_MQTT_HOST,
+           CONFIG_BENCH_MQTT_PORT);
+
+    // A batch limit of one byte sends every message in its own write
+    benchPublish("qos0_unbatched", MqttClient::QoS::AtMostOnce, 1, 16);
+    benchPublish("qos0_batched", MqttClient::QoS::AtMostOnce, 1460, 16);
+    benchPublish("qos1_window1", MqttClient::QoS::AtLeastOnce, 1460, 1);
+    benchPublish("qos1_window16", MqttClient::QoS::AtLeastOnce, 1460, 16);
+    benchPublish("qos1_window64", MqttClient::QoS::AtLeastOnce, 1460, 64);
+    benchSpoolDrain();
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,221 @@
+// bench_main.cpp
+// Socket throughput benchmarks for lib/esperto (ESP32 over WiFi)
+// Author: ESPerto Contributors
+// License: MIT
+//
+// Moves CONFIG_BENCH_TRANSFER_KB of data to and from scripts/bench/net_sink.py once through
+// BSD sockets and once through UdpSocket / TcpConnection, and reports the throughput of
+// each. Received data is checksummed on both paths so the zero-copy side is charged for
+// reading it. Lines starting with "BENCH" are meant to be diffed between commits.
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+}
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include "task.hpp"
+#include "tcp_connection.hpp"
+#include "udp_socket.hpp"
+#include "wifi.hpp"
+
+using namespace esperto;
+
+static constexpr size_t DatagramSize = 1400;
+static constexpr size_t StreamChunk = 5840;
+static constexpr size_t TransferBytes = static_cast<size_t>(CONFIG_BENCH_TRANSFER_KB) * 1024;
+
+// Sent by every transmit benchmark; never written after start-up
+static esperto::uint8 s_payload[StreamChunk];
+static esperto::uint8 s_receiveBuffer[StreamChunk];
+
+static void report(const char* name, size_t bytes, esperto::int64 elapsedUs) {
+    double mbps = elapsedUs > 0 ? static_cast<double>(bytes) * 8.0 / static_cast<double>(elapsedUs) : 0.0;
+    printf("BENCH %s mbps=%.2f bytes=%u ms=%lld\n", name, mbps, static_cast<unsigned>(bytes),
+           static_cast<long long>(elapsedUs / 1000));
+}
+
+static esperto::uint32 checksum(const esperto::uint8* data, size_t length, esperto::uint32 sum) {
+    for (size_t i = 0; i < length; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static sockaddr_in sinkAddress(esperto::uint16 port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    inet_pton(AF_INET, CONFIG_BENCH_SINK_ADDRESS, &address.sin_addr);
+    return address;
+}
+
+static void benchUdpSocket() {
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    sockaddr_in address = sinkAddress(CONFIG_BENCH_SINK_PORT);
+    size_t sent = 0;
+    esperto::int64 start = esp_timer_get_time();
+    while (sent < TransferBytes) {
+        if (sendto(fd, s_payload, DatagramSize, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            // Out of pbufs: let the driver drain
+            Task::delayTicks(1);
+            continue;
+        }
+        sent += DatagramSize;
+    }
+    report("udp_tx_bsd", sent, esp_timer_get_time() - start);
+    ::close(fd);
+}
+
+static void benchUdpZeroCopy(const NetEndpoint& sink) {
+    UdpSocket socket;
+    if (!socket.connect(sink)) {
+        printf("udp_tx_pbuf: cannot open the socket\n");
+        return;
+    }
+    NetPayload payload = NetPayload::wrap(s_payload, DatagramSize);
+    size_t sent = 0;
+    esperto::int64 start = esp_timer_get_time();
+    while (sent < TransferBytes) {
+        if (!socket.send(payload)) {
+            Task::delayTicks(1);
+            continue;
+        }
+        sent += DatagramSize;
+    }
+    report("udp_tx_pbuf", sent, esp_timer_get_time() - start);
+}
+
+static void benchTcpSendSocket() {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    sockaddr_in address = sinkAddress(CONFIG_BENCH_SINK_PORT);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        printf("tcp_tx_bsd: connect failed (errno %d)\n", errno);
+        ::close(fd);
+        return;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    size_t sent = 0;
+    esperto::int64 start = esp_timer_get_time();
+    while (sent < TransferBytes) {
+        ssize_t written = ::send(fd, s_payload, StreamChunk, 0);
+        if (written <= 0) {
+            printf("tcp_tx_bsd: send failed (errno %d)\n", errno);
+            break;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    report("tcp_tx_bsd", sent, esp_timer_get_time() - start);
+    ::close(fd);
+}
+
+static void benchTcpSendZeroCopy(const NetEndpoint& sink) {
+    TcpConnection connection;
+    if (!connection.connect(sink)) {
+        printf("tcp_tx_pbuf: connect failed\n");
+        return;
+    }
+    NetPayload payload = NetPayload::wrap(s_payload, StreamChunk);
+    size_t sent = 0;
+    esperto::int64 start = esp_timer_get_time();
+    while (sent < TransferBytes) {
+        if (!connection.send(payload)) {
+            printf("tcp_tx_pbuf: send failed\n");
+            break;
+        }
+        sent += StreamChunk;
+    }
+    report("tcp_tx_pbuf", sent, esp_timer_get_time() - start);
+    connection.close();
+}
+
+static void benchTcpReceiveSocket() {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    sockaddr_in address = sinkAddress(CONFIG_BENCH_SINK_PORT + 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        printf("tcp_rx_bsd: connect failed (errno %d)\n", errno);
+        ::close(fd);
+        return;
+    }
+
+    size_t received = 0;
+    esperto::uint32 sum = 0;
+    esperto::int64 start = esp_timer_get_time();
+    while (received < TransferBytes) {
+        ssize_t length = ::recv(fd, s_receiveBuffer, sizeof(s_receiveBuffer), 0);
+        if (length <= 0) {
+            break;
+        }
+        sum = checksum(s_receiveBuffer, static_cast<size_t>(length), sum);
+        received += static_cast<size_t>(length);
+    }
+    report("tcp_rx_bsd", received, esp_timer_get_time() - start);
+    ::close(fd);
+    printf("tcp_rx_bsd checksum %08lx\n", static_cast<unsigned long>(sum));
+}
+
+static void benchTcpReceiveZeroCopy(const NetEndpoint& source) {
+    TcpConnection connection;
+    if (!connection.connect(source)) {
+        printf("tcp_rx_pbuf: connect failed\n");
+        return;
+    }
+
+    size_t received = 0;
+    esperto::uint32 sum = 0;
+    esperto::int64 start = esp_timer_get_time();
+    NetBuffer buffer;
+    while (received < TransferBytes && connection.receive(buffer)) {
+        buffer.forEachSegment([&sum](const NetSegment& segment) {
+            sum = checksum(segment.data, segment.length, sum);
+        });
+        received += buffer.size();
+        buffer.release();
+    }
+    report("tcp_rx_pbuf", received, esp_timer_get_time() - start);
+    connection.close();
+    printf("tcp_rx_pbuf checksum %08lx\n", static_cast<unsigned long>(sum));
+}
+
+extern "C" void app_main(void)
+{
+    for (size_t i = 0; i < sizeof(s_payload); ++i) {
+        s_payload[i] = static_cast<esperto::uint8>(i);
+    }
+
+    static WiFi wifi;
+    wifi.setPowerProfile(WiFi::PowerProfile::LowLatency);
+    wifi.beginStation(CONFIG_BENCH_WIFI_SSID, CONFIG_BENCH_WIFI_PASSWORD);
+    for (int i = 0; i < 300 && !wifi.isConnected(); ++i) {
+        Task::delay(100);
+    }
+    if (!wifi.isConnected()) {
+        printf("esperto net benchmarks: no WiFi connection to %s\n", CONFIG_BENCH_WIFI_SSID);
+        return;
+    }
+
+    NetEndpoint sink;
+    NetEndpoint source;
+    if (!NetEndpoint::parse(CONFIG_BENCH_SINK_ADDRESS, CONFIG_BENCH_SINK_PORT, sink) ||
+        !NetEndpoint::parse(CONFIG_BENCH_SINK_ADDRESS, CONFIG_BENCH_SINK_PORT + 1, source)) {
+        printf("esperto net benchmarks: invalid sink address %s\n", CONFIG_BENCH_SINK_ADDRESS);
+        return;
+    }
+
+    printf("esperto net benchmarks: %u KiB per run, sink %s:%d, RSSI %ld dBm\n",
+           static_cast<unsigned>(CONFIG_BENCH_TRANSFER_KB), CONFIG_BENCH_SINK_ADDRESS, CONFIG_BENCH_SINK_PORT,
+           static_cast<long>(wifi.getRSSI()));
+
+    benchUdpSocket();
+    benchUdpZeroCopy(sink);
+    benchTcpSendSocket();
+    benchTcpSendZeroCopy(sink);
+    benchTcpReceiveSocket();
+    benchTcpReceiveZeroCopy(source);
+    fflush(stdout);
+}
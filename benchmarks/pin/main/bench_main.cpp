@@ -0,0 +1,142 @@
+// bench_main.cpp
+// Pin access benchmarks for lib/esperto on an ESP32
+// Author: ESPerto Contributors
+// License: MIT
+//
+// Times the same pin operations through StaticGpio (constant register addresses, inlined),
+// Gpio (backend vtable) and the IDF driver calls, in CPU cycles per operation, and the
+// latency from a StaticGpio::set() to the first instruction of a handler attached with
+// StaticGpio::enableInterrupt, using the pin's own input as loopback. Lines starting with
+// "BENCH" are meant to be diffed between commits.
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+}
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gpio.hpp"
+#include "static_gpio.hpp"
+
+using namespace esperto;
+
+using BenchPin = StaticGpio<static_cast<gpio_num_t>(CONFIG_BENCH_PIN_GPIO)>;
+
+static constexpr int Warmups = 2;
+static constexpr int Repetitions = 15;
+static constexpr int Operations = CONFIG_BENCH_PIN_OPERATIONS;
+static constexpr int LatencySamples = 1000;
+
+static DRAM_ATTR std::atomic<esperto::uint32> s_isrCycles{0};
+
+// body() runs `Operations` pin operations; the result is the median cost of one, in cycles
+template <typename Body>
+static void measure(const char* name, Body body) {
+    for (int i = 0; i < Warmups; ++i) {
+        body();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(Repetitions);
+    for (int i = 0; i < Repetitions; ++i) {
+        esperto::uint32 start = esp_cpu_get_cycle_count();
+        body();
+        esperto::uint32 cycles = esp_cpu_get_cycle_count() - start;
+        samples.push_back(static_cast<double>(cycles) / Operations);
+    }
+    std::sort(samples.begin(), samples.end());
+    printf("BENCH %s median_cycles=%.1f min_cycles=%.1f\n", name, samples[samples.size() / 2], samples.front());
+}
+
+static void IRAM_ATTR onEdge(void*) {
+    s_isrCycles.store(esp_cpu_get_cycle_count(), std::memory_order_relaxed);
+}
+
+static void benchInterruptLatency() {
+    // Input and output at once: the pin sees its own rising edge
+    gpio_set_direction(BenchPin::pin, GPIO_MODE_INPUT_OUTPUT);
+    BenchPin::clear();
+    if (!BenchPin::enableInterrupt(GPIO_INTR_POSEDGE, onEdge)) {
+        printf("isr_latency: cannot attach the handler\n");
+        return;
+    }
+
+    std::vector<esperto::uint32> samples;
+    samples.reserve(LatencySamples);
+    for (int i = 0; i < LatencySamples; ++i) {
+        s_isrCycles.store(0, std::memory_order_relaxed);
+        esperto::uint32 start = esp_cpu_get_cycle_count();
+        BenchPin::set();
+        while (s_isrCycles.load(std::memory_order_relaxed) == 0) {
+        }
+        samples.push_back(s_isrCycles.load(std::memory_order_relaxed) - start);
+        BenchPin::clear();
+    }
+    BenchPin::disableInterrupt();
+
+    std::sort(samples.begin(), samples.end());
+    printf("BENCH isr_latency median_cycles=%u p90_cycles=%u min_cycles=%u\n",
+           static_cast<unsigned>(samples[samples.size() / 2]),
+           static_cast<unsigned>(samples[(samples.size() * 9) / 10]), static_cast<unsigned>(samples.front()));
+}
+
+extern "C" void app_main(void)
+{
+    printf("esperto pin benchmarks: GPIO%d, %d repetitions of %d operations\n", CONFIG_BENCH_PIN_GPIO,
+           Repetitions, Operations);
+    if (!BenchPin::setOutput()) {
+        printf("GPIO%d cannot be configured as an output\n", CONFIG_BENCH_PIN_GPIO);
+        return;
+    }
+
+    // Two operations per iteration: the pin always ends low
+    measure("static_set_clear", []() {
+        for (int i = 0; i < Operations / 2; ++i) {
+            BenchPin::set();
+            BenchPin::clear();
+        }
+    });
+    measure("static_toggle", []() {
+        for (int i = 0; i < Operations; ++i) {
+            BenchPin::toggle();
+        }
+    });
+    measure("driver_set_level", []() {
+        for (int i = 0; i < Operations / 2; ++i) {
+            gpio_set_level(BenchPin::pin, 1);
+            gpio_set_level(BenchPin::pin, 0);
+        }
+    });
+
+    Gpio gpio(BenchPin::pin);
+    measure("gpio_set_level", [&gpio]() {
+        for (int i = 0; i < Operations / 2; ++i) {
+            gpio.setLevel(1);
+            gpio.setLevel(0);
+        }
+    });
+
+    gpio_set_direction(BenchPin::pin, GPIO_MODE_INPUT_OUTPUT);
+    measure("static_read", []() {
+        volatile esperto::uint32 level = 0;
+        for (int i = 0; i < Operations; ++i) {
+            level = BenchPin::read();
+        }
+        (void)level;
+    });
+    measure("driver_get_level", []() {
+        volatile int level = 0;
+        for (int i = 0; i < Operations; ++i) {
+            level = gpio_get_level(BenchPin::pin);
+        }
+        (void)level;
+    });
+
+    benchInterruptLatency();
+    fflush(stdout);
+}
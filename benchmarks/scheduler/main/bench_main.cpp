@@ -0,0 +1,230 @@
+// bench_main.cpp
+// Scheduler micro-benchmarks for lib/esperto (ESP-IDF linux target)
+// Author: ESPerto Contributors
+// License: MIT
+//
+// Every benchmark runs a fixed batch of operations per repetition and reports the
+// median, 90th percentile and minimum cost per operation over all repetitions.
+// Lines starting with "BENCH" are meant to be diffed between commits.
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+}
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "task_scheduler.hpp"
+
+using namespace esperto;
+
+static constexpr int Warmups = 2;
+static constexpr int Repetitions = 15;
+static constexpr UBaseType_t BenchPriority = 10;
+
+struct Result {
+    const char* name;
+    double medianNs;
+    double p90Ns;
+    double minNs;
+};
+
+// body() runs one batch of `operations` and returns its duration in microseconds
+template <typename Body>
+static Result measure(const char* name, int operations, Body body) {
+    for (int i = 0; i < Warmups; ++i) {
+        body();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(Repetitions);
+    for (int i = 0; i < Repetitions; ++i) {
+        samples.push_back(static_cast<double>(body()) * 1000.0 / operations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.medianNs = samples[samples.size() / 2];
+    result.p90Ns = samples[(samples.size() * 9) / 10];
+    result.minNs = samples.front();
+    printf("%-28s %12.0f %12.0f %12.0f\n", result.name, result.medianNs, result.p90Ns, result.minNs);
+    return result;
+}
+
+// startNew cost: the spawned tasks have a lower priority and only run once the batch is timed
+static Result benchSpawn(TaskScheduler& scheduler) {
+    constexpr int Batch = 50;
+    return measure("spawn (startNew)", Batch, [&scheduler]() {
+        std::vector<std::shared_ptr<Task>> tasks;
+        tasks.reserve(Batch);
+        esperto::int64 start = esp_timer_get_time();
+        for (int i = 0; i < Batch; ++i) {
+            tasks.push_back(scheduler.startNew([](Task&) {}, "Spawn", 2048, BenchPriority - 1));
+        }
+        esperto::int64 elapsed = esp_timer_get_time() - start;
+        for (auto& task : tasks) {
+            task->wait();
+        }
+        scheduler.cleanupCompletedTasks();
+        return elapsed;
+    });
+}
+
+// wait() latency: from the last instruction of the joined task to the joiner running again
+static Result benchJoin(TaskScheduler& scheduler) {
+    constexpr int Batch = 20;
+    static std::atomic<esperto::int64> finishedAt{0};
+    return measure("join latency (wait)", Batch, [&scheduler]() {
+        esperto::int64 total = 0;
+        for (int i = 0; i < Batch; ++i) {
+            auto task = scheduler.startNew([](Task&) {
+                finishedAt = esp_timer_get_time();
+            }, "Join", 2048, BenchPriority - 1);
+            task->wait();
+            total += esp_timer_get_time() - finishedAt.load();
+        }
+        scheduler.cleanupCompletedTasks();
+        return total;
+    });
+}
+
+// Context switch: two tasks ping-pong a task notification
+static Result benchContextSwitch(TaskScheduler& scheduler) {
+    constexpr int RoundTrips = 1000;
+    static std::atomic<esperto::int64> elapsed{0};
+    return measure("context switch", RoundTrips * 2, [&scheduler]() {
+        static std::atomic<TaskHandle_t> ping{nullptr};
+        static std::atomic<TaskHandle_t> pong{nullptr};
+        ping = nullptr;
+        pong = nullptr;
+
+        auto pongTask = scheduler.startNew([](Task& self) {
+            pong = self.getHandle();
+            for (int i = 0; i < RoundTrips; ++i) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                xTaskNotifyGive(ping.load());
+            }
+        }, "Pong", 2048, BenchPriority + 1);
+        auto pingTask = scheduler.startNew([](Task& self) {
+            ping = self.getHandle();
+            while (!pong.load()) {
+                Task::yield();
+            }
+            esperto::int64 start = esp_timer_get_time();
+            for (int i = 0; i < RoundTrips; ++i) {
+                xTaskNotifyGive(pong.load());
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            elapsed = esp_timer_get_time() - start;
+        }, "Ping", 2048, BenchPriority + 1);
+
+        pingTask->wait();
+        pongTask->wait();
+        scheduler.cleanupCompletedTasks();
+        return elapsed.load();
+    });
+}
+
+// Snapshot cost with a populated registry: owning copy versus epoch-protected iteration
+static void benchSnapshots(TaskScheduler& scheduler, std::vector<Result>& results) {
+    constexpr int Population = 32;
+    constexpr int Calls = 200;
+
+    std::vector<std::shared_ptr<Task>> sleepers;
+    for (int i = 0; i < Population; ++i) {
+        sleepers.push_back(scheduler.startNew([](Task&) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }, "Sleeper", 2048, BenchPriority - 1));
+    }
+    Task::delay(10);
+
+    results.push_back(measure("getTasks (32 tasks)", Calls, [&scheduler]() {
+        size_t seen = 0;
+        esperto::int64 start = esp_timer_get_time();
+        for (int i = 0; i < Calls; ++i) {
+            seen += scheduler.getTasks().size();
+        }
+        esperto::int64 elapsed = esp_timer_get_time() - start;
+        return seen ? elapsed : 0;
+    }));
+
+    results.push_back(measure("snapshot iterate (32 tasks)", Calls, [&scheduler]() {
+        size_t seen = 0;
+        esperto::int64 start = esp_timer_get_time();
+        for (int i = 0; i < Calls; ++i) {
+            for (Task& task : scheduler.snapshot()) {
+                seen += task.getPriority() != 0;
+            }
+        }
+        esperto::int64 elapsed = esp_timer_get_time() - start;
+        return seen ? elapsed : 0;
+    }));
+
+    for (auto& task : sleepers) {
+        xTaskNotifyGive(task->getHandle());
+        task->wait();
+    }
+    scheduler.cleanupCompletedTasks();
+}
+
+// Pool throughput: several producers flood run() while the workers drain and steal
+static Result benchPoolContention(TaskScheduler& scheduler) {
+    constexpr int Producers = 4;
+    constexpr int JobsPerProducer = 2000;
+    constexpr int Jobs = Producers * JobsPerProducer;
+    static std::atomic<int> executed{0};
+
+    return measure("pool job (4 producers)", Jobs, [&scheduler]() {
+        executed = 0;
+        esperto::int64 start = esp_timer_get_time();
+        std::vector<std::shared_ptr<Task>> producers;
+        for (int p = 0; p < Producers; ++p) {
+            producers.push_back(scheduler.startNew([&scheduler](Task&) {
+                for (int i = 0; i < JobsPerProducer; ++i) {
+                    while (!scheduler.run([]() { executed.fetch_add(1, std::memory_order_relaxed); })) {
+                        Task::yield();
+                    }
+                }
+            }, "Producer", 2048, BenchPriority - 1));
+        }
+        for (auto& producer : producers) {
+            producer->wait();
+        }
+        while (executed.load() < Jobs) {
+            Task::delayTicks(1);
+        }
+        esperto::int64 elapsed = esp_timer_get_time() - start;
+        scheduler.cleanupCompletedTasks();
+        return elapsed;
+    });
+}
+
+extern "C" void app_main(void)
+{
+    vTaskPrioritySet(nullptr, BenchPriority);
+    auto& scheduler = TaskScheduler::instance();
+    scheduler.enablePool();
+
+    printf("esperto scheduler benchmarks: %d repetitions, tick %d Hz, %d core(s)\n",
+           Repetitions, configTICK_RATE_HZ, portNUM_PROCESSORS);
+    printf("%-28s %12s %12s %12s\n", "benchmark (ns/op)", "median", "p90", "min");
+
+    std::vector<Result> results;
+    results.push_back(benchSpawn(scheduler));
+    results.push_back(benchJoin(scheduler));
+    results.push_back(benchContextSwitch(scheduler));
+    benchSnapshots(scheduler, results);
+    results.push_back(benchPoolContention(scheduler));
+
+    printf("\n");
+    for (const Result& result : results) {
+        printf("BENCH %s median_ns=%.0f p90_ns=%.0f min_ns=%.0f\n", result.name, result.medianNs, result.p90Ns, result.minNs);
+    }
+    fflush(stdout);
+    exit(0);
+}
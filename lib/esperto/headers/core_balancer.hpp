@@ -0,0 +1,119 @@
+// core_balancer.hpp
+// Load-aware core placement and rebalancing for TaskScheduler tasks
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <memory>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+class Task;
+
+/**
+ * @brief Places new tasks on the least-loaded core and moves long-lived ones when the
+ * cores drift apart.
+ *
+ * Core load is the busy share of each core (everything but its idle task) between two
+ * samples, taken from the FreeRTOS run-time statistics. Rebalancing needs to change the
+ * affinity of a live task, which only the SMP FreeRTOS kernel supports
+ * (CONFIG_FREERTOS_SMP); with the default IDF kernel tasks are placed once, at creation.
+ */
+class CoreBalancer : public Object {
+public:
+    /**
+     * @brief Core argument of TaskScheduler::startNew asking for automatic placement.
+     */
+    static constexpr BaseType_t AutoCore = -1;
+
+    /**
+     * @brief Balancer configuration.
+     */
+    struct Config {
+        esperto::uint32 sampleIntervalMs = 1000;     ///< Load sampling (and rebalancing) period
+        esperto::uint32 imbalancePercent = 25;       ///< Busy share difference that triggers a migration
+        esperto::uint32 placementWeightPercent = 5;  ///< Load assumed for a task placed since the last sample
+        bool rebalance = true;                       ///< Move tracked tasks between cores (SMP kernel only)
+    };
+
+    /**
+     * @brief Sampled load and placement counters.
+     */
+    struct Statistics {
+        bool loadAvailable = false;                      ///< Run-time stats enabled in sdkconfig
+        bool rebalanceSupported = false;                 ///< Kernel can change the affinity of a live task
+        float load[portNUM_PROCESSORS] = {};             ///< Busy share of each core over the last interval, in percent
+        esperto::uint32 placed[portNUM_PROCESSORS] = {}; ///< Tasks placed on each core by pickCore()
+        esperto::uint32 tracked = 0;                     ///< Live auto-placed tasks
+        esperto::uint32 migrations = 0;                  ///< Tasks moved by rebalancing
+        esperto::uint64 samples = 0;                     ///< Load samples taken
+    };
+
+    /**
+     * @brief Creates the balancer.
+     * @param config Sampling and rebalancing configuration.
+     */
+    explicit CoreBalancer(const Config& config);
+
+    ~CoreBalancer() override;
+
+    /**
+     * @brief Gets the configuration.
+     */
+    const Config& getConfig() const;
+
+    /**
+     * @brief Chooses the core for a new task: the lowest sampled load plus a small weight
+     * for every task placed there since the last sample.
+     */
+    BaseType_t pickCore();
+
+    /**
+     * @brief Registers a started auto-placed task as a rebalancing candidate.
+     */
+    void track(const std::shared_ptr<Task>& task);
+
+    /**
+     * @brief Samples the per-core load and, if enabled, migrates at most one task from the
+     * busiest to the idlest core. Called periodically from the timer service.
+     */
+    void sample();
+
+    /**
+     * @brief Gets the last sampled load and the counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct RunTimeSample {
+        TaskHandle_t handle;
+        esperto::uint64 runTimeUs;
+    };
+
+    Config m_config;
+    std::vector<std::weak_ptr<Task>> m_tracked;
+    std::vector<RunTimeSample> m_previous;
+    esperto::uint64 m_previousTotalUs;
+    float m_load[portNUM_PROCESSORS];
+    esperto::uint32 m_recent[portNUM_PROCESSORS];
+    esperto::uint32 m_placed[portNUM_PROCESSORS];
+    esperto::uint32 m_migrations;
+    esperto::uint64 m_samples;
+    bool m_loadAvailable;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;
+
+    esperto::uint64 runTimeDelta(const std::vector<RunTimeSample>& current, TaskHandle_t handle) const;
+    void rebalance(const std::vector<RunTimeSample>& current, esperto::uint64 intervalUs);
+};
+
+} // namespace esperto
@@ -0,0 +1,235 @@
+// coroutine.hpp
+// C++20 coroutines multiplexed on a single FreeRTOS task
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <esp_attr.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+class CoroutineLoop;
+
+/**
+ * @brief Ready queue entry for a suspended coroutine.
+ *
+ * Lives inside the awaiter (and so inside the coroutine frame) for as long as the
+ * coroutine is suspended, so scheduling a resume never allocates.
+ */
+struct CoroutineNode {
+    CoroutineNode* next = nullptr;
+    std::coroutine_handle<> handle;
+    CoroutineLoop* loop = nullptr;
+};
+
+/**
+ * @brief Coroutine return type (C#-like async Task).
+ *
+ * A CoTask starts suspended. Spawned on a CoroutineLoop it runs detached and frees its
+ * frame when it finishes; co_awaited from another coroutine it runs inline and resumes
+ * the awaiting coroutine when done.
+ */
+class CoTask {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        CoroutineNode node;
+        bool detached = false;
+
+        CoTask get_return_object() { return CoTask(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    CoTask() = default;
+    CoTask(CoTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() { reset(); }
+
+    /**
+     * @brief Checks if the CoTask owns a coroutine.
+     */
+    bool isValid() const { return static_cast<bool>(m_handle); }
+
+    /**
+     * @brief Checks if the coroutine has run to completion.
+     */
+    bool isDone() const { return !m_handle || m_handle.done(); }
+
+    // Awaiting a CoTask starts it right away (symmetric transfer)
+    bool await_ready() const noexcept { return isDone(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+    void await_resume() const noexcept {}
+
+private:
+    friend class CoroutineLoop;
+
+    explicit CoTask(Handle handle) : m_handle(handle) {}
+
+    Handle release() { return std::exchange(m_handle, nullptr); }
+    void reset() {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    Handle m_handle;
+};
+
+/**
+ * @brief Runs many coroutines on one FreeRTOS task.
+ *
+ * Resumed coroutines go through a lock-free intrusive ready queue that any task or ISR
+ * can push to; the loop task sleeps on a task notification while the queue is empty.
+ * Each coroutine costs its frame (typically a few hundred bytes) instead of a stack.
+ */
+class CoroutineLoop : public Object {
+public:
+    /**
+     * @brief Coroutine loop configuration.
+     */
+    struct Config {
+        esperto::uint32 stackSize = 4096;              ///< Loop task stack size in words
+        UBaseType_t priority = tskIDLE_PRIORITY + 2;   ///< Loop task priority
+    };
+
+    /**
+     * @brief Counters describing the loop activity.
+     */
+    struct Statistics {
+        esperto::uint32 live = 0;       ///< Spawned coroutines that have not finished
+        esperto::uint64 spawned = 0;    ///< Coroutines spawned since start
+        esperto::uint64 resumed = 0;    ///< Resumptions executed by the loop
+    };
+
+    /**
+     * @brief Creates a loop (does not start the task).
+     * @param config Loop configuration.
+     */
+    explicit CoroutineLoop(const Config& config);
+
+    /**
+     * @brief Stops the loop task.
+     */
+    ~CoroutineLoop() override;
+
+    /**
+     * @brief Starts the loop task.
+     * @return true if the task is running.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the loop task. Coroutines still suspended are not resumed again, so
+     * stop only once they have finished. Must not be called from a coroutine.
+     */
+    void stop();
+
+    /**
+     * @brief Runs a coroutine on the loop. The loop owns it until it finishes.
+     * @param task The coroutine to run.
+     * @return false if the task is empty.
+     */
+    bool spawn(CoTask task);
+
+    /**
+     * @brief Queues a suspended coroutine for resumption. Callable from any task.
+     */
+    void schedule(CoroutineNode& node);
+
+    /**
+     * @brief Queues a suspended coroutine for resumption from an interrupt handler.
+     */
+    void IRAM_ATTR scheduleFromISR(CoroutineNode& node);
+
+    /**
+     * @brief Gets the loop running the calling code.
+     * @return The loop, or nullptr outside of a coroutine loop task.
+     */
+    static CoroutineLoop* current();
+
+    /**
+     * @brief Checks if the loop task is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Gets the loop counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    friend class CoTask;
+
+    Config m_config;
+    std::atomic<CoroutineNode*> m_ready;
+    TaskHandle_t m_handle;
+    SemaphoreHandle_t m_exited;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+    std::atomic<esperto::uint32> m_live;
+    std::atomic<esperto::uint64> m_spawned;
+    std::atomic<esperto::uint64> m_resumed;
+
+    static thread_local CoroutineLoop* s_current;
+
+    static void loopEntryPoint(void* param);
+    void run();
+    bool push(CoroutineNode& node);
+};
+
+/**
+ * @brief Awaitable delay, returned by Task::delayAsync.
+ *
+ * Inside a coroutine loop the coroutine is parked on the TaskScheduler timer service and
+ * the loop keeps running other coroutines. Elsewhere it falls back to a blocking delay.
+ * When the timer service has no free timer the await fails at once instead of blocking
+ * the loop: co_await yields false and the coroutine decides whether to retry.
+ */
+class DelayAwaiter {
+public:
+    explicit DelayAwaiter(esperto::uint32 delayMs) : m_delayMs(delayMs), m_failed(false) {}
+
+    bool await_ready() const noexcept { return m_delayMs == 0; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    bool await_resume() const noexcept { return !m_failed; }
+
+private:
+    esperto::uint32 m_delayMs;
+    bool m_failed;          ///< No timer was available; the coroutine was not delayed
+    CoroutineNode m_node;
+};
+
+} // namespace esperto
@@ -0,0 +1,343 @@
+// future.hpp
+// Future/Promise result types (C#/.NET Task<T>-like) for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+/** Timeout value meaning "wait forever". */
+constexpr esperto::uint32 InfiniteTimeout = 0xFFFFFFFFu;
+
+/** Index whenAny completes with when there is nothing to wait for. */
+constexpr size_t NoIndex = static_cast<size_t>(-1);
+
+/**
+ * @brief Empty value carried by Future<void>.
+ */
+struct Unit {};
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace detail {
+
+template <typename T> struct FutureValue { using type = T; };
+template <> struct FutureValue<void> { using type = Unit; };
+
+inline TickType_t timeoutToTicks(esperto::uint32 timeoutMs) {
+    return timeoutMs == InfiniteTimeout ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+}
+
+/**
+ * @brief Shared state between a Promise and its Futures.
+ *
+ * Completion is signalled through an event group, so waiters block until the value
+ * is set instead of polling. Continuations run in the context of the task that sets
+ * the value, before waiters are released.
+ */
+template <typename T>
+class FutureState {
+public:
+    using value_type = typename FutureValue<T>::type;
+    using Continuation = std::function<void(const value_type&)>;
+
+    FutureState() : m_ready(false), m_claimed(false) {
+        m_event = xEventGroupCreateStatic(&m_eventBuffer);
+        m_lock = xSemaphoreCreateMutexStatic(&m_lockBuffer);
+    }
+
+    ~FutureState() {
+        vEventGroupDelete(m_event);
+        vSemaphoreDelete(m_lock);
+    }
+
+    FutureState(const FutureState&) = delete;
+    FutureState& operator=(const FutureState&) = delete;
+
+    bool isReady() const {
+        return m_ready.load(std::memory_order_acquire);
+    }
+
+    bool wait(esperto::uint32 timeoutMs) const {
+        if (isReady()) {
+            return true;
+        }
+        EventBits_t bits = xEventGroupWaitBits(m_event, ReadyBit, pdFALSE, pdTRUE, timeoutToTicks(timeoutMs));
+        return (bits & ReadyBit) != 0;
+    }
+
+    const value_type& value() const {
+        return *m_value;
+    }
+
+    bool setValue(value_type value) {
+        if (m_claimed.exchange(true)) {
+            return false;
+        }
+        m_value.emplace(std::move(value));
+
+        // Ready is published only once no continuation is left, so isReady() and wait()
+        // never return before they have run. Continuations added meanwhile join the next pass.
+        for (;;) {
+            std::vector<Continuation> continuations;
+            xSemaphoreTake(m_lock, portMAX_DELAY);
+            continuations.swap(m_continuations);
+            if (continuations.empty()) {
+                m_ready.store(true, std::memory_order_release);
+                xSemaphoreGive(m_lock);
+                break;
+            }
+            xSemaphoreGive(m_lock);
+
+            for (auto& continuation : continuations) {
+                continuation(*m_value);
+            }
+        }
+        xEventGroupSetBits(m_event, ReadyBit);
+        return true;
+    }
+
+    void addContinuation(Continuation continuation) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        if (!m_ready.load(std::memory_order_acquire)) {
+            m_continuations.push_back(std::move(continuation));
+            xSemaphoreGive(m_lock);
+            return;
+        }
+        xSemaphoreGive(m_lock);
+        continuation(*m_value);
+    }
+
+private:
+    static constexpr EventBits_t ReadyBit = 1 << 0;
+
+    StaticEventGroup_t m_eventBuffer;
+    EventGroupHandle_t m_event;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;
+    std::atomic<bool> m_ready;
+    std::atomic<bool> m_claimed;
+    std::optional<value_type> m_value;
+    std::vector<Continuation> m_continuations;
+};
+
+} // namespace detail
+
+/**
+ * @brief Read side of an asynchronous result (C#-like Task<T>).
+ *
+ * Copies share the same state. Future<void> carries a Unit value.
+ */
+template <typename T>
+class Future {
+public:
+    using value_type = typename detail::FutureValue<T>::type;
+
+    /**
+     * @brief Creates an invalid future (not bound to any promise).
+     */
+    Future() = default;
+
+    /**
+     * @brief Checks if the future is bound to a promise.
+     */
+    bool isValid() const {
+        return static_cast<bool>(m_state);
+    }
+
+    /**
+     * @brief Checks if the value has been set.
+     */
+    bool isReady() const {
+        return m_state && m_state->isReady();
+    }
+
+    /**
+     * @brief Blocks the calling task until the value is set.
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return true if the value is available, false on timeout or invalid future.
+     */
+    bool wait(esperto::uint32 timeoutMs = InfiniteTimeout) const {
+        return m_state && m_state->wait(timeoutMs);
+    }
+
+    /**
+     * @brief Waits for the value and returns it. The future must be valid.
+     */
+    const value_type& get() const {
+        m_state->wait(InfiniteTimeout);
+        return m_state->value();
+    }
+
+    /**
+     * @brief Registers a continuation (C#-like ContinueWith).
+     *
+     * The continuation runs in the task that completes this future, or immediately in
+     * the caller if the value is already set. It receives the value, or nothing for
+     * Future<void>.
+     * @param func The continuation.
+     * @return A future completed with the continuation's result.
+     */
+    template <typename F>
+    auto continueWith(F func) const {
+        using R = typename std::conditional_t<std::is_invocable_v<F, const value_type&>,
+                                              std::invoke_result<F, const value_type&>,
+                                              std::invoke_result<F>>::type;
+        if (!m_state) {
+            return Future<R>();
+        }
+        Promise<R> promise;
+        Future<R> result = promise.getFuture();
+        m_state->addContinuation([promise, func = std::move(func)](const value_type& value) mutable {
+            if constexpr (std::is_invocable_v<F, const value_type&>) {
+                if constexpr (std::is_void_v<R>) {
+                    func(value);
+                    promise.setValue();
+                } else {
+                    promise.setValue(func(value));
+                }
+            } else {
+                if constexpr (std::is_void_v<R>) {
+                    func();
+                    promise.setValue();
+                } else {
+                    promise.setValue(func());
+                }
+            }
+        });
+        return result;
+    }
+
+private:
+    template <typename> friend class Promise;
+
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<detail::FutureState<T>> m_state;
+};
+
+/**
+ * @brief Write side of an asynchronous result.
+ */
+template <typename T>
+class Promise {
+public:
+    using value_type = typename detail::FutureValue<T>::type;
+
+    Promise() : m_state(std::make_shared<detail::FutureState<T>>()) {}
+
+    /**
+     * @brief Gets a future bound to this promise.
+     */
+    Future<T> getFuture() const {
+        return Future<T>(m_state);
+    }
+
+    /**
+     * @brief Sets the value, runs the continuations and wakes the waiters.
+     * @return false if the value was already set.
+     */
+    bool setValue(value_type value = value_type()) const {
+        return m_state->setValue(std::move(value));
+    }
+
+private:
+    std::shared_ptr<detail::FutureState<T>> m_state;
+};
+
+/**
+ * @brief Result type of whenAll: a vector of values, or void for Future<void>.
+ */
+template <typename T>
+using WhenAllResult = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+/**
+ * @brief Creates a future completed when every input future is completed (C#-like WhenAll).
+ * @param futures The futures to wait for.
+ * @return A future holding the values in input order (Future<void> for void inputs).
+ */
+template <typename T>
+Future<WhenAllResult<T>> whenAll(const std::vector<Future<T>>& futures) {
+    using Value = typename Future<T>::value_type;
+    struct Join {
+        std::atomic<size_t> remaining;
+        std::vector<std::optional<Value>> values;
+        Promise<WhenAllResult<T>> promise;
+    };
+
+    auto join = std::make_shared<Join>();
+    join->remaining = futures.size();
+    join->values.resize(futures.size());
+    Future<WhenAllResult<T>> result = join->promise.getFuture();
+
+    auto complete = [join]() {
+        if constexpr (std::is_void_v<T>) {
+            join->promise.setValue();
+        } else {
+            std::vector<T> values;
+            values.reserve(join->values.size());
+            for (auto& value : join->values) {
+                values.push_back(std::move(*value));
+            }
+            join->promise.setValue(std::move(values));
+        }
+    };
+
+    if (futures.empty()) {
+        complete();
+        return result;
+    }
+
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].continueWith([join, complete, i](const Value& value) {
+            join->values[i].emplace(value);
+            if (join->remaining.fetch_sub(1) == 1) {
+                complete();
+            }
+        });
+    }
+    return result;
+}
+
+/**
+ * @brief Creates a future completed when the first input future is completed (C#-like WhenAny).
+ * @param futures The futures to wait for.
+ * @return A future holding the index of the first completed future, or NoIndex at once
+ * if there are none.
+ */
+template <typename T>
+Future<size_t> whenAny(const std::vector<Future<T>>& futures) {
+    using Value = typename Future<T>::value_type;
+    Promise<size_t> promise;
+    Future<size_t> result = promise.getFuture();
+    if (futures.empty()) {
+        promise.setValue(NoIndex);
+        return result;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        // Promise::setValue ignores every completion after the first one
+        futures[i].continueWith([promise, i](const Value&) {
+            promise.setValue(i);
+        });
+    }
+    return result;
+}
+
+} // namespace esperto
@@ -7,21 +7,42 @@
 
 #include "object.hpp"
 #include "types.hpp"
+#include "coroutine.hpp"
+#include "gpio_backend.hpp"
+#include "gpio_dispatcher.hpp"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "gpio_debouncer.hpp"
+#include "pulse_train.hpp"
+#include "pwm_output.hpp"
+#endif
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <esp_attr.h>
-extern "C" {
-#include "driver/gpio.h"
-}
 
 namespace esperto {
 
+class GpioEdgeAwaiter;
+
 /**
  * @brief Class to manage GPIO functionality in an OOP way.
+ *
+ * Pin access goes through GpioBackend::current(), so on the linux target the same class
+ * runs against the simulator. PWM, pulse trains and debouncing need the chip.
  */
 class Gpio : public Object {
 public:
     using InterruptCallback = std::function<void(Gpio&)>;
+    using EventCallback = std::function<void(Gpio&, const GpioEvent&)>;
+
+    /**
+     * @brief Where interrupt callbacks run.
+     */
+    enum class DispatchMode {
+        Immediate,  ///< In the ISR: must be short and IRAM-safe
+        Deferred,   ///< On the GpioDispatcher task: the ISR only queues a GpioEvent
+        Debounced   ///< On the esp_timer task, once per transition validated by the GpioDebouncer
+    };
 
     /**
      * @brief Construct a GPIO object for a given pin.
@@ -68,20 +89,80 @@ public:
      * @brief Enable interrupt on this GPIO pin.
      * @param interruptType Type of interrupt (GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, etc.)
      * @param callback Function to call when interrupt occurs
+     * @param mode Immediate runs the callback in the ISR, Deferred on the dispatcher task,
+     * Debounced on the esp_timer task with the default GpioDebounce timing
+     */
+    void enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback, DispatchMode mode = DispatchMode::Immediate);
+
+#if !CONFIG_IDF_TARGET_LINUX
+    /**
+     * @brief Enable a debounced interrupt: edges only feed the GpioDebouncer state machine and
+     * the callback runs, on the esp_timer task, once the level has settled on a new value.
+     * @param interruptType Transitions to report (GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE)
+     * @param callback Function to call for every validated transition
+     * @param debounce Stable window and minimum pulse width
+     */
+    void enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback, const GpioDebounce& debounce);
+#endif
+
+    /**
+     * @brief Enable a deferred interrupt whose callback also receives the captured event
+     * (level and cycle-count timestamp at the interrupt). Starts the GpioDispatcher if needed.
+     * @param interruptType Type of interrupt (GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, etc.)
+     * @param callback Function to call, from the dispatcher task, for every queued event
      */
-    void enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback);
+    void enableDeferredInterrupt(gpio_int_type_t interruptType, EventCallback callback);
 
     /**
      * @brief Disable interrupt on this GPIO pin.
      */
     void disableInterrupt();
 
+    /**
+     * @brief Get the dispatch mode of the enabled interrupt.
+     */
+    DispatchMode getDispatchMode() const;
+
+    /**
+     * @brief Get the last level validated by the debouncer, or the current level when the
+     * interrupt is not debounced.
+     * @return 0 = Low, 1 = High
+     */
+    int getDebouncedLevel() const;
+
     /**
      * @brief Check if interrupt is enabled on this pin.
      * @return true if interrupt is enabled, false otherwise
      */
     bool isInterruptEnabled() const;
 
+    /**
+     * @brief Awaitable edge for coroutines running on a CoroutineLoop:
+     * co_await gpio.edgeAsync(GPIO_INTR_POSEDGE) resumes on the next matching edge and
+     * yields the pin level. Replaces the enabled interrupt while waiting and enables it
+     * again, with its callback and mode, once the coroutine resumes.
+     * @param edge Edge to wait for (GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE)
+     */
+    GpioEdgeAwaiter edgeAsync(gpio_int_type_t edge);
+
+#if !CONFIG_IDF_TARGET_LINUX
+    /**
+     * @brief Starts a hardware PWM waveform on this pin (LEDC): after this call the pin
+     * toggles without any task or interrupt involvement.
+     * @param frequencyHz Output frequency
+     * @param dutyPercent Duty cycle, 0 to 100
+     * @return The running output, or nullptr if no LEDC channel or timer could provide it
+     */
+    std::unique_ptr<PwmOutput> startPwm(esperto::uint32 frequencyHz, float dutyPercent);
+
+    /**
+     * @brief Opens an RMT pulse train output on this pin for arbitrary timed sequences.
+     * @param config RMT resolution and channel memory
+     * @return The started output, or nullptr if no RMT TX channel is free
+     */
+    std::unique_ptr<PulseTrain> startPulseTrain(const PulseTrain::Config& config = PulseTrain::Config());
+#endif
+
     /**
      * @brief Get the pin number managed by this object.
      */
@@ -91,12 +172,62 @@ public:
     bool equals(const Object& other) const override;
 
 private:
+    friend class GpioDebouncer;
+    friend class GpioDispatcher;
+    friend class GpioEdgeAwaiter;
+
+    // Interrupt configuration, saved and restored around an edgeAsync wait
+    struct InterruptSetup {
+        bool enabled = false;
+        DispatchMode mode = DispatchMode::Immediate;
+        gpio_int_type_t type = GPIO_INTR_DISABLE;
+        InterruptCallback callback;
+        EventCallback eventCallback;
+#if !CONFIG_IDF_TARGET_LINUX
+        GpioDebounce debounce;
+#endif
+    };
+
     gpio_num_t m_pin;
     InterruptCallback m_callback;
+    EventCallback m_eventCallback;
+    DispatchMode m_mode;
+    gpio_int_type_t m_interruptType;
+#if !CONFIG_IDF_TARGET_LINUX
+    GpioDebounce m_debounce;
+#endif
     bool m_interruptEnabled;
     
     static void IRAM_ATTR gpio_isr_handler(void* arg);
-    static bool s_gpio_service_installed;
+    static void IRAM_ATTR gpio_deferred_isr_handler(void* arg);
+#if !CONFIG_IDF_TARGET_LINUX
+    static void IRAM_ATTR gpio_debounce_isr_handler(void* arg);
+#endif
+
+    void dispatch(const GpioEvent& event);
+    InterruptSetup saveInterrupt() const;
+    void restoreInterrupt(const InterruptSetup& setup);
+};
+
+/**
+ * @brief Awaiter returned by Gpio::edgeAsync. The ISR only queues the coroutine; it
+ * resumes on its loop task, where the interrupt the pin had before the wait is restored.
+ */
+class GpioEdgeAwaiter {
+public:
+    GpioEdgeAwaiter(Gpio& gpio, gpio_int_type_t edge) : m_gpio(gpio), m_edge(edge), m_armed(false), m_fired(false) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    int await_resume();
+
+private:
+    Gpio& m_gpio;
+    gpio_int_type_t m_edge;
+    CoroutineNode m_node;
+    bool m_armed;
+    std::atomic<bool> m_fired;
+    Gpio::InterruptSetup m_previous;   ///< Interrupt to restore on resume
 };
 
 } // namespace esperto
@@ -0,0 +1,94 @@
+// gpio_backend.hpp
+// Pin access behind Gpio: the ESP-IDF driver on the chip, a simulator on the host
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "gpio_host_types.hpp"
+#else
+extern "C" {
+#include "driver/gpio.h"
+}
+#endif
+
+namespace esperto {
+
+/**
+ * @brief Interface for the pin operations Gpio performs.
+ *
+ * Gpio never calls the GPIO driver directly, so the linux target can run the same code
+ * against SimulatedGpioBackend. The backend must be selected before the first Gpio is
+ * created. Calls in interrupt context go through the backend too, except the level and
+ * timestamp captured by the deferred ISR on the chip, which stay register reads so that
+ * handler remains IRAM-safe.
+ */
+class GpioBackend {
+public:
+    virtual ~GpioBackend() = default;
+
+    /**
+     * @brief Prepares interrupt handling; called once per Gpio, must be idempotent.
+     */
+    virtual bool install() = 0;
+
+    virtual bool setDirection(gpio_num_t pin, gpio_mode_t mode) = 0;
+    virtual bool setLevel(gpio_num_t pin, esperto::uint32 level) = 0;
+    virtual int getLevel(gpio_num_t pin) = 0;
+    virtual bool setPullMode(gpio_num_t pin, gpio_pull_mode_t mode) = 0;
+    virtual bool setInterruptType(gpio_num_t pin, gpio_int_type_t type) = 0;
+    virtual bool enableInterrupt(gpio_num_t pin) = 0;
+    virtual bool disableInterrupt(gpio_num_t pin) = 0;
+    virtual bool addHandler(gpio_num_t pin, gpio_isr_t handler, void* arg) = 0;
+    virtual bool removeHandler(gpio_num_t pin) = 0;
+
+    /**
+     * @brief Gets the timestamp stored in GpioEvent::cycles (CPU cycles, wrapping).
+     */
+    virtual esperto::uint32 getTimestamp() = 0;
+
+    /**
+     * @brief Gets the backend used by Gpio: EspGpioBackend on the chip, a
+     * SimulatedGpioBackend on the linux target, unless replaced with use().
+     */
+    static GpioBackend& current();
+
+    /**
+     * @brief Replaces the backend. Call it before creating any Gpio.
+     */
+    static void use(GpioBackend& backend);
+};
+
+#if !CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief GpioBackend on the ESP-IDF GPIO driver; handlers go through GpioIsrRouter.
+ */
+class EspGpioBackend : public Object, public GpioBackend {
+public:
+    /**
+     * @brief Gets the driver backend.
+     */
+    static EspGpioBackend& instance();
+
+    bool install() override;
+    bool setDirection(gpio_num_t pin, gpio_mode_t mode) override;
+    bool setLevel(gpio_num_t pin, esperto::uint32 level) override;
+    int getLevel(gpio_num_t pin) override;
+    bool setPullMode(gpio_num_t pin, gpio_pull_mode_t mode) override;
+    bool setInterruptType(gpio_num_t pin, gpio_int_type_t type) override;
+    bool enableInterrupt(gpio_num_t pin) override;
+    bool disableInterrupt(gpio_num_t pin) override;
+    bool addHandler(gpio_num_t pin, gpio_isr_t handler, void* arg) override;
+    bool removeHandler(gpio_num_t pin) override;
+    esperto::uint32 getTimestamp() override;
+
+private:
+    EspGpioBackend() = default;
+};
+#endif
+
+} // namespace esperto
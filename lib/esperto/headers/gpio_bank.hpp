@@ -0,0 +1,107 @@
+// gpio_bank.hpp
+// Multi-pin GPIO access through single register writes and reads (C++/OOP)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <initializer_list>
+#include <vector>
+extern "C" {
+#include "driver/gpio.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Drives or samples a group of pins as one value.
+ *
+ * Bit i of the value maps to the i-th pin given to the constructor. Writes go through the
+ * W1TS/W1TC set and clear registers, so every pin settles within two register stores and
+ * pins outside the bank are never touched; reads take one snapshot of the input registers.
+ * Pins that are consecutive and ascending within one register use a shift instead of the
+ * per-bit remapping.
+ */
+class GpioBank : public Object {
+public:
+    static constexpr size_t MaxPins = 32;
+
+    /**
+     * @brief Creates a bank. The pins are not configured until setDirection().
+     * @param pins Pins, least significant bit first (up to 32, no duplicates).
+     */
+    GpioBank(std::initializer_list<gpio_num_t> pins);
+
+    /**
+     * @brief Creates a bank. The pins are not configured until setDirection().
+     * @param pins Pins, least significant bit first (up to 32, no duplicates).
+     */
+    explicit GpioBank(const std::vector<gpio_num_t>& pins);
+
+    /**
+     * @brief Checks if every pin is valid and appears once.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Configures every pin of the bank with one gpio_config call.
+     * @param mode GPIO_MODE_INPUT, GPIO_MODE_OUTPUT, etc.
+     * @return false if the bank is invalid or the driver rejected the configuration.
+     */
+    bool setDirection(gpio_mode_t mode);
+
+    /**
+     * @brief Enables or disables the internal pull-up resistor of every pin.
+     */
+    void setPullup(bool enable);
+
+    /**
+     * @brief Drives all pins at once.
+     * @param value Bit i is the level of the i-th pin.
+     */
+    void write(esperto::uint32 value);
+
+    /**
+     * @brief Drives high the pins whose bit is set, leaving the others unchanged.
+     */
+    void setBits(esperto::uint32 bits);
+
+    /**
+     * @brief Drives low the pins whose bit is set, leaving the others unchanged.
+     */
+    void clearBits(esperto::uint32 bits);
+
+    /**
+     * @brief Samples all pins at once.
+     * @return Bit i is the level of the i-th pin.
+     */
+    esperto::uint32 read() const;
+
+    /**
+     * @brief Gets the number of pins in the bank.
+     */
+    size_t getWidth() const;
+
+    /**
+     * @brief Gets the pin behind a bit of the value.
+     */
+    gpio_num_t getPin(size_t bit) const;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+private:
+    std::vector<gpio_num_t> m_pins;
+    esperto::uint32 m_valueMask;    ///< Bits of the value used by the bank
+    esperto::uint32 m_lowMask;      ///< Bank pins in GPIO 0-31
+    esperto::uint32 m_highMask;     ///< Bank pins in GPIO 32 and up
+    esperto::int32 m_shift;         ///< Shift of the contiguous fast path, -1 if the pins are scattered
+    bool m_valid;
+
+    void initialize();
+    void toRegisters(esperto::uint32 value, esperto::uint32& low, esperto::uint32& high) const;
+};
+
+} // namespace esperto
@@ -0,0 +1,133 @@
+// gpio_debouncer.hpp
+// Interrupt-driven debouncing of GPIO inputs on one shared esp_timer
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <esp_attr.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+}
+
+namespace esperto {
+
+class Gpio;
+
+/**
+ * @brief Debounce timing of one input.
+ */
+struct GpioDebounce {
+    esperto::uint32 stableUs = 5000;    ///< Quiet time after the last edge before the level is trusted
+    esperto::uint32 minPulseUs = 0;     ///< Shortest accepted pulse, measured from the first edge of a burst
+};
+
+/**
+ * @brief Turns bouncing edges into validated transitions.
+ *
+ * Every debounced pin runs a small state machine: the ISR only timestamps edges and extends
+ * the pin's deadline, and one esp_timer, armed for the earliest deadline of all pins, samples
+ * the settled level. A callback runs (on the esp_timer task) only when that level differs from
+ * the last validated one, so a burst of bounces costs a few short ISRs and at most one callback.
+ * A burst that settles back on the previous level is counted as a glitch and reported to no one.
+ */
+class GpioDebouncer : public Object {
+public:
+    /**
+     * @brief Counters of the debounce engine.
+     */
+    struct Statistics {
+        esperto::uint32 pins = 0;          ///< Pins attached
+        esperto::uint32 pending = 0;       ///< Pins with an unsettled burst
+        esperto::uint64 edges = 0;         ///< Raw edges seen by the ISR
+        esperto::uint64 transitions = 0;   ///< Validated level changes
+        esperto::uint64 callbacks = 0;     ///< Transitions matching the requested edge
+        esperto::uint64 glitches = 0;      ///< Bursts that settled on the previous level
+        esperto::uint64 timerRuns = 0;     ///< esp_timer expirations
+    };
+
+    /**
+     * @brief Gets the debouncer shared by every Gpio in debounced mode.
+     */
+    static GpioDebouncer& instance();
+
+    /**
+     * @brief Starts debouncing a pin. The pin interrupt must be set to GPIO_INTR_ANYEDGE by the caller.
+     * @param gpio Pin owner; its interrupt callback runs on validated transitions
+     * @param edge Transitions to report: GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE or GPIO_INTR_ANYEDGE
+     * @param debounce Stable window and minimum pulse width
+     * @return false for level interrupt types or if the esp_timer cannot be created.
+     */
+    bool attach(Gpio& gpio, gpio_int_type_t edge, const GpioDebounce& debounce);
+
+    /**
+     * @brief Stops debouncing a pin. Once it returns, no callback of that Gpio runs unless it is
+     * called from inside one of its own callbacks.
+     */
+    void detach(Gpio& gpio);
+
+    /**
+     * @brief Records an edge. Interrupt context only.
+     */
+    void IRAM_ATTR edgeFromISR(gpio_num_t pin);
+
+    /**
+     * @brief Records an edge on the debouncer, once a pin has been attached. Interrupt context
+     * only; reaches the debouncer through DRAM instead of the flash-resident instance().
+     */
+    static void IRAM_ATTR recordFromISR(gpio_num_t pin);
+
+    /**
+     * @brief Gets the last validated level of a pin.
+     * @return 0 = Low, 1 = High, -1 if the pin is not attached
+     */
+    int getStableLevel(gpio_num_t pin) const;
+
+    /**
+     * @brief Gets the engine counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct PinState {
+        Gpio* gpio;
+        esperto::uint32 stableUs;
+        esperto::uint32 minPulseUs;
+        bool reportRising;
+        bool reportFalling;
+        esperto::uint32 stableLevel;
+        esperto::int64 burstStartUs;   ///< First edge of the unsettled burst
+        esperto::int64 lastEdgeUs;     ///< Latest edge of the unsettled burst
+    };
+
+    GpioDebouncer();
+
+    PinState m_pins[GPIO_NUM_MAX];
+    esperto::uint64 m_pending;        ///< Bit per pin with an unsettled burst
+    bool m_armed;
+    esperto::int64 m_deadlineUs;      ///< Expiry of the armed timer
+    esperto::uint32 m_attached;
+    esperto::uint64 m_edges;
+    esperto::uint64 m_transitions;
+    esperto::uint64 m_callbacks;
+    esperto::uint64 m_glitches;
+    esperto::uint64 m_timerRuns;
+    esp_timer_handle_t m_timer;
+    portMUX_TYPE m_spinlock;          ///< Shared with the ISR: pin timing, pending bits and timer state
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;         ///< Held while callbacks run, so detach can wait for them
+
+    static GpioDebouncer* s_active;   ///< Set by the first attach, for the ISR (DRAM, unlike instance())
+
+    static void timerEntryPoint(void* param);
+    void run();
+    static esperto::int64 IRAM_ATTR deadlineOf(const PinState& state);
+    void IRAM_ATTR armLocked(esperto::int64 deadlineUs, esperto::int64 nowUs);
+};
+
+} // namespace esperto
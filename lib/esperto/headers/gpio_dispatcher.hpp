@@ -0,0 +1,143 @@
+// gpio_dispatcher.hpp
+// Deferred GPIO interrupt dispatch through a lock-free event ring
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "gpio_backend.hpp"
+#include <atomic>
+#include <esp_attr.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+class Gpio;
+
+/**
+ * @brief One GPIO interrupt, as captured by the ISR.
+ */
+struct GpioEvent {
+    gpio_num_t pin;             ///< Pin that raised the interrupt
+    esperto::uint32 level;      ///< Pin level read in the ISR
+    esperto::uint32 cycles;     ///< CPU cycle count at the interrupt (esp_cpu_get_cycle_count)
+};
+
+/**
+ * @brief Moves GPIO callbacks out of interrupt context.
+ *
+ * The ISR only copies a GpioEvent into a single-producer/single-consumer ring and wakes
+ * the dispatcher task when it is asleep; the dispatcher drains the ring in batches and
+ * runs the callbacks as ordinary task code. The GPIO ISR service runs on one core, so
+ * every pin shares the same producer.
+ */
+class GpioDispatcher : public Object {
+public:
+    /**
+     * @brief Dispatcher configuration.
+     */
+    struct Config {
+        esperto::uint32 capacity = 1024;                   ///< Ring size in events, rounded up to a power of two
+        esperto::uint32 stackSize = 4096;                  ///< Dispatcher task stack size in words
+        UBaseType_t priority = configMAX_PRIORITIES - 6;   ///< Dispatcher task priority
+        BaseType_t core = tskNO_AFFINITY;                  ///< Core the dispatcher task is pinned to
+    };
+
+    /**
+     * @brief Counters describing the ring and the dispatcher task.
+     */
+    struct Statistics {
+        esperto::uint32 capacity = 0;     ///< Ring size in events
+        esperto::uint32 pending = 0;      ///< Events waiting in the ring
+        esperto::uint32 highWater = 0;    ///< Most events ever waiting at once
+        esperto::uint64 dispatched = 0;   ///< Events handed to callbacks
+        esperto::uint32 dropped = 0;      ///< Events lost because the ring was full
+        esperto::uint64 batches = 0;      ///< Dispatcher wake-ups
+        esperto::uint32 maxBatch = 0;     ///< Most events drained in one wake-up
+    };
+
+    /**
+     * @brief Gets the dispatcher shared by every Gpio in deferred mode.
+     */
+    static GpioDispatcher& instance();
+
+    /**
+     * @brief Sets the configuration. Only possible before the dispatcher starts.
+     * @return true if applied.
+     */
+    bool configure(const Config& config);
+
+    /**
+     * @brief Allocates the ring in internal RAM and starts the dispatcher task.
+     * @return true if the dispatcher is running.
+     */
+    bool start();
+
+    /**
+     * @brief Checks if the dispatcher task is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Routes the events of a pin to a Gpio.
+     */
+    void attach(Gpio& gpio);
+
+    /**
+     * @brief Stops routing the events of a pin and discards the ones still queued for it, so a
+     * Gpio attached to the pin later never receives them. Once it returns, no callback of that
+     * Gpio runs unless it is called from inside one of its own callbacks.
+     */
+    void detach(Gpio& gpio);
+
+    /**
+     * @brief Queues an event. Interrupt context only (single producer).
+     * @return false if the ring was full and the event was dropped.
+     */
+    bool IRAM_ATTR pushFromISR(const GpioEvent& event);
+
+    /**
+     * @brief Queues an event on the running dispatcher. Interrupt context only. Touches
+     * IRAM code and DRAM data only, so it may run with the flash cache disabled.
+     * @return false if the dispatcher is not running or the ring was full.
+     */
+    static bool IRAM_ATTR queueFromISR(const GpioEvent& event);
+
+    /**
+     * @brief Gets the ring and dispatch counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    GpioDispatcher();
+
+    Config m_config;
+    GpioEvent* m_ring;
+    esperto::uint32 m_mask;
+    std::atomic<esperto::uint32> m_head;
+    std::atomic<esperto::uint32> m_tail;
+    std::atomic<bool> m_waiting;
+    std::atomic<esperto::uint32> m_highWater;
+    std::atomic<esperto::uint32> m_dropped;
+    std::atomic<esperto::uint64> m_dispatched;
+    std::atomic<esperto::uint64> m_batches;
+    std::atomic<esperto::uint32> m_maxBatch;
+    Gpio* m_targets[GPIO_NUM_MAX];
+    TaskHandle_t m_handle;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;
+
+    static GpioDispatcher* s_running;   ///< Started dispatcher, for the ISR (DRAM, unlike instance())
+
+    static void dispatcherEntryPoint(void* param);
+    void run();
+    esperto::uint32 drain();
+};
+
+} // namespace esperto
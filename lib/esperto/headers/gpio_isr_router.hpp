@@ -0,0 +1,134 @@
+// gpio_isr_router.hpp
+// Selectable GPIO interrupt backend: IDF ISR service or one shared bitmask-dispatch ISR
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <esp_attr.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Owns the GPIO interrupt and routes it to per-pin handlers.
+ *
+ * With the IsrService backend handlers go through gpio_isr_handler_add, as before. With the
+ * Shared backend esperto registers the one GPIO interrupt itself: the ISR reads the status
+ * registers once, walks the set bits with count-trailing-zeros and calls each pin's handler
+ * through a flat table in internal RAM. Like the ISR service, it clears the status bit of an
+ * edge-triggered pin before its handler and that of a level-triggered pin after it, so an edge
+ * arriving while the handlers run is not lost. It also counts the interrupts of every pin. The backend must be chosen before the first Gpio is
+ * created, as both cannot be installed at once.
+ */
+class GpioIsrRouter : public Object {
+public:
+    /**
+     * @brief Interrupt dispatch implementation.
+     */
+    enum class Backend {
+        IsrService,  ///< IDF gpio_install_isr_service and its per-pin handler list
+        Shared       ///< esperto-owned ISR with bitmask dispatch and per-pin counters
+    };
+
+    /**
+     * @brief Counters of the shared ISR (all zero with the IsrService backend).
+     */
+    struct Statistics {
+        esperto::uint64 entries = 0;    ///< ISR invocations
+        esperto::uint64 dispatched = 0; ///< Handler calls
+        esperto::uint32 spurious = 0;   ///< Status bits with no handler attached
+        esperto::uint32 maxPins = 0;    ///< Most pins served by one invocation
+    };
+
+    /**
+     * @brief Gets the router shared by every Gpio and StaticGpio.
+     */
+    static GpioIsrRouter& instance();
+
+    /**
+     * @brief Selects the backend. Only possible before install().
+     * @param backend Dispatch implementation
+     * @param interruptFlags ESP_INTR_FLAG_* for the interrupt allocation (ESP_INTR_FLAG_IRAM
+     * requires every handler to be IRAM-safe)
+     * @return true if applied.
+     */
+    bool configure(Backend backend, int interruptFlags = 0);
+
+    /**
+     * @brief Gets the selected backend.
+     */
+    Backend getBackend() const;
+
+    /**
+     * @brief Installs the selected backend on the calling core; later calls do nothing.
+     * @return true if the backend is installed.
+     */
+    bool install();
+
+    /**
+     * @brief Sets the interrupt type of a pin and records whether the shared ISR clears it
+     * before (edge) or after (level) the handler.
+     * @param pin Pin to configure
+     * @param type GPIO_INTR_* trigger
+     */
+    bool setInterruptType(gpio_num_t pin, gpio_int_type_t type);
+
+    /**
+     * @brief Attaches a handler to a pin, installing the backend if needed.
+     * @param pin Pin whose interrupt calls the handler
+     * @param handler Function called in interrupt context
+     * @param arg Passed to the handler unchanged
+     */
+    bool add(gpio_num_t pin, gpio_isr_t handler, void* arg);
+
+    /**
+     * @brief Detaches the handler of a pin.
+     */
+    bool remove(gpio_num_t pin);
+
+    /**
+     * @brief Gets the number of interrupts raised by a pin (Shared backend only).
+     */
+    esperto::uint32 getInterruptCount(gpio_num_t pin) const;
+
+    /**
+     * @brief Resets the per-pin interrupt counters.
+     */
+    void resetInterruptCounts();
+
+    /**
+     * @brief Gets the shared ISR counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct Entry {
+        volatile gpio_isr_t handler;
+        void* volatile arg;
+    };
+
+    GpioIsrRouter();
+
+    Backend m_backend;
+    int m_interruptFlags;
+    bool m_installed;
+    gpio_isr_handle_t m_handle;
+    portMUX_TYPE m_lock;
+    // Lives in .bss, which is internal DRAM: safe to read while the flash cache is disabled
+    Entry m_table[GPIO_NUM_MAX];
+    esperto::uint32 m_counts[GPIO_NUM_MAX];
+    volatile esperto::uint64 m_clearOnEntry;   ///< Edge-triggered pins, one bit per pin
+    Statistics m_stats;                        ///< Guarded by m_lock, in the ISR too
+
+    static void IRAM_ATTR sharedIsr(void* arg);
+    void IRAM_ATTR walk(esperto::uint32 status, esperto::uint32 base, Statistics& pass);
+    static void IRAM_ATTR clearStatus(esperto::uint32 bit, esperto::uint32 base);
+};
+
+} // namespace esperto
@@ -0,0 +1,205 @@
+// logic_capture.hpp
+// Multi-pin edge capture on the RMT receive peripheral (logic analyzer mode)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "future.hpp"
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <esp_attr.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/rmt_rx.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Records fast digital signals on a set of pins for protocol decoding.
+ *
+ * Each pin gets an RMT RX channel, which timestamps edges in hardware at the configured
+ * resolution and writes them as (level, duration) symbols straight into a buffer from a
+ * fixed pool. A filled buffer is handed to the consumer by pointer and comes back to the
+ * pool on release(); nothing is copied. Until the trigger fires, filled buffers go to a
+ * circular pre-trigger queue whose oldest entry is recycled, so the consumer also receives
+ * the activity that led to the trigger.
+ *
+ * A capture frame ends when the line has been idle for idleThresholdNs; the channel then
+ * restarts on the next free buffer. Edges that arrive while no buffer is free are lost and
+ * counted as overruns.
+ */
+class LogicCapture : public Object {
+public:
+    /**
+     * @brief Condition that starts delivering buffers.
+     *
+     * A level held for idleThresholdNs ends the frame, so its duration is only known to be at
+     * least the idle threshold: a level the line rests at matches when minDurationNs is not
+     * above idleThresholdNs, and never matches otherwise.
+     */
+    struct Trigger {
+        esperto::int32 pinIndex = -1;        ///< Pin (index in the pin list) to watch; -1 triggers at start
+        esperto::uint32 level = 0;           ///< Level to look for
+        esperto::uint32 minDurationNs = 0;   ///< The level must be held at least this long
+    };
+
+    /**
+     * @brief Capture configuration.
+     */
+    struct Config {
+        esperto::uint32 resolutionHz = 10000000;          ///< Tick rate (100 ns per tick by default)
+        esperto::uint32 memorySymbols = 64;               ///< RMT channel memory, in symbols
+        bool useDma = false;                              ///< Stream through DMA (targets with RMT DMA only)
+        esperto::uint32 symbolsPerBuffer = 256;           ///< Buffer size, in symbols
+        esperto::uint32 buffersPerPin = 4;                ///< Buffers in each pin's pool (at least 2)
+        esperto::uint32 preTriggerBuffers = 2;            ///< Buffers kept from before the trigger (fewer than buffersPerPin)
+        esperto::uint32 idleThresholdNs = 1000000;        ///< Idle time that ends a frame (at most 32767 ticks)
+        esperto::uint32 glitchFilterNs = 0;               ///< Pulses shorter than this are ignored (0 = off)
+        Trigger trigger;                                  ///< Start condition
+        esperto::uint32 stackSize = 4096;                 ///< Capture task stack size in words
+        UBaseType_t priority = configMAX_PRIORITIES - 4;  ///< Capture task priority
+    };
+
+    /**
+     * @brief A filled buffer on loan to the consumer until release().
+     */
+    struct Buffer {
+        esperto::uint32 pinIndex = 0;                ///< Index of the pin in the pin list
+        gpio_num_t pin = GPIO_NUM_NC;                ///< Pin the symbols were captured on
+        const rmt_symbol_word_t* symbols = nullptr;  ///< Captured symbols; a zero duration ends the frame
+        size_t count = 0;                            ///< Symbols in the buffer
+        esperto::int64 timestampUs = 0;              ///< esp_timer time at the end of the frame
+        esperto::uint32 slot = 0;                    ///< Pool slot, used by release()
+    };
+
+    /**
+     * @brief Capture counters.
+     */
+    struct Statistics {
+        bool triggered = false;          ///< The trigger has fired
+        esperto::uint64 frames = 0;      ///< Buffers filled by the hardware
+        esperto::uint64 delivered = 0;   ///< Buffers handed to the consumer
+        esperto::uint64 recycled = 0;    ///< Pre-trigger buffers overwritten before the trigger
+        esperto::uint64 overruns = 0;    ///< Times a channel stopped for lack of a free buffer
+    };
+
+    /**
+     * @brief Creates a capture (does not touch the hardware).
+     * @param pins Pins to record; one RMT RX channel each.
+     * @param config Resolution, buffers and trigger.
+     */
+    LogicCapture(const std::vector<gpio_num_t>& pins, const Config& config);
+
+    /**
+     * @brief Stops the capture and frees the buffers.
+     */
+    ~LogicCapture() override;
+
+    LogicCapture(const LogicCapture&) = delete;
+    LogicCapture& operator=(const LogicCapture&) = delete;
+
+    /**
+     * @brief Allocates the channels and the buffer pool and starts recording.
+     * @return false if a channel or the DMA-capable memory is not available.
+     */
+    bool start();
+
+    /**
+     * @brief Stops recording and releases the channels. Buffers still on loan become invalid,
+     * and consumers waiting in take() return false.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the capture is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Waits for the next filled buffer, in the order the frames ended.
+     * @param buffer Receives the buffer on success.
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return false on timeout, or if the capture is not running or stops while waiting.
+     */
+    bool take(Buffer& buffer, esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Returns a buffer obtained from take() to its pool.
+     */
+    void release(const Buffer& buffer);
+
+    /**
+     * @brief Converts a symbol duration to nanoseconds.
+     */
+    esperto::uint32 ticksToNs(esperto::uint32 ticks) const;
+
+    /**
+     * @brief Gets the capture counters.
+     */
+    Statistics getStatistics() const;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+private:
+    enum class EventType : esperto::uint8 {
+        Filled,    ///< The hardware finished a frame
+        Released,  ///< The consumer returned a buffer
+        Stop
+    };
+
+    struct Event {
+        EventType type;
+        esperto::uint32 slot;
+        esperto::uint32 count;
+        esperto::int64 timestampUs;
+    };
+
+    struct Channel {
+        LogicCapture* owner;
+        esperto::uint32 index;
+        rmt_channel_handle_t handle;
+        esperto::uint32 activeSlot;      ///< Slot being filled, NoSlot when stalled
+        std::vector<esperto::uint32> freeSlots;
+    };
+
+    static constexpr esperto::uint32 NoSlot = 0xFFFFFFFF;
+
+    std::vector<gpio_num_t> m_pins;
+    Config m_config;
+    std::vector<Channel> m_channels;
+    rmt_symbol_word_t* m_pool;                ///< buffersPerPin * symbolsPerBuffer symbols per pin
+    std::deque<Event> m_preTrigger;
+    QueueHandle_t m_events;                   ///< ISR and consumer to capture task
+    QueueHandle_t m_ready;                    ///< Capture task to consumer
+    TaskHandle_t m_handle;
+    SemaphoreHandle_t m_exited;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_triggered;
+    std::atomic<esperto::uint64> m_frames;
+    std::atomic<esperto::uint64> m_delivered;
+    std::atomic<esperto::uint64> m_recycled;
+    std::atomic<esperto::uint64> m_overruns;
+
+    static bool IRAM_ATTR onReceiveDone(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* data, void* context);
+    static void captureEntryPoint(void* param);
+    void captureLoop();
+    void arm(Channel& channel);
+    void recycle(esperto::uint32 slot);
+    void deliver(const Event& event);
+    bool matchesTrigger(const Event& event) const;
+    rmt_symbol_word_t* slotSymbols(esperto::uint32 slot) const;
+    void releaseChannels();
+    void releaseQueues();
+};
+
+} // namespace esperto
@@ -0,0 +1,263 @@
+// mqtt_client.hpp
+// Batched MQTT 3.1.1 publisher with a QoS1 window and an offline spool
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "future.hpp"
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "sdkconfig.h"
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+}
+
+namespace esperto {
+
+#if !CONFIG_IDF_TARGET_LINUX
+class WiFi;
+#endif
+
+/**
+ * @brief MQTT 3.1.1 client that publishes from its own task.
+ *
+ * publish() copies the message into a queue and returns. The client task packs queued
+ * messages back to back into one TCP write of up to batchBytes, waiting at most
+ * batchDelayMs for a partial batch to fill, so a burst of small messages costs a few
+ * writes instead of one round trip each. Up to maxInFlight QoS1 messages may await their
+ * PUBACK; once the window is full, messages wait in the queue and publish() applies
+ * backpressure. Unacknowledged messages are sent again with the DUP flag after
+ * ackTimeoutMs and after a reconnect.
+ *
+ * While the broker is unreachable, queued messages are appended to a spool file (for
+ * example on LittleFS, mounted by the application) and sent in order once the client is
+ * connected again; until the spool is empty, new QoS1 messages go through it too so their
+ * order is kept, while QoS0 messages are sent at once. Delivered records at the head of
+ * the file are cut off when it reaches spoolMaxBytes. The spool survives a reboot.
+ *
+ * The transport is a BSD socket, so the client also runs on the ESP-IDF linux target
+ * against a broker on the host, such as mosquitto on 127.0.0.1:1883.
+ */
+class MqttClient : public Object {
+public:
+    /**
+     * @brief Delivery guarantee of a message.
+     */
+    enum class QoS : esperto::uint8 {
+        AtMostOnce = 0,
+        AtLeastOnce = 1
+    };
+
+    /**
+     * @brief Client configuration.
+     */
+    struct Config {
+        esperto::string host = "127.0.0.1";          ///< Broker host name or IPv4 address
+        esperto::uint16 port = 1883;                 ///< Broker port
+        esperto::string clientId = "esperto";
+        esperto::string username;                    ///< Empty to omit
+        esperto::string password;                    ///< Empty to omit
+        esperto::uint16 keepAliveSec = 60;
+        bool cleanSession = true;
+        esperto::uint32 queueLength = 64;            ///< Messages waiting for the client task
+        esperto::uint32 maxInFlight = 16;            ///< QoS1 messages awaiting PUBACK
+        esperto::uint32 batchBytes = 1460;           ///< Largest write; one message larger than this is sent alone
+        esperto::uint32 batchDelayMs = 2;            ///< Wait for more messages before writing a partial batch
+        esperto::uint32 pollMs = 5;                  ///< Acknowledgement polling period while messages are in flight
+        esperto::uint32 ackTimeoutMs = 10000;        ///< Resend an unacknowledged QoS1 message after this
+        esperto::uint32 connectTimeoutMs = 5000;
+        esperto::uint32 reconnectMinMs = 1000;       ///< First reconnect delay, doubled up to reconnectMaxMs
+        esperto::uint32 reconnectMaxMs = 30000;
+        esperto::string spoolPath;                   ///< Offline spool file, e.g. "/littlefs/mqtt.spool"; empty keeps messages in the queue
+        esperto::uint32 spoolMaxBytes = 65536;       ///< Undelivered spooled bytes; messages beyond this are dropped
+        bool spoolQos0 = false;                      ///< Spool QoS0 messages too instead of dropping them while offline
+        esperto::uint32 stackSize = 6144;            ///< Client task stack size in words
+        UBaseType_t priority = 5;                    ///< Client task priority
+    };
+
+    /**
+     * @brief Client counters.
+     */
+    struct Statistics {
+        esperto::uint64 published = 0;     ///< Messages written to the broker, retransmissions excluded
+        esperto::uint64 writes = 0;        ///< TCP writes; published / writes is the batching factor
+        esperto::uint64 bytesSent = 0;
+        esperto::uint64 acknowledged = 0;  ///< QoS1 messages acknowledged by the broker
+        esperto::uint32 retransmits = 0;   ///< QoS1 messages sent again with DUP
+        esperto::uint64 spooled = 0;       ///< Messages written to the spool
+        esperto::uint64 unspooled = 0;     ///< Messages read back from the spool
+        esperto::uint32 dropped = 0;       ///< Messages lost: queue full, spool full, or QoS0 while offline
+        esperto::uint32 connects = 0;      ///< Successful CONNECT handshakes
+        esperto::uint32 inFlight = 0;      ///< QoS1 messages awaiting PUBACK
+        esperto::uint32 spoolBytes = 0;    ///< Spool file size
+    };
+
+    explicit MqttClient(const Config& config);
+
+    /**
+     * @brief Stops the client task.
+     */
+    ~MqttClient() override;
+
+    MqttClient(const MqttClient&) = delete;
+    MqttClient& operator=(const MqttClient&) = delete;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Starts the client task, which connects and reconnects on its own.
+     */
+    bool start();
+
+    /**
+     * @brief Disconnects and stops the client task. Messages still queued are dropped;
+     * spooled ones stay in the spool file.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the client task is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Checks if the broker accepted the connection and it is still up.
+     */
+    bool isConnected() const;
+
+#if !CONFIG_IDF_TARGET_LINUX
+    /**
+     * @brief Follows the station state: connects as soon as WiFi gets an IP address instead
+     * of waiting for the reconnect delay, and spools while WiFi is down.
+     */
+    void bindWiFi(WiFi& wifi);
+#endif
+
+    /**
+     * @brief Queues a message.
+     * @param timeoutMs Maximum wait for queue space in milliseconds.
+     * @return false if the queue stayed full or the client is not running.
+     */
+    bool publish(const esperto::string& topic, const void* payload, size_t length,
+                 QoS qos = QoS::AtMostOnce, bool retain = false, esperto::uint32 timeoutMs = 0);
+
+    /**
+     * @brief Queues a message with a text payload.
+     */
+    bool publish(const esperto::string& topic, const esperto::string& payload,
+                 QoS qos = QoS::AtMostOnce, bool retain = false, esperto::uint32 timeoutMs = 0);
+
+    /**
+     * @brief Waits until every message published so far has been written (QoS0) or
+     * acknowledged (QoS1), including the ones passing through the spool.
+     * @return false on timeout.
+     */
+    bool flush(esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Gets the client counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct Message {
+        esperto::string topic;
+        std::vector<esperto::uint8> payload;
+        esperto::uint8 qos = 0;
+        bool retain = false;
+        bool spooled = false;        ///< Read back from the spool
+        esperto::uint32 spoolOffset = 0;   ///< Position of its record in the spool file
+        esperto::uint16 packetId = 0;
+        esperto::int64 sentUs = 0;   ///< Last transmission, 0 to send again at once
+    };
+
+    // Statistics kept as atomics: the client task counts, getStatistics() reads from any task
+    struct Counters {
+        std::atomic<esperto::uint64> published{0};
+        std::atomic<esperto::uint64> writes{0};
+        std::atomic<esperto::uint64> bytesSent{0};
+        std::atomic<esperto::uint64> acknowledged{0};
+        std::atomic<esperto::uint32> retransmits{0};
+        std::atomic<esperto::uint64> spooled{0};
+        std::atomic<esperto::uint64> unspooled{0};
+        std::atomic<esperto::uint32> dropped{0};
+        std::atomic<esperto::uint32> connects{0};
+        std::atomic<esperto::uint32> inFlight{0};
+    };
+
+    Config m_config;
+    QueueHandle_t m_queue;                 ///< Message*; nullptr only wakes the task
+    TaskHandle_t m_handle;
+    SemaphoreHandle_t m_exited;
+    EventGroupHandle_t m_events;           ///< DrainedBit: nothing was left outstanding or spooled
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_connected;
+    std::atomic<bool> m_networkUp;
+    std::atomic<bool> m_connectNow;        ///< Skip the reconnect delay once
+    std::atomic<esperto::uint32> m_outstanding;   ///< Published messages neither done nor in the spool
+    std::atomic<esperto::uint32> m_rejected;      ///< publish() calls that found the queue full
+    std::atomic<esperto::uint32> m_spoolSize;     ///< Spool file size, 0 once fully delivered
+    Counters m_stats;
+    int m_socket;
+    esperto::uint16 m_nextPacketId;
+    std::deque<Message*> m_inFlight;       ///< QoS1 awaiting PUBACK, oldest first
+    Message* m_carry;                      ///< Did not fit in the last batch; goes first in the next
+    std::vector<esperto::uint8> m_batch;   ///< Packets for the next write
+    std::vector<Message*> m_batchMessages; ///< QoS0 messages in m_batch, done once it is written
+    esperto::uint32 m_batchPublished;      ///< First transmissions in m_batch
+    std::vector<esperto::uint8> m_rx;      ///< Received bytes not yet parsed
+    esperto::int64 m_lastSendUs;
+    esperto::int64 m_pingSentUs;           ///< 0 when no PINGRESP is pending
+    esperto::uint32 m_reconnectDelayMs;
+    esperto::int64 m_nextConnectUs;
+    esperto::uint32 m_spoolReadOffset;
+    esperto::uint32 m_spoolUnacked;        ///< Read back from the spool and not done yet
+    FILE* m_spoolFile;                     ///< Spool read and appended through one handle, opened on first use
+    bool m_spoolAppended;                  ///< Last spool access was a write; the next read seeks first
+#if !CONFIG_IDF_TARGET_LINUX
+    WiFi* m_wifi;
+    esperto::uint32 m_wifiSubscription;
+#endif
+
+    static void taskEntryPoint(void* param);
+    void run();
+    void runConnected();
+    void runOffline();
+    bool connectBroker();
+    void disconnectBroker();
+    void scheduleReconnect();
+    bool receivePackets(esperto::uint32 waitMs);
+    void handlePacket(esperto::uint8 header, const esperto::uint8* body, size_t length);
+    bool retransmitExpired();
+    bool fillBatch();
+    Message* nextMessage(TickType_t wait);
+    bool appendMessage(Message* message, bool duplicate);
+    bool writeBatch();
+    bool sendAll(const esperto::uint8* data, size_t length);
+    bool keepAlive();
+    void complete(Message* message);
+    void signalDrained();
+    void spoolOrDrop(Message* message);
+    bool spoolAppend(const Message& message);
+    Message* spoolRead();
+    FILE* spoolOpen();
+    void spoolClose();
+    esperto::uint32 spoolDelivered() const;
+    bool spoolCompact();
+    void spoolTrim();
+    void spoolDiscard();
+    void wake();
+};
+
+} // namespace esperto
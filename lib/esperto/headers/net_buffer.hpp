@@ -0,0 +1,236 @@
+// net_buffer.hpp
+// Zero-copy network buffers over lwIP pbuf chains
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <cstddef>
+extern "C" {
+#include "lwip/pbuf.h"
+#include "lwip/ip_addr.h"
+#include "lwip/priv/tcpip_priv.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief IPv4 address and port.
+ */
+struct NetEndpoint {
+    esperto::uint32 address = 0;   ///< IPv4 address in network byte order (as in ip4_addr_t)
+    esperto::uint16 port = 0;      ///< Port in host byte order
+
+    /**
+     * @brief Parses a dotted IPv4 address.
+     * @return false if the address is not a valid IPv4 address.
+     */
+    static bool parse(const esperto::string& address, esperto::uint16 port, NetEndpoint& endpoint);
+
+    bool operator==(const NetEndpoint& other) const {
+        return address == other.address && port == other.port;
+    }
+};
+
+/**
+ * @brief One contiguous piece of a buffer chain.
+ */
+struct NetSegment {
+    const esperto::uint8* data;
+    size_t length;
+};
+
+/**
+ * @brief Received data, kept in the lwIP pbuf chain it arrived in.
+ *
+ * Segments point into the pbufs that lwIP filled, so reading them copies nothing; they
+ * remain valid until the buffer is released, reassigned or destroyed. A datagram or TCP
+ * read may span several segments. Move-only.
+ */
+class NetBuffer : public Object {
+public:
+    NetBuffer();
+
+    /**
+     * @brief Takes ownership of a pbuf chain (one reference).
+     */
+    explicit NetBuffer(struct pbuf* chain);
+
+    /**
+     * @brief Frees the chain.
+     */
+    ~NetBuffer() override;
+
+    NetBuffer(NetBuffer&& other) noexcept;
+    NetBuffer& operator=(NetBuffer&& other) noexcept;
+    NetBuffer(const NetBuffer&) = delete;
+    NetBuffer& operator=(const NetBuffer&) = delete;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Gets the total number of bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if the buffer holds no chain.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Gets the number of non-empty segments.
+     */
+    esperto::uint32 segmentCount() const;
+
+    /**
+     * @brief Gets a segment by index (walks the chain).
+     * @return An empty segment if the index is out of range.
+     */
+    NetSegment segment(esperto::uint32 index) const;
+
+    /**
+     * @brief Calls fn(const NetSegment&) for each non-empty segment, in order.
+     */
+    template <typename Fn>
+    void forEachSegment(Fn fn) const {
+        for (const struct pbuf* p = m_chain; p; p = p->next) {
+            if (p->len != 0) {
+                fn(NetSegment{static_cast<const esperto::uint8*>(p->payload), p->len});
+            }
+        }
+    }
+
+    /**
+     * @brief Copies bytes out of the chain, for callers that need them contiguous.
+     * @return Number of bytes copied.
+     */
+    size_t copyTo(void* destination, size_t length, size_t offset = 0) const;
+
+    /**
+     * @brief Frees the chain now.
+     */
+    void release();
+
+    /**
+     * @brief Gives up ownership of the chain; the caller must pbuf_free() it.
+     */
+    struct pbuf* detach();
+
+private:
+    struct pbuf* m_chain;
+};
+
+/**
+ * @brief Reference-counted transmit payload.
+ *
+ * Sockets hand the payload memory to lwIP by reference instead of copying it. lwIP holds a
+ * reference for as long as it may still read the memory (until a UDP datagram is passed
+ * to the driver, or until TCP data is acknowledged), so the memory is released - freed,
+ * or handed back through the release callback - only when the application and lwIP are
+ * both done with it. The contents must not change while a send is in progress.
+ */
+class NetPayload : public Object {
+public:
+    using ReleaseCallback = void (*)(void* data, void* context);
+
+    NetPayload();
+
+    /**
+     * @brief Allocates a payload on the heap, freed with the last reference.
+     * @return An invalid payload if memory is exhausted.
+     */
+    static NetPayload allocate(size_t length);
+
+    /**
+     * @brief Wraps memory owned by the caller.
+     * @param release Called (from any task, including the lwIP thread) with the last reference
+     * dropped; nullptr when the memory outlives every send, such as a static buffer.
+     */
+    static NetPayload wrap(const void* data, size_t length, ReleaseCallback release = nullptr, void* context = nullptr);
+
+    NetPayload(const NetPayload& other);
+    NetPayload& operator=(const NetPayload& other);
+    NetPayload(NetPayload&& other) noexcept;
+    NetPayload& operator=(NetPayload&& other) noexcept;
+    ~NetPayload() override;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Gets the payload memory.
+     */
+    esperto::uint8* data() const;
+
+    /**
+     * @brief Gets the payload length in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if the payload refers to memory.
+     */
+    bool valid() const;
+
+    /**
+     * @brief Gets the number of references, lwIP's included.
+     */
+    esperto::uint32 useCount() const;
+
+    /**
+     * @brief Creates a PBUF_REF pbuf over part of the payload that holds a reference until
+     * lwIP frees it.
+     * @return nullptr if out of memory or the range is empty or longer than 65535 bytes.
+     */
+    struct pbuf* toPbuf(size_t offset = 0, size_t length = SIZE_MAX) const;
+
+private:
+    struct Control {
+        std::atomic<esperto::uint32> references;
+        esperto::uint8* data;
+        size_t length;
+        ReleaseCallback release;
+        void* context;
+        bool owned;   ///< data was allocated by allocate()
+    };
+
+    // pbuf_custom must come first: lwIP hands the pbuf back to the free function
+    struct RefPbuf {
+        struct pbuf_custom custom;
+        Control* control;
+    };
+
+    Control* m_control;
+
+    explicit NetPayload(Control* control);
+    static void acquire(Control* control);
+    static void drop(Control* control);
+    static void freeRefPbuf(struct pbuf* p);
+};
+
+/**
+ * @brief Runs fn() on the lwIP tcpip thread and waits for it to return.
+ *
+ * The lwIP raw API (udp_*, tcp_*) is not thread-safe and must only be called there; fn
+ * returns the err_t handed back to the caller.
+ */
+template <typename Fn>
+err_t tcpipCall(Fn fn) {
+    struct Call {
+        struct tcpip_api_call_data base;   ///< Must come first: lwIP passes it back
+        Fn* fn;
+    };
+
+    Call call = {};
+    call.fn = &fn;
+    return tcpip_api_call([](struct tcpip_api_call_data* data) -> err_t {
+        return (*reinterpret_cast<Call*>(data)->fn)();
+    }, &call.base);
+}
+
+} // namespace esperto
@@ -0,0 +1,159 @@
+// ota_updater.hpp
+// Streaming HTTP(S) firmware update with overlapped download and flash writes
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_http_client.h"
+#include "esp_ota_ops.h"
+}
+
+struct tinfl_decompressor_tag;
+
+namespace esperto {
+
+/**
+ * @brief Downloads a firmware image into the next OTA partition.
+ *
+ * update() downloads on the calling task into one of two buffers while a writer task
+ * takes the other one, inflates it if the image is compressed and passes it to
+ * esp_ota_write, so the network transfer and the flash erase/write overlap instead of
+ * taking turns. The statistics tell which side was the bottleneck: flashWaitMs grows when
+ * the download waited for a free buffer, networkWaitMs when the writer waited for data.
+ *
+ * Images may be served raw or zlib-compressed (see scripts/ota/compress_image.py); with
+ * Compression::Auto the first byte decides (0xE9 is an app image, 0x78 a zlib stream).
+ * Compressed images are inflated with the ROM miniz decoder; the transfer shrinks by the
+ * compression ratio while the flash writes stay the same.
+ *
+ * When the connection drops, the download resumes where it stopped with an HTTP Range
+ * request (If-Range with the ETag, when the server sent one, guards against a changed
+ * file). A server that answers the resumed request with the whole file restarts the image.
+ */
+class OtaUpdater : public Object {
+public:
+    enum class State : esperto::uint8 {
+        Idle,
+        Downloading,
+        Done,          ///< Image written and verified; boot partition set if configured
+        Failed
+    };
+
+    enum class Compression : esperto::uint8 {
+        Auto,
+        None,
+        Zlib
+    };
+
+    /**
+     * @brief Updater configuration.
+     */
+    struct Config {
+        esperto::string url;
+        const char* certPem = nullptr;            ///< Server CA; nullptr uses the certificate bundle when enabled
+        size_t bufferSize = 16384;                ///< Size of each of the two pipeline buffers
+        esperto::uint32 timeoutMs = 10000;        ///< Network timeout per request and read
+        esperto::uint32 maxResumes = 5;           ///< Range requests after dropped connections before giving up
+        esperto::uint32 retryDelayMs = 1000;      ///< Wait before each resume
+        Compression compression = Compression::Auto;
+        esperto::uint32 writerStackSize = 4096;   ///< Writer task stack size in words
+        UBaseType_t writerPriority = 5;
+        BaseType_t writerCore = tskNO_AFFINITY;   ///< On dual-core chips core 1 keeps flash writes away from WiFi
+        bool setBootPartition = true;             ///< Boot the new image on the next restart
+    };
+
+    /**
+     * @brief Update counters.
+     */
+    struct Statistics {
+        esperto::uint64 downloadedBytes = 0;   ///< Bytes received, compressed if the image is
+        esperto::uint64 totalBytes = 0;        ///< Size of the served file, 0 if unknown
+        esperto::uint64 imageBytes = 0;        ///< Bytes written to flash
+        esperto::uint32 resumes = 0;           ///< Range requests after dropped connections
+        esperto::uint32 restarts = 0;          ///< Resumes the server answered with the whole file
+        bool compressed = false;
+        esperto::uint32 elapsedMs = 0;
+        esperto::uint32 flashWaitMs = 0;       ///< Download waited for the writer
+        esperto::uint32 networkWaitMs = 0;     ///< Writer waited for the download
+    };
+
+    explicit OtaUpdater(const Config& config);
+
+    ~OtaUpdater() override;
+
+    OtaUpdater(const OtaUpdater&) = delete;
+    OtaUpdater& operator=(const OtaUpdater&) = delete;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Downloads, writes and verifies the image; blocks until done.
+     * @return true if the image is valid (and set as boot partition when configured).
+     * The caller restarts the chip to run it.
+     */
+    bool update();
+
+    /**
+     * @brief Gets the update state.
+     */
+    State getState() const;
+
+    /**
+     * @brief Gets the update counters; may be called while update() runs.
+     */
+    Statistics getStatistics() const;
+
+private:
+    // Pipeline buffer passed between the download and the writer
+    struct Chunk {
+        esperto::uint8* data;
+        size_t length;
+        esperto::uint8 flags;
+    };
+
+    Config m_config;
+    std::atomic<State> m_state;
+    Statistics m_stats;
+    QueueHandle_t m_free;          ///< Buffers the download may fill
+    QueueHandle_t m_filled;        ///< Buffers waiting for the writer
+    SemaphoreHandle_t m_writerDone;
+    esperto::uint8* m_buffers[2];
+    const esp_partition_t* m_partition;
+    esp_ota_handle_t m_handle;
+    bool m_imageOpen;
+    std::atomic<bool> m_writerFailed;
+    bool m_writerResult;
+    esperto::string m_etag;        ///< Response header, captured by the HTTP event handler
+    bool m_zlib;
+    bool m_formatKnown;
+    bool m_inflateDone;
+    struct tinfl_decompressor_tag* m_inflator;
+    esperto::uint8* m_dictionary;  ///< Inflate window, written to flash as it fills
+    size_t m_dictionaryOffset;
+
+    static esp_err_t httpEvent(esp_http_client_event_t* event);
+    static void writerEntryPoint(void* param);
+    bool download();
+    bool streamBody(esp_http_client_handle_t client, bool restartImage);
+    bool takeBuffer(Chunk& chunk);
+    void pushBuffer(Chunk& chunk);
+    void writerLoop();
+    bool openImage();
+    bool writeImage(const esperto::uint8* data, size_t length);
+    bool inflate(const esperto::uint8* data, size_t length);
+    bool finishImage();
+    void closeImage();
+    void releaseResources();
+};
+
+} // namespace esperto
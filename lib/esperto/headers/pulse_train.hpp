@@ -0,0 +1,105 @@
+// pulse_train.hpp
+// Hardware-timed arbitrary pulse trains on the RMT peripheral (C++/OOP)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "future.hpp"
+#include <vector>
+extern "C" {
+#include "driver/gpio.h"
+#include "driver/rmt_tx.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Plays a sequence of timed levels on a pin through an RMT TX channel.
+ *
+ * The sequence is converted once into RMT symbols; the peripheral then shifts it out
+ * with its own clock, so edges land on the resolution grid regardless of CPU load.
+ */
+class PulseTrain : public Object {
+public:
+    /**
+     * @brief One level held for a duration.
+     */
+    struct Pulse {
+        esperto::uint32 level;        ///< 0 = Low, 1 = High
+        esperto::uint32 durationUs;   ///< Time the level is held
+    };
+
+    /**
+     * @brief RMT channel configuration.
+     */
+    struct Config {
+        esperto::uint32 resolutionHz = 1000000;   ///< RMT tick rate (1 us per tick by default)
+        esperto::uint32 memorySymbols = 64;       ///< Channel memory, in symbols
+        esperto::uint32 queueDepth = 4;           ///< Transmissions queued in the driver
+        esperto::uint32 idleLevel = 0;            ///< Level after the last pulse
+    };
+
+    /**
+     * @brief Creates a pulse train output (does not touch the hardware).
+     * @param pin Output pin.
+     * @param config Resolution and channel memory.
+     */
+    PulseTrain(gpio_num_t pin, const Config& config);
+
+    /**
+     * @brief Waits for the current transmission and releases the RMT channel.
+     */
+    ~PulseTrain() override;
+
+    PulseTrain(const PulseTrain&) = delete;
+    PulseTrain& operator=(const PulseTrain&) = delete;
+
+    /**
+     * @brief Allocates and enables the RMT channel.
+     * @return false if no TX channel is free.
+     */
+    bool start();
+
+    /**
+     * @brief Waits for the current transmission and releases the RMT channel.
+     */
+    void stop();
+
+    /**
+     * @brief Starts playing a sequence; returns as soon as the hardware has it.
+     * Waits first for the previous sequence, whose symbols are being replaced.
+     * @param pulses Levels and durations; durations beyond the RMT range are split.
+     * @param loopCount 0 to play once, N to repeat N more times, -1 to repeat until stopped
+     * (repeats need hardware loop support on the target).
+     * @return false if the channel is not started or the driver rejected the sequence.
+     */
+    bool transmit(const std::vector<Pulse>& pulses, esperto::int32 loopCount = 0);
+
+    /**
+     * @brief Waits until the queued sequences have been played.
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return true if the channel is idle.
+     */
+    bool wait(esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Gets the pin driven by this output.
+     */
+    gpio_num_t getPin() const;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+private:
+    gpio_num_t m_pin;
+    Config m_config;
+    rmt_channel_handle_t m_channel;
+    rmt_encoder_handle_t m_encoder;
+    std::vector<rmt_symbol_word_t> m_symbols;
+    bool m_looping;
+};
+
+} // namespace esperto
@@ -0,0 +1,120 @@
+// pwm_output.hpp
+// Hardware PWM output on the LEDC peripheral (C++/OOP)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+extern "C" {
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Square wave with a programmable duty cycle, generated by an LEDC channel.
+ *
+ * Once started, the waveform and any fade run in hardware without CPU involvement.
+ * Channels are allocated automatically; outputs with the same frequency and resolution
+ * share one LEDC timer.
+ */
+class PwmOutput : public Object {
+public:
+    /**
+     * @brief PWM configuration.
+     */
+    struct Config {
+        esperto::uint32 frequencyHz = 5000;    ///< Output frequency
+        esperto::uint32 resolutionBits = 10;   ///< Duty resolution; lower it for high frequencies
+        float dutyPercent = 0.0f;              ///< Initial duty cycle
+        bool inverted = false;                 ///< Invert the output level
+    };
+
+    /**
+     * @brief Creates a PWM output (does not touch the hardware).
+     * @param pin Output pin.
+     * @param config Frequency, resolution and initial duty.
+     */
+    PwmOutput(gpio_num_t pin, const Config& config);
+
+    /**
+     * @brief Stops the output and releases its channel and timer.
+     */
+    ~PwmOutput() override;
+
+    PwmOutput(const PwmOutput&) = delete;
+    PwmOutput& operator=(const PwmOutput&) = delete;
+
+    /**
+     * @brief Allocates a channel and a timer and starts the waveform.
+     * @return false if no channel or timer is free, or the frequency cannot be reached
+     * at the requested resolution.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the waveform and releases the channel and timer.
+     * @param idleLevel Level the pin keeps afterwards.
+     */
+    void stop(esperto::uint32 idleLevel = 0);
+
+    /**
+     * @brief Checks if the waveform is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Sets the duty cycle, effective from the next period.
+     * @param percent Duty cycle, 0 to 100.
+     */
+    bool setDuty(float percent);
+
+    /**
+     * @brief Gets the duty cycle in percent.
+     */
+    float getDuty() const;
+
+    /**
+     * @brief Changes the frequency. The output moves to another timer if its current one
+     * is shared with other outputs.
+     * @return false if no timer can provide the frequency.
+     */
+    bool setFrequency(esperto::uint32 frequencyHz);
+
+    /**
+     * @brief Gets the configured frequency in Hz.
+     */
+    esperto::uint32 getFrequency() const;
+
+    /**
+     * @brief Fades the duty cycle linearly in hardware.
+     * @param percent Target duty cycle, 0 to 100.
+     * @param durationMs Fade duration.
+     * @param wait Block until the fade completes.
+     */
+    bool fadeTo(float percent, esperto::uint32 durationMs, bool wait = false);
+
+    /**
+     * @brief Gets the pin driven by this output.
+     */
+    gpio_num_t getPin() const;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+private:
+    gpio_num_t m_pin;
+    Config m_config;
+    ledc_channel_t m_channel;
+    ledc_timer_t m_timer;
+    bool m_running;
+
+    esperto::uint32 toDuty(float percent) const;
+    static bool acquireTimer(esperto::uint32 frequencyHz, esperto::uint32 resolutionBits, ledc_timer_t& timer);
+    static void releaseTimer(ledc_timer_t timer);
+};
+
+} // namespace esperto
@@ -0,0 +1,163 @@
+// realtime_policy.hpp
+// Rate-monotonic periodic tasks with response-time admission control
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+class Task;
+
+/**
+ * @brief Real-time policy for periodic tasks (partitioned, deadline-monotonic).
+ *
+ * Each periodic task declares a period, a relative deadline and an execution budget and
+ * is pinned to one core. Priorities inside a reserved band are assigned by deadline
+ * (rate-monotonic when deadline equals period), and a new task is admitted only if the
+ * worst-case response time of every task on its core still meets its deadline.
+ * At runtime each job is timed against its budget and deadline.
+ */
+class RealtimePolicy : public Object {
+public:
+    using Job = std::function<void()>;
+
+    /**
+     * @brief Policy configuration.
+     */
+    struct Config {
+        UBaseType_t lowestPriority = configMAX_PRIORITIES - 11;   ///< Bottom of the real-time band
+        UBaseType_t highestPriority = configMAX_PRIORITIES - 4;   ///< Top of the band (below esp_timer, WiFi and IPC tasks)
+        esperto::uint32 overheadUs = 50;                          ///< Added to every budget: context switches, ticks, ISRs
+    };
+
+    /**
+     * @brief Timing parameters of a periodic task.
+     */
+    struct Parameters {
+        esperto::uint32 periodMs = 0;                   ///< Release period (a whole number of ticks)
+        esperto::uint32 deadlineMs = 0;                 ///< Relative deadline, 0 for the period; must not exceed it
+        esperto::uint32 budgetUs = 0;                   ///< Worst-case execution time of one job
+        BaseType_t core = portNUM_PROCESSORS - 1;       ///< Core the task is pinned to
+    };
+
+    /**
+     * @brief Analysis result and runtime counters of a periodic task.
+     */
+    struct TaskStatistics {
+        esperto::string name;
+        Parameters parameters;
+        UBaseType_t priority = 0;
+        esperto::uint32 responseBoundUs = 0;    ///< Worst-case response time from the admission analysis
+        esperto::uint64 jobs = 0;               ///< Completed jobs
+        esperto::uint32 deadlineMisses = 0;     ///< Jobs that finished after their deadline
+        esperto::uint32 budgetOverruns = 0;     ///< Jobs that ran longer than their budget (wall time)
+        esperto::uint32 skippedReleases = 0;    ///< Releases dropped because the previous job ran past them
+        esperto::uint32 maxExecutionUs = 0;     ///< Longest job, wall time including preemption
+        esperto::uint32 maxResponseUs = 0;      ///< Longest release-to-completion time
+    };
+
+    /**
+     * @brief Policy-wide counters.
+     */
+    struct Statistics {
+        esperto::uint32 admitted = 0;
+        esperto::uint32 rejected = 0;
+        float utilization[portNUM_PROCESSORS] = {};   ///< Admitted budget / period per core
+        std::vector<TaskStatistics> tasks;
+    };
+
+    using MissHandler = std::function<void(const TaskStatistics& task)>;
+
+    /**
+     * @brief Creates the policy.
+     * @param config Priority band and overhead model.
+     */
+    explicit RealtimePolicy(const Config& config);
+
+    ~RealtimePolicy() override;
+
+    /**
+     * @brief Replaces the configuration. Only possible while no task is admitted.
+     */
+    bool configure(const Config& config);
+
+    /**
+     * @brief Checks whether a periodic task could be admitted now.
+     */
+    bool isSchedulable(const Parameters& parameters) const;
+
+    /**
+     * @brief Admits a periodic task and starts it. Priorities of the other tasks on the same
+     * core are reassigned if the new task has a shorter deadline.
+     * @param job Work done once per period.
+     * @param parameters Period, deadline, budget and core.
+     * @param name The task name.
+     * @param stackSize Stack size in words.
+     * @return The started task, or nullptr if the task set would not be schedulable or the
+     * task could not be created (nothing is admitted then).
+     */
+    std::shared_ptr<Task> startPeriodic(Job job, const Parameters& parameters, const esperto::string& name, esperto::uint32 stackSize);
+
+    /**
+     * @brief Asks a periodic task to stop after its current job; its share of the core is
+     * released when it exits.
+     * @return false if the task is not managed by the policy.
+     */
+    bool stop(const std::shared_ptr<Task>& task);
+
+    /**
+     * @brief Sets the function called, from the late task, after every deadline miss.
+     */
+    void setMissHandler(MissHandler handler);
+
+    /**
+     * @brief Gets the admission results and runtime counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct Entry {
+        esperto::string name;
+        Parameters parameters;
+        TickType_t periodTicks = 0;
+        UBaseType_t priority = 0;
+        esperto::uint32 responseBoundUs = 0;
+        std::weak_ptr<Task> task;
+        std::atomic<bool> stopping{false};
+        std::atomic<esperto::uint64> jobs{0};
+        std::atomic<esperto::uint32> deadlineMisses{0};
+        std::atomic<esperto::uint32> budgetOverruns{0};
+        std::atomic<esperto::uint32> skippedReleases{0};
+        std::atomic<esperto::uint32> maxExecutionUs{0};
+        std::atomic<esperto::uint32> maxResponseUs{0};
+    };
+
+    Config m_config;
+    std::vector<std::shared_ptr<Entry>> m_entries;
+    esperto::uint32 m_admitted;
+    esperto::uint32 m_rejected;
+    MissHandler m_missHandler;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;
+
+    bool validate(const Parameters& parameters) const;
+    bool analyze(const Entry* candidate, std::vector<Entry*>& order, std::vector<esperto::uint32>& bounds) const;
+    void runPeriodic(Entry& entry, const Job& job);
+    void retire(Entry* entry);
+    TaskStatistics snapshot(const Entry& entry) const;
+};
+
+} // namespace esperto
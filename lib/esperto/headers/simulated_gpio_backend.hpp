@@ -0,0 +1,186 @@
+// simulated_gpio_backend.hpp
+// Virtual-time GPIO simulator for host-side tests and benchmarks
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "gpio_backend.hpp"
+#include <functional>
+#include <queue>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief GpioBackend that replays scripted input edges on a virtual clock.
+ *
+ * Edges are injected with absolute virtual timestamps and played by advanceTo(), which
+ * moves the clock from event to event. An edge matching a pin's interrupt type latches
+ * that pin's interrupt status; the handler runs interruptLatencyNs later in virtual time,
+ * and further edges on the pin while its status is latched are coalesced and counted as
+ * dropped, as the hardware would. Each handler call is timed on the host clock, which is
+ * what regresses when the dispatch hot path gets slower. Output levels are recorded with
+ * their virtual time as a waveform.
+ *
+ * Handlers run on the task that calls advanceTo(); there is no real interrupt context.
+ * Level interrupt types fire once when the pin enters the level.
+ */
+class SimulatedGpioBackend : public Object, public GpioBackend {
+public:
+    /**
+     * @brief One input level change.
+     */
+    struct Edge {
+        esperto::uint64 timeNs;   ///< Absolute virtual time
+        esperto::uint32 level;    ///< New level
+    };
+
+    /**
+     * @brief One recorded output level change.
+     */
+    struct Sample {
+        esperto::uint64 timeNs;   ///< Virtual time of the change
+        gpio_num_t pin;           ///< Output pin
+        esperto::uint32 level;    ///< New level
+    };
+
+    /**
+     * @brief Simulation parameters.
+     */
+    struct Config {
+        esperto::uint32 interruptLatencyNs = 2000;   ///< Virtual time from an edge to its handler
+        esperto::uint32 cpuFrequencyMhz = 240;       ///< Converts virtual time to GpioEvent cycles
+        esperto::uint32 maxSamples = 4096;           ///< Waveform capacity; later changes are counted only
+    };
+
+    /**
+     * @brief Simulation counters.
+     */
+    struct Statistics {
+        esperto::uint64 nowNs = 0;            ///< Virtual clock
+        esperto::uint64 edges = 0;            ///< Input level changes played
+        esperto::uint64 interrupts = 0;       ///< Handler calls
+        esperto::uint64 droppedEdges = 0;     ///< Edges coalesced into an interrupt already latched
+        esperto::uint64 dispatchTotalNs = 0;  ///< Host time spent in handlers
+        esperto::uint32 dispatchMinNs = 0;    ///< Fastest handler call, host time
+        esperto::uint32 dispatchMaxNs = 0;    ///< Slowest handler call, host time
+        esperto::uint32 samplesDropped = 0;   ///< Output changes beyond maxSamples
+    };
+
+    SimulatedGpioBackend();
+    explicit SimulatedGpioBackend(const Config& config);
+
+    SimulatedGpioBackend(const SimulatedGpioBackend&) = delete;
+    SimulatedGpioBackend& operator=(const SimulatedGpioBackend&) = delete;
+
+    /**
+     * @brief Schedules input level changes on a pin.
+     * @param edges Levels with absolute virtual times (not before the current time).
+     */
+    void injectEdges(gpio_num_t pin, const std::vector<Edge>& edges);
+
+    /**
+     * @brief Schedules a square wave: count edges starting at startNs, one every halfPeriodNs,
+     * beginning with a rising edge.
+     */
+    void injectSquareWave(gpio_num_t pin, esperto::uint64 startNs, esperto::uint64 halfPeriodNs, esperto::uint32 count);
+
+    /**
+     * @brief Plays every event up to a virtual time and sets the clock to it.
+     * @return Number of handlers called.
+     */
+    esperto::uint64 advanceTo(esperto::uint64 timeNs);
+
+    /**
+     * @brief Plays every scheduled event, including the interrupts they raise; the clock
+     * stops at the last one.
+     * @return Number of handlers called.
+     */
+    esperto::uint64 runAll();
+
+    /**
+     * @brief Gets the virtual time in nanoseconds.
+     */
+    esperto::uint64 now() const;
+
+    /**
+     * @brief Gets the recorded output changes, in virtual time order.
+     */
+    std::vector<Sample> getWaveform() const;
+
+    /**
+     * @brief Clears the waveform and the counters; the clock and the pins keep their state.
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Gets the simulation counters.
+     */
+    Statistics getStatistics() const;
+
+    // GpioBackend interface
+    bool install() override;
+    bool setDirection(gpio_num_t pin, gpio_mode_t mode) override;
+    bool setLevel(gpio_num_t pin, esperto::uint32 level) override;
+    int getLevel(gpio_num_t pin) override;
+    bool setPullMode(gpio_num_t pin, gpio_pull_mode_t mode) override;
+    bool setInterruptType(gpio_num_t pin, gpio_int_type_t type) override;
+    bool enableInterrupt(gpio_num_t pin) override;
+    bool disableInterrupt(gpio_num_t pin) override;
+    bool addHandler(gpio_num_t pin, gpio_isr_t handler, void* arg) override;
+    bool removeHandler(gpio_num_t pin) override;
+    esperto::uint32 getTimestamp() override;
+
+private:
+    enum class EventType : esperto::uint8 {
+        Edge,     ///< Input level change
+        Service   ///< Latched interrupt reaches its handler
+    };
+
+    struct Event {
+        esperto::uint64 timeNs;
+        esperto::uint64 sequence;   ///< Keeps events with equal times in insertion order
+        EventType type;
+        gpio_num_t pin;
+        esperto::uint32 level;
+
+        bool operator>(const Event& other) const {
+            return timeNs != other.timeNs ? timeNs > other.timeNs : sequence > other.sequence;
+        }
+    };
+
+    struct PinState {
+        gpio_mode_t mode;
+        gpio_pull_mode_t pull;
+        gpio_int_type_t interruptType;
+        bool interruptEnabled;
+        bool latched;            ///< Interrupt status set, handler not run yet
+        esperto::uint32 input;   ///< Level applied from outside
+        esperto::uint32 output;  ///< Level driven by setLevel
+        gpio_isr_t handler;
+        void* arg;
+    };
+
+    Config m_config;
+    PinState m_pins[GPIO_NUM_MAX];
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events;
+    esperto::uint64 m_sequence;
+    esperto::uint64 m_nowNs;
+    std::vector<Sample> m_waveform;
+    Statistics m_stats;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;      ///< Pin state, queue and counters; never held while a handler runs
+
+    esperto::uint64 play(esperto::uint64 timeNs);
+    void schedule(esperto::uint64 timeNs, EventType type, gpio_num_t pin, esperto::uint32 level);
+    void applyEdge(PinState& state, gpio_num_t pin, esperto::uint32 level);
+    static esperto::uint32 padLevel(const PinState& state);
+    static bool matches(gpio_int_type_t type, esperto::uint32 previous, esperto::uint32 level);
+};
+
+} // namespace esperto
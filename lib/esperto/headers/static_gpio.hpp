@@ -0,0 +1,132 @@
+// static_gpio.hpp
+// Compile-time GPIO pin with direct register access (C++/templates)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "types.hpp"
+#include "gpio_isr_router.hpp"
+extern "C" {
+#include "driver/gpio.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief GPIO pin fixed at compile time, for bit-banging and other cycle-critical code.
+ *
+ * Unlike Gpio there is no object, vtable or stored pin: the register addresses and the
+ * bitmask are constants, and set/clear/toggle/read are force-inlined to one or two
+ * register accesses with no argument checks. Pin validity is checked by static_assert
+ * instead. Interrupt handlers are plain function pointers, so attaching one allocates
+ * nothing. Configuration still goes through the driver, as it is not on the hot path.
+ *
+ * Example: using Clock = StaticGpio<GPIO_NUM_18>; Clock::setOutput(); Clock::set();
+ */
+template <gpio_num_t Pin>
+class StaticGpio {
+    static_assert(GPIO_IS_VALID_GPIO(Pin), "StaticGpio: invalid GPIO number");
+
+public:
+    using Handler = void (*)(void* arg);
+
+    static constexpr gpio_num_t pin = Pin;
+    static constexpr esperto::uint32 mask = static_cast<esperto::uint32>(1) << (Pin % 32);
+
+    StaticGpio() = delete;
+
+#if SOC_GPIO_PIN_COUNT > 32
+    static constexpr esperto::uint32 outReg = Pin < 32 ? GPIO_OUT_REG : GPIO_OUT1_REG;
+    static constexpr esperto::uint32 setReg = Pin < 32 ? GPIO_OUT_W1TS_REG : GPIO_OUT1_W1TS_REG;
+    static constexpr esperto::uint32 clearReg = Pin < 32 ? GPIO_OUT_W1TC_REG : GPIO_OUT1_W1TC_REG;
+    static constexpr esperto::uint32 inReg = Pin < 32 ? GPIO_IN_REG : GPIO_IN1_REG;
+#else
+    static constexpr esperto::uint32 outReg = GPIO_OUT_REG;
+    static constexpr esperto::uint32 setReg = GPIO_OUT_W1TS_REG;
+    static constexpr esperto::uint32 clearReg = GPIO_OUT_W1TC_REG;
+    static constexpr esperto::uint32 inReg = GPIO_IN_REG;
+#endif
+
+    /**
+     * @brief Configures the pin as a push-pull output.
+     */
+    static bool setOutput() {
+        static_assert(GPIO_IS_VALID_OUTPUT_GPIO(Pin), "StaticGpio: pin cannot drive an output");
+        return gpio_reset_pin(Pin) == ESP_OK && gpio_set_direction(Pin, GPIO_MODE_OUTPUT) == ESP_OK;
+    }
+
+    /**
+     * @brief Configures the pin as an input.
+     * @param pullup Enable the internal pull-up resistor
+     */
+    static bool setInput(bool pullup = false) {
+        return gpio_reset_pin(Pin) == ESP_OK && gpio_set_direction(Pin, GPIO_MODE_INPUT) == ESP_OK &&
+               gpio_set_pull_mode(Pin, pullup ? GPIO_PULLUP_ONLY : GPIO_FLOATING) == ESP_OK;
+    }
+
+    /**
+     * @brief Drives the pin high (one register store).
+     */
+    __attribute__((always_inline)) static inline void set() {
+        REG_WRITE(setReg, mask);
+    }
+
+    /**
+     * @brief Drives the pin low (one register store).
+     */
+    __attribute__((always_inline)) static inline void clear() {
+        REG_WRITE(clearReg, mask);
+    }
+
+    /**
+     * @brief Drives the pin to a level.
+     * @param level 0 = Low, anything else = High
+     */
+    __attribute__((always_inline)) static inline void write(esperto::uint32 level) {
+        REG_WRITE(level ? setReg : clearReg, mask);
+    }
+
+    /**
+     * @brief Inverts the driven level (one load and one store; not atomic against an
+     * interrupt driving the same pin in between).
+     */
+    __attribute__((always_inline)) static inline void toggle() {
+        REG_WRITE((REG_READ(outReg) & mask) ? clearReg : setReg, mask);
+    }
+
+    /**
+     * @brief Reads the input level (one register load).
+     * @return 0 = Low, 1 = High
+     */
+    __attribute__((always_inline)) static inline esperto::uint32 read() {
+        return (REG_READ(inReg) >> (Pin % 32)) & 1;
+    }
+
+    /**
+     * @brief Attaches an interrupt handler through the GpioIsrRouter, installing its
+     * backend if needed.
+     * @param interruptType Type of interrupt (GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, etc.)
+     * @param handler Function called in interrupt context; it must be IRAM_ATTR
+     * @param arg Passed to the handler unchanged
+     */
+    static bool enableInterrupt(gpio_int_type_t interruptType, Handler handler, void* arg = nullptr) {
+        GpioIsrRouter& router = GpioIsrRouter::instance();
+        router.remove(Pin);
+        return router.setInterruptType(Pin, interruptType) && router.add(Pin, handler, arg);
+    }
+
+    /**
+     * @brief Detaches the interrupt handler.
+     */
+    static void disableInterrupt() {
+        GpioIsrRouter& router = GpioIsrRouter::instance();
+        router.setInterruptType(Pin, GPIO_INTR_DISABLE);
+        router.remove(Pin);
+    }
+};
+
+} // namespace esperto
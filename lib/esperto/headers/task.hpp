@@ -7,21 +7,34 @@
 
 #include "object.hpp"
 #include "types.hpp"
+#include "coroutine.hpp"
+#include "future.hpp"
+#include "task_arena.hpp"
+#include "task_statistics.hpp"
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 extern "C" {
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 }
 
 namespace esperto {
 
 /**
  * @brief Represents an asynchronous operation (C#-like Task) using FreeRTOS.
+ *
+ * Completion is signalled through an event group: waiters block until the task
+ * function returns and wake immediately, without polling the FreeRTOS task state.
  */
-class Task : public Object {
+class Task : public Object, public std::enable_shared_from_this<Task> {
 public:
     using TaskFunction = std::function<void(Task&)>;
+    using Continuation = std::function<void(Task&)>;
 
     enum class TaskState {
         Created,    ///< Task has been created but not started
@@ -45,15 +58,57 @@ public:
      */
     virtual ~Task();
 
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
     /**
      * @brief Starts the task (if not started already).
      */
     virtual void start();
 
+    /**
+     * @brief Switches the task to static allocation: its TCB and stack come from the arena
+     * and start() uses xTaskCreateStatic. Must be called before start().
+     * @param arena The arena to take the slot from.
+     * @return true if a slot with at least getStackSize() words was reserved.
+     */
+    bool useArena(TaskArena& arena);
+
+    /**
+     * @brief Checks if the task uses a statically allocated TCB and stack.
+     */
+    bool isStatic() const;
+
     /**
      * @brief Waits for the task to complete (join).
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return true if the task has completed, false on timeout or if it was never started.
+     */
+    virtual bool wait(esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Registers a continuation (C#-like ContinueWith).
+     *
+     * The continuation runs in the task's own context right after the task function
+     * returns, before waiters are released, or immediately in the caller if the task
+     * has already completed.
+     * @param continuation Function to call with the completed task.
+     */
+    void continueWith(Continuation continuation);
+
+    /**
+     * @brief Creates a future completed when every task has completed (C#-like WhenAll).
+     * @param tasks The tasks to wait for.
+     */
+    static Future<void> whenAll(const std::vector<std::shared_ptr<Task>>& tasks);
+
+    /**
+     * @brief Creates a future completed when the first task completes (C#-like WhenAny).
+     * @param tasks The tasks to wait for.
+     * @return A future holding the index of the first completed task, or NoIndex at once
+     * if there is no task to wait for.
      */
-    virtual void wait();
+    static Future<size_t> whenAny(const std::vector<std::shared_ptr<Task>>& tasks);
 
     /**
      * @brief Suspends the task.
@@ -90,6 +145,32 @@ public:
      */
     virtual UBaseType_t getPriority() const;
 
+    /**
+     * @brief Changes the task priority, immediately if the task is alive (wraps vTaskPrioritySet).
+     * @param priority New priority.
+     */
+    void setPriority(UBaseType_t priority);
+
+    /**
+     * @brief Pins the task to a core. Must be called before start().
+     * @param core Core number, or tskNO_AFFINITY to let FreeRTOS pick.
+     * @return false if the task has already started or the core does not exist.
+     */
+    bool setCoreAffinity(BaseType_t core);
+
+    /**
+     * @brief Gets the core the task is pinned to (tskNO_AFFINITY if none).
+     */
+    BaseType_t getCoreAffinity() const;
+
+    /**
+     * @brief Moves a started task to another core (wraps vTaskCoreAffinitySet). Only the SMP
+     * FreeRTOS kernel (CONFIG_FREERTOS_SMP) can change the core of a live task.
+     * @param core Core number.
+     * @return false if the task is not alive, the core does not exist or the kernel cannot migrate.
+     */
+    bool migrate(BaseType_t core);
+
     /**
      * @brief Checks if the task is currently running.
      */
@@ -100,6 +181,24 @@ public:
      */
     virtual bool isCompleted() const;
 
+    /**
+     * @brief Gets the number of times the task blocked or yielded in Task::wait,
+     * Task::delay, Task::delayTicks or Task::yield.
+     */
+    esperto::uint32 getVoluntarySwitches() const;
+
+    /**
+     * @brief Gets the wake-up-to-run latency of the task: time from a joined task's
+     * completion to this task running again, and delay overshoot past the requested ticks.
+     */
+    LatencyHistogram getLatency() const;
+
+    /**
+     * @brief Gets the Task running the calling code.
+     * @return The current Task, or nullptr in a task not created through Task.
+     */
+    static Task* current();
+
     /**
      * @brief Static method to delay the current task (wraps vTaskDelay).
      * @param delayMs Delay time in milliseconds
@@ -112,6 +211,14 @@ public:
      */
     static void delayTicks(TickType_t delayTicks);
 
+    /**
+     * @brief Awaitable delay for coroutines: co_await Task::delayAsync(ms) suspends only
+     * the calling coroutine, not the loop task running it.
+     * @param delayMs Delay time in milliseconds
+     * @return Awaiter; co_await yields false if no timer was free and nothing was delayed
+     */
+    static DelayAwaiter delayAsync(esperto::uint32 delayMs);
+
     /**
      * @brief Static method to yield the current task (wraps taskYIELD).
      */
@@ -125,10 +232,27 @@ private:
     esperto::string m_name;
     esperto::uint32 m_stackSize;
     UBaseType_t m_priority;
+    BaseType_t m_core;
     TaskHandle_t m_handle;
-    TaskState m_state;
-    
+    std::atomic<TaskState> m_state;
+    StaticEventGroup_t m_doneEventBuffer;
+    EventGroupHandle_t m_doneEvent;
+    StaticSemaphore_t m_lockBuffer;
+    SemaphoreHandle_t m_lock;
+    std::vector<Continuation> m_continuations;
+    TaskArena* m_arena;
+    TaskArena::Slot m_slot;
+    std::atomic<esperto::uint32> m_voluntarySwitches;
+    std::atomic<esperto::int64> m_completedAtUs;
+    LatencyRecorder m_latency;
+
+    static thread_local Task* s_current;
+
+    static constexpr EventBits_t DoneBit = 1 << 0;
+    static constexpr EventBits_t ArmedBit = 1 << 1;
+
     static void taskEntryPoint(void* param);
+    void complete();
     TaskState convertFreeRTOSState(eTaskState freeRTOSState) const;
 };
 
@@ -0,0 +1,204 @@
+// task_arena.hpp
+// Preallocated, size-classed stack/TCB arena for statically allocated tasks
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Fixed arena of task stacks, TCBs and Task objects, grouped in size classes.
+ *
+ * All memory is allocated once by configure(). Tasks started in static mode take the
+ * smallest free slot that fits their stack and create their FreeRTOS task with
+ * xTaskCreateStatic. A slot returns to the arena from the thread-local-storage
+ * deletion callback, i.e. only once FreeRTOS has finished with the TCB.
+ */
+class TaskArena : public Object {
+public:
+    static constexpr size_t MaxSizeClasses = 8;
+
+    /**
+     * TLS pointer index reserved for slot reclamation (index 0 belongs to pthread). Taken from
+     * the Kconfig count: with deletion callbacks IDF doubles configNUM_THREAD_LOCAL_STORAGE_POINTERS
+     * and keeps the callbacks in the upper half, so at least 2 pointers are needed.
+     */
+    static constexpr BaseType_t TlsIndex = CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS - 1;
+
+    /**
+     * @brief A group of slots sharing the same stack size.
+     */
+    struct SizeClass {
+        esperto::uint32 stackSize;  ///< Stack size in words
+        esperto::uint32 count;      ///< Number of slots
+    };
+
+    /**
+     * @brief Buffers handed to a statically allocated task.
+     */
+    struct Slot {
+        StaticTask_t* tcb = nullptr;
+        StackType_t* stack = nullptr;
+        esperto::uint32 stackSize = 0;
+        void* cookie = nullptr;  ///< Identifies the slot when it is released
+    };
+
+    /**
+     * @brief Occupancy of one size class.
+     */
+    struct ClassStatistics {
+        esperto::uint32 stackSize = 0;
+        esperto::uint32 capacity = 0;
+        esperto::uint32 inUse = 0;
+        esperto::uint32 highWater = 0;  ///< Largest inUse value observed
+    };
+
+    /**
+     * @brief Arena occupancy snapshot.
+     */
+    struct Statistics {
+        ClassStatistics classes[MaxSizeClasses];
+        size_t classCount = 0;
+        size_t totalBytes = 0;                   ///< Memory reserved by the arena
+        esperto::uint32 failedAllocations = 0;   ///< Slot requests that found no free slot
+        esperto::uint32 objectFallbacks = 0;     ///< Task objects that did not fit an object block
+    };
+
+    TaskArena();
+    ~TaskArena() override;
+
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+
+    /**
+     * @brief Allocates every slot; fails if the arena is already configured.
+     * @param classes Size classes (at most MaxSizeClasses).
+     * @return true if the arena was allocated; on failure nothing stays allocated.
+     */
+    bool configure(const std::vector<SizeClass>& classes);
+
+    /**
+     * @brief Checks if configure() succeeded.
+     */
+    bool isConfigured() const;
+
+    /**
+     * @brief Takes the smallest free slot whose stack is at least stackSize words.
+     * @param stackSize Requested stack size in words.
+     * @param slot Receives the buffers.
+     * @return true if a slot was found.
+     */
+    bool acquire(esperto::uint32 stackSize, Slot& slot);
+
+    /**
+     * @brief Returns a slot to the arena.
+     * @param cookie The cookie of the slot.
+     */
+    void release(void* cookie);
+
+    /**
+     * @brief FreeRTOS TLS deletion callback that releases the slot of a deleted task.
+     */
+    static void onTaskDeleted(int index, void* cookie);
+
+    /**
+     * @brief Allocates a block for a Task object, falling back to the heap if none fits.
+     */
+    void* allocateObject(size_t size);
+
+    /**
+     * @brief Frees a block returned by allocateObject.
+     */
+    void deallocateObject(void* pointer);
+
+    /**
+     * @brief Gets the arena occupancy.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct SlotInfo {
+        TaskArena* arena;
+        esperto::uint16 classIndex;
+        esperto::uint16 index;
+    };
+
+    struct ClassStorage {
+        esperto::uint32 stackSize = 0;
+        esperto::uint32 count = 0;
+        StaticTask_t* tcbs = nullptr;
+        StackType_t* stacks = nullptr;
+        SlotInfo* infos = nullptr;
+        esperto::uint32* usedMask = nullptr;
+        esperto::uint32 inUse = 0;
+        esperto::uint32 highWater = 0;
+    };
+
+    mutable portMUX_TYPE m_lock;
+    ClassStorage m_classes[MaxSizeClasses];
+    size_t m_classCount;
+    size_t m_totalBytes;
+    esperto::uint32 m_failedAllocations;
+    esperto::uint32 m_objectFallbacks;
+    bool m_configured;
+
+    esperto::uint8* m_objects;
+    esperto::uint32* m_objectUsedMask;
+    esperto::uint32 m_objectCount;
+    size_t m_objectBlockSize;
+
+    // Frees everything configure() allocated, also after a partial failure
+    void releaseStorage();
+    static bool takeFreeBit(esperto::uint32* mask, esperto::uint32 count, esperto::uint32& index);
+};
+
+/**
+ * @brief Standard allocator over TaskArena object blocks, for std::allocate_shared<Task>.
+ */
+template <typename T>
+class TaskArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit TaskArenaAllocator(TaskArena& arena) : m_arena(&arena) {}
+
+    template <typename U>
+    TaskArenaAllocator(const TaskArenaAllocator<U>& other) : m_arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(m_arena->allocateObject(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        m_arena->deallocateObject(pointer);
+    }
+
+    TaskArena* arena() const {
+        return m_arena;
+    }
+
+    template <typename U>
+    bool operator==(const TaskArenaAllocator<U>& other) const {
+        return m_arena == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const TaskArenaAllocator<U>& other) const {
+        return m_arena != other.arena();
+    }
+
+private:
+    TaskArena* m_arena;
+};
+
+} // namespace esperto
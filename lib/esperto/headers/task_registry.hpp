@@ -0,0 +1,182 @@
+// task_registry.hpp
+// Lock-free task registry with epoch-protected read snapshots
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace esperto {
+
+class Task;
+
+/**
+ * @brief Fixed-capacity set of tasks that any task, on any core, can use concurrently.
+ *
+ * Insert and remove are lock-free compare-and-swap operations on slots. Readers enter an
+ * epoch (two reader counters, RCU style) and walk raw Task pointers without touching
+ * the shared_ptr reference counts. A removed slot keeps its owning reference until two
+ * epoch flips have passed, so no reader can still be looking at it when it is freed.
+ */
+class TaskRegistry : public Object {
+public:
+    static constexpr size_t DefaultCapacity = 64;
+
+    /**
+     * @brief Read-side critical section over the registry (RCU-like snapshot).
+     *
+     * Iteration yields Task& for every task present when it is visited. Tasks stay alive
+     * for the lifetime of the snapshot. Keep snapshots short: while one is open, removed
+     * slots cannot be recycled.
+     */
+    class Snapshot {
+    public:
+        class Iterator {
+        public:
+            Iterator(const TaskRegistry* registry, size_t index)
+                : m_registry(registry), m_index(index), m_task(nullptr) { skipEmpty(); }
+            Task& operator*() const { return *m_task; }
+            Task* operator->() const { return m_task; }
+            Iterator& operator++() { ++m_index; skipEmpty(); return *this; }
+            bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+            bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+        private:
+            // Loads each slot once: a concurrent remove may clear it right after
+            void skipEmpty() {
+                m_task = nullptr;
+                while (m_index < m_registry->m_capacity &&
+                       !(m_task = m_registry->m_slots[m_index].task.load(std::memory_order_acquire))) {
+                    ++m_index;
+                }
+            }
+
+            const TaskRegistry* m_registry;
+            size_t m_index;
+            Task* m_task;   ///< Task of the current slot, kept alive by the snapshot
+        };
+
+        explicit Snapshot(const TaskRegistry& registry) : m_registry(&registry), m_epoch(registry.enterRead()) {}
+        Snapshot(Snapshot&& other) noexcept : m_registry(other.m_registry), m_epoch(other.m_epoch) { other.m_registry = nullptr; }
+        ~Snapshot() { if (m_registry) m_registry->exitRead(m_epoch); }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+
+        Iterator begin() const { return Iterator(m_registry, 0); }
+        Iterator end() const { return Iterator(m_registry, m_registry->m_capacity); }
+
+    private:
+        const TaskRegistry* m_registry;
+        esperto::uint32 m_epoch;
+    };
+
+    /**
+     * @brief Creates a registry with a fixed number of slots.
+     * @param capacity Maximum number of tasks.
+     */
+    explicit TaskRegistry(size_t capacity = DefaultCapacity);
+
+    /**
+     * @brief Reallocates the slots with a new capacity. Not safe against concurrent use:
+     * only possible while the registry is empty, before any task uses it.
+     * @param capacity Maximum number of tasks.
+     * @return true if applied.
+     */
+    bool setCapacity(size_t capacity);
+
+    /**
+     * @brief Adds a task.
+     * @return false if every slot is taken.
+     */
+    bool insert(const std::shared_ptr<Task>& task);
+
+    /**
+     * @brief Removes a task.
+     * @return false if the task was not registered.
+     */
+    bool remove(const std::shared_ptr<Task>& task);
+
+    /**
+     * @brief Removes every task matching a predicate.
+     * @param predicate Called with Task&; return true to remove the task.
+     * @return Number of removed tasks.
+     */
+    template <typename Predicate>
+    size_t removeIf(Predicate predicate) {
+        size_t removed = 0;
+        {
+            Snapshot guard(*this);
+            for (size_t i = 0; i < m_capacity; ++i) {
+                Task* task = m_slots[i].task.load(std::memory_order_acquire);
+                if (task && predicate(*task) && retire(i, task)) {
+                    ++removed;
+                }
+            }
+        }
+        reclaim();
+        return removed;
+    }
+
+    /**
+     * @brief Opens a read snapshot. Iterating it costs no reference count operations.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Copies the registered tasks into owning pointers.
+     */
+    std::vector<std::shared_ptr<Task>> toVector() const;
+
+    /**
+     * @brief Gets the number of registered tasks.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the maximum number of tasks.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Releases removed tasks that no reader can still see. Never blocks.
+     */
+    void reclaim();
+
+private:
+    enum SlotState : esperto::uint32 {
+        Free,        ///< Available for insert
+        Claimed,     ///< Being filled by insert
+        Live,        ///< Visible to readers
+        Removing,    ///< Being unlinked by remove
+        Retired,     ///< Unlinked, owner kept until the grace period ends
+        Reclaiming   ///< Owner being released
+    };
+
+    struct Slot {
+        std::atomic<esperto::uint32> state{Free};
+        std::atomic<Task*> task{nullptr};
+        std::shared_ptr<Task> owner;
+        esperto::uint32 retireEpoch = 0;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_capacity;
+    std::atomic<esperto::uint32> m_epoch;
+    mutable std::atomic<esperto::uint32> m_readers[2];
+    std::atomic<size_t> m_count;
+
+    esperto::uint32 enterRead() const;
+    void exitRead(esperto::uint32 epoch) const;
+    bool retire(size_t index, Task* expected);
+    void tryAdvanceEpoch();
+};
+
+} // namespace esperto
@@ -7,8 +7,20 @@
 
 #include "object.hpp"
 #include "task.hpp"
+#include "core_balancer.hpp"
+#include "coroutine.hpp"
+#include "future.hpp"
+#include "realtime_policy.hpp"
+#include "task_arena.hpp"
+#include "task_registry.hpp"
+#include "task_statistics.hpp"
+#include "timer_service.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace esperto {
 
@@ -28,15 +40,227 @@ public:
      * @param name The task name.
      * @param stackSize Stack size in words.
      * @param priority Task priority.
-     * @return Shared pointer to the created Task.
+     * @param core Core to pin the task to, tskNO_AFFINITY to let FreeRTOS pick, or
+     * CoreBalancer::AutoCore to place it on the least-loaded core.
+     * @return Shared pointer to the created Task, or nullptr if the task registry is full.
+     * Behaviour change: the scheduler used to grow without bound and never returned nullptr.
+     * A full registry first drops its completed tasks, as cleanupCompletedTasks() does, so
+     * only more than configureRegistry() live tasks at once make this fail.
      */
-    std::shared_ptr<Task> startNew(Task::TaskFunction func, const esperto::string& name = "Task", esperto::uint32 stackSize = 4096, UBaseType_t priority = tskIDLE_PRIORITY + 1);
+    std::shared_ptr<Task> startNew(Task::TaskFunction func, const esperto::string& name = "Task", esperto::uint32 stackSize = 4096, UBaseType_t priority = tskIDLE_PRIORITY + 1, BaseType_t core = tskNO_AFFINITY);
 
     /**
-     * @brief Gets all managed tasks.
+     * @brief Sets how many tasks the scheduler tracks at once (TaskRegistry::DefaultCapacity
+     * by default). Call it at boot, before the first task is started.
+     * @param capacity Maximum number of registered tasks.
+     * @return true if applied; false once a task has been registered.
+     */
+    bool configureRegistry(size_t capacity);
+
+    /**
+     * @brief Allocates the static task arena. Call once at boot; static tasks then run
+     * without further heap allocation for their TCB, stack and Task object.
+     * @param classes Stack size classes and slot counts.
+     * @return true if the arena was allocated.
+     */
+    bool configureArena(const std::vector<TaskArena::SizeClass>& classes);
+
+    /**
+     * @brief Starts a new task whose TCB, stack and Task object come from the arena.
+     * @param func The function to execute.
+     * @param name The task name.
+     * @param stackSize Minimum stack size in words.
+     * @param priority Task priority.
+     * @param core Core to pin the task to, tskNO_AFFINITY or CoreBalancer::AutoCore.
+     * @return Shared pointer to the created Task, or nullptr if no arena slot fits or the
+     * task registry is full.
+     */
+    std::shared_ptr<Task> startNewStatic(Task::TaskFunction func, const esperto::string& name = "Task", esperto::uint32 stackSize = 4096, UBaseType_t priority = tskIDLE_PRIORITY + 1, BaseType_t core = tskNO_AFFINITY);
+
+    /**
+     * @brief Gets the static task arena occupancy.
+     */
+    TaskArena::Statistics getArenaStatistics() const;
+
+    /**
+     * @brief Sets the real-time priority band and overhead model. Only possible while no
+     * periodic task is running.
+     * @param config Real-time policy configuration.
+     * @return true if applied.
+     */
+    bool configureRealtime(const RealtimePolicy::Config& config);
+
+    /**
+     * @brief Starts a periodic real-time task, if the task set on its core stays schedulable.
+     * Its priority is assigned by the policy (rate/deadline-monotonic within the band).
+     * @param job Work done once per period.
+     * @param parameters Period, deadline, budget and core.
+     * @param name The task name.
+     * @param stackSize Stack size in words.
+     * @return Shared pointer to the created Task, or nullptr if admission control rejected it
+     * or the task registry is full.
+     */
+    std::shared_ptr<Task> startPeriodic(RealtimePolicy::Job job, const RealtimePolicy::Parameters& parameters, const esperto::string& name = "Periodic", esperto::uint32 stackSize = 4096);
+
+    /**
+     * @brief Stops a periodic task after its current job and releases its share of the core.
+     * @return false if the task is not a periodic task.
+     */
+    bool stopPeriodic(const std::shared_ptr<Task>& task);
+
+    /**
+     * @brief Sets the function called, from the late task, after every deadline miss.
+     */
+    void setDeadlineMissHandler(RealtimePolicy::MissHandler handler);
+
+    /**
+     * @brief Gets admission results and deadline/budget counters of the periodic tasks.
+     */
+    RealtimePolicy::Statistics getRealtimeStatistics() const;
+
+    /**
+     * @brief Starts sampling the per-core load for CoreBalancer::AutoCore placement, and
+     * rebalancing of auto-placed tasks where the kernel supports it. Runs on the timer service.
+     * @param config Balancer configuration.
+     * @return true if the balancer is sampling; on false nothing is installed and a later
+     * call tries again.
+     */
+    bool enableBalancing(const CoreBalancer::Config& config = CoreBalancer::Config());
+
+    /**
+     * @brief Gets the sampled core load and placement counters (all zero when never enabled).
+     */
+    CoreBalancer::Statistics getBalancingStatistics() const;
+
+    /**
+     * @brief Enables pool mode: starts the work-stealing worker pool used by run().
+     * @param config Worker pool configuration.
+     * @return true if the pool is running.
+     */
+    bool enablePool(const WorkerPool::Config& config = WorkerPool::Config());
+
+    /**
+     * @brief Stops the worker pool. Must not race with run().
+     */
+    void disablePool();
+
+    /**
+     * @brief Checks if pool mode is enabled.
+     */
+    bool isPoolEnabled() const;
+
+    /**
+     * @brief Runs a short job on the worker pool instead of a dedicated FreeRTOS task.
+     * Enables the pool with the default configuration on first use.
+     * @param func The function to execute.
+     * @return true if queued, false if every worker deque is full.
+     */
+    bool run(WorkerPool::WorkFunction func);
+
+    /**
+     * @brief Runs a short job on the worker pool and returns its result as a future.
+     * @param func The function to execute; its return value completes the future.
+     * @return A future for the result, or an invalid future if the job was not queued.
+     */
+    template <typename F>
+    auto runAsync(F func) -> Future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        Promise<R> promise;
+        Future<R> future = promise.getFuture();
+        bool queued = run([promise, func = std::move(func)]() mutable {
+            if constexpr (std::is_void_v<R>) {
+                func();
+                promise.setValue();
+            } else {
+                promise.setValue(func());
+            }
+        });
+        return queued ? future : Future<R>();
+    }
+
+    /**
+     * @brief Gets the worker pool counters (all zero when the pool is disabled).
+     */
+    WorkerPool::Statistics getPoolStatistics() const;
+
+    /**
+     * @brief Starts the coroutine loop used by spawn().
+     * @param config Coroutine loop configuration.
+     * @return true if the loop is running.
+     */
+    bool enableCoroutines(const CoroutineLoop::Config& config = CoroutineLoop::Config());
+
+    /**
+     * @brief Runs a coroutine on the shared coroutine loop. Enables the loop with the
+     * default configuration on first use.
+     * @param task The coroutine to run; the loop owns it until it finishes.
+     * @return true if the coroutine was queued.
+     */
+    bool spawn(CoTask task);
+
+    /**
+     * @brief Gets the coroutine loop counters (all zero when it was never started).
+     */
+    CoroutineLoop::Statistics getCoroutineStatistics() const;
+
+    /**
+     * @brief Starts the timer service used by scheduleAfter/scheduleAt/schedulePeriodic.
+     * @param config Timer service configuration.
+     * @return true if the service is running.
+     */
+    bool enableTimers(const TimerService::Config& config = TimerService::Config());
+
+    /**
+     * @brief Runs a callback once after a delay, from the timer service task.
+     * Enables the timer service with the default configuration on first use.
+     * @param delayMs Delay in milliseconds.
+     * @param callback Short, non-blocking function to call.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or TimerService::InvalidTimer on failure.
+     */
+    TimerService::TimerId scheduleAfter(esperto::uint32 delayMs, TimerService::TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Runs a callback once at an absolute tick count, from the timer service task.
+     * @param deadline FreeRTOS tick count (as returned by xTaskGetTickCount).
+     * @param callback Short, non-blocking function to call.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or TimerService::InvalidTimer on failure.
+     */
+    TimerService::TimerId scheduleAt(TickType_t deadline, TimerService::TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Runs a callback every period, from the timer service task. Replaces a
+     * dedicated task looping on Task::delay.
+     * @param periodMs Period in milliseconds.
+     * @param callback Short, non-blocking function to call.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or TimerService::InvalidTimer on failure.
+     */
+    TimerService::TimerId schedulePeriodic(esperto::uint32 periodMs, TimerService::TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Cancels a timer created by one of the schedule methods.
+     * @return true if the timer was pending.
+     */
+    bool cancelTimer(TimerService::TimerId id);
+
+    /**
+     * @brief Gets the timer service counters (all zero when it was never started).
+     */
+    TimerService::Statistics getTimerStatistics() const;
+
+    /**
+     * @brief Gets all managed tasks as owning pointers (one reference count increment per task).
      */
     std::vector<std::shared_ptr<Task>> getTasks() const;
 
+    /**
+     * @brief Opens a read snapshot of the managed tasks. Safe while other tasks add or
+     * remove entries, and iterating it costs no reference count operations.
+     */
+    TaskRegistry::Snapshot snapshot() const;
+
     /**
      * @brief Removes a task from the scheduler.
      */
@@ -63,12 +287,19 @@ public:
     void cleanupCompletedTasks();
 
     /**
-     * @brief Waits for all tasks to complete.
+     * @brief Waits for all tasks to complete. Each join wakes on the task's completion event.
      */
     void waitForAll();
 
     /**
-     * @brief Gets statistics about running tasks.
+     * @brief Collects a profiling snapshot: per-task CPU share since the previous snapshot,
+     * stack high-water marks, voluntary context switches and wake-up latency histograms,
+     * plus the arena, pool and timer counters.
+     */
+    SchedulerStatistics getStatistics() const;
+
+    /**
+     * @brief Prints the getStatistics() snapshot.
      */
     void printTaskStatistics() const;
 
@@ -77,7 +308,27 @@ public:
 
 private:
     TaskScheduler() = default;
-    std::vector<std::shared_ptr<Task>> m_tasks;
+    TaskRegistry m_tasks;
+    std::atomic<WorkerPool*> m_pool{nullptr};
+    TaskArena m_arena;
+    RealtimePolicy m_realtime{RealtimePolicy::Config()};
+    std::atomic<TimerService*> m_timers{nullptr};
+    std::atomic<CoroutineLoop*> m_coroutines{nullptr};
+    std::atomic<CoreBalancer*> m_balancer{nullptr};
+
+    struct RunTimeSample {
+        TaskHandle_t handle;
+        esperto::uint64 runTimeUs;
+    };
+
+    // Previous profiling sample, the baseline for cpuPercent
+    mutable portMUX_TYPE m_sampleLock = portMUX_INITIALIZER_UNLOCKED;
+    mutable std::vector<RunTimeSample> m_lastSample;
+    mutable esperto::uint64 m_lastSampleUs = 0;
+
+    TimerService* timers();
+    bool place(Task& task, BaseType_t core);
+    bool registerTask(const std::shared_ptr<Task>& task);
 };
 
 } // namespace esperto
@@ -0,0 +1,132 @@
+// task_statistics.hpp
+// Runtime profiling snapshots for tasks and the TaskScheduler
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "types.hpp"
+#include "core_balancer.hpp"
+#include "coroutine.hpp"
+#include "task_arena.hpp"
+#include "realtime_policy.hpp"
+#include "timer_service.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Latency distribution with power-of-two microsecond buckets.
+ *
+ * Bucket 0 counts samples below 1 us, bucket i counts samples in [2^(i-1), 2^i) us and
+ * the last bucket counts everything above. Plain value type, safe to copy and merge.
+ */
+struct LatencyHistogram {
+    static constexpr size_t BucketCount = 20;
+
+    esperto::uint32 buckets[BucketCount] = {};
+    esperto::uint32 samples = 0;
+    esperto::uint32 maxUs = 0;
+    esperto::uint64 totalUs = 0;
+
+    /**
+     * @brief Gets the bucket a latency falls into.
+     */
+    static size_t bucketFor(esperto::uint32 latencyUs);
+
+    /**
+     * @brief Gets the exclusive upper bound of a bucket in microseconds.
+     */
+    static esperto::uint32 bucketLimitUs(size_t index);
+
+    /**
+     * @brief Adds the samples of another histogram.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Gets the mean latency in microseconds.
+     */
+    esperto::uint32 averageUs() const;
+
+    /**
+     * @brief Gets an upper bound for a percentile (bucket resolution).
+     * @param percent Percentile, 0 to 100.
+     */
+    esperto::uint32 percentileUs(esperto::uint32 percent) const;
+};
+
+/**
+ * @brief Lock-free latency recorder, written by the task it belongs to and read by
+ * profiling snapshots from any task.
+ */
+class LatencyRecorder {
+public:
+    /**
+     * @brief Records one latency sample.
+     */
+    void record(esperto::uint32 latencyUs);
+
+    /**
+     * @brief Copies the current distribution.
+     */
+    LatencyHistogram snapshot() const;
+
+private:
+    std::atomic<esperto::uint32> m_buckets[LatencyHistogram::BucketCount] = {};
+    std::atomic<esperto::uint32> m_samples{0};
+    std::atomic<esperto::uint32> m_maxUs{0};
+    std::atomic<esperto::uint64> m_totalUs{0};
+};
+
+/**
+ * @brief Profile of one FreeRTOS task.
+ */
+struct TaskProfile {
+    esperto::string name;
+    TaskHandle_t handle = nullptr;
+    eTaskState state = eInvalid;
+    UBaseType_t priority = 0;
+    esperto::int32 core = -1;                   ///< Core the task is pinned to (-1: either core)
+    esperto::uint64 runTimeUs = 0;              ///< CPU time since the task was created
+    float cpuPercent = 0.0f;                    ///< Share of the total CPU capacity since the previous snapshot
+    esperto::uint32 stackHighWaterMark = 0;     ///< Lowest free stack space ever seen, in words
+    bool managed = false;                       ///< Task started through the TaskScheduler
+    esperto::uint32 voluntarySwitches = 0;      ///< Times the task blocked or yielded in an esperto primitive (managed only)
+    LatencyHistogram latency;                   ///< Wake-up-to-run latency (managed only)
+};
+
+/**
+ * @brief Structured TaskScheduler report, as printed by printTaskStatistics().
+ */
+struct SchedulerStatistics {
+    esperto::uint32 taskCount = 0;              ///< Tasks tracked by the scheduler
+    esperto::uint32 running = 0;
+    esperto::uint32 suspended = 0;
+    esperto::uint32 completed = 0;
+    esperto::uint64 uptimeUs = 0;               ///< Run-time clock at the snapshot
+    esperto::uint64 intervalUs = 0;             ///< Time covered by cpuPercent
+    bool profilingAvailable = false;            ///< Run-time stats enabled in sdkconfig
+    std::vector<TaskProfile> tasks;             ///< Every FreeRTOS task, managed or not
+    LatencyHistogram latency;                   ///< Merged latency of the managed tasks
+    bool arenaConfigured = false;
+    TaskArena::Statistics arena;
+    bool poolEnabled = false;
+    WorkerPool::Statistics pool;
+    bool timersEnabled = false;
+    TimerService::Statistics timers;
+    bool coroutinesEnabled = false;
+    CoroutineLoop::Statistics coroutines;
+    RealtimePolicy::Statistics realtime;
+    bool balancingEnabled = false;
+    CoreBalancer::Statistics balancing;
+};
+
+} // namespace esperto
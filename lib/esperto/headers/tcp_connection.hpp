@@ -0,0 +1,161 @@
+// tcp_connection.hpp
+// Zero-copy TCP client connection on the lwIP raw API
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "future.hpp"
+#include "net_buffer.hpp"
+#include <atomic>
+#include <deque>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "lwip/tcp.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief TCP client connection that passes data as pbuf chains instead of copying it.
+ *
+ * Received segments are queued as the pbufs lwIP filled and handed out as NetBuffer. While
+ * the queue is full lwIP keeps the refused data and retries, which stops the receive window
+ * from growing, so a slow reader throttles the peer instead of losing data. The window is
+ * reopened in batches of windowUpdateBytes as the application takes buffers.
+ *
+ * send() passes payload memory to tcp_write without TCP_WRITE_FLAG_COPY and keeps a
+ * reference to each NetPayload until the peer acknowledges its last byte, so nothing is
+ * copied until the driver builds the frame. Every lwIP call runs on the tcpip thread.
+ */
+class TcpConnection : public Object {
+public:
+    /**
+     * @brief Connection configuration.
+     */
+    struct Config {
+        esperto::uint32 receiveQueueLength = 16;   ///< Received pbuf chains waiting for receive()
+        esperto::uint32 windowUpdateBytes = 2920;  ///< Bytes taken by the application before the window is reopened
+        esperto::uint32 closeTimeoutMs = 2000;     ///< Wait for unacknowledged data on close() before aborting
+        bool noDelay = true;                       ///< Disable Nagle's algorithm
+    };
+
+    /**
+     * @brief Connection counters.
+     */
+    struct Statistics {
+        esperto::uint64 sentBytes = 0;       ///< Bytes queued to lwIP
+        esperto::uint64 ackedBytes = 0;      ///< Bytes acknowledged by the peer
+        esperto::uint64 receivedBytes = 0;   ///< Bytes handed to receive()
+        esperto::uint32 sendStalls = 0;      ///< Times send() waited for send buffer space
+        esperto::uint32 refusedChains = 0;   ///< Receive chains lwIP had to keep because the queue was full
+    };
+
+    TcpConnection();
+    explicit TcpConnection(const Config& config);
+
+    /**
+     * @brief Closes the connection.
+     */
+    ~TcpConnection() override;
+
+    TcpConnection(const TcpConnection&) = delete;
+    TcpConnection& operator=(const TcpConnection&) = delete;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Connects to a remote endpoint.
+     * @param timeoutMs Maximum wait for the handshake in milliseconds.
+     * @return false on error or timeout.
+     */
+    bool connect(const NetEndpoint& remote, esperto::uint32 timeoutMs = 5000);
+
+    /**
+     * @brief Closes the connection once the data sent so far is acknowledged, or aborts it
+     * after closeTimeoutMs. Queued received data is freed.
+     */
+    void close();
+
+    /**
+     * @brief Queues the given parts, in order, without copying them.
+     * @param timeoutMs Maximum wait for send buffer space in milliseconds.
+     * @return false if the connection failed, or on timeout; the parts queued before that
+     * stay queued.
+     */
+    bool send(const NetPayload* parts, size_t count, esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Queues one payload without copying it.
+     */
+    bool send(const NetPayload& payload, esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Waits for received data.
+     * @param buffer Receives the next chain.
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return false on timeout, or once the peer has closed and every chain has been taken.
+     */
+    bool receive(NetBuffer& buffer, esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Checks if the connection is established and not failed.
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Checks if the peer has closed its side.
+     */
+    bool isPeerClosed() const;
+
+    /**
+     * @brief Gets the connection counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    enum class State : esperto::uint8 {
+        Closed,
+        Connecting,
+        Connected,
+        Failed
+    };
+
+    // Payload referenced by lwIP until `end` bytes of the stream are acknowledged
+    struct InFlight {
+        NetPayload payload;
+        esperto::uint64 end;
+    };
+
+    Config m_config;
+    struct tcp_pcb* m_pcb;             ///< Only touched on the tcpip thread
+    std::atomic<State> m_state;
+    std::atomic<bool> m_peerClosed;
+    bool m_endOfStream;                ///< receive() has seen the peer close marker
+    QueueHandle_t m_queue;
+    StaticSemaphore_t m_signalBuffer;
+    SemaphoreHandle_t m_signal;        ///< Given on connect, acknowledgement and error
+    std::deque<InFlight> m_inFlight;   ///< Only touched on the tcpip thread
+    esperto::uint64 m_queuedBytes;     ///< Stream offset after the last queued byte (tcpip thread)
+    esperto::uint64 m_ackedBytes;      ///< Stream offset acknowledged by the peer (tcpip thread)
+    esperto::uint32 m_windowPending;   ///< Bytes taken by the application, not yet passed to tcp_recved
+    Statistics m_stats;
+    std::atomic<esperto::uint32> m_refusedChains;
+
+    static err_t connectedCallback(void* arg, struct tcp_pcb* pcb, err_t err);
+    static err_t receiveCallback(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err);
+    static err_t sentCallback(void* arg, struct tcp_pcb* pcb, u16_t length);
+    static void errorCallback(void* arg, err_t err);
+
+    void detachPcb();
+    void releaseInFlight();
+    void updateWindow();
+    void drainQueue();
+};
+
+} // namespace esperto
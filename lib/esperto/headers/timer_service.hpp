@@ -0,0 +1,186 @@
+// timer_service.hpp
+// Hierarchical timing wheel for delayed and periodic jobs (single service task)
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Runs delayed and periodic callbacks from one FreeRTOS task.
+ *
+ * Timers live in a hierarchical timing wheel (4 levels of 64 slots). Insert and cancel
+ * are O(1) list operations on preallocated nodes. Deadlines are quantized to the wheel
+ * resolution, optionally widened by a per-timer slack, so timers that fall close
+ * together land in the same slot and fire on a single wake-up.
+ */
+class TimerService : public Object {
+public:
+    using TimerCallback = std::function<void()>;
+    using TimerId = esperto::uint32;
+
+    static constexpr TimerId InvalidTimer = 0;
+
+    /**
+     * @brief Timer service configuration.
+     */
+    struct Config {
+        esperto::uint32 capacity = 64;                     ///< Maximum number of pending timers
+        esperto::uint32 resolutionMs = 10;                 ///< Wheel slot length
+        esperto::uint32 stackSize = 4096;                  ///< Service task stack size in words
+        UBaseType_t priority = configMAX_PRIORITIES - 12;  ///< Service task priority, below the RealtimePolicy band
+    };
+
+    /**
+     * @brief Counters describing the timer service activity.
+     */
+    struct Statistics {
+        esperto::uint32 active = 0;          ///< Pending timers
+        esperto::uint32 capacity = 0;        ///< Preallocated timer nodes
+        esperto::uint64 fired = 0;           ///< Callbacks executed
+        esperto::uint64 wakeups = 0;         ///< Service task wake-ups that fired at least one timer
+        esperto::uint32 rejected = 0;        ///< Timers refused because every node was in use
+        esperto::uint32 maxLatenessMs = 0;   ///< Largest delay between a deadline and its callback
+    };
+
+    /**
+     * @brief Creates the service (does not start the task).
+     * @param config Service configuration.
+     */
+    explicit TimerService(const Config& config);
+
+    /**
+     * @brief Stops the service task.
+     */
+    ~TimerService() override;
+
+    /**
+     * @brief Starts the service task.
+     * @return true if the task is running.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the service task. Pending timers are dropped.
+     */
+    void stop();
+
+    /**
+     * @brief Runs a callback once after a delay.
+     * @param delayMs Delay in milliseconds.
+     * @param callback Function to call from the service task.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or InvalidTimer if no node is free.
+     */
+    TimerId scheduleAfter(esperto::uint32 delayMs, TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Runs a callback once at an absolute tick count.
+     * @param deadline FreeRTOS tick count (as returned by xTaskGetTickCount).
+     * @param callback Function to call from the service task.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or InvalidTimer if no node is free.
+     */
+    TimerId scheduleAt(TickType_t deadline, TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Runs a callback every period, starting one period from now.
+     * @param periodMs Period in milliseconds.
+     * @param callback Function to call from the service task.
+     * @param slackMs Extra lateness the caller accepts, used to coalesce deadlines.
+     * @return Timer id, or InvalidTimer if no node is free.
+     */
+    TimerId schedulePeriodic(esperto::uint32 periodMs, TimerCallback callback, esperto::uint32 slackMs = 0);
+
+    /**
+     * @brief Cancels a pending timer. A callback already running completes normally.
+     * @return true if the timer was pending.
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief Checks if the service task is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Gets the service counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    static constexpr esperto::uint32 LevelBits = 6;
+    static constexpr esperto::uint32 SlotsPerLevel = 1u << LevelBits;
+    static constexpr esperto::uint32 SlotMask = SlotsPerLevel - 1;
+    static constexpr esperto::uint32 Levels = 4;
+
+    enum class NodeState : esperto::uint8 {
+        Free,
+        Pending,
+        Firing,
+        Cancelled
+    };
+
+    struct Node {
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        esperto::uint64 expires = 0;   ///< Deadline in wheel slots
+        esperto::uint32 period = 0;    ///< Period in wheel slots (0 for one-shot)
+        esperto::uint32 granularity = 1;
+        esperto::uint16 generation = 0;
+        esperto::uint8 level = 0;
+        esperto::uint8 slot = 0;
+        NodeState state = NodeState::Free;
+        TimerCallback callback;
+    };
+
+    struct Bucket {
+        Node* head = nullptr;
+    };
+
+    Config m_config;
+    TickType_t m_ticksPerSlot;
+    std::unique_ptr<Node[]> m_nodes;
+    Node* m_freeList;
+    Bucket m_wheel[Levels][SlotsPerLevel];
+    esperto::uint64 m_occupied[Levels];
+    esperto::uint64 m_now;          ///< Next wheel slot to process
+    esperto::uint64 m_nextWake;     ///< Slot the service task sleeps until
+    esperto::uint64 m_tickBase;     ///< High part of the extended tick count
+    TickType_t m_lastTick;
+    mutable portMUX_TYPE m_lock;
+    TaskHandle_t m_handle;
+    SemaphoreHandle_t m_exited;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+    Statistics m_stats;
+
+    static void serviceEntryPoint(void* param);
+    void serviceLoop();
+    TimerId schedule(esperto::uint64 delayTicks, esperto::uint32 periodTicks, TimerCallback callback, esperto::uint32 slackMs);
+    esperto::uint64 currentTick();
+    esperto::uint64 roundToSlot(esperto::uint64 tick, esperto::uint32 granularity) const;
+    void place(Node* node);
+    void unlink(Node* node);
+    Node* collectExpired(esperto::uint64 target);
+    bool skipIdle(esperto::uint64 slot);
+    void cascade(esperto::uint32 level);
+    esperto::uint64 nextExpiry() const;
+    void release(Node* node);
+    Node* nodeFromId(TimerId id) const;
+    TimerId idFromNode(const Node* node) const;
+};
+
+} // namespace esperto
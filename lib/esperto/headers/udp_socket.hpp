@@ -0,0 +1,142 @@
+// udp_socket.hpp
+// Zero-copy UDP socket on the lwIP raw API
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include "future.hpp"
+#include "net_buffer.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "lwip/udp.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief UDP endpoint that passes datagrams as pbuf chains instead of copying them.
+ *
+ * Received datagrams are queued as the pbufs lwIP filled and handed out as NetBuffer;
+ * datagrams arriving while the queue is full are dropped and counted. A datagram is sent
+ * as a chain of PBUF_REF pbufs, one per NetPayload part (scatter/gather), so the payload
+ * is never copied into the socket layer. Usable once WiFi reports Connected; every lwIP
+ * call runs on the tcpip thread.
+ */
+class UdpSocket : public Object {
+public:
+    /**
+     * @brief Socket configuration.
+     */
+    struct Config {
+        esperto::uint32 receiveQueueLength = 16;   ///< Datagrams waiting for receive()
+    };
+
+    /**
+     * @brief Socket counters.
+     */
+    struct Statistics {
+        esperto::uint64 sent = 0;             ///< Datagrams passed to lwIP
+        esperto::uint64 sentBytes = 0;
+        esperto::uint32 sendErrors = 0;       ///< Datagrams lwIP refused or that could not be built
+        esperto::uint64 received = 0;         ///< Datagrams handed to receive()
+        esperto::uint64 receivedBytes = 0;
+        esperto::uint32 dropped = 0;          ///< Datagrams lost because the queue was full
+    };
+
+    UdpSocket();
+    explicit UdpSocket(const Config& config);
+
+    /**
+     * @brief Closes the socket and frees the queued datagrams.
+     */
+    ~UdpSocket() override;
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // Object interface
+    bool equals(const Object& other) const override;
+
+    /**
+     * @brief Opens the socket on a local port.
+     * @param port Local port; 0 picks an ephemeral port.
+     * @return false if the port is in use or memory is exhausted.
+     */
+    bool bind(esperto::uint16 port = 0);
+
+    /**
+     * @brief Sets the default destination and accepts datagrams from it only. Binds an
+     * ephemeral port first if needed.
+     */
+    bool connect(const NetEndpoint& remote);
+
+    /**
+     * @brief Closes the socket; queued datagrams are freed.
+     */
+    void close();
+
+    /**
+     * @brief Sends one datagram made of the given parts, in order, to the connected remote.
+     */
+    bool send(const NetPayload* parts, size_t count);
+
+    /**
+     * @brief Sends one datagram made of a single payload to the connected remote.
+     */
+    bool send(const NetPayload& payload);
+
+    /**
+     * @brief Sends one datagram made of the given parts, in order.
+     * @return false if the datagram could not be built or lwIP refused it.
+     */
+    bool sendTo(const NetEndpoint& remote, const NetPayload* parts, size_t count);
+
+    /**
+     * @brief Waits for the next datagram.
+     * @param buffer Receives the datagram.
+     * @param from Receives the sender, if not nullptr.
+     * @param timeoutMs Maximum wait in milliseconds (InfiniteTimeout to wait forever).
+     * @return false on timeout or if the socket is closed.
+     */
+    bool receive(NetBuffer& buffer, NetEndpoint* from = nullptr, esperto::uint32 timeoutMs = InfiniteTimeout);
+
+    /**
+     * @brief Gets the bound local port (0 if closed).
+     */
+    esperto::uint16 localPort() const;
+
+    /**
+     * @brief Checks if the socket is bound.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Gets the socket counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct Datagram {
+        struct pbuf* chain;
+        NetEndpoint from;
+    };
+
+    Config m_config;
+    struct udp_pcb* m_pcb;
+    QueueHandle_t m_queue;
+    bool m_connected;
+    NetEndpoint m_remote;
+    Statistics m_stats;                    ///< Updated by the tasks calling send and receive
+    std::atomic<esperto::uint32> m_dropped;   ///< Updated on the tcpip thread
+
+    static void receiveCallback(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* address, u16_t port);
+    struct pbuf* buildChain(const NetPayload* parts, size_t count);
+    void drainQueue();
+};
+
+} // namespace esperto
@@ -2,16 +2,23 @@
 
 #include "object.hpp"
 #include "types.hpp"
+#include "coroutine.hpp"
+#include <atomic>
 #include <functional>
 
 extern "C" {
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 }
 
 namespace esperto {
 
+class WiFiStatusAwaiter;
+
 class WiFi : public Object {
 public:
     enum class Mode {
@@ -28,8 +35,99 @@ public:
         Failed
     };
 
+    // Trade inbound latency for radio power. While the modem sleeps, the AP buffers frames
+    // until the station wakes, so the added latency is bounded by the wake period:
+    //   LowLatency: modem always on, no added latency, highest current.
+    //   Balanced:   modem sleep, wakes every DTIM (DTIM period x beacon interval, usually 102.4 ms).
+    //   MaxSaving:  modem sleep, wakes every listenInterval beacons, and automatic light sleep
+    //               when power management is enabled (CONFIG_PM_ENABLE).
+    // Actual numbers depend on the AP: measure latency with measureRoundTrip() and current
+    // with a meter in series with the supply.
+    enum class PowerProfile {
+        LowLatency,
+        Balanced,
+        MaxSaving
+    };
+
+    // Round trip statistics from measureRoundTrip()
+    struct RoundTripStats {
+        esperto::uint32 sent = 0;
+        esperto::uint32 received = 0;
+        esperto::uint32 minMs = 0;
+        esperto::uint32 avgMs = 0;
+        esperto::uint32 maxMs = 0;
+    };
+
     using EventCallback = std::function<void(Status status, const esperto::string& info)>;
 
+    // Typed event delivered to subscribers; plain data, copied into queues as is
+    struct Event {
+        enum class Type : uint8_t {
+            StationStarted,
+            Associated,     // bssid, channel
+            Disconnected,   // reason, rssi, bssid; status tells whether a retry is scheduled (Disconnected) or not (Failed)
+            GotIp,          // ip, gateway, netmask, rssi, bssid, channel
+            APStarted
+        };
+
+        Type type;
+        Status status;            // Status after the event
+        uint8_t reason;           // wifi_err_reason_t, Disconnected only
+        int8_t rssi;              // dBm, 0 when unknown
+        uint8_t channel;
+        uint8_t bssid[6];
+        esp_ip4_addr_t ip;
+        esp_ip4_addr_t gateway;
+        esp_ip4_addr_t netmask;
+        esperto::int64 timestampUs;   // esp_timer time of the event
+    };
+
+    using EventListener = std::function<void(const Event& event)>;
+    using SubscriptionId = esperto::uint32;
+
+    static constexpr SubscriptionId InvalidSubscription = 0;
+    static constexpr esperto::uint32 MaxSubscribers = 8;
+
+    // Addresses applied instead of DHCP
+    struct StaticIp {
+        esp_ip4_addr_t ip = {};
+        esp_ip4_addr_t gateway = {};
+        esp_ip4_addr_t netmask = {};
+        esp_ip4_addr_t dns = {};        // Left unset when zero
+    };
+
+    // Fast reconnect: after a successful connection the BSSID, channel and DHCP lease are
+    // cached in RTC memory (kept across deep sleep) and NVS (kept across power cycles). The
+    // next beginStation() on the same SSID joins that BSSID on that channel without a full
+    // scan, and falls back to a full scan if the cached AP cannot be joined.
+    struct FastConnectConfig {
+        bool enabled = true;        // Connect to the cached BSSID and channel
+        bool reuseLease = false;    // Apply the cached lease instead of running DHCP; only safe with reserved leases
+        bool useStaticIp = false;   // Apply staticIp instead of DHCP, on every connection
+        StaticIp staticIp;
+    };
+
+    // Automatic reconnection after a disconnect the application did not ask for. Retries run
+    // from the TaskScheduler timer service, never on the event loop: attempt n waits
+    // min(initialDelayMs * 2^n, maxDelayMs), shortened by a random part of up to jitterPercent,
+    // so stations dropped together by an AP reboot do not come back together.
+    struct ReconnectPolicy {
+        bool enabled = true;
+        esperto::uint32 initialDelayMs = 500;
+        esperto::uint32 maxDelayMs = 60000;
+        esperto::uint8 jitterPercent = 50;
+        esperto::uint32 maxRetries = 20;            // Status::Failed after this many; 0 retries forever
+        esperto::uint32 maxCredentialFailures = 2;  // Consecutive auth/handshake failures before Status::Failed
+    };
+
+    // Time from connect() to each step of the last connection attempt
+    struct ConnectTiming {
+        esperto::uint32 associationMs = 0;  // 0 until associated
+        esperto::uint32 ipMs = 0;           // 0 until the station has an IP address
+        bool fastPath = false;              // The cached BSSID and channel were tried
+        bool fellBack = false;              // They failed and a full scan followed
+    };
+
     WiFi();
     ~WiFi() override;
 
@@ -42,6 +140,25 @@ public:
     bool disconnect();
     bool reconnect();
 
+    // Fast reconnect; set before beginStation()
+    void setFastConnect(const FastConnectConfig& config);
+    FastConnectConfig getFastConnect() const;
+    void clearFastConnectCache();
+    ConnectTiming getConnectTiming() const;
+
+    // Power save; listenInterval is in beacons and applies from the next association
+    bool setPowerProfile(PowerProfile profile, uint16_t listenInterval = 10);
+    PowerProfile getPowerProfile() const;
+    // Pings an IPv4 address (the gateway when empty) from the calling task; blocks until done
+    bool measureRoundTrip(RoundTripStats& stats, const esperto::string& host = "", 
+                          esperto::uint32 count = 10, esperto::uint32 intervalMs = 200);
+
+    // Reconnect policy
+    void setReconnectPolicy(const ReconnectPolicy& policy);
+    ReconnectPolicy getReconnectPolicy() const;
+    esperto::uint32 getReconnectAttempts() const;   // Retries since the last connection
+    uint8_t getDisconnectReason() const;            // wifi_err_reason_t of the last disconnect
+
     // WiFi Access Point methods
     bool beginAccessPoint(const esperto::string& ssid, const esperto::string& password = "", 
                          uint8_t channel = 1, uint8_t maxConnections = 4);
@@ -60,7 +177,17 @@ public:
     int32_t getRSSI() const;
     
     // Event handling
+    // Listeners run on the system event loop task and must return quickly; a queue subscriber
+    // gets a copy of each Event (create the queue with an item size of sizeof(WiFi::Event)) and
+    // handles it on its own task. Events for a full queue are dropped, never waited for.
+    SubscriptionId subscribe(EventListener listener);
+    SubscriptionId subscribe(QueueHandle_t queue);
+    bool unsubscribe(SubscriptionId id);
+    esperto::uint32 getDroppedEvents() const;
+    // Single legacy callback; its info string is only formatted when one is set
     void setEventCallback(EventCallback callback);
+    // Coroutines: co_await wifi.statusChangeAsync() resumes with the new status
+    WiFiStatusAwaiter statusChangeAsync();
     
     // Utility methods
     bool isConnected() const;
@@ -76,6 +203,42 @@ private:
     esp_netif_t* m_netifSta;
     esp_netif_t* m_netifAp;
     bool m_initialized;
+    WiFiStatusAwaiter* m_statusWaiters;
+    portMUX_TYPE m_waiterLock;
+    FastConnectConfig m_fastConnect;
+    ConnectTiming m_timing;
+    esperto::int64 m_connectStartUs;
+    bool m_fastAttempt;      // Joining the cached BSSID, not associated yet
+    bool m_bssidPinned;      // The station config targets the cached BSSID and channel
+    bool m_leaseApplied;     // The cached lease replaced DHCP
+    uint8_t m_bssid[6];      // AP of the current association
+    uint8_t m_channel;
+    ReconnectPolicy m_reconnect;
+    bool m_reconnectAllowed;     // Cleared by disconnect() and end()
+    bool m_pendingReconnect;     // reconnect() waits for its disconnect event
+    esperto::uint32 m_attempts;
+    esperto::uint32 m_credentialFailures;
+    uint8_t m_disconnectReason;
+    esperto::uint32 m_retryTimer;
+    std::atomic<esperto::uint32> m_retryGeneration;   // Invalidates retries already scheduled
+    PowerProfile m_powerProfile;
+    uint16_t m_listenInterval;
+    bool m_lightSleepEnabled;    // Automatic light sleep was turned on by MaxSaving
+
+    struct Subscriber {
+        SubscriptionId id = InvalidSubscription;
+        EventListener listener;
+        QueueHandle_t queue = nullptr;
+        bool busy = false;   // Listener running; its slot is not reused until it returns
+    };
+
+    Subscriber m_subscribers[MaxSubscribers];
+    SubscriptionId m_nextSubscription;
+    std::atomic<esperto::uint32> m_droppedEvents;
+    StaticSemaphore_t m_subscriberLockBuffer;
+    SemaphoreHandle_t m_subscriberLock;   // Recursive: listeners may unsubscribe while being called
+
+    friend class WiFiStatusAwaiter;
 
     // Static event handlers
     static void wifiEventHandler(void* arg, esp_event_base_t eventBase, 
@@ -87,7 +250,39 @@ private:
     bool initializeNetif();
     void cleanupNetif();
     void handleEvent(esp_event_base_t eventBase, int32_t eventId, void* eventData);
+    SubscriptionId addSubscriber(EventListener listener, QueueHandle_t queue);
+    void publish(Event& event);
     Status convertWifiStatus() const;
+    bool applyFastConnect(wifi_config_t& wifiConfig);
+    void applyStaticIp(const StaticIp& staticIp);
+    void restoreDhcp();
+    void unpinBssid();
+    void fallBackToScan();
+    void saveFastConnect(const esp_netif_ip_info_t& ipInfo);
+    bool startConnect();
+    bool scheduleRetry(uint8_t reason);
+    void retryConnect(esperto::uint32 generation);
+    void cancelRetry();
+    bool applyPowerProfile();
+    esperto::uint32 backoffDelayMs(esperto::uint32 attempt) const;
+    void notifyStatusWaiters();
+};
+
+// Awaiter returned by WiFi::statusChangeAsync; resumed from the event loop on the next status change
+class WiFiStatusAwaiter {
+public:
+    explicit WiFiStatusAwaiter(WiFi& wifi) : m_wifi(wifi), m_next(nullptr) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    WiFi::Status await_resume() const { return m_wifi.getStatus(); }
+
+private:
+    friend class WiFi;
+
+    WiFi& m_wifi;
+    CoroutineNode m_node;
+    WiFiStatusAwaiter* m_next;
 };
 
 } // namespace esperto
\ No newline at end of file
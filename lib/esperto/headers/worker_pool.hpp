@@ -0,0 +1,132 @@
+// worker_pool.hpp
+// Work-stealing worker pool for short jobs on ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#pragma once
+
+#include "object.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+namespace esperto {
+
+/**
+ * @brief Fixed set of worker tasks, pinned to each core, that execute lightweight work items.
+ *
+ * Every worker owns a bounded deque. The owner pushes and pops at the bottom (LIFO),
+ * idle workers steal from the top of the other deques (FIFO). Work items are plain
+ * callables, so running a job costs no task creation, no stack and no TCB.
+ */
+class WorkerPool : public Object {
+public:
+    using WorkFunction = std::function<void()>;
+
+    /**
+     * @brief Worker pool configuration.
+     */
+    struct Config {
+        esperto::uint32 workersPerCore = 1;            ///< Workers pinned to each core
+        esperto::uint32 stackSize = 4096;              ///< Worker stack size in words
+        UBaseType_t priority = tskIDLE_PRIORITY + 2;   ///< Worker priority
+        esperto::uint32 queueCapacity = 64;            ///< Deque capacity per worker (rounded up to a power of two)
+    };
+
+    /**
+     * @brief Counters describing the pool activity since start.
+     */
+    struct Statistics {
+        esperto::uint32 workers = 0;   ///< Number of worker tasks
+        esperto::uint32 pending = 0;   ///< Work items currently queued
+        esperto::uint64 executed = 0;  ///< Work items executed
+        esperto::uint64 stolen = 0;    ///< Work items executed by a worker other than the one they were queued on
+        esperto::uint64 rejected = 0;  ///< Work items refused because every deque was full
+    };
+
+    /**
+     * @brief Creates a pool (does not start the workers).
+     * @param config Pool configuration.
+     */
+    explicit WorkerPool(const Config& config);
+
+    /**
+     * @brief Stops the workers and releases the deques.
+     */
+    ~WorkerPool() override;
+
+    /**
+     * @brief Creates the worker tasks.
+     * @return true if every worker was created.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the workers and drops queued work items. Must not be called from a worker.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a work item. Called from a worker, it goes to that worker's own deque.
+     * @param func The function to execute.
+     * @return true if queued, false if the pool is stopped or every deque is full.
+     */
+    bool submit(WorkFunction func);
+
+    /**
+     * @brief Checks if the workers are running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Gets the number of worker tasks.
+     */
+    size_t getWorkerCount() const;
+
+    /**
+     * @brief Gets the pool counters.
+     */
+    Statistics getStatistics() const;
+
+private:
+    struct Worker {
+        WorkerPool* pool = nullptr;
+        esperto::uint32 index = 0;
+        BaseType_t core = 0;
+        TaskHandle_t handle = nullptr;
+        portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+        std::unique_ptr<WorkFunction[]> items;
+        esperto::uint32 top = 0;     ///< Steal end (guarded by lock)
+        esperto::uint32 bottom = 0;  ///< Owner end (guarded by lock)
+        std::atomic<bool> sleeping{false};
+        std::atomic<esperto::uint32> executed{0};
+        std::atomic<esperto::uint32> stolen{0};
+    };
+
+    Config m_config;
+    esperto::uint32 m_mask;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+    std::atomic<esperto::uint32> m_nextWorker;
+    std::atomic<esperto::uint32> m_rejected;
+    SemaphoreHandle_t m_exited;
+
+    static void workerEntryPoint(void* param);
+    void workerLoop(Worker& worker);
+    Worker* currentWorker() const;
+    bool pushBottom(Worker& worker, WorkFunction& func);
+    bool popBottom(Worker& worker, WorkFunction& func);
+    bool stealTop(Worker& victim, WorkFunction& func);
+    bool steal(Worker& thief, WorkFunction& func);
+    void wake(Worker& target);
+};
+
+} // namespace esperto
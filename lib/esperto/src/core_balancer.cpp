@@ -0,0 +1,200 @@
+// core_balancer.cpp
+// Implementation of CoreBalancer class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/core_balancer.hpp"
+#include "../headers/task.hpp"
+#include <algorithm>
+
+extern "C" {
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "CoreBalancer";
+
+CoreBalancer::CoreBalancer(const Config& config)
+    : m_config(config), m_previousTotalUs(0), m_load{}, m_recent{}, m_placed{}, m_migrations(0), m_samples(0),
+      m_loadAvailable(false) {
+    m_lock = xSemaphoreCreateMutexStatic(&m_lockBuffer);
+}
+
+CoreBalancer::~CoreBalancer() {
+    vSemaphoreDelete(m_lock);
+}
+
+const CoreBalancer::Config& CoreBalancer::getConfig() const {
+    return m_config;
+}
+
+BaseType_t CoreBalancer::pickCore() {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    BaseType_t best = 0;
+    float bestScore = 0.0f;
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; ++core) {
+        float score = m_load[core] + static_cast<float>(m_config.placementWeightPercent * m_recent[core]);
+        if (core == 0 || score < bestScore) {
+            best = core;
+            bestScore = score;
+        }
+    }
+    m_recent[best]++;
+    m_placed[best]++;
+    xSemaphoreGive(m_lock);
+    return best;
+}
+
+void CoreBalancer::track(const std::shared_ptr<Task>& task) {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_tracked.push_back(task);
+    xSemaphoreGive(m_lock);
+}
+
+void CoreBalancer::sample() {
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+    // Collected outside the lock: pickCore() must not wait for the system state walk
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    std::vector<TaskStatus_t> status(capacity);
+    configRUN_TIME_COUNTER_TYPE totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(status.data(), capacity, &totalRunTime);
+
+    std::vector<RunTimeSample> current;
+    current.reserve(count);
+    for (UBaseType_t i = 0; i < count; ++i) {
+        current.push_back({status[i].xHandle, static_cast<esperto::uint64>(status[i].ulRunTimeCounter)});
+    }
+#endif
+
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_tracked.erase(std::remove_if(m_tracked.begin(), m_tracked.end(), [](const std::weak_ptr<Task>& weak) {
+        auto task = weak.lock();
+        return !task || task->isCompleted();
+    }), m_tracked.end());
+
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+    esperto::uint64 intervalUs = static_cast<esperto::uint64>(totalRunTime) - m_previousTotalUs;
+    if (!m_previous.empty() && intervalUs > 0) {
+        // A core is busy whenever its idle task is not running
+        for (BaseType_t core = 0; core < portNUM_PROCESSORS; ++core) {
+            esperto::uint64 idleUs = std::min(runTimeDelta(current, xTaskGetIdleTaskHandleForCore(core)), intervalUs);
+            m_load[core] = 100.0f * static_cast<float>(intervalUs - idleUs) / static_cast<float>(intervalUs);
+            m_recent[core] = 0;
+        }
+        m_loadAvailable = true;
+        if (m_config.rebalance) {
+            rebalance(current, intervalUs);
+        }
+    }
+    m_previous.swap(current);
+    m_previousTotalUs = totalRunTime;
+#else
+    // No load figures: balance on the number of live auto-placed tasks per core
+    std::fill(std::begin(m_recent), std::end(m_recent), 0);
+    for (const auto& weak : m_tracked) {
+        auto task = weak.lock();
+        BaseType_t core = task ? task->getCoreAffinity() : tskNO_AFFINITY;
+        if (core >= 0 && core < portNUM_PROCESSORS) {
+            m_recent[core]++;
+        }
+    }
+#endif
+    m_samples++;
+    xSemaphoreGive(m_lock);
+}
+
+CoreBalancer::Statistics CoreBalancer::getStatistics() const {
+    Statistics stats;
+#if CONFIG_FREERTOS_SMP
+    stats.rebalanceSupported = true;
+#endif
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    stats.loadAvailable = m_loadAvailable;
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; ++core) {
+        stats.load[core] = m_load[core];
+        stats.placed[core] = m_placed[core];
+    }
+    stats.tracked = static_cast<esperto::uint32>(m_tracked.size());
+    stats.migrations = m_migrations;
+    stats.samples = m_samples;
+    xSemaphoreGive(m_lock);
+    return stats;
+}
+
+esperto::uint64 CoreBalancer::runTimeDelta(const std::vector<RunTimeSample>& current, TaskHandle_t handle) const {
+    esperto::uint64 now = 0;
+    esperto::uint64 before = 0;
+    for (const RunTimeSample& sample : current) {
+        if (sample.handle == handle) {
+            now = sample.runTimeUs;
+            break;
+        }
+    }
+    for (const RunTimeSample& sample : m_previous) {
+        if (sample.handle == handle) {
+            before = sample.runTimeUs;
+            break;
+        }
+    }
+    return now >= before ? now - before : 0;
+}
+
+void CoreBalancer::rebalance(const std::vector<RunTimeSample>& current, esperto::uint64 intervalUs) {
+#if CONFIG_FREERTOS_SMP
+    if (portNUM_PROCESSORS < 2) {
+        return;
+    }
+    BaseType_t busiest = 0;
+    BaseType_t idlest = 0;
+    for (BaseType_t core = 1; core < portNUM_PROCESSORS; ++core) {
+        if (m_load[core] > m_load[busiest]) {
+            busiest = core;
+        }
+        if (m_load[core] < m_load[idlest]) {
+            idlest = core;
+        }
+    }
+    float gap = m_load[busiest] - m_load[idlest];
+    if (gap < static_cast<float>(m_config.imbalancePercent)) {
+        return;
+    }
+
+    // Moving a task with share s narrows the gap by 2s: take the largest share up to gap / 2,
+    // so the move cannot simply swap which core is overloaded
+    std::shared_ptr<Task> candidate;
+    float candidateShare = 0.0f;
+    for (const auto& weak : m_tracked) {
+        auto task = weak.lock();
+        if (!task || task->getCoreAffinity() != busiest || task->isCompleted() || !task->getHandle()) {
+            continue;
+        }
+        // Safe point: only tasks parked in a blocking call are moved, never one mid-job
+        eTaskState state = eTaskGetState(task->getHandle());
+        if (state != eBlocked && state != eSuspended) {
+            continue;
+        }
+        esperto::uint64 runTimeUs = runTimeDelta(current, task->getHandle());
+        float share = 100.0f * static_cast<float>(runTimeUs) / static_cast<float>(intervalUs);
+        if (share > candidateShare && share <= gap / 2.0f) {
+            candidate = task;
+            candidateShare = share;
+        }
+    }
+
+    // One migration per sample: the next interval shows its effect before anything else moves
+    if (candidate && candidate->migrate(idlest)) {
+        m_migrations++;
+        m_load[busiest] -= candidateShare;
+        m_load[idlest] += candidateShare;
+        ESP_LOGI(TAG, "Moved %s from core %ld to core %ld (%.1f%% CPU)", candidate->getName().c_str(),
+                 static_cast<long>(busiest), static_cast<long>(idlest), static_cast<double>(candidateShare));
+    }
+#else
+    // The IDF kernel fixes a task's core at creation: placement is all it can do
+    (void)current;
+    (void)intervalUs;
+#endif
+}
+
+} // namespace esperto
@@ -0,0 +1,200 @@
+// coroutine.cpp
+// Implementation of CoTask and CoroutineLoop for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/coroutine.hpp"
+#include "../headers/task_scheduler.hpp"
+#include "esp_log.h"
+
+namespace esperto {
+
+static const char* TAG = "CoroutineLoop";
+
+thread_local CoroutineLoop* CoroutineLoop::s_current = nullptr;
+
+std::coroutine_handle<> CoTask::FinalAwaiter::await_suspend(Handle handle) noexcept {
+    promise_type& promise = handle.promise();
+    if (promise.detached) {
+        // Spawned coroutines own their frame: nothing else refers to it any more
+        CoroutineLoop* loop = promise.node.loop;
+        handle.destroy();
+        if (loop) {
+            loop->m_live.fetch_sub(1);
+        }
+        return std::noop_coroutine();
+    }
+    return promise.continuation ? promise.continuation : std::noop_coroutine();
+}
+
+std::coroutine_handle<> CoTask::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().continuation = awaiting;
+    m_handle.promise().node.loop = CoroutineLoop::current();
+    return m_handle;
+}
+
+CoroutineLoop::CoroutineLoop(const Config& config)
+    : m_config(config), m_ready(nullptr), m_handle(nullptr), m_exited(nullptr), m_running(false),
+      m_stopping(false), m_live(0), m_spawned(0), m_resumed(0) {}
+
+CoroutineLoop::~CoroutineLoop() {
+    stop();
+}
+
+bool CoroutineLoop::start() {
+    if (m_running) {
+        return true;
+    }
+
+    m_exited = xSemaphoreCreateBinary();
+    if (!m_exited) {
+        return false;
+    }
+
+    m_stopping = false;
+    m_running = true;
+    BaseType_t result = xTaskCreate(
+        &CoroutineLoop::loopEntryPoint,
+        "CoroutineLoop",
+        m_config.stackSize,
+        this,
+        m_config.priority,
+        &m_handle
+    );
+    if (result != pdPASS) {
+        m_running = false;
+        m_handle = nullptr;
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void CoroutineLoop::stop() {
+    if (!m_running || current() == this) {
+        return;
+    }
+
+    m_stopping = true;
+    xTaskNotifyGive(m_handle);
+    xSemaphoreTake(m_exited, portMAX_DELAY);
+    vSemaphoreDelete(m_exited);
+    m_exited = nullptr;
+    m_handle = nullptr;
+    m_running = false;
+}
+
+bool CoroutineLoop::spawn(CoTask task) {
+    CoTask::Handle handle = task.release();
+    if (!handle) {
+        return false;
+    }
+
+    CoTask::promise_type& promise = handle.promise();
+    promise.detached = true;
+    promise.node.handle = handle;
+    promise.node.loop = this;
+    m_live.fetch_add(1);
+    m_spawned.fetch_add(1);
+    schedule(promise.node);
+    return true;
+}
+
+void CoroutineLoop::schedule(CoroutineNode& node) {
+    if (push(node) && m_handle) {
+        xTaskNotifyGive(m_handle);
+    }
+}
+
+void IRAM_ATTR CoroutineLoop::scheduleFromISR(CoroutineNode& node) {
+    if (push(node) && m_handle) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(m_handle, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+}
+
+CoroutineLoop* CoroutineLoop::current() {
+    return s_current;
+}
+
+bool CoroutineLoop::isRunning() const {
+    return m_running;
+}
+
+CoroutineLoop::Statistics CoroutineLoop::getStatistics() const {
+    Statistics stats;
+    stats.live = m_live.load();
+    stats.spawned = m_spawned.load();
+    stats.resumed = m_resumed.load();
+    return stats;
+}
+
+void CoroutineLoop::loopEntryPoint(void* param) {
+    CoroutineLoop* self = static_cast<CoroutineLoop*>(param);
+    s_current = self;
+    self->run();
+    xSemaphoreGive(self->m_exited);
+    vTaskDelete(nullptr);
+}
+
+void CoroutineLoop::run() {
+    while (!m_stopping) {
+        CoroutineNode* pending = m_ready.exchange(nullptr, std::memory_order_acquire);
+        if (!pending) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // The queue is a LIFO stack: reverse it so coroutines resume in scheduling order
+        CoroutineNode* ready = nullptr;
+        while (pending) {
+            CoroutineNode* next = pending->next;
+            pending->next = ready;
+            ready = pending;
+            pending = next;
+        }
+
+        while (ready) {
+            CoroutineNode* node = ready;
+            // Resuming may destroy the frame that holds the node
+            ready = ready->next;
+            node->next = nullptr;
+            m_resumed.fetch_add(1, std::memory_order_relaxed);
+            node->handle.resume();
+        }
+    }
+}
+
+bool CoroutineLoop::push(CoroutineNode& node) {
+    CoroutineNode* head = m_ready.load(std::memory_order_relaxed);
+    do {
+        node.next = head;
+    } while (!m_ready.compare_exchange_weak(head, &node, std::memory_order_release, std::memory_order_relaxed));
+    // Only the push onto an empty queue needs to wake the loop
+    return head == nullptr;
+}
+
+bool DelayAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    CoroutineLoop* loop = CoroutineLoop::current();
+    if (loop) {
+        m_node.handle = handle;
+        m_node.loop = loop;
+        TimerService::TimerId id = TaskScheduler::instance().scheduleAfter(m_delayMs, [this]() {
+            m_node.loop->schedule(m_node);
+        });
+        if (id != TimerService::InvalidTimer) {
+            return true;
+        }
+        // Blocking here would stall every coroutine on the loop: resume at once, undelayed
+        ESP_LOGW(TAG, "No free timer for a %u ms delay", static_cast<unsigned>(m_delayMs));
+        m_failed = true;
+        return false;
+    }
+    // Not on a loop: block the calling task instead
+    vTaskDelay(pdMS_TO_TICKS(m_delayMs));
+    return false;
+}
+
+} // namespace esperto
@@ -5,17 +5,23 @@
 
 #include "../headers/gpio.hpp"
 
+extern "C" {
+#include "esp_log.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#include "hal/gpio_ll.h"
+#endif
+}
+
 namespace esperto {
 
-bool Gpio::s_gpio_service_installed = false;
+static const char* TAG = "Gpio";
 
-Gpio::Gpio(gpio_num_t pin) : m_pin(pin), m_interruptEnabled(false) {    
+Gpio::Gpio(gpio_num_t pin)
+    : m_pin(pin), m_mode(DispatchMode::Immediate), m_interruptType(GPIO_INTR_DISABLE), m_interruptEnabled(false) {    
     
-    // Install GPIO ISR service if not already installed
-    if (!s_gpio_service_installed) {
-        gpio_install_isr_service(0);
-        s_gpio_service_installed = true;
-    }
+    // Install the interrupt handling of the backend if not already installed
+    GpioBackend::current().install();
 }
 
 Gpio::~Gpio() {
@@ -25,52 +31,163 @@ Gpio::~Gpio() {
 }
 
 void Gpio::setDirection(gpio_mode_t mode) {
-    gpio_set_direction(m_pin, mode);
+    GpioBackend::current().setDirection(m_pin, mode);
 }
 
 void Gpio::setLevel(uint32_t level) {
-    gpio_set_level(m_pin, level);
+    GpioBackend::current().setLevel(m_pin, level);
 }
 
 int Gpio::getLevel() const {
-    return gpio_get_level(m_pin);
+    return GpioBackend::current().getLevel(m_pin);
 }
 
 void Gpio::setPullup(bool enable) {
-    gpio_set_pull_mode(m_pin, enable ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+    GpioBackend::current().setPullMode(m_pin, enable ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
 }
 
 void Gpio::setPulldown(bool enable) {
-    gpio_set_pull_mode(m_pin, enable ? GPIO_PULLDOWN_ONLY : GPIO_FLOATING);
+    GpioBackend::current().setPullMode(m_pin, enable ? GPIO_PULLDOWN_ONLY : GPIO_FLOATING);
 }
 
-void Gpio::enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback) {
+void Gpio::enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback, DispatchMode mode) {
+    if (mode == DispatchMode::Deferred) {
+        enableDeferredInterrupt(interruptType, [callback](Gpio& gpio, const GpioEvent&) {
+            callback(gpio);
+        });
+        return;
+    }
+    if (mode == DispatchMode::Debounced) {
+#if CONFIG_IDF_TARGET_LINUX
+        ESP_LOGE(TAG, "GPIO%d: debouncing needs the chip, interrupt left disabled", static_cast<int>(m_pin));
+#else
+        enableInterrupt(interruptType, callback, GpioDebounce());
+#endif
+        return;
+    }
+
     if (m_interruptEnabled) {
         disableInterrupt();
     }
     
     m_callback = callback;
+    m_mode = DispatchMode::Immediate;
+    m_interruptType = interruptType;
     
     // Configure interrupt
-    gpio_set_intr_type(m_pin, interruptType);
-    gpio_isr_handler_add(m_pin, gpio_isr_handler, this);
+    GpioBackend& backend = GpioBackend::current();
+    backend.setInterruptType(m_pin, interruptType);
+    backend.addHandler(m_pin, gpio_isr_handler, this);
     
     m_interruptEnabled = true;
 }
 
+#if !CONFIG_IDF_TARGET_LINUX
+void Gpio::enableInterrupt(gpio_int_type_t interruptType, InterruptCallback callback, const GpioDebounce& debounce) {
+    if (m_interruptEnabled) {
+        disableInterrupt();
+    }
+
+    m_callback = callback;
+    m_mode = DispatchMode::Debounced;
+    if (!GpioDebouncer::instance().attach(*this, interruptType, debounce)) {
+        m_callback = nullptr;
+        m_mode = DispatchMode::Immediate;
+        return;
+    }
+    m_interruptType = interruptType;
+    m_debounce = debounce;
+
+    // Both edges feed the state machine; the requested edge only filters the callbacks
+    GpioBackend& backend = GpioBackend::current();
+    backend.setInterruptType(m_pin, GPIO_INTR_ANYEDGE);
+    backend.addHandler(m_pin, gpio_debounce_isr_handler, this);
+
+    m_interruptEnabled = true;
+}
+#endif
+
+void Gpio::enableDeferredInterrupt(gpio_int_type_t interruptType, EventCallback callback) {
+    if (m_interruptEnabled) {
+        disableInterrupt();
+    }
+
+    GpioDispatcher& dispatcher = GpioDispatcher::instance();
+    if (!dispatcher.start()) {
+        ESP_LOGE(TAG, "GPIO%d: dispatcher not running, interrupt left disabled", static_cast<int>(m_pin));
+        return;
+    }
+
+    m_eventCallback = callback;
+    m_mode = DispatchMode::Deferred;
+    m_interruptType = interruptType;
+    dispatcher.attach(*this);
+
+    GpioBackend& backend = GpioBackend::current();
+    backend.setInterruptType(m_pin, interruptType);
+    backend.addHandler(m_pin, gpio_deferred_isr_handler, this);
+
+    m_interruptEnabled = true;
+}
+
 void Gpio::disableInterrupt() {
     if (m_interruptEnabled) {
-        gpio_isr_handler_remove(m_pin);
-        gpio_set_intr_type(m_pin, GPIO_INTR_DISABLE);
+        GpioBackend& backend = GpioBackend::current();
+        backend.removeHandler(m_pin);
+        backend.setInterruptType(m_pin, GPIO_INTR_DISABLE);
+        if (m_mode == DispatchMode::Deferred) {
+            // Waits for a batch in progress: no callback runs on this object afterwards
+            GpioDispatcher::instance().detach(*this);
+        }
+#if !CONFIG_IDF_TARGET_LINUX
+        if (m_mode == DispatchMode::Debounced) {
+            // Waits for a timer run in progress, like the dispatcher
+            GpioDebouncer::instance().detach(*this);
+        }
+#endif
         m_interruptEnabled = false;
+        m_interruptType = GPIO_INTR_DISABLE;
         m_callback = nullptr;
+        m_eventCallback = nullptr;
     }
 }
 
+Gpio::DispatchMode Gpio::getDispatchMode() const {
+    return m_mode;
+}
+
+int Gpio::getDebouncedLevel() const {
+#if !CONFIG_IDF_TARGET_LINUX
+    if (m_interruptEnabled && m_mode == DispatchMode::Debounced) {
+        return GpioDebouncer::instance().getStableLevel(m_pin);
+    }
+#endif
+    return getLevel();
+}
+
 bool Gpio::isInterruptEnabled() const {
     return m_interruptEnabled;
 }
 
+GpioEdgeAwaiter Gpio::edgeAsync(gpio_int_type_t edge) {
+    return GpioEdgeAwaiter(*this, edge);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+std::unique_ptr<PwmOutput> Gpio::startPwm(esperto::uint32 frequencyHz, float dutyPercent) {
+    PwmOutput::Config config;
+    config.frequencyHz = frequencyHz;
+    config.dutyPercent = dutyPercent;
+    auto output = std::make_unique<PwmOutput>(m_pin, config);
+    return output->start() ? std::move(output) : nullptr;
+}
+
+std::unique_ptr<PulseTrain> Gpio::startPulseTrain(const PulseTrain::Config& config) {
+    auto output = std::make_unique<PulseTrain>(m_pin, config);
+    return output->start() ? std::move(output) : nullptr;
+}
+#endif
+
 gpio_num_t Gpio::getPin() const {
     return m_pin;
 }
@@ -87,4 +204,106 @@ void IRAM_ATTR Gpio::gpio_isr_handler(void* arg) {
     }
 }
 
+void IRAM_ATTR Gpio::gpio_deferred_isr_handler(void* arg) {
+    Gpio* gpio = static_cast<Gpio*>(arg);
+    GpioEvent event;
+    event.pin = gpio->m_pin;
+#if CONFIG_IDF_TARGET_LINUX
+    GpioBackend& backend = GpioBackend::current();
+    event.level = static_cast<esperto::uint32>(backend.getLevel(gpio->m_pin));
+    event.cycles = backend.getTimestamp();
+#else
+    // Register reads only: gpio_get_level and the backend vtable are not guaranteed to be in
+    // IRAM. The handler only survives a disabled flash cache when the GpioIsrRouter is
+    // configured with ESP_INTR_FLAG_IRAM; with the default flags it waits for the cache
+    event.level = static_cast<esperto::uint32>(gpio_ll_get_level(&GPIO, gpio->m_pin));
+    event.cycles = esp_cpu_get_cycle_count();
+#endif
+    // Not instance(): its function-local static guard lives in flash
+    GpioDispatcher::queueFromISR(event);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+void IRAM_ATTR Gpio::gpio_debounce_isr_handler(void* arg) {
+    Gpio* gpio = static_cast<Gpio*>(arg);
+    GpioDebouncer::recordFromISR(gpio->m_pin);
+}
+#endif
+
+void Gpio::dispatch(const GpioEvent& event) {
+    if (m_eventCallback) {
+        m_eventCallback(*this, event);
+    }
+}
+
+Gpio::InterruptSetup Gpio::saveInterrupt() const {
+    InterruptSetup setup;
+    setup.enabled = m_interruptEnabled;
+    setup.mode = m_mode;
+    setup.type = m_interruptType;
+    setup.callback = m_callback;
+    setup.eventCallback = m_eventCallback;
+#if !CONFIG_IDF_TARGET_LINUX
+    setup.debounce = m_debounce;
+#endif
+    return setup;
+}
+
+void Gpio::restoreInterrupt(const InterruptSetup& setup) {
+    disableInterrupt();
+    if (!setup.enabled) {
+        return;
+    }
+
+    switch (setup.mode) {
+    case DispatchMode::Deferred:
+        enableDeferredInterrupt(setup.type, setup.eventCallback);
+        break;
+#if !CONFIG_IDF_TARGET_LINUX
+    case DispatchMode::Debounced:
+        enableInterrupt(setup.type, setup.callback, setup.debounce);
+        break;
+#endif
+    default:
+        enableInterrupt(setup.type, setup.callback);
+        break;
+    }
+}
+
+bool GpioEdgeAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    CoroutineLoop* loop = CoroutineLoop::current();
+    if (!loop) {
+        return false;
+    }
+
+    m_node.handle = handle;
+    m_node.loop = loop;
+    m_previous = m_gpio.saveInterrupt();
+    m_armed = true;
+    m_gpio.enableInterrupt(m_edge, [this](Gpio& gpio) {
+        // Interrupt context: queue the coroutine once and mask further edges
+        if (!m_fired.exchange(true)) {
+#if CONFIG_IDF_TARGET_LINUX
+            GpioBackend::current().disableInterrupt(gpio.getPin());
+#else
+            // Register write only, like the deferred handler: the backend vtable is not in IRAM
+            gpio_ll_intr_disable(&GPIO, gpio.getPin());
+#endif
+            m_node.loop->scheduleFromISR(m_node);
+        }
+    });
+    GpioBackend::current().enableInterrupt(m_gpio.getPin());
+    return true;
+}
+
+int GpioEdgeAwaiter::await_resume() {
+    if (m_armed) {
+        // The ISR masked the pin behind the backend's back: tell it from task context, then
+        // put back whatever interrupt the pin had before the wait
+        GpioBackend::current().disableInterrupt(m_gpio.getPin());
+        m_gpio.restoreInterrupt(m_previous);
+    }
+    return m_gpio.getLevel();
+}
+
 } // namespace esperto
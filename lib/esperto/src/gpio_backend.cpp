@@ -0,0 +1,87 @@
+// gpio_backend.cpp
+// Implementation of GpioBackend selection and EspGpioBackend class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/gpio_backend.hpp"
+#if CONFIG_IDF_TARGET_LINUX
+#include "../headers/simulated_gpio_backend.hpp"
+#else
+#include "../headers/gpio_isr_router.hpp"
+extern "C" {
+#include "esp_cpu.h"
+}
+#endif
+
+namespace esperto {
+
+static GpioBackend* s_backend = nullptr;
+
+GpioBackend& GpioBackend::current() {
+    if (!s_backend) {
+#if CONFIG_IDF_TARGET_LINUX
+        static SimulatedGpioBackend simulator;
+        s_backend = &simulator;
+#else
+        s_backend = &EspGpioBackend::instance();
+#endif
+    }
+    return *s_backend;
+}
+
+void GpioBackend::use(GpioBackend& backend) {
+    s_backend = &backend;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+EspGpioBackend& EspGpioBackend::instance() {
+    static EspGpioBackend backend;
+    return backend;
+}
+
+bool EspGpioBackend::install() {
+    return GpioIsrRouter::instance().install();
+}
+
+bool EspGpioBackend::setDirection(gpio_num_t pin, gpio_mode_t mode) {
+    return gpio_set_direction(pin, mode) == ESP_OK;
+}
+
+bool EspGpioBackend::setLevel(gpio_num_t pin, esperto::uint32 level) {
+    return gpio_set_level(pin, level) == ESP_OK;
+}
+
+int EspGpioBackend::getLevel(gpio_num_t pin) {
+    return gpio_get_level(pin);
+}
+
+bool EspGpioBackend::setPullMode(gpio_num_t pin, gpio_pull_mode_t mode) {
+    return gpio_set_pull_mode(pin, mode) == ESP_OK;
+}
+
+bool EspGpioBackend::setInterruptType(gpio_num_t pin, gpio_int_type_t type) {
+    return GpioIsrRouter::instance().setInterruptType(pin, type);
+}
+
+bool EspGpioBackend::enableInterrupt(gpio_num_t pin) {
+    return gpio_intr_enable(pin) == ESP_OK;
+}
+
+bool EspGpioBackend::disableInterrupt(gpio_num_t pin) {
+    return gpio_intr_disable(pin) == ESP_OK;
+}
+
+bool EspGpioBackend::addHandler(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    return GpioIsrRouter::instance().add(pin, handler, arg);
+}
+
+bool EspGpioBackend::removeHandler(gpio_num_t pin) {
+    return GpioIsrRouter::instance().remove(pin);
+}
+
+esperto::uint32 EspGpioBackend::getTimestamp() {
+    return esp_cpu_get_cycle_count();
+}
+#endif
+
+} // namespace esperto
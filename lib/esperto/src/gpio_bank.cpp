@@ -0,0 +1,192 @@
+// gpio_bank.cpp
+// Implementation of GpioBank class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/gpio_bank.hpp"
+
+extern "C" {
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+}
+
+namespace esperto {
+
+GpioBank::GpioBank(std::initializer_list<gpio_num_t> pins) : m_pins(pins) {
+    initialize();
+}
+
+GpioBank::GpioBank(const std::vector<gpio_num_t>& pins) : m_pins(pins) {
+    initialize();
+}
+
+void GpioBank::initialize() {
+    m_valueMask = 0;
+    m_lowMask = 0;
+    m_highMask = 0;
+    m_shift = -1;
+    m_valid = !m_pins.empty() && m_pins.size() <= MaxPins;
+
+    for (size_t bit = 0; m_valid && bit < m_pins.size(); ++bit) {
+        gpio_num_t pin = m_pins[bit];
+        if (!GPIO_IS_VALID_GPIO(pin)) {
+            m_valid = false;
+            break;
+        }
+        esperto::uint32& mask = pin < 32 ? m_lowMask : m_highMask;
+        esperto::uint32 pinBit = static_cast<esperto::uint32>(1) << (pin % 32);
+        if (mask & pinBit) {
+            m_valid = false;
+            break;
+        }
+        mask |= pinBit;
+        m_valueMask |= static_cast<esperto::uint32>(1) << bit;
+    }
+    if (!m_valid) {
+        m_valueMask = 0;
+        m_lowMask = 0;
+        m_highMask = 0;
+        return;
+    }
+
+    // Fast path: consecutive ascending pins in one register map to a plain shift
+    bool contiguous = (m_lowMask == 0) != (m_highMask == 0);
+    for (size_t bit = 1; contiguous && bit < m_pins.size(); ++bit) {
+        contiguous = m_pins[bit] == m_pins[bit - 1] + 1;
+    }
+    if (contiguous) {
+        m_shift = static_cast<esperto::int32>(m_pins[0] % 32);
+    }
+}
+
+bool GpioBank::isValid() const {
+    return m_valid;
+}
+
+bool GpioBank::setDirection(gpio_mode_t mode) {
+    if (!m_valid) {
+        return false;
+    }
+    if (mode & GPIO_MODE_DEF_OUTPUT) {
+        for (gpio_num_t pin : m_pins) {
+            if (!GPIO_IS_VALID_OUTPUT_GPIO(pin)) {
+                return false;
+            }
+        }
+    }
+
+    gpio_config_t config = {};
+    config.pin_bit_mask = static_cast<esperto::uint64>(m_lowMask) | (static_cast<esperto::uint64>(m_highMask) << 32);
+    config.mode = mode;
+    config.pull_up_en = GPIO_PULLUP_DISABLE;
+    config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    config.intr_type = GPIO_INTR_DISABLE;
+    return gpio_config(&config) == ESP_OK;
+}
+
+void GpioBank::setPullup(bool enable) {
+    for (gpio_num_t pin : m_pins) {
+        gpio_set_pull_mode(pin, enable ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+    }
+}
+
+void GpioBank::toRegisters(esperto::uint32 value, esperto::uint32& low, esperto::uint32& high) const {
+    value &= m_valueMask;
+    if (m_shift >= 0) {
+        low = m_lowMask ? value << m_shift : 0;
+        high = m_highMask ? value << m_shift : 0;
+        return;
+    }
+
+    low = 0;
+    high = 0;
+    while (value) {
+        size_t bit = static_cast<size_t>(__builtin_ctz(value));
+        value &= value - 1;
+        gpio_num_t pin = m_pins[bit];
+        if (pin < 32) {
+            low |= static_cast<esperto::uint32>(1) << pin;
+        } else {
+            high |= static_cast<esperto::uint32>(1) << (pin - 32);
+        }
+    }
+}
+
+void GpioBank::write(esperto::uint32 value) {
+    esperto::uint32 low = 0;
+    esperto::uint32 high = 0;
+    toRegisters(value, low, high);
+    if (m_lowMask) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, low);
+        REG_WRITE(GPIO_OUT_W1TC_REG, m_lowMask & ~low);
+    }
+#if SOC_GPIO_PIN_COUNT > 32
+    if (m_highMask) {
+        REG_WRITE(GPIO_OUT1_W1TS_REG, high);
+        REG_WRITE(GPIO_OUT1_W1TC_REG, m_highMask & ~high);
+    }
+#endif
+}
+
+void GpioBank::setBits(esperto::uint32 bits) {
+    esperto::uint32 low = 0;
+    esperto::uint32 high = 0;
+    toRegisters(bits, low, high);
+    if (low) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, low);
+    }
+#if SOC_GPIO_PIN_COUNT > 32
+    if (high) {
+        REG_WRITE(GPIO_OUT1_W1TS_REG, high);
+    }
+#endif
+}
+
+void GpioBank::clearBits(esperto::uint32 bits) {
+    esperto::uint32 low = 0;
+    esperto::uint32 high = 0;
+    toRegisters(bits, low, high);
+    if (low) {
+        REG_WRITE(GPIO_OUT_W1TC_REG, low);
+    }
+#if SOC_GPIO_PIN_COUNT > 32
+    if (high) {
+        REG_WRITE(GPIO_OUT1_W1TC_REG, high);
+    }
+#endif
+}
+
+esperto::uint32 GpioBank::read() const {
+    esperto::uint32 low = m_lowMask ? REG_READ(GPIO_IN_REG) : 0;
+    esperto::uint32 high = 0;
+#if SOC_GPIO_PIN_COUNT > 32
+    high = m_highMask ? REG_READ(GPIO_IN1_REG) : 0;
+#endif
+    if (m_shift >= 0) {
+        return ((m_lowMask ? low : high) >> m_shift) & m_valueMask;
+    }
+
+    esperto::uint32 value = 0;
+    for (size_t bit = 0; bit < m_pins.size(); ++bit) {
+        gpio_num_t pin = m_pins[bit];
+        esperto::uint32 level = pin < 32 ? (low >> pin) & 1 : (high >> (pin - 32)) & 1;
+        value |= level << bit;
+    }
+    return value;
+}
+
+size_t GpioBank::getWidth() const {
+    return m_pins.size();
+}
+
+gpio_num_t GpioBank::getPin(size_t bit) const {
+    return bit < m_pins.size() ? m_pins[bit] : GPIO_NUM_NC;
+}
+
+bool GpioBank::equals(const Object& other) const {
+    auto* o = static_cast<const GpioBank*>(&other);
+    return o && o->m_pins == m_pins;
+}
+
+} // namespace esperto
@@ -0,0 +1,226 @@
+// gpio_debouncer.cpp
+// Implementation of GpioDebouncer class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/gpio_debouncer.hpp"
+#include "../headers/gpio.hpp"
+#include <algorithm>
+
+extern "C" {
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "GpioDebouncer";
+
+DRAM_ATTR GpioDebouncer* GpioDebouncer::s_active = nullptr;
+
+GpioDebouncer& GpioDebouncer::instance() {
+    static GpioDebouncer debouncer;
+    return debouncer;
+}
+
+GpioDebouncer::GpioDebouncer()
+    : m_pins{}, m_pending(0), m_armed(false), m_deadlineUs(0), m_attached(0), m_edges(0), m_transitions(0),
+      m_callbacks(0), m_glitches(0), m_timerRuns(0), m_timer(nullptr), m_spinlock(portMUX_INITIALIZER_UNLOCKED) {
+    // Recursive: a callback may disable its own interrupt while the timer task holds the lock
+    m_lock = xSemaphoreCreateRecursiveMutexStatic(&m_lockBuffer);
+}
+
+bool GpioDebouncer::attach(Gpio& gpio, gpio_int_type_t edge, const GpioDebounce& debounce) {
+    if (edge != GPIO_INTR_POSEDGE && edge != GPIO_INTR_NEGEDGE && edge != GPIO_INTR_ANYEDGE) {
+        ESP_LOGE(TAG, "GPIO%d: only edge interrupts can be debounced", static_cast<int>(gpio.getPin()));
+        return false;
+    }
+
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    if (!m_timer) {
+        esp_timer_create_args_t args = {};
+        args.callback = &GpioDebouncer::timerEntryPoint;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "GpioDebounce";
+        if (esp_timer_create(&args, &m_timer) != ESP_OK) {
+            m_timer = nullptr;
+            xSemaphoreGiveRecursive(m_lock);
+            ESP_LOGE(TAG, "Cannot create the debounce timer");
+            return false;
+        }
+        s_active = this;
+    }
+
+    gpio_num_t pin = gpio.getPin();
+    PinState state = {};
+    state.gpio = &gpio;
+    state.stableUs = debounce.stableUs;
+    state.minPulseUs = debounce.minPulseUs;
+    state.reportRising = edge != GPIO_INTR_NEGEDGE;
+    state.reportFalling = edge != GPIO_INTR_POSEDGE;
+    state.stableLevel = static_cast<esperto::uint32>(gpio_get_level(pin));
+
+    portENTER_CRITICAL(&m_spinlock);
+    if (!m_pins[pin].gpio) {
+        m_attached++;
+    }
+    m_pins[pin] = state;
+    m_pending &= ~(static_cast<esperto::uint64>(1) << pin);
+    portEXIT_CRITICAL(&m_spinlock);
+
+    xSemaphoreGiveRecursive(m_lock);
+    return true;
+}
+
+void GpioDebouncer::detach(Gpio& gpio) {
+    gpio_num_t pin = gpio.getPin();
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&m_spinlock);
+    if (m_pins[pin].gpio == &gpio) {
+        // A timer already armed for this pin finds nothing to do
+        m_pins[pin] = PinState{};
+        m_pending &= ~(static_cast<esperto::uint64>(1) << pin);
+        m_attached--;
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+    xSemaphoreGiveRecursive(m_lock);
+}
+
+void IRAM_ATTR GpioDebouncer::edgeFromISR(gpio_num_t pin) {
+    esperto::int64 now = esp_timer_get_time();
+    esperto::uint64 bit = static_cast<esperto::uint64>(1) << pin;
+
+    portENTER_CRITICAL_ISR(&m_spinlock);
+    PinState& state = m_pins[pin];
+    if (state.gpio) {
+        m_edges++;
+        if (!(m_pending & bit)) {
+            m_pending |= bit;
+            state.burstStartUs = now;
+        }
+        state.lastEdgeUs = now;
+        armLocked(deadlineOf(state), now);
+    }
+    portEXIT_CRITICAL_ISR(&m_spinlock);
+}
+
+void IRAM_ATTR GpioDebouncer::recordFromISR(gpio_num_t pin) {
+    GpioDebouncer* debouncer = s_active;
+    if (debouncer) {
+        debouncer->edgeFromISR(pin);
+    }
+}
+
+int GpioDebouncer::getStableLevel(gpio_num_t pin) const {
+    int level = -1;
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    if (m_pins[pin].gpio) {
+        level = static_cast<int>(m_pins[pin].stableLevel);
+    }
+    xSemaphoreGiveRecursive(m_lock);
+    return level;
+}
+
+GpioDebouncer::Statistics GpioDebouncer::getStatistics() const {
+    Statistics stats;
+    portENTER_CRITICAL(const_cast<portMUX_TYPE*>(&m_spinlock));
+    stats.pins = m_attached;
+    stats.pending = static_cast<esperto::uint32>(__builtin_popcountll(m_pending));
+    stats.edges = m_edges;
+    stats.transitions = m_transitions;
+    stats.callbacks = m_callbacks;
+    stats.glitches = m_glitches;
+    stats.timerRuns = m_timerRuns;
+    portEXIT_CRITICAL(const_cast<portMUX_TYPE*>(&m_spinlock));
+    return stats;
+}
+
+void GpioDebouncer::timerEntryPoint(void* param) {
+    static_cast<GpioDebouncer*>(param)->run();
+}
+
+void GpioDebouncer::run() {
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+
+    // Collect the pins whose burst has settled; later edges re-arm the timer on their own
+    esperto::uint64 settled = 0;
+    portENTER_CRITICAL(&m_spinlock);
+    m_armed = false;
+    m_timerRuns++;
+    esperto::int64 now = esp_timer_get_time();
+    esperto::uint64 pending = m_pending;
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        if (deadlineOf(m_pins[pin]) <= now) {
+            settled |= static_cast<esperto::uint64>(1) << pin;
+        }
+    }
+    m_pending &= ~settled;
+    portEXIT_CRITICAL(&m_spinlock);
+
+    // Sample outside the spinlock: gpio_get_level and the callbacks are ordinary task code
+    while (settled) {
+        int pin = __builtin_ctzll(settled);
+        settled &= settled - 1;
+        PinState& state = m_pins[pin];
+        if (!state.gpio) {
+            continue;
+        }
+
+        esperto::uint32 level = static_cast<esperto::uint32>(gpio_get_level(static_cast<gpio_num_t>(pin)));
+        bool report = false;
+        portENTER_CRITICAL(&m_spinlock);
+        if (level == state.stableLevel) {
+            m_glitches++;
+        } else {
+            state.stableLevel = level;
+            m_transitions++;
+            report = level ? state.reportRising : state.reportFalling;
+            if (report) {
+                m_callbacks++;
+            }
+        }
+        portEXIT_CRITICAL(&m_spinlock);
+
+        if (report && state.gpio->m_callback) {
+            state.gpio->m_callback(*state.gpio);
+        }
+    }
+
+    // Re-arm for the earliest burst still open, unless an ISR already armed for an earlier one
+    portENTER_CRITICAL(&m_spinlock);
+    pending = m_pending;
+    if (pending) {
+        esperto::int64 earliest = INT64_MAX;
+        while (pending) {
+            int pin = __builtin_ctzll(pending);
+            pending &= pending - 1;
+            earliest = std::min(earliest, deadlineOf(m_pins[pin]));
+        }
+        armLocked(earliest, esp_timer_get_time());
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+
+    xSemaphoreGiveRecursive(m_lock);
+}
+
+esperto::int64 IRAM_ATTR GpioDebouncer::deadlineOf(const PinState& state) {
+    esperto::int64 quiet = state.lastEdgeUs + state.stableUs;
+    esperto::int64 pulse = state.burstStartUs + state.minPulseUs;
+    return quiet > pulse ? quiet : pulse;
+}
+
+void IRAM_ATTR GpioDebouncer::armLocked(esperto::int64 deadlineUs, esperto::int64 nowUs) {
+    if (m_armed && deadlineUs >= m_deadlineUs) {
+        return;
+    }
+    if (m_armed) {
+        esp_timer_stop(m_timer);
+    }
+    esperto::int64 delay = deadlineUs - nowUs;
+    m_armed = esp_timer_start_once(m_timer, delay > 0 ? static_cast<esperto::uint64>(delay) : 1) == ESP_OK;
+    m_deadlineUs = deadlineUs;
+}
+
+} // namespace esperto
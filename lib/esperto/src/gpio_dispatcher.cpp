@@ -0,0 +1,206 @@
+// gpio_dispatcher.cpp
+// Implementation of GpioDispatcher class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/gpio_dispatcher.hpp"
+#include "../headers/gpio.hpp"
+
+extern "C" {
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "GpioDispatcher";
+
+DRAM_ATTR GpioDispatcher* GpioDispatcher::s_running = nullptr;
+
+GpioDispatcher& GpioDispatcher::instance() {
+    static GpioDispatcher dispatcher;
+    return dispatcher;
+}
+
+GpioDispatcher::GpioDispatcher()
+    : m_ring(nullptr), m_mask(0), m_head(0), m_tail(0), m_waiting(false), m_highWater(0), m_dropped(0),
+      m_dispatched(0), m_batches(0), m_maxBatch(0), m_targets{}, m_handle(nullptr) {
+    // Recursive: a callback may disable its own interrupt while the dispatcher holds the lock
+    m_lock = xSemaphoreCreateRecursiveMutexStatic(&m_lockBuffer);
+}
+
+bool GpioDispatcher::configure(const Config& config) {
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    bool idle = m_handle == nullptr;
+    if (idle) {
+        m_config = config;
+    }
+    xSemaphoreGiveRecursive(m_lock);
+    return idle;
+}
+
+bool GpioDispatcher::start() {
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    if (m_handle) {
+        xSemaphoreGiveRecursive(m_lock);
+        return true;
+    }
+
+    esperto::uint32 capacity = 1;
+    while (capacity < m_config.capacity) {
+        capacity <<= 1;
+    }
+    // Internal RAM: with ESP_INTR_FLAG_IRAM the ISR writes to the ring while the flash cache is disabled
+    m_ring = static_cast<GpioEvent*>(heap_caps_malloc(capacity * sizeof(GpioEvent), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (!m_ring) {
+        xSemaphoreGiveRecursive(m_lock);
+        ESP_LOGE(TAG, "No internal RAM for %lu events", static_cast<unsigned long>(capacity));
+        return false;
+    }
+    m_mask = capacity - 1;
+    m_head = 0;
+    m_tail = 0;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        &GpioDispatcher::dispatcherEntryPoint,
+        "GpioDispatch",
+        m_config.stackSize,
+        this,
+        m_config.priority,
+        &m_handle,
+        m_config.core
+    );
+    if (result != pdPASS) {
+        m_handle = nullptr;
+        heap_caps_free(m_ring);
+        m_ring = nullptr;
+        m_mask = 0;
+    } else {
+        s_running = this;
+    }
+    xSemaphoreGiveRecursive(m_lock);
+    return m_handle != nullptr;
+}
+
+bool GpioDispatcher::isRunning() const {
+    return m_handle != nullptr;
+}
+
+void GpioDispatcher::attach(Gpio& gpio) {
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    m_targets[gpio.getPin()] = &gpio;
+    xSemaphoreGiveRecursive(m_lock);
+}
+
+void GpioDispatcher::detach(Gpio& gpio) {
+    gpio_num_t pin = gpio.getPin();
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    if (m_targets[pin] == &gpio) {
+        m_targets[pin] = nullptr;
+        // The dispatcher only consumes under the lock: the queued events are ours to edit
+        esperto::uint32 head = m_head.load(std::memory_order_acquire);
+        for (esperto::uint32 index = m_tail.load(std::memory_order_relaxed); index != head; ++index) {
+            if (m_ring[index & m_mask].pin == pin) {
+                m_ring[index & m_mask].pin = GPIO_NUM_NC;
+            }
+        }
+    }
+    xSemaphoreGiveRecursive(m_lock);
+}
+
+bool IRAM_ATTR GpioDispatcher::queueFromISR(const GpioEvent& event) {
+    GpioDispatcher* dispatcher = s_running;
+    return dispatcher && dispatcher->pushFromISR(event);
+}
+
+bool IRAM_ATTR GpioDispatcher::pushFromISR(const GpioEvent& event) {
+    esperto::uint32 head = m_head.load(std::memory_order_relaxed);
+    esperto::uint32 tail = m_tail.load(std::memory_order_acquire);
+    if (!m_ring || head - tail > m_mask) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_ring[head & m_mask] = event;
+    m_head.store(head + 1, std::memory_order_seq_cst);
+
+    // Single producer: a plain load/store keeps the high-water mark exact
+    esperto::uint32 depth = head + 1 - tail;
+    if (depth > m_highWater.load(std::memory_order_relaxed)) {
+        m_highWater.store(depth, std::memory_order_relaxed);
+    }
+
+    // Only the first event after the dispatcher went to sleep pays for a notification
+    if (m_waiting.exchange(false, std::memory_order_seq_cst)) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(m_handle, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+    return true;
+}
+
+GpioDispatcher::Statistics GpioDispatcher::getStatistics() const {
+    Statistics stats;
+    stats.capacity = m_ring ? m_mask + 1 : 0;
+    stats.pending = m_head.load() - m_tail.load();
+    stats.highWater = m_highWater.load();
+    stats.dispatched = m_dispatched.load();
+    stats.dropped = m_dropped.load();
+    stats.batches = m_batches.load();
+    stats.maxBatch = m_maxBatch.load();
+    return stats;
+}
+
+void GpioDispatcher::dispatcherEntryPoint(void* param) {
+    static_cast<GpioDispatcher*>(param)->run();
+}
+
+void GpioDispatcher::run() {
+    for (;;) {
+        if (drain() > 0) {
+            continue;
+        }
+        // Announce the sleep, then re-check: an event pushed in between either is seen
+        // here or sees m_waiting and sends the notification
+        m_waiting.store(true, std::memory_order_seq_cst);
+        if (m_head.load(std::memory_order_seq_cst) == m_tail.load(std::memory_order_relaxed)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+esperto::uint32 GpioDispatcher::drain() {
+    esperto::uint32 tail = m_tail.load(std::memory_order_relaxed);
+    esperto::uint32 head = m_head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return 0;
+    }
+
+    // One lock per batch; the batch is bounded so attach/detach never wait for long
+    esperto::uint32 count = 0;
+    xSemaphoreTakeRecursive(m_lock, portMAX_DELAY);
+    while (tail != head && count <= m_mask) {
+        GpioEvent event = m_ring[tail & m_mask];
+        m_tail.store(++tail, std::memory_order_release);
+        // Events of a detached pin were discarded by detach()
+        Gpio* target = event.pin == GPIO_NUM_NC ? nullptr : m_targets[event.pin];
+        if (target) {
+            target->dispatch(event);
+        }
+        count++;
+        if (tail == head) {
+            head = m_head.load(std::memory_order_acquire);
+        }
+    }
+    xSemaphoreGiveRecursive(m_lock);
+
+    m_dispatched.fetch_add(count, std::memory_order_relaxed);
+    m_batches.fetch_add(1, std::memory_order_relaxed);
+    if (count > m_maxBatch.load(std::memory_order_relaxed)) {
+        m_maxBatch.store(count, std::memory_order_relaxed);
+    }
+    return count;
+}
+
+} // namespace esperto
@@ -0,0 +1,196 @@
+// gpio_isr_router.cpp
+// Implementation of GpioIsrRouter class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/gpio_isr_router.hpp"
+
+extern "C" {
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "hal/gpio_ll.h"
+#include "soc/soc_caps.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "GpioIsrRouter";
+
+GpioIsrRouter& GpioIsrRouter::instance() {
+    static GpioIsrRouter router;
+    return router;
+}
+
+GpioIsrRouter::GpioIsrRouter()
+    : m_backend(Backend::IsrService), m_interruptFlags(0), m_installed(false), m_handle(nullptr),
+      m_lock(portMUX_INITIALIZER_UNLOCKED), m_table{}, m_counts{}, m_clearOnEntry(0) {}
+
+bool GpioIsrRouter::configure(Backend backend, int interruptFlags) {
+    portENTER_CRITICAL(&m_lock);
+    bool idle = !m_installed;
+    if (idle) {
+        m_backend = backend;
+        m_interruptFlags = interruptFlags;
+    }
+    portEXIT_CRITICAL(&m_lock);
+    return idle;
+}
+
+GpioIsrRouter::Backend GpioIsrRouter::getBackend() const {
+    return m_backend;
+}
+
+bool GpioIsrRouter::install() {
+    if (m_installed) {
+        return true;
+    }
+
+    esp_err_t result;
+    if (m_backend == Backend::Shared) {
+        result = gpio_isr_register(&GpioIsrRouter::sharedIsr, this, m_interruptFlags, &m_handle);
+    } else {
+        result = gpio_install_isr_service(m_interruptFlags);
+        // Already installed by code outside esperto: usable as is
+        if (result == ESP_ERR_INVALID_STATE) {
+            result = ESP_OK;
+        }
+    }
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot install the %s backend (%d)", m_backend == Backend::Shared ? "shared ISR" : "ISR service",
+                 static_cast<int>(result));
+        return false;
+    }
+    m_installed = true;
+    return true;
+}
+
+bool GpioIsrRouter::setInterruptType(gpio_num_t pin, gpio_int_type_t type) {
+    if (!GPIO_IS_VALID_GPIO(pin) || gpio_set_intr_type(pin, type) != ESP_OK) {
+        return false;
+    }
+    // Same rule as the ISR service: edge interrupts are acknowledged before their handler
+    bool edge = type == GPIO_INTR_POSEDGE || type == GPIO_INTR_NEGEDGE || type == GPIO_INTR_ANYEDGE;
+    esperto::uint64 bit = 1ULL << pin;
+    portENTER_CRITICAL(&m_lock);
+    m_clearOnEntry = edge ? (m_clearOnEntry | bit) : (m_clearOnEntry & ~bit);
+    portEXIT_CRITICAL(&m_lock);
+    return true;
+}
+
+bool GpioIsrRouter::add(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    if (!GPIO_IS_VALID_GPIO(pin) || !install()) {
+        return false;
+    }
+    if (m_backend == Backend::IsrService) {
+        return gpio_isr_handler_add(pin, handler, arg) == ESP_OK;
+    }
+
+    // The handler is cleared first so the ISR never pairs the new handler with the old argument
+    portENTER_CRITICAL(&m_lock);
+    m_table[pin].handler = nullptr;
+    m_table[pin].arg = arg;
+    m_table[pin].handler = handler;
+    portEXIT_CRITICAL(&m_lock);
+    // Routes the pin to the core the shared ISR was registered on
+    return gpio_intr_enable(pin) == ESP_OK;
+}
+
+bool GpioIsrRouter::remove(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin) || !m_installed) {
+        return false;
+    }
+    if (m_backend == Backend::IsrService) {
+        return gpio_isr_handler_remove(pin) == ESP_OK;
+    }
+
+    gpio_intr_disable(pin);
+    portENTER_CRITICAL(&m_lock);
+    m_table[pin].handler = nullptr;
+    m_table[pin].arg = nullptr;
+    portEXIT_CRITICAL(&m_lock);
+    return true;
+}
+
+esperto::uint32 GpioIsrRouter::getInterruptCount(gpio_num_t pin) const {
+    return GPIO_IS_VALID_GPIO(pin) ? m_counts[pin] : 0;
+}
+
+void GpioIsrRouter::resetInterruptCounts() {
+    portENTER_CRITICAL(&m_lock);
+    for (esperto::uint32& count : m_counts) {
+        count = 0;
+    }
+    portEXIT_CRITICAL(&m_lock);
+}
+
+GpioIsrRouter::Statistics GpioIsrRouter::getStatistics() const {
+    portENTER_CRITICAL(const_cast<portMUX_TYPE*>(&m_lock));
+    Statistics stats = m_stats;
+    portEXIT_CRITICAL(const_cast<portMUX_TYPE*>(&m_lock));
+    return stats;
+}
+
+void IRAM_ATTR GpioIsrRouter::sharedIsr(void* arg) {
+    GpioIsrRouter* self = static_cast<GpioIsrRouter*>(arg);
+    esperto::uint32 core = static_cast<esperto::uint32>(esp_cpu_get_core_id());
+
+    // One snapshot of the status registers for every pending pin
+    esperto::uint32 low = 0;
+    gpio_ll_get_intr_status(&GPIO, core, &low);
+#if SOC_GPIO_PIN_COUNT > 32
+    esperto::uint32 high = 0;
+    gpio_ll_get_intr_status_high(&GPIO, core, &high);
+#endif
+
+    Statistics pass;
+    self->walk(low, 0, pass);
+#if SOC_GPIO_PIN_COUNT > 32
+    self->walk(high, 32, pass);
+#endif
+
+    portENTER_CRITICAL_ISR(&self->m_lock);
+    self->m_stats.entries++;
+    self->m_stats.dispatched += pass.dispatched;
+    self->m_stats.spurious += pass.spurious;
+    if (pass.dispatched > self->m_stats.maxPins) {
+        self->m_stats.maxPins = static_cast<esperto::uint32>(pass.dispatched);
+    }
+    portEXIT_CRITICAL_ISR(&self->m_lock);
+}
+
+void IRAM_ATTR GpioIsrRouter::walk(esperto::uint32 status, esperto::uint32 base, Statistics& pass) {
+    while (status) {
+        esperto::uint32 bit = status & (~status + 1);
+        esperto::uint32 pin = base + static_cast<esperto::uint32>(__builtin_ctz(status));
+        status &= status - 1;
+        m_counts[pin]++;
+        // Edge pins are cleared before the handler, so an edge raised while it runs stays
+        // pending; level pins after it, once the handler has removed their cause
+        bool clearFirst = (m_clearOnEntry >> pin) & 1;
+        if (clearFirst) {
+            clearStatus(bit, base);
+        }
+        gpio_isr_t handler = m_table[pin].handler;
+        if (handler) {
+            handler(m_table[pin].arg);
+            pass.dispatched++;
+        } else {
+            pass.spurious++;
+        }
+        if (!clearFirst) {
+            clearStatus(bit, base);
+        }
+    }
+}
+
+void IRAM_ATTR GpioIsrRouter::clearStatus(esperto::uint32 bit, esperto::uint32 base) {
+#if SOC_GPIO_PIN_COUNT > 32
+    if (base) {
+        gpio_ll_clear_intr_status_high(&GPIO, bit);
+        return;
+    }
+#endif
+    gpio_ll_clear_intr_status(&GPIO, bit);
+}
+
+} // namespace esperto
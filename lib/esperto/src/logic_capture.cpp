@@ -0,0 +1,345 @@
+// logic_capture.cpp
+// Implementation of LogicCapture class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/logic_capture.hpp"
+
+extern "C" {
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "LogicCapture";
+
+// Largest duration a symbol half can hold (15-bit field)
+static constexpr esperto::uint32 MaxSymbolTicks = 0x7FFF;
+
+LogicCapture::LogicCapture(const std::vector<gpio_num_t>& pins, const Config& config)
+    : m_pins(pins), m_config(config), m_pool(nullptr), m_events(nullptr), m_ready(nullptr), m_handle(nullptr),
+      m_exited(nullptr), m_running(false), m_triggered(false), m_frames(0), m_delivered(0), m_recycled(0),
+      m_overruns(0) {}
+
+LogicCapture::~LogicCapture() {
+    stop();
+    releaseQueues();
+}
+
+bool LogicCapture::start() {
+    if (m_running) {
+        return true;
+    }
+    esperto::uint64 idleTicks = static_cast<esperto::uint64>(m_config.idleThresholdNs) * m_config.resolutionHz / 1000000000ULL;
+    if (m_pins.empty() || m_config.resolutionHz == 0 || m_config.symbolsPerBuffer == 0 ||
+        m_config.buffersPerPin < 2 || m_config.preTriggerBuffers >= m_config.buffersPerPin ||
+        idleTicks == 0 || idleTicks > MaxSymbolTicks ||
+        m_config.trigger.pinIndex >= static_cast<esperto::int32>(m_pins.size())) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return false;
+    }
+
+    esperto::uint32 slots = static_cast<esperto::uint32>(m_pins.size()) * m_config.buffersPerPin;
+    // DMA-capable internal RAM: the RMT (or its DMA) writes the symbols directly
+    m_pool = static_cast<rmt_symbol_word_t*>(heap_caps_malloc(
+        static_cast<size_t>(slots) * m_config.symbolsPerBuffer * sizeof(rmt_symbol_word_t),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+    // The queues outlive stop(), for consumers still blocked in take(); a restart reuses them
+    if (m_events && m_ready) {
+        xQueueReset(m_events);
+        xQueueReset(m_ready);
+    } else {
+        // Every slot has at most one event in flight, plus the stop request
+        m_events = xQueueCreate(slots + 1, sizeof(Event));
+        m_ready = xQueueCreate(slots, sizeof(Event));
+    }
+    m_exited = xSemaphoreCreateBinary();
+    if (!m_pool || !m_events || !m_ready || !m_exited) {
+        ESP_LOGE(TAG, "Out of memory for %lu buffers", static_cast<unsigned long>(slots));
+        releaseChannels();
+        return false;
+    }
+
+    // Sized once: the ISR keeps a pointer to its Channel
+    m_channels.assign(m_pins.size(), Channel());
+    for (esperto::uint32 i = 0; i < m_pins.size(); ++i) {
+        Channel& channel = m_channels[i];
+        channel.owner = this;
+        channel.index = i;
+        channel.handle = nullptr;
+        channel.activeSlot = NoSlot;
+        for (esperto::uint32 b = 0; b < m_config.buffersPerPin; ++b) {
+            channel.freeSlots.push_back(i * m_config.buffersPerPin + b);
+        }
+
+        rmt_rx_channel_config_t channelConfig = {};
+        channelConfig.gpio_num = m_pins[i];
+        channelConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+        channelConfig.resolution_hz = m_config.resolutionHz;
+        channelConfig.mem_block_symbols = m_config.memorySymbols;
+        channelConfig.flags.with_dma = m_config.useDma ? 1 : 0;
+        rmt_rx_event_callbacks_t callbacks = {};
+        callbacks.on_recv_done = &LogicCapture::onReceiveDone;
+        if (rmt_new_rx_channel(&channelConfig, &channel.handle) != ESP_OK) {
+            ESP_LOGE(TAG, "GPIO%d: no RMT RX channel available", static_cast<int>(m_pins[i]));
+            channel.handle = nullptr;
+            releaseChannels();
+            return false;
+        }
+        if (rmt_rx_register_event_callbacks(channel.handle, &callbacks, &channel) != ESP_OK ||
+            rmt_enable(channel.handle) != ESP_OK) {
+            releaseChannels();
+            return false;
+        }
+    }
+
+    m_preTrigger.clear();
+    m_triggered = m_config.trigger.pinIndex < 0;
+    for (Channel& channel : m_channels) {
+        arm(channel);
+    }
+
+    m_running = true;
+    BaseType_t result = xTaskCreate(
+        &LogicCapture::captureEntryPoint,
+        "LogicCapture",
+        m_config.stackSize,
+        this,
+        m_config.priority,
+        &m_handle
+    );
+    if (result != pdPASS) {
+        m_running = false;
+        m_handle = nullptr;
+        releaseChannels();
+        return false;
+    }
+    return true;
+}
+
+void LogicCapture::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    Event event = {EventType::Stop, NoSlot, 0, 0};
+    xQueueSend(m_events, &event, portMAX_DELAY);
+    xSemaphoreTake(m_exited, portMAX_DELAY);
+    m_handle = nullptr;
+    m_running = false;
+    releaseChannels();
+
+    // Wake the consumers blocked in take(): every one of them finds a stop event
+    xQueueReset(m_events);
+    xQueueReset(m_ready);
+    while (xQueueSend(m_ready, &event, 0) == pdTRUE) {
+    }
+}
+
+bool LogicCapture::isRunning() const {
+    return m_running;
+}
+
+bool LogicCapture::take(Buffer& buffer, esperto::uint32 timeoutMs) {
+    if (!m_running) {
+        return false;
+    }
+    Event event;
+    if (xQueueReceive(m_ready, &event, detail::timeoutToTicks(timeoutMs)) != pdTRUE ||
+        event.type == EventType::Stop) {
+        return false;
+    }
+    buffer.pinIndex = event.slot / m_config.buffersPerPin;
+    buffer.pin = m_pins[buffer.pinIndex];
+    buffer.symbols = slotSymbols(event.slot);
+    buffer.count = event.count;
+    buffer.timestampUs = event.timestampUs;
+    buffer.slot = event.slot;
+    return true;
+}
+
+void LogicCapture::release(const Buffer& buffer) {
+    if (!m_running || !buffer.symbols) {
+        return;
+    }
+    // The capture task owns the pools: hand the slot back through its queue
+    Event event = {EventType::Released, buffer.slot, 0, 0};
+    xQueueSend(m_events, &event, portMAX_DELAY);
+}
+
+esperto::uint32 LogicCapture::ticksToNs(esperto::uint32 ticks) const {
+    return static_cast<esperto::uint32>(static_cast<esperto::uint64>(ticks) * 1000000000ULL / m_config.resolutionHz);
+}
+
+LogicCapture::Statistics LogicCapture::getStatistics() const {
+    Statistics stats;
+    stats.triggered = m_triggered.load();
+    stats.frames = m_frames.load();
+    stats.delivered = m_delivered.load();
+    stats.recycled = m_recycled.load();
+    stats.overruns = m_overruns.load();
+    return stats;
+}
+
+bool LogicCapture::equals(const Object& other) const {
+    auto* o = static_cast<const LogicCapture*>(&other);
+    return o && o->m_pins == m_pins;
+}
+
+bool IRAM_ATTR LogicCapture::onReceiveDone(rmt_channel_handle_t, const rmt_rx_done_event_data_t* data, void* context) {
+    Channel* channel = static_cast<Channel*>(context);
+    Event event = {EventType::Filled, channel->activeSlot, static_cast<esperto::uint32>(data->num_symbols), esp_timer_get_time()};
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    xQueueSendFromISR(channel->owner->m_events, &event, &higherPriorityTaskWoken);
+    return higherPriorityTaskWoken == pdTRUE;
+}
+
+void LogicCapture::captureEntryPoint(void* param) {
+    LogicCapture* self = static_cast<LogicCapture*>(param);
+    self->captureLoop();
+    xSemaphoreGive(self->m_exited);
+    vTaskDelete(nullptr);
+}
+
+void LogicCapture::captureLoop() {
+    for (;;) {
+        Event event;
+        if (xQueueReceive(m_events, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (event.type == EventType::Stop) {
+            return;
+        }
+        if (event.type == EventType::Released) {
+            recycle(event.slot);
+            continue;
+        }
+
+        // Restart the channel first: edges are lost for as long as it has no buffer
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+        Channel& channel = m_channels[event.slot / m_config.buffersPerPin];
+        channel.activeSlot = NoSlot;
+        arm(channel);
+
+        if (!m_triggered && matchesTrigger(event)) {
+            m_triggered = true;
+            for (const Event& earlier : m_preTrigger) {
+                deliver(earlier);
+            }
+            m_preTrigger.clear();
+        }
+        if (m_triggered) {
+            deliver(event);
+            continue;
+        }
+
+        m_preTrigger.push_back(event);
+        while (m_preTrigger.size() > m_config.preTriggerBuffers) {
+            esperto::uint32 oldest = m_preTrigger.front().slot;
+            m_preTrigger.pop_front();
+            m_recycled.fetch_add(1, std::memory_order_relaxed);
+            recycle(oldest);
+        }
+    }
+}
+
+void LogicCapture::arm(Channel& channel) {
+    if (channel.freeSlots.empty()) {
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    esperto::uint32 slot = channel.freeSlots.back();
+    channel.freeSlots.pop_back();
+    channel.activeSlot = slot;
+
+    rmt_receive_config_t receiveConfig = {};
+    receiveConfig.signal_range_min_ns = m_config.glitchFilterNs;
+    receiveConfig.signal_range_max_ns = m_config.idleThresholdNs;
+    if (rmt_receive(channel.handle, slotSymbols(slot), m_config.symbolsPerBuffer * sizeof(rmt_symbol_word_t),
+                    &receiveConfig) != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO%d: receive rejected", static_cast<int>(m_pins[channel.index]));
+        channel.activeSlot = NoSlot;
+        channel.freeSlots.push_back(slot);
+    }
+}
+
+void LogicCapture::recycle(esperto::uint32 slot) {
+    Channel& channel = m_channels[slot / m_config.buffersPerPin];
+    channel.freeSlots.push_back(slot);
+    if (channel.activeSlot == NoSlot) {
+        arm(channel);
+    }
+}
+
+void LogicCapture::deliver(const Event& event) {
+    // The ready queue holds every slot, so this never blocks
+    xQueueSend(m_ready, &event, 0);
+    m_delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool LogicCapture::matchesTrigger(const Event& event) const {
+    if (static_cast<esperto::int32>(event.slot / m_config.buffersPerPin) != m_config.trigger.pinIndex) {
+        return false;
+    }
+    const rmt_symbol_word_t* symbols = slotSymbols(event.slot);
+    // The zero-duration half that ends the frame is the level the line idled at, for at
+    // least idleThresholdNs
+    const Trigger& trigger = m_config.trigger;
+    bool idleMatches = m_config.idleThresholdNs >= trigger.minDurationNs;
+    for (esperto::uint32 i = 0; i < event.count; ++i) {
+        const rmt_symbol_word_t& symbol = symbols[i];
+        if (symbol.duration0 == 0) {
+            return symbol.level0 == trigger.level && idleMatches;
+        }
+        if (symbol.level0 == trigger.level && ticksToNs(symbol.duration0) >= trigger.minDurationNs) {
+            return true;
+        }
+        if (symbol.duration1 == 0) {
+            return symbol.level1 == trigger.level && idleMatches;
+        }
+        if (symbol.level1 == trigger.level && ticksToNs(symbol.duration1) >= trigger.minDurationNs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+rmt_symbol_word_t* LogicCapture::slotSymbols(esperto::uint32 slot) const {
+    return m_pool + static_cast<size_t>(slot) * m_config.symbolsPerBuffer;
+}
+
+void LogicCapture::releaseChannels() {
+    // Channels first: once disabled, no ISR posts to the queues below
+    for (Channel& channel : m_channels) {
+        if (channel.handle) {
+            rmt_disable(channel.handle);
+            rmt_del_channel(channel.handle);
+        }
+    }
+    m_channels.clear();
+    m_preTrigger.clear();
+    if (m_exited) {
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+    }
+    if (m_pool) {
+        heap_caps_free(m_pool);
+        m_pool = nullptr;
+    }
+}
+
+void LogicCapture::releaseQueues() {
+    if (m_events) {
+        vQueueDelete(m_events);
+        m_events = nullptr;
+    }
+    if (m_ready) {
+        vQueueDelete(m_ready);
+        m_ready = nullptr;
+    }
+}
+
+} // namespace esperto
@@ -0,0 +1,1025 @@
+// mqtt_client.cpp
+// Implementation of MqttClient class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/mqtt_client.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if !CONFIG_IDF_TARGET_LINUX
+#include "../headers/wifi.hpp"
+#endif
+
+extern "C" {
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "MqttClient";
+
+// MQTT 3.1.1 control packet types (first byte, flags cleared)
+static constexpr esperto::uint8 PacketConnect = 0x10;
+static constexpr esperto::uint8 PacketConnAck = 0x20;
+static constexpr esperto::uint8 PacketPublish = 0x30;
+static constexpr esperto::uint8 PacketPubAck = 0x40;
+static constexpr esperto::uint8 PacketPingReq = 0xC0;
+static constexpr esperto::uint8 PacketPingResp = 0xD0;
+static constexpr esperto::uint8 PacketDisconnect = 0xE0;
+static constexpr esperto::uint8 PublishDup = 0x08;
+static constexpr esperto::uint8 PublishRetain = 0x01;
+
+// A write that cannot progress for this long means the connection is gone
+static constexpr esperto::uint32 WriteTimeoutMs = 5000;
+
+static constexpr EventBits_t DrainedBit = 1 << 0;
+
+// Spool file record, followed by the topic and the payload
+struct SpoolRecord {
+    esperto::uint16 topicLength;
+    esperto::uint8 qos;
+    esperto::uint8 retain;
+    esperto::uint32 payloadLength;
+};
+
+static size_t remainingLengthSize(size_t length) {
+    size_t bytes = 1;
+    while (length >= 128) {
+        length /= 128;
+        ++bytes;
+    }
+    return bytes;
+}
+
+static void putRemainingLength(std::vector<esperto::uint8>& out, size_t length) {
+    do {
+        esperto::uint8 digit = length % 128;
+        length /= 128;
+        out.push_back(length > 0 ? digit | 0x80 : digit);
+    } while (length > 0);
+}
+
+// Bytes used by the remaining length field, 0 if more data is needed, -1 if malformed
+static int decodeRemainingLength(const esperto::uint8* data, size_t available, size_t& length) {
+    length = 0;
+    size_t multiplier = 1;
+    for (size_t i = 0; i < 4; ++i) {
+        if (i >= available) {
+            return 0;
+        }
+        length += (data[i] & 0x7F) * multiplier;
+        if ((data[i] & 0x80) == 0) {
+            return static_cast<int>(i + 1);
+        }
+        multiplier *= 128;
+    }
+    return -1;
+}
+
+static void putUint16(std::vector<esperto::uint8>& out, esperto::uint16 value) {
+    out.push_back(static_cast<esperto::uint8>(value >> 8));
+    out.push_back(static_cast<esperto::uint8>(value & 0xFF));
+}
+
+static void putString(std::vector<esperto::uint8>& out, const esperto::string& value) {
+    putUint16(out, static_cast<esperto::uint16>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static void encodeConnect(std::vector<esperto::uint8>& out, const MqttClient::Config& config) {
+    // A password is only allowed together with a user name
+    bool withUser = !config.username.empty();
+    bool withPassword = withUser && !config.password.empty();
+    size_t length = 10 + 2 + config.clientId.size();
+    esperto::uint8 flags = config.cleanSession ? 0x02 : 0x00;
+    if (withUser) {
+        length += 2 + config.username.size();
+        flags |= 0x80;
+    }
+    if (withPassword) {
+        length += 2 + config.password.size();
+        flags |= 0x40;
+    }
+
+    out.push_back(PacketConnect);
+    putRemainingLength(out, length);
+    putString(out, "MQTT");
+    out.push_back(4);   // Protocol level 3.1.1
+    out.push_back(flags);
+    putUint16(out, config.keepAliveSec);
+    putString(out, config.clientId);
+    if (withUser) {
+        putString(out, config.username);
+    }
+    if (withPassword) {
+        putString(out, config.password);
+    }
+}
+
+// Waits until the socket is readable (or writable); false on timeout or error
+static bool waitSocket(int fd, bool writable, esperto::uint32 timeoutMs) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    timeval timeout = {};
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    int ready;
+    do {
+        // The linux target's tick signal interrupts blocking calls
+        ready = select(fd + 1, writable ? nullptr : &set, writable ? &set : nullptr, nullptr, &timeout);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
+}
+
+MqttClient::MqttClient(const Config& config)
+    : m_config(config), m_queue(nullptr), m_handle(nullptr), m_exited(nullptr), m_events(nullptr), m_running(false),
+      m_stopping(false), m_connected(false), m_networkUp(true), m_connectNow(false), m_outstanding(0),
+      m_rejected(0), m_spoolSize(0), m_socket(-1), m_nextPacketId(1), m_carry(nullptr), m_batchPublished(0),
+      m_lastSendUs(0), m_pingSentUs(0), m_reconnectDelayMs(config.reconnectMinMs), m_nextConnectUs(0),
+      m_spoolReadOffset(0), m_spoolUnacked(0), m_spoolFile(nullptr), m_spoolAppended(false)
+#if !CONFIG_IDF_TARGET_LINUX
+      , m_wifi(nullptr), m_wifiSubscription(0)
+#endif
+{
+    m_config.maxInFlight = std::max<esperto::uint32>(m_config.maxInFlight, 1);
+    m_config.reconnectMinMs = std::max<esperto::uint32>(m_config.reconnectMinMs, 1);
+}
+
+MqttClient::~MqttClient() {
+#if !CONFIG_IDF_TARGET_LINUX
+    if (m_wifi) {
+        m_wifi->unsubscribe(m_wifiSubscription);
+    }
+#endif
+    stop();
+    if (m_queue) {
+        vQueueDelete(m_queue);
+    }
+    if (m_events) {
+        vEventGroupDelete(m_events);
+    }
+}
+
+bool MqttClient::equals(const Object& other) const {
+    auto* o = static_cast<const MqttClient*>(&other);
+    return o && o->m_queue == m_queue;
+}
+
+bool MqttClient::start() {
+    if (m_running) {
+        return true;
+    }
+
+    if (!m_queue) {
+        m_queue = xQueueCreate(m_config.queueLength, sizeof(Message*));
+        if (!m_queue) {
+            ESP_LOGE(TAG, "Out of memory for the publish queue");
+            return false;
+        }
+    }
+    if (!m_events) {
+        m_events = xEventGroupCreate();
+        if (!m_events) {
+            return false;
+        }
+    }
+    m_exited = xSemaphoreCreateBinary();
+    if (!m_exited) {
+        return false;
+    }
+
+    m_batch.reserve(m_config.batchBytes);
+    m_stopping = false;
+    m_running = true;
+    BaseType_t result = xTaskCreate(
+        &MqttClient::taskEntryPoint,
+        "MqttClient",
+        m_config.stackSize,
+        this,
+        m_config.priority,
+        &m_handle
+    );
+    if (result != pdPASS) {
+        m_running = false;
+        m_handle = nullptr;
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void MqttClient::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_stopping = true;
+    wake();
+    xSemaphoreTake(m_exited, portMAX_DELAY);
+    vSemaphoreDelete(m_exited);
+    m_exited = nullptr;
+    m_handle = nullptr;
+    m_running = false;
+}
+
+bool MqttClient::isRunning() const {
+    return m_running;
+}
+
+bool MqttClient::isConnected() const {
+    return m_connected;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+void MqttClient::bindWiFi(WiFi& wifi) {
+    if (m_wifi) {
+        m_wifi->unsubscribe(m_wifiSubscription);
+    }
+    m_wifi = &wifi;
+    m_networkUp = wifi.isConnected();
+    m_wifiSubscription = wifi.subscribe([this](const WiFi::Event& event) {
+        if (event.type == WiFi::Event::Type::GotIp) {
+            m_networkUp = true;
+            m_connectNow = true;
+            wake();
+        } else if (event.type == WiFi::Event::Type::Disconnected) {
+            m_networkUp = false;
+        }
+    });
+}
+#endif
+
+bool MqttClient::publish(const esperto::string& topic, const void* payload, size_t length,
+                         QoS qos, bool retain, esperto::uint32 timeoutMs) {
+    if (!m_running || topic.empty() || topic.size() > 0xFFFF) {
+        return false;
+    }
+
+    Message* message = new (std::nothrow) Message();
+    if (!message) {
+        return false;
+    }
+    const esperto::uint8* bytes = static_cast<const esperto::uint8*>(payload);
+    message->topic = topic;
+    message->payload.assign(bytes, bytes + length);
+    message->qos = static_cast<esperto::uint8>(qos);
+    message->retain = retain;
+
+    m_outstanding++;
+    if (xQueueSend(m_queue, &message, detail::timeoutToTicks(timeoutMs)) != pdTRUE) {
+        m_outstanding--;
+        m_rejected++;
+        delete message;
+        signalDrained();
+        return false;
+    }
+    return true;
+}
+
+bool MqttClient::publish(const esperto::string& topic, const esperto::string& payload,
+                         QoS qos, bool retain, esperto::uint32 timeoutMs) {
+    return publish(topic, payload.data(), payload.size(), qos, retain, timeoutMs);
+}
+
+bool MqttClient::flush(esperto::uint32 timeoutMs) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = detail::timeoutToTicks(timeoutMs);
+    while (m_outstanding.load() > 0 || m_spoolSize.load() > 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (!m_running || m_stopping || (timeout != portMAX_DELAY && elapsed >= timeout)) {
+            return false;
+        }
+        // The bit may be left over from an earlier drain; clearing it on exit makes a stale
+        // one cost a single check
+        xEventGroupWaitBits(m_events, DrainedBit, pdTRUE, pdTRUE,
+                            timeout == portMAX_DELAY ? portMAX_DELAY : timeout - elapsed);
+    }
+    return true;
+}
+
+MqttClient::Statistics MqttClient::getStatistics() const {
+    Statistics stats;
+    stats.published = m_stats.published.load();
+    stats.writes = m_stats.writes.load();
+    stats.bytesSent = m_stats.bytesSent.load();
+    stats.acknowledged = m_stats.acknowledged.load();
+    stats.retransmits = m_stats.retransmits.load();
+    stats.spooled = m_stats.spooled.load();
+    stats.unspooled = m_stats.unspooled.load();
+    stats.dropped = m_stats.dropped.load() + m_rejected.load();
+    stats.connects = m_stats.connects.load();
+    stats.inFlight = m_stats.inFlight.load();
+    stats.spoolBytes = m_spoolSize.load();
+    return stats;
+}
+
+void MqttClient::taskEntryPoint(void* param) {
+    MqttClient* self = static_cast<MqttClient*>(param);
+    self->run();
+    xSemaphoreGive(self->m_exited);
+    vTaskDelete(nullptr);
+}
+
+void MqttClient::run() {
+    // A compaction cut short by a reset leaves only the rewritten file
+    struct stat info;
+    if (!m_config.spoolPath.empty() && stat(m_config.spoolPath.c_str(), &info) != 0) {
+        esperto::string rewritten = m_config.spoolPath + ".tmp";
+        if (stat(rewritten.c_str(), &info) == 0) {
+            rename(rewritten.c_str(), m_config.spoolPath.c_str());
+        }
+    }
+
+    // Whatever a previous run left in the spool is sent after the first connect
+    bool spooled = !m_config.spoolPath.empty() && stat(m_config.spoolPath.c_str(), &info) == 0;
+    m_spoolSize = spooled ? static_cast<esperto::uint32>(info.st_size) : 0;
+    m_spoolReadOffset = 0;
+    m_reconnectDelayMs = m_config.reconnectMinMs;
+    m_nextConnectUs = 0;
+
+    while (!m_stopping) {
+        if (m_connected) {
+            runConnected();
+        } else {
+            runOffline();
+        }
+    }
+    disconnectBroker();
+
+    // Spooled messages stay in the file; the rest is lost
+    Message* message = nullptr;
+    while (xQueueReceive(m_queue, &message, 0) == pdTRUE) {
+        if (message) {
+            m_stats.dropped++;
+            complete(message);
+        }
+    }
+    if (m_carry) {
+        complete(m_carry);
+        m_carry = nullptr;
+    }
+    for (Message* pending : m_inFlight) {
+        complete(pending);
+    }
+    m_inFlight.clear();
+    m_stats.inFlight = 0;
+    spoolClose();
+    // Wakes flush() callers, which give up once they see the client stopping
+    xEventGroupSetBits(m_events, DrainedBit);
+}
+
+void MqttClient::runConnected() {
+    // With the window full there is nothing to do but wait for acknowledgements
+    esperto::uint32 waitMs = m_inFlight.size() >= m_config.maxInFlight ? m_config.pollMs : 0;
+    if (receivePackets(waitMs) && retransmitExpired() && fillBatch() && keepAlive()) {
+        return;
+    }
+    ESP_LOGW(TAG, "Connection to the broker lost");
+    disconnectBroker();
+    scheduleReconnect();
+}
+
+void MqttClient::runOffline() {
+    if (m_connectNow.exchange(false)) {
+        m_reconnectDelayMs = m_config.reconnectMinMs;
+        m_nextConnectUs = 0;
+    }
+
+    esperto::int64 now = esp_timer_get_time();
+    if (m_networkUp && now >= m_nextConnectUs) {
+        if (connectBroker()) {
+            m_reconnectDelayMs = m_config.reconnectMinMs;
+            return;
+        }
+        scheduleReconnect();
+        now = esp_timer_get_time();
+    }
+
+    TickType_t wait = portMAX_DELAY;
+    if (m_networkUp) {
+        esperto::int64 left = std::max<esperto::int64>(m_nextConnectUs - now, 0);
+        wait = pdMS_TO_TICKS(left / 1000) + 1;
+    }
+
+    if (m_config.spoolPath.empty()) {
+        // Without a spool, messages wait in the queue and publish() blocks once it is full
+        ulTaskNotifyTake(pdTRUE, wait);
+        return;
+    }
+
+    Message* message = nullptr;
+    while (xQueueReceive(m_queue, &message, wait) == pdTRUE) {
+        if (!message) {
+            return;
+        }
+        spoolOrDrop(message);
+        wait = 0;
+    }
+}
+
+bool MqttClient::connectBroker() {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address = nullptr;
+    char port[6];
+    snprintf(port, sizeof(port), "%u", static_cast<unsigned>(m_config.port));
+    if (getaddrinfo(m_config.host.c_str(), port, &hints, &address) != 0 || !address) {
+        ESP_LOGW(TAG, "Cannot resolve %s", m_config.host.c_str());
+        return false;
+    }
+
+    int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(address);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int result = ::connect(fd, address->ai_addr, address->ai_addrlen);
+    freeaddrinfo(address);
+    if (result != 0) {
+        int error = errno;
+        socklen_t length = sizeof(error);
+        if (error != EINPROGRESS || !waitSocket(fd, true, m_config.connectTimeoutMs) ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            ESP_LOGW(TAG, "Cannot connect to %s:%u (errno %d)", m_config.host.c_str(),
+                     static_cast<unsigned>(m_config.port), error);
+            ::close(fd);
+            return false;
+        }
+    }
+    // Batching is done here; Nagle would only delay the last packet of a batch
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    m_socket = fd;
+    m_rx.clear();
+
+    std::vector<esperto::uint8> connect;
+    encodeConnect(connect, m_config);
+    if (!sendAll(connect.data(), connect.size())) {
+        disconnectBroker();
+        return false;
+    }
+
+    esperto::int64 deadline = esp_timer_get_time() + static_cast<esperto::int64>(m_config.connectTimeoutMs) * 1000;
+    while (m_rx.size() < 4) {
+        esperto::int64 left = deadline - esp_timer_get_time();
+        esperto::uint8 chunk[4];
+        ssize_t length = left > 0 && waitSocket(fd, false, static_cast<esperto::uint32>(left / 1000))
+                             ? recv(fd, chunk, sizeof(chunk) - m_rx.size(), 0) : -1;
+        if (length <= 0) {
+            ESP_LOGW(TAG, "No CONNACK from the broker");
+            disconnectBroker();
+            return false;
+        }
+        m_rx.insert(m_rx.end(), chunk, chunk + length);
+    }
+    if (m_rx[0] != PacketConnAck || m_rx[1] != 2 || m_rx[3] != 0) {
+        ESP_LOGW(TAG, "Broker refused the connection (code %u)", static_cast<unsigned>(m_rx[3]));
+        disconnectBroker();
+        return false;
+    }
+    m_rx.clear();
+
+    // Everything unacknowledged goes again, before any new message
+    for (Message* message : m_inFlight) {
+        message->sentUs = 0;
+    }
+    m_pingSentUs = 0;
+    m_stats.connects++;
+    m_connected = true;
+    ESP_LOGI(TAG, "Connected to %s:%u", m_config.host.c_str(), static_cast<unsigned>(m_config.port));
+    return true;
+}
+
+void MqttClient::disconnectBroker() {
+    if (m_socket < 0) {
+        return;
+    }
+    if (m_connected) {
+        const esperto::uint8 packet[] = {PacketDisconnect, 0};
+        send(m_socket, packet, sizeof(packet), 0);
+    }
+    ::close(m_socket);
+    m_socket = -1;
+    m_connected = false;
+    m_rx.clear();
+    m_pingSentUs = 0;
+}
+
+void MqttClient::scheduleReconnect() {
+    m_nextConnectUs = esp_timer_get_time() + static_cast<esperto::int64>(m_reconnectDelayMs) * 1000;
+    m_reconnectDelayMs = std::min(m_reconnectDelayMs * 2, std::max(m_config.reconnectMaxMs, m_config.reconnectMinMs));
+}
+
+bool MqttClient::receivePackets(esperto::uint32 waitMs) {
+    if (waitMs > 0 && !waitSocket(m_socket, false, waitMs)) {
+        return true;
+    }
+
+    esperto::uint8 chunk[256];
+    for (;;) {
+        ssize_t length = recv(m_socket, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (length > 0) {
+            m_rx.insert(m_rx.end(), chunk, chunk + length);
+            continue;
+        }
+        if (length == 0) {
+            ESP_LOGW(TAG, "Broker closed the connection");
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return false;
+    }
+
+    size_t offset = 0;
+    while (m_rx.size() - offset >= 2) {
+        size_t length = 0;
+        int lengthBytes = decodeRemainingLength(&m_rx[offset + 1], m_rx.size() - offset - 1, length);
+        if (lengthBytes < 0) {
+            ESP_LOGW(TAG, "Malformed packet from the broker");
+            return false;
+        }
+        size_t body = offset + 1 + lengthBytes;
+        if (lengthBytes == 0 || m_rx.size() - body < length) {
+            break;
+        }
+        handlePacket(m_rx[offset], m_rx.data() + body, length);
+        offset = body + length;
+    }
+    m_rx.erase(m_rx.begin(), m_rx.begin() + offset);
+    return true;
+}
+
+void MqttClient::handlePacket(esperto::uint8 header, const esperto::uint8* body, size_t length) {
+    switch (header & 0xF0) {
+        case PacketPubAck: {
+            if (length < 2) {
+                break;
+            }
+            esperto::uint16 packetId = static_cast<esperto::uint16>((body[0] << 8) | body[1]);
+            auto it = std::find_if(m_inFlight.begin(), m_inFlight.end(),
+                                   [packetId](const Message* message) { return message->packetId == packetId; });
+            if (it != m_inFlight.end()) {
+                Message* message = *it;
+                m_inFlight.erase(it);
+                m_stats.inFlight = static_cast<esperto::uint32>(m_inFlight.size());
+                m_stats.acknowledged++;
+                complete(message);
+                spoolTrim();
+            }
+            break;
+        }
+        case PacketPingResp:
+            m_pingSentUs = 0;
+            break;
+        default:
+            // Nothing is subscribed: any other packet is unexpected and ignored
+            break;
+    }
+}
+
+bool MqttClient::retransmitExpired() {
+    esperto::int64 now = esp_timer_get_time();
+    esperto::int64 timeoutUs = static_cast<esperto::int64>(m_config.ackTimeoutMs) * 1000;
+    for (Message* message : m_inFlight) {
+        if (message->sentUs != 0 && now - message->sentUs < timeoutUs) {
+            continue;
+        }
+        if (!appendMessage(message, true)) {
+            if (!writeBatch()) {
+                return false;
+            }
+            appendMessage(message, true);
+        }
+        m_stats.retransmits++;
+    }
+    return true;
+}
+
+bool MqttClient::fillBatch() {
+    esperto::int64 batchDelayUs = static_cast<esperto::int64>(m_config.batchDelayMs) * 1000;
+    esperto::int64 deadline = m_batch.empty() ? 0 : esp_timer_get_time() + batchDelayUs;
+    esperto::uint32 idleMs = m_config.keepAliveSec > 0 ? m_config.keepAliveSec * 500u : 1000u;
+
+    while (!m_stopping && m_inFlight.size() < m_config.maxInFlight) {
+        Message* message = m_carry;
+        m_carry = nullptr;
+        if (!message) {
+            TickType_t wait = 0;
+            if (m_batch.empty()) {
+                // Sleep longer only when no acknowledgement is awaited
+                bool busy = !m_inFlight.empty() || m_spoolSize.load() > 0;
+                wait = pdMS_TO_TICKS(busy ? m_config.pollMs : idleMs);
+            } else {
+                esperto::int64 left = deadline - esp_timer_get_time();
+                wait = left > 0 ? pdMS_TO_TICKS(left / 1000) : 0;
+            }
+            message = nextMessage(wait);
+            if (!message) {
+                break;
+            }
+        }
+        if (!appendMessage(message, false)) {
+            m_carry = message;
+            break;
+        }
+        if (deadline == 0) {
+            deadline = esp_timer_get_time() + batchDelayUs;
+        }
+    }
+    return writeBatch();
+}
+
+MqttClient::Message* MqttClient::nextMessage(TickType_t wait) {
+    Message* message = nullptr;
+    if (m_spoolSize.load() == 0) {
+        while (xQueueReceive(m_queue, &message, wait) == pdTRUE) {
+            if (message) {
+                return message;
+            }
+            wait = 0;
+        }
+        return nullptr;
+    }
+
+    // Until the spool is empty new QoS1 messages line up behind it; QoS0 promises no order
+    // and goes out at once
+    while (xQueueReceive(m_queue, &message, 0) == pdTRUE) {
+        if (message && message->qos == 0) {
+            return message;
+        }
+        if (message) {
+            spoolOrDrop(message);
+        }
+    }
+    if (m_spoolReadOffset < m_spoolSize.load()) {
+        return spoolRead();
+    }
+    if (xQueueReceive(m_queue, &message, wait) == pdTRUE && message) {
+        if (message->qos == 0) {
+            return message;
+        }
+        spoolOrDrop(message);
+    }
+    return nullptr;
+}
+
+bool MqttClient::appendMessage(Message* message, bool duplicate) {
+    size_t length = 2 + message->topic.size() + (message->qos > 0 ? 2 : 0) + message->payload.size();
+    size_t size = 1 + remainingLengthSize(length) + length;
+    if (!m_batch.empty() && m_batch.size() + size > m_config.batchBytes) {
+        return false;
+    }
+
+    if (message->qos > 0 && !duplicate) {
+        message->packetId = m_nextPacketId;
+        m_nextPacketId = m_nextPacketId == 0xFFFF ? 1 : m_nextPacketId + 1;
+    }
+    esperto::uint8 header = PacketPublish | static_cast<esperto::uint8>(message->qos << 1);
+    if (duplicate) {
+        header |= PublishDup;
+    }
+    if (message->retain) {
+        header |= PublishRetain;
+    }
+    m_batch.push_back(header);
+    putRemainingLength(m_batch, length);
+    putString(m_batch, message->topic);
+    if (message->qos > 0) {
+        putUint16(m_batch, message->packetId);
+    }
+    m_batch.insert(m_batch.end(), message->payload.begin(), message->payload.end());
+
+    if (!duplicate) {
+        m_batchPublished++;
+    }
+    if (message->qos == 0) {
+        m_batchMessages.push_back(message);
+    } else {
+        message->sentUs = esp_timer_get_time();
+        if (!duplicate) {
+            m_inFlight.push_back(message);
+            m_stats.inFlight = static_cast<esperto::uint32>(m_inFlight.size());
+        }
+    }
+    return true;
+}
+
+bool MqttClient::writeBatch() {
+    if (m_batch.empty()) {
+        return true;
+    }
+
+    bool written = sendAll(m_batch.data(), m_batch.size());
+    if (written) {
+        m_stats.published += m_batchPublished;
+    }
+    // QoS0 is done once written; QoS1 stays in flight and is sent again after a reconnect
+    for (Message* message : m_batchMessages) {
+        if (!written) {
+            m_stats.dropped++;
+        }
+        complete(message);
+    }
+    m_batchMessages.clear();
+    m_batch.clear();
+    m_batchPublished = 0;
+    spoolTrim();
+    return written;
+}
+
+bool MqttClient::sendAll(const esperto::uint8* data, size_t length) {
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t written = send(m_socket, data + offset, length - offset, 0);
+        if (written > 0) {
+            offset += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && waitSocket(m_socket, true, WriteTimeoutMs)) {
+            continue;
+        }
+        return false;
+    }
+    m_stats.writes++;
+    m_stats.bytesSent += length;
+    m_lastSendUs = esp_timer_get_time();
+    return true;
+}
+
+bool MqttClient::keepAlive() {
+    if (m_config.keepAliveSec == 0) {
+        return true;
+    }
+
+    esperto::int64 now = esp_timer_get_time();
+    esperto::int64 periodUs = static_cast<esperto::int64>(m_config.keepAliveSec) * 1000000;
+    if (m_pingSentUs != 0) {
+        if (now - m_pingSentUs > periodUs) {
+            ESP_LOGW(TAG, "No PINGRESP from the broker");
+            return false;
+        }
+        return true;
+    }
+    if (now - m_lastSendUs >= periodUs / 2) {
+        const esperto::uint8 packet[] = {PacketPingReq, 0};
+        if (!sendAll(packet, sizeof(packet))) {
+            return false;
+        }
+        m_pingSentUs = now;
+    }
+    return true;
+}
+
+void MqttClient::complete(Message* message) {
+    if (message->spooled) {
+        m_spoolUnacked--;
+    } else {
+        m_outstanding--;
+    }
+    delete message;
+    signalDrained();
+}
+
+void MqttClient::signalDrained() {
+    if (m_outstanding.load() == 0 && m_spoolSize.load() == 0) {
+        xEventGroupSetBits(m_events, DrainedBit);
+    }
+}
+
+void MqttClient::spoolOrDrop(Message* message) {
+    bool keep = !m_config.spoolPath.empty() && (message->qos > 0 || m_config.spoolQos0);
+    if (keep && spoolAppend(*message)) {
+        m_stats.spooled++;
+    } else {
+        m_stats.dropped++;
+    }
+    // The spool now owns the message, or it is lost
+    m_outstanding--;
+    delete message;
+    signalDrained();
+}
+
+bool MqttClient::spoolAppend(const Message& message) {
+    const char* path = m_config.spoolPath.c_str();
+    esperto::uint32 recordSize = static_cast<esperto::uint32>(
+        sizeof(SpoolRecord) + message.topic.size() + message.payload.size());
+    // Delivered records still at the head of the file do not count; they are cut off
+    // only when the file would outgrow the cap
+    if (m_spoolSize.load() - spoolDelivered() + recordSize > m_config.spoolMaxBytes) {
+        return false;
+    }
+    if (m_spoolSize.load() + recordSize > m_config.spoolMaxBytes && !spoolCompact()) {
+        return false;
+    }
+
+    esperto::uint32 size = m_spoolSize.load();
+    FILE* file = spoolOpen();
+    if (!file) {
+        return false;
+    }
+    SpoolRecord record = {};
+    record.topicLength = static_cast<esperto::uint16>(message.topic.size());
+    record.qos = message.qos;
+    record.retain = message.retain ? 1 : 0;
+    record.payloadLength = static_cast<esperto::uint32>(message.payload.size());
+    // Switching from reading to writing needs a seek; append mode writes at the end anyway
+    m_spoolAppended = true;
+    bool written = fseek(file, 0, SEEK_END) == 0 &&
+                   fwrite(&record, sizeof(record), 1, file) == 1 &&
+                   fwrite(message.topic.data(), message.topic.size(), 1, file) == 1 &&
+                   (message.payload.empty() || fwrite(message.payload.data(), message.payload.size(), 1, file) == 1);
+    // The record has to survive a reset once the message is no longer in memory
+    written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (!written) {
+        // Cut off the partial record so the next one starts where the reader expects it
+        ESP_LOGE(TAG, "Cannot write the spool %s", path);
+        spoolClose();
+        truncate(path, size);
+        return false;
+    }
+    m_spoolSize = size + recordSize;
+    return true;
+}
+
+MqttClient::Message* MqttClient::spoolRead() {
+    Message* message = new (std::nothrow) Message();
+    if (!message) {
+        return nullptr;
+    }
+
+    // Records are read in order, so the handle only seeks after an append or a reopen
+    FILE* file = spoolOpen();
+    if (file && m_spoolAppended && fseek(file, static_cast<long>(m_spoolReadOffset), SEEK_SET) != 0) {
+        file = nullptr;
+    }
+    m_spoolAppended = false;
+    esperto::uint32 left = m_spoolSize.load() - m_spoolReadOffset;
+    SpoolRecord record = {};
+    bool valid = file && fread(&record, sizeof(record), 1, file) == 1 && record.topicLength > 0 &&
+                 sizeof(record) + record.topicLength + record.payloadLength <= left;
+    if (valid) {
+        message->topic.resize(record.topicLength);
+        message->payload.resize(record.payloadLength);
+        valid = fread(&message->topic[0], record.topicLength, 1, file) == 1 &&
+                (record.payloadLength == 0 || fread(message->payload.data(), record.payloadLength, 1, file) == 1);
+    }
+    if (!valid) {
+        ESP_LOGE(TAG, "Spool %s is unreadable, discarding it", m_config.spoolPath.c_str());
+        delete message;
+        spoolDiscard();
+        return nullptr;
+    }
+
+    message->qos = record.qos > 0 ? 1 : 0;
+    message->retain = record.retain != 0;
+    message->spooled = true;
+    message->spoolOffset = m_spoolReadOffset;
+    m_spoolReadOffset += static_cast<esperto::uint32>(sizeof(record) + record.topicLength + record.payloadLength);
+    m_spoolUnacked++;
+    m_stats.unspooled++;
+    return message;
+}
+
+FILE* MqttClient::spoolOpen() {
+    if (!m_spoolFile) {
+        m_spoolFile = fopen(m_config.spoolPath.c_str(), "a+b");
+        if (!m_spoolFile) {
+            ESP_LOGE(TAG, "Cannot open the spool %s", m_config.spoolPath.c_str());
+            return nullptr;
+        }
+        m_spoolAppended = true;
+    }
+    return m_spoolFile;
+}
+
+void MqttClient::spoolClose() {
+    if (m_spoolFile) {
+        fclose(m_spoolFile);
+        m_spoolFile = nullptr;
+    }
+}
+
+esperto::uint32 MqttClient::spoolDelivered() const {
+    // Everything before the oldest record still held in memory is done
+    esperto::uint32 delivered = m_spoolReadOffset;
+    auto hold = [&delivered](const Message* message) {
+        if (message && message->spooled) {
+            delivered = std::min(delivered, message->spoolOffset);
+        }
+    };
+    for (const Message* message : m_inFlight) {
+        hold(message);
+    }
+    for (const Message* message : m_batchMessages) {
+        hold(message);
+    }
+    hold(m_carry);
+    return delivered;
+}
+
+bool MqttClient::spoolCompact() {
+    esperto::uint32 delivered = spoolDelivered();
+    if (delivered == 0) {
+        return false;
+    }
+
+    // The undelivered tail goes to a new file that then replaces the spool
+    const char* path = m_config.spoolPath.c_str();
+    esperto::string rewritten = m_config.spoolPath + ".tmp";
+    FILE* from = spoolOpen();
+    FILE* to = fopen(rewritten.c_str(), "wb");
+    bool copied = from && to && fseek(from, static_cast<long>(delivered), SEEK_SET) == 0;
+    esperto::uint8 chunk[256];
+    for (esperto::uint32 left = m_spoolSize.load() - delivered; copied && left > 0;) {
+        size_t length = std::min<size_t>(left, sizeof(chunk));
+        copied = fread(chunk, length, 1, from) == 1 && fwrite(chunk, length, 1, to) == 1;
+        left -= static_cast<esperto::uint32>(length);
+    }
+    if (to) {
+        copied = fflush(to) == 0 && fsync(fileno(to)) == 0 && copied;
+        copied = fclose(to) == 0 && copied;
+    }
+    spoolClose();
+    // FAT cannot rename over an existing file; run() finishes the job after a reset in between
+    if (!copied || remove(path) != 0) {
+        ESP_LOGE(TAG, "Cannot compact the spool %s", path);
+        remove(rewritten.c_str());
+        return false;
+    }
+    if (rename(rewritten.c_str(), path) != 0) {
+        ESP_LOGE(TAG, "Cannot replace the spool %s, its messages are lost", path);
+        remove(rewritten.c_str());
+        m_spoolSize = 0;
+        m_spoolReadOffset = 0;
+        signalDrained();
+        return false;
+    }
+
+    m_spoolSize = m_spoolSize.load() - delivered;
+    m_spoolReadOffset -= delivered;
+    for (Message* message : m_inFlight) {
+        if (message->spooled) {
+            message->spoolOffset -= delivered;
+        }
+    }
+    for (Message* message : m_batchMessages) {
+        if (message->spooled) {
+            message->spoolOffset -= delivered;
+        }
+    }
+    if (m_carry && m_carry->spooled) {
+        m_carry->spoolOffset -= delivered;
+    }
+    return true;
+}
+
+void MqttClient::spoolTrim() {
+    // The file goes once every record in it is delivered
+    if (m_spoolSize.load() == 0 || m_spoolReadOffset < m_spoolSize.load() || m_spoolUnacked > 0) {
+        return;
+    }
+    spoolDiscard();
+}
+
+void MqttClient::spoolDiscard() {
+    spoolClose();
+    if (remove(m_config.spoolPath.c_str()) != 0) {
+        ESP_LOGW(TAG, "Cannot remove the spool %s", m_config.spoolPath.c_str());
+    }
+    m_spoolSize = 0;
+    m_spoolReadOffset = 0;
+    signalDrained();
+}
+
+void MqttClient::wake() {
+    if (!m_handle) {
+        return;
+    }
+    Message* marker = nullptr;
+    xQueueSendToFront(m_queue, &marker, 0);
+    xTaskNotifyGive(m_handle);
+}
+
+} // namespace esperto
@@ -0,0 +1,237 @@
+// net_buffer.cpp
+// Implementation of NetBuffer and NetPayload classes for ESP32 lwIP
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/net_buffer.hpp"
+#include <new>
+
+namespace esperto {
+
+bool NetEndpoint::parse(const esperto::string& address, esperto::uint16 port, NetEndpoint& endpoint) {
+    ip_addr_t parsed;
+    if (!ipaddr_aton(address.c_str(), &parsed) || !IP_IS_V4(&parsed)) {
+        return false;
+    }
+    endpoint.address = ip_addr_get_ip4_u32(&parsed);
+    endpoint.port = port;
+    return true;
+}
+
+NetBuffer::NetBuffer() : m_chain(nullptr) {}
+
+NetBuffer::NetBuffer(struct pbuf* chain) : m_chain(chain) {}
+
+NetBuffer::~NetBuffer() {
+    release();
+}
+
+NetBuffer::NetBuffer(NetBuffer&& other) noexcept : m_chain(other.m_chain) {
+    other.m_chain = nullptr;
+}
+
+NetBuffer& NetBuffer::operator=(NetBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_chain = other.m_chain;
+        other.m_chain = nullptr;
+    }
+    return *this;
+}
+
+bool NetBuffer::equals(const Object& other) const {
+    auto* o = static_cast<const NetBuffer*>(&other);
+    return o && o->m_chain == m_chain;
+}
+
+size_t NetBuffer::size() const {
+    return m_chain ? m_chain->tot_len : 0;
+}
+
+bool NetBuffer::empty() const {
+    return m_chain == nullptr;
+}
+
+esperto::uint32 NetBuffer::segmentCount() const {
+    esperto::uint32 count = 0;
+    for (const struct pbuf* p = m_chain; p; p = p->next) {
+        if (p->len != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+NetSegment NetBuffer::segment(esperto::uint32 index) const {
+    for (const struct pbuf* p = m_chain; p; p = p->next) {
+        if (p->len == 0) {
+            continue;
+        }
+        if (index-- == 0) {
+            return NetSegment{static_cast<const esperto::uint8*>(p->payload), p->len};
+        }
+    }
+    return NetSegment{nullptr, 0};
+}
+
+size_t NetBuffer::copyTo(void* destination, size_t length, size_t offset) const {
+    if (!m_chain || offset >= m_chain->tot_len) {
+        return 0;
+    }
+    size_t available = m_chain->tot_len - offset;
+    return pbuf_copy_partial(m_chain, destination, static_cast<u16_t>(length < available ? length : available),
+                             static_cast<u16_t>(offset));
+}
+
+void NetBuffer::release() {
+    if (m_chain) {
+        pbuf_free(m_chain);
+        m_chain = nullptr;
+    }
+}
+
+struct pbuf* NetBuffer::detach() {
+    struct pbuf* chain = m_chain;
+    m_chain = nullptr;
+    return chain;
+}
+
+NetPayload::NetPayload() : m_control(nullptr) {}
+
+NetPayload::NetPayload(Control* control) : m_control(control) {}
+
+NetPayload NetPayload::allocate(size_t length) {
+    auto* data = new (std::nothrow) esperto::uint8[length];
+    auto* control = data ? new (std::nothrow) Control() : nullptr;
+    if (!control) {
+        delete[] data;
+        return NetPayload();
+    }
+    control->references.store(1);
+    control->data = data;
+    control->length = length;
+    control->release = nullptr;
+    control->context = nullptr;
+    control->owned = true;
+    return NetPayload(control);
+}
+
+NetPayload NetPayload::wrap(const void* data, size_t length, ReleaseCallback release, void* context) {
+    auto* control = new (std::nothrow) Control();
+    if (!control) {
+        return NetPayload();
+    }
+    control->references.store(1);
+    control->data = static_cast<esperto::uint8*>(const_cast<void*>(data));
+    control->length = length;
+    control->release = release;
+    control->context = context;
+    control->owned = false;
+    return NetPayload(control);
+}
+
+NetPayload::NetPayload(const NetPayload& other) : m_control(other.m_control) {
+    acquire(m_control);
+}
+
+NetPayload& NetPayload::operator=(const NetPayload& other) {
+    if (m_control != other.m_control) {
+        acquire(other.m_control);
+        drop(m_control);
+        m_control = other.m_control;
+    }
+    return *this;
+}
+
+NetPayload::NetPayload(NetPayload&& other) noexcept : m_control(other.m_control) {
+    other.m_control = nullptr;
+}
+
+NetPayload& NetPayload::operator=(NetPayload&& other) noexcept {
+    if (this != &other) {
+        drop(m_control);
+        m_control = other.m_control;
+        other.m_control = nullptr;
+    }
+    return *this;
+}
+
+NetPayload::~NetPayload() {
+    drop(m_control);
+}
+
+bool NetPayload::equals(const Object& other) const {
+    auto* o = static_cast<const NetPayload*>(&other);
+    return o && o->m_control == m_control;
+}
+
+esperto::uint8* NetPayload::data() const {
+    return m_control ? m_control->data : nullptr;
+}
+
+size_t NetPayload::size() const {
+    return m_control ? m_control->length : 0;
+}
+
+bool NetPayload::valid() const {
+    return m_control != nullptr;
+}
+
+esperto::uint32 NetPayload::useCount() const {
+    return m_control ? m_control->references.load() : 0;
+}
+
+struct pbuf* NetPayload::toPbuf(size_t offset, size_t length) const {
+    if (!m_control || offset >= m_control->length) {
+        return nullptr;
+    }
+    size_t available = m_control->length - offset;
+    if (length > available) {
+        length = available;
+    }
+    if (length > 0xFFFF) {
+        return nullptr;
+    }
+
+    auto* ref = new (std::nothrow) RefPbuf();
+    if (!ref) {
+        return nullptr;
+    }
+    ref->custom.custom_free_function = freeRefPbuf;
+    ref->control = m_control;
+    struct pbuf* p = pbuf_alloced_custom(PBUF_RAW, static_cast<u16_t>(length), PBUF_REF, &ref->custom,
+                                         m_control->data + offset, static_cast<u16_t>(length));
+    if (!p) {
+        delete ref;
+        return nullptr;
+    }
+    acquire(m_control);
+    return p;
+}
+
+void NetPayload::acquire(Control* control) {
+    if (control) {
+        control->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NetPayload::drop(Control* control) {
+    if (!control || control->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (control->owned) {
+        delete[] control->data;
+    } else if (control->release) {
+        control->release(control->data, control->context);
+    }
+    delete control;
+}
+
+void NetPayload::freeRefPbuf(struct pbuf* p) {
+    auto* ref = reinterpret_cast<RefPbuf*>(p);
+    Control* control = ref->control;
+    delete ref;
+    drop(control);
+}
+
+} // namespace esperto
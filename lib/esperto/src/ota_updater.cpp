@@ -0,0 +1,456 @@
+// ota_updater.cpp
+// Implementation of OtaUpdater class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/ota_updater.hpp"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <strings.h>
+#include "sdkconfig.h"
+
+extern "C" {
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "miniz.h"
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
+}
+
+namespace esperto {
+
+static const char* TAG = "OtaUpdater";
+
+// Chunk flags
+static constexpr esperto::uint8 ChunkEnd = 0x01;       // No data: finish the image
+static constexpr esperto::uint8 ChunkAbort = 0x02;     // With ChunkEnd: discard the image
+static constexpr esperto::uint8 ChunkRestart = 0x04;   // Data starts a new image
+
+static constexpr esperto::uint8 ImageMagic = 0xE9;
+static constexpr esperto::uint8 ZlibMagic = 0x78;
+
+OtaUpdater::OtaUpdater(const Config& config)
+    : m_config(config), m_state(State::Idle), m_free(nullptr), m_filled(nullptr), m_writerDone(nullptr),
+      m_buffers{nullptr, nullptr}, m_partition(nullptr), m_handle(0), m_imageOpen(false), m_writerFailed(false),
+      m_writerResult(false), m_zlib(false), m_formatKnown(false), m_inflateDone(false), m_inflator(nullptr),
+      m_dictionary(nullptr), m_dictionaryOffset(0) {}
+
+OtaUpdater::~OtaUpdater() {
+    releaseResources();
+}
+
+bool OtaUpdater::equals(const Object& other) const {
+    auto* o = static_cast<const OtaUpdater*>(&other);
+    return o && o->m_config.url == m_config.url;
+}
+
+bool OtaUpdater::update() {
+    if (m_state.load() == State::Downloading) {
+        return false;
+    }
+
+    m_stats = Statistics();
+    m_etag.clear();
+    m_writerFailed = false;
+    m_writerResult = false;
+    m_state = State::Downloading;
+    esperto::int64 start = esp_timer_get_time();
+
+    m_partition = esp_ota_get_next_update_partition(nullptr);
+    if (!m_partition) {
+        ESP_LOGE(TAG, "No OTA partition to update");
+        m_state = State::Failed;
+        return false;
+    }
+
+    m_buffers[0] = new (std::nothrow) esperto::uint8[m_config.bufferSize];
+    m_buffers[1] = new (std::nothrow) esperto::uint8[m_config.bufferSize];
+    m_free = xQueueCreate(2, sizeof(Chunk));
+    // Both buffers plus the end marker
+    m_filled = xQueueCreate(3, sizeof(Chunk));
+    m_writerDone = xSemaphoreCreateBinary();
+    if (!m_buffers[0] || !m_buffers[1] || !m_free || !m_filled || !m_writerDone) {
+        ESP_LOGE(TAG, "Out of memory for the update pipeline");
+        releaseResources();
+        m_state = State::Failed;
+        return false;
+    }
+    for (esperto::uint8* buffer : m_buffers) {
+        Chunk chunk = {buffer, 0, 0};
+        xQueueSend(m_free, &chunk, 0);
+    }
+
+    if (!openImage()) {
+        releaseResources();
+        m_state = State::Failed;
+        return false;
+    }
+    BaseType_t created = xTaskCreatePinnedToCore(
+        &OtaUpdater::writerEntryPoint,
+        "OtaWriter",
+        m_config.writerStackSize,
+        this,
+        m_config.writerPriority,
+        nullptr,
+        m_config.writerCore
+    );
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Cannot start the writer task");
+        closeImage();
+        releaseResources();
+        m_state = State::Failed;
+        return false;
+    }
+
+    bool downloaded = download();
+    Chunk end = {nullptr, 0, static_cast<esperto::uint8>(downloaded ? ChunkEnd : ChunkEnd | ChunkAbort)};
+    xQueueSend(m_filled, &end, portMAX_DELAY);
+    xSemaphoreTake(m_writerDone, portMAX_DELAY);
+
+    bool updated = downloaded && m_writerResult;
+    if (updated && m_config.setBootPartition) {
+        esp_err_t err = esp_ota_set_boot_partition(m_partition);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot set the boot partition: %s", esp_err_to_name(err));
+            updated = false;
+        }
+    }
+    m_stats.elapsedMs = static_cast<esperto::uint32>((esp_timer_get_time() - start) / 1000);
+    releaseResources();
+
+    if (updated) {
+        ESP_LOGI(TAG, "Wrote %llu bytes to %s in %lu ms (%llu downloaded, %lu resumes)",
+                 static_cast<unsigned long long>(m_stats.imageBytes), m_partition->label,
+                 static_cast<unsigned long>(m_stats.elapsedMs),
+                 static_cast<unsigned long long>(m_stats.downloadedBytes),
+                 static_cast<unsigned long>(m_stats.resumes));
+    }
+    m_state = updated ? State::Done : State::Failed;
+    return updated;
+}
+
+OtaUpdater::State OtaUpdater::getState() const {
+    return m_state.load();
+}
+
+OtaUpdater::Statistics OtaUpdater::getStatistics() const {
+    return m_stats;
+}
+
+esp_err_t OtaUpdater::httpEvent(esp_http_client_event_t* event) {
+    auto* self = static_cast<OtaUpdater*>(event->user_data);
+    // A weak validator cannot be used with If-Range
+    if (event->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(event->header_key, "ETag") == 0 &&
+        strncmp(event->header_value, "W/", 2) != 0) {
+        self->m_etag = event->header_value;
+    }
+    return ESP_OK;
+}
+
+void OtaUpdater::writerEntryPoint(void* param) {
+    OtaUpdater* self = static_cast<OtaUpdater*>(param);
+    self->writerLoop();
+    xSemaphoreGive(self->m_writerDone);
+    vTaskDelete(nullptr);
+}
+
+bool OtaUpdater::download() {
+    esp_http_client_config_t config = {};
+    config.url = m_config.url.c_str();
+    config.cert_pem = m_config.certPem;
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+    if (!m_config.certPem) {
+        config.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+#endif
+    config.timeout_ms = static_cast<int>(m_config.timeoutMs);
+    config.event_handler = httpEvent;
+    config.user_data = this;
+    config.keep_alive_enable = true;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        ESP_LOGE(TAG, "Cannot create the HTTP client");
+        return false;
+    }
+
+    bool complete = false;
+    for (esperto::uint32 attempt = 0; !complete && !m_writerFailed.load(); ++attempt) {
+        if (attempt > 0) {
+            if (attempt > m_config.maxResumes) {
+                ESP_LOGE(TAG, "Giving up after %lu resumes", static_cast<unsigned long>(m_config.maxResumes));
+                break;
+            }
+            m_stats.resumes++;
+            vTaskDelay(pdMS_TO_TICKS(m_config.retryDelayMs));
+        }
+
+        esperto::uint64 offset = m_stats.downloadedBytes;
+        if (offset > 0) {
+            char range[32];
+            snprintf(range, sizeof(range), "bytes=%llu-", static_cast<unsigned long long>(offset));
+            esp_http_client_set_header(client, "Range", range);
+            if (!m_etag.empty()) {
+                esp_http_client_set_header(client, "If-Range", m_etag.c_str());
+            }
+        } else {
+            esp_http_client_delete_header(client, "Range");
+            esp_http_client_delete_header(client, "If-Range");
+        }
+
+        esp_err_t err = esp_http_client_open(client, 0);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Cannot connect to the update server: %s", esp_err_to_name(err));
+            continue;
+        }
+        esperto::int64 length = esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+
+        bool restartImage = false;
+        if (status == 206 && offset > 0) {
+            ESP_LOGI(TAG, "Resuming at byte %llu", static_cast<unsigned long long>(offset));
+        } else if (status == 200) {
+            // Without range support (or with a changed file) the image starts over
+            if (offset > 0) {
+                ESP_LOGW(TAG, "Server sent the whole image again, restarting it");
+                m_stats.restarts++;
+                m_stats.downloadedBytes = 0;
+                restartImage = true;
+            }
+            m_stats.totalBytes = length > 0 ? static_cast<esperto::uint64>(length) : 0;
+        } else {
+            ESP_LOGE(TAG, "Update server answered %d", status);
+            esp_http_client_close(client);
+            break;
+        }
+
+        complete = streamBody(client, restartImage);
+        esp_http_client_close(client);
+    }
+    esp_http_client_cleanup(client);
+    return complete && !m_writerFailed.load();
+}
+
+bool OtaUpdater::streamBody(esp_http_client_handle_t client, bool restartImage) {
+    Chunk chunk;
+    if (!takeBuffer(chunk)) {
+        return false;
+    }
+    chunk.flags = restartImage ? ChunkRestart : 0;
+
+    bool complete = false;
+    for (;;) {
+        int read = esp_http_client_read(client, reinterpret_cast<char*>(chunk.data + chunk.length),
+                                        static_cast<int>(m_config.bufferSize - chunk.length));
+        if (read < 0) {
+            ESP_LOGW(TAG, "Download interrupted at byte %llu",
+                     static_cast<unsigned long long>(m_stats.downloadedBytes));
+            break;
+        }
+        if (read == 0) {
+            complete = esp_http_client_is_complete_data_received(client) ||
+                       (m_stats.totalBytes > 0 && m_stats.downloadedBytes >= m_stats.totalBytes);
+            break;
+        }
+
+        chunk.length += static_cast<size_t>(read);
+        m_stats.downloadedBytes += static_cast<esperto::uint64>(read);
+        if (chunk.length == m_config.bufferSize) {
+            pushBuffer(chunk);
+            if (!takeBuffer(chunk)) {
+                return false;
+            }
+        }
+    }
+    // Everything received so far is valid; a resume continues after it
+    pushBuffer(chunk);
+    return complete;
+}
+
+bool OtaUpdater::takeBuffer(Chunk& chunk) {
+    esperto::int64 start = esp_timer_get_time();
+    xQueueReceive(m_free, &chunk, portMAX_DELAY);
+    m_stats.flashWaitMs += static_cast<esperto::uint32>((esp_timer_get_time() - start) / 1000);
+    chunk.length = 0;
+    chunk.flags = 0;
+    return !m_writerFailed.load();
+}
+
+void OtaUpdater::pushBuffer(Chunk& chunk) {
+    if (chunk.length == 0 && chunk.flags == 0) {
+        xQueueSend(m_free, &chunk, portMAX_DELAY);
+        return;
+    }
+    xQueueSend(m_filled, &chunk, portMAX_DELAY);
+}
+
+void OtaUpdater::writerLoop() {
+    bool ok = true;
+    esperto::int64 waitedUs = 0;
+    for (;;) {
+        Chunk chunk;
+        esperto::int64 start = esp_timer_get_time();
+        xQueueReceive(m_filled, &chunk, portMAX_DELAY);
+        waitedUs += esp_timer_get_time() - start;
+        m_stats.networkWaitMs = static_cast<esperto::uint32>(waitedUs / 1000);
+
+        if (chunk.flags & ChunkEnd) {
+            ok = ok && !(chunk.flags & ChunkAbort) && finishImage();
+            break;
+        }
+        if (ok && (chunk.flags & ChunkRestart)) {
+            closeImage();
+            ok = openImage();
+        }
+        if (ok) {
+            ok = writeImage(chunk.data, chunk.length);
+        }
+        if (!ok) {
+            // The download stops at its next buffer
+            m_writerFailed = true;
+        }
+        xQueueSend(m_free, &chunk, portMAX_DELAY);
+    }
+    closeImage();
+    m_writerResult = ok;
+}
+
+bool OtaUpdater::openImage() {
+    esp_err_t err = esp_ota_begin(m_partition, OTA_WITH_SEQUENTIAL_WRITES, &m_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot start writing %s: %s", m_partition->label, esp_err_to_name(err));
+        return false;
+    }
+    m_imageOpen = true;
+    m_stats.imageBytes = 0;
+    m_formatKnown = m_config.compression != Compression::Auto;
+    m_zlib = m_config.compression == Compression::Zlib;
+    m_inflateDone = false;
+    m_dictionaryOffset = 0;
+    if (m_inflator) {
+        tinfl_init(m_inflator);
+    }
+    return true;
+}
+
+bool OtaUpdater::writeImage(const esperto::uint8* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (!m_formatKnown) {
+        m_zlib = data[0] == ZlibMagic;
+        m_formatKnown = true;
+        if (!m_zlib && data[0] != ImageMagic) {
+            ESP_LOGE(TAG, "Not an app image (first byte 0x%02x)", data[0]);
+            return false;
+        }
+    }
+    if (m_zlib) {
+        m_stats.compressed = true;
+        return inflate(data, length);
+    }
+
+    esp_err_t err = esp_ota_write(m_handle, data, length);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Flash write failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    m_stats.imageBytes += length;
+    return true;
+}
+
+bool OtaUpdater::inflate(const esperto::uint8* data, size_t length) {
+    if (!m_inflator) {
+        // Allocated on first use: about 43 KiB that raw images never need
+        m_inflator = new (std::nothrow) tinfl_decompressor;
+        m_dictionary = new (std::nothrow) esperto::uint8[TINFL_LZ_DICT_SIZE];
+        if (!m_inflator || !m_dictionary) {
+            ESP_LOGE(TAG, "Out of memory for the inflater");
+            return false;
+        }
+        tinfl_init(m_inflator);
+    }
+    if (m_inflateDone) {
+        ESP_LOGW(TAG, "Ignoring %u bytes after the end of the compressed image", static_cast<unsigned>(length));
+        return true;
+    }
+
+    size_t offset = 0;
+    for (;;) {
+        size_t inBytes = length - offset;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - m_dictionaryOffset;
+        tinfl_status status = tinfl_decompress(m_inflator, data + offset, &inBytes, m_dictionary,
+                                               m_dictionary + m_dictionaryOffset, &outBytes,
+                                               TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        offset += inBytes;
+        if (outBytes > 0) {
+            esp_err_t err = esp_ota_write(m_handle, m_dictionary + m_dictionaryOffset, outBytes);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Flash write failed: %s", esp_err_to_name(err));
+                return false;
+            }
+            m_stats.imageBytes += outBytes;
+            m_dictionaryOffset = (m_dictionaryOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) {
+            m_inflateDone = true;
+            return true;
+        }
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Corrupt compressed image (status %d)", static_cast<int>(status));
+            return false;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && offset == length) {
+            return true;
+        }
+    }
+}
+
+bool OtaUpdater::finishImage() {
+    if (m_zlib && !m_inflateDone) {
+        ESP_LOGE(TAG, "Compressed image is truncated");
+        return false;
+    }
+    m_imageOpen = false;
+    // Verifies the image, including its checksum and hash
+    esp_err_t err = esp_ota_end(m_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+void OtaUpdater::closeImage() {
+    if (m_imageOpen) {
+        esp_ota_abort(m_handle);
+        m_imageOpen = false;
+    }
+}
+
+void OtaUpdater::releaseResources() {
+    delete[] m_buffers[0];
+    delete[] m_buffers[1];
+    m_buffers[0] = nullptr;
+    m_buffers[1] = nullptr;
+    if (m_free) {
+        vQueueDelete(m_free);
+        m_free = nullptr;
+    }
+    if (m_filled) {
+        vQueueDelete(m_filled);
+        m_filled = nullptr;
+    }
+    if (m_writerDone) {
+        vSemaphoreDelete(m_writerDone);
+        m_writerDone = nullptr;
+    }
+    delete m_inflator;
+    delete[] m_dictionary;
+    m_inflator = nullptr;
+    m_dictionary = nullptr;
+}
+
+} // namespace esperto
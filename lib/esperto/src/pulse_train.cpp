@@ -0,0 +1,148 @@
+// pulse_train.cpp
+// Implementation of PulseTrain class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/pulse_train.hpp"
+#include <algorithm>
+
+extern "C" {
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "PulseTrain";
+
+// Largest duration a symbol half can hold (15-bit field)
+static constexpr esperto::uint32 MaxSymbolTicks = 0x7FFF;
+
+PulseTrain::PulseTrain(gpio_num_t pin, const Config& config)
+    : m_pin(pin), m_config(config), m_channel(nullptr), m_encoder(nullptr), m_looping(false) {}
+
+PulseTrain::~PulseTrain() {
+    stop();
+}
+
+bool PulseTrain::start() {
+    if (m_channel) {
+        return true;
+    }
+
+    rmt_tx_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = m_pin;
+    channelConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    channelConfig.resolution_hz = m_config.resolutionHz;
+    channelConfig.mem_block_symbols = m_config.memorySymbols;
+    channelConfig.trans_queue_depth = m_config.queueDepth;
+    if (rmt_new_tx_channel(&channelConfig, &m_channel) != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO%d: no RMT TX channel available", static_cast<int>(m_pin));
+        m_channel = nullptr;
+        return false;
+    }
+
+    rmt_copy_encoder_config_t encoderConfig = {};
+    if (rmt_new_copy_encoder(&encoderConfig, &m_encoder) != ESP_OK || rmt_enable(m_channel) != ESP_OK) {
+        if (m_encoder) {
+            rmt_del_encoder(m_encoder);
+            m_encoder = nullptr;
+        }
+        rmt_del_channel(m_channel);
+        m_channel = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PulseTrain::stop() {
+    if (!m_channel) {
+        return;
+    }
+    // A looping sequence never finishes: disabling the channel aborts it
+    if (!m_looping) {
+        rmt_tx_wait_all_done(m_channel, -1);
+    }
+    rmt_disable(m_channel);
+    rmt_del_encoder(m_encoder);
+    rmt_del_channel(m_channel);
+    m_encoder = nullptr;
+    m_channel = nullptr;
+    m_looping = false;
+}
+
+bool PulseTrain::transmit(const std::vector<Pulse>& pulses, esperto::int32 loopCount) {
+    if (!m_channel || pulses.empty()) {
+        return false;
+    }
+
+    // The driver reads m_symbols while it plays them
+    if (m_looping) {
+        rmt_disable(m_channel);
+        rmt_enable(m_channel);
+        m_looping = false;
+    } else {
+        rmt_tx_wait_all_done(m_channel, -1);
+    }
+
+    // Two pulses per symbol; a zero duration would end the sequence early, so long
+    // pulses are split and empty ones dropped
+    m_symbols.clear();
+    bool half = false;
+    for (const Pulse& pulse : pulses) {
+        esperto::uint64 ticks = static_cast<esperto::uint64>(pulse.durationUs) * m_config.resolutionHz / 1000000;
+        while (ticks > 0) {
+            esperto::uint32 chunk = static_cast<esperto::uint32>(std::min<esperto::uint64>(ticks, MaxSymbolTicks));
+            ticks -= chunk;
+            if (!half) {
+                rmt_symbol_word_t symbol = {};
+                symbol.level0 = pulse.level ? 1 : 0;
+                symbol.duration0 = chunk;
+                m_symbols.push_back(symbol);
+            } else {
+                m_symbols.back().level1 = pulse.level ? 1 : 0;
+                m_symbols.back().duration1 = chunk;
+            }
+            half = !half;
+        }
+    }
+    if (m_symbols.empty()) {
+        return false;
+    }
+    if (half) {
+        // Pad the last symbol with one idle-level tick so its second half is not an end marker
+        m_symbols.back().level1 = m_config.idleLevel ? 1 : 0;
+        m_symbols.back().duration1 = 1;
+    }
+
+    rmt_transmit_config_t transmitConfig = {};
+    transmitConfig.loop_count = loopCount;
+    transmitConfig.flags.eot_level = m_config.idleLevel ? 1 : 0;
+    if (rmt_transmit(m_channel, m_encoder, m_symbols.data(), m_symbols.size() * sizeof(rmt_symbol_word_t),
+                     &transmitConfig) != ESP_OK) {
+        return false;
+    }
+    m_looping = loopCount < 0;
+    return true;
+}
+
+bool PulseTrain::wait(esperto::uint32 timeoutMs) {
+    if (!m_channel) {
+        return true;
+    }
+    if (m_looping) {
+        return false;
+    }
+    int timeout = timeoutMs == InfiniteTimeout ? -1 : static_cast<int>(std::min<esperto::uint32>(timeoutMs, 0x7FFFFFFF));
+    return rmt_tx_wait_all_done(m_channel, timeout) == ESP_OK;
+}
+
+gpio_num_t PulseTrain::getPin() const {
+    return m_pin;
+}
+
+bool PulseTrain::equals(const Object& other) const {
+    auto* o = static_cast<const PulseTrain*>(&other);
+    return o && o->m_pin == m_pin;
+}
+
+} // namespace esperto
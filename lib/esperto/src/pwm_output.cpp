@@ -0,0 +1,248 @@
+// pwm_output.cpp
+// Implementation of PwmOutput class for ESP32
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/pwm_output.hpp"
+#include <algorithm>
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "PwmOutput";
+
+// Low-speed mode exists on every ESP32 variant and updates duty/frequency on its own
+static constexpr ledc_mode_t SpeedMode = LEDC_LOW_SPEED_MODE;
+
+struct LedcTimerSlot {
+    esperto::uint32 frequencyHz;
+    esperto::uint32 resolutionBits;
+    esperto::uint32 users;
+};
+
+static LedcTimerSlot s_timers[LEDC_TIMER_MAX] = {};
+static esperto::uint32 s_channels = 0;
+static bool s_fadeInstalled = false;
+
+// Guards the channel and timer tables; held across LEDC driver calls, so not a spinlock
+static SemaphoreHandle_t allocationLock() {
+    static StaticSemaphore_t buffer;
+    static SemaphoreHandle_t handle = xSemaphoreCreateMutexStatic(&buffer);
+    return handle;
+}
+
+PwmOutput::PwmOutput(gpio_num_t pin, const Config& config)
+    : m_pin(pin), m_config(config), m_channel(LEDC_CHANNEL_MAX), m_timer(LEDC_TIMER_MAX), m_running(false) {}
+
+PwmOutput::~PwmOutput() {
+    stop();
+}
+
+bool PwmOutput::start() {
+    if (m_running) {
+        return true;
+    }
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(m_pin) || m_config.resolutionBits == 0 ||
+        m_config.resolutionBits >= LEDC_TIMER_BIT_MAX || m_config.frequencyHz == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(allocationLock(), portMAX_DELAY);
+    if (!s_fadeInstalled) {
+        // Also makes ledc_set_duty_and_update safe against a running fade
+        s_fadeInstalled = ledc_fade_func_install(0) == ESP_OK;
+    }
+
+    ledc_channel_t channel = LEDC_CHANNEL_MAX;
+    for (int i = 0; i < LEDC_CHANNEL_MAX; ++i) {
+        if (!(s_channels & (1u << i))) {
+            channel = static_cast<ledc_channel_t>(i);
+            break;
+        }
+    }
+    ledc_timer_t timer = LEDC_TIMER_MAX;
+    if (channel == LEDC_CHANNEL_MAX || !acquireTimer(m_config.frequencyHz, m_config.resolutionBits, timer)) {
+        xSemaphoreGive(allocationLock());
+        ESP_LOGE(TAG, "GPIO%d: no LEDC %s for %lu Hz at %lu bits", static_cast<int>(m_pin),
+                 channel == LEDC_CHANNEL_MAX ? "channel" : "timer", static_cast<unsigned long>(m_config.frequencyHz),
+                 static_cast<unsigned long>(m_config.resolutionBits));
+        return false;
+    }
+
+    ledc_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = m_pin;
+    channelConfig.speed_mode = SpeedMode;
+    channelConfig.channel = channel;
+    channelConfig.intr_type = LEDC_INTR_DISABLE;
+    channelConfig.timer_sel = timer;
+    channelConfig.duty = toDuty(m_config.dutyPercent);
+    channelConfig.hpoint = 0;
+    channelConfig.flags.output_invert = m_config.inverted ? 1 : 0;
+    if (ledc_channel_config(&channelConfig) != ESP_OK) {
+        releaseTimer(timer);
+        xSemaphoreGive(allocationLock());
+        return false;
+    }
+
+    s_channels |= 1u << channel;
+    m_channel = channel;
+    m_timer = timer;
+    m_running = true;
+    xSemaphoreGive(allocationLock());
+    return true;
+}
+
+void PwmOutput::stop(esperto::uint32 idleLevel) {
+    if (!m_running) {
+        return;
+    }
+    ledc_stop(SpeedMode, m_channel, idleLevel);
+
+    xSemaphoreTake(allocationLock(), portMAX_DELAY);
+    s_channels &= ~(1u << m_channel);
+    releaseTimer(m_timer);
+    xSemaphoreGive(allocationLock());
+
+    m_channel = LEDC_CHANNEL_MAX;
+    m_timer = LEDC_TIMER_MAX;
+    m_running = false;
+}
+
+bool PwmOutput::isRunning() const {
+    return m_running;
+}
+
+bool PwmOutput::setDuty(float percent) {
+    m_config.dutyPercent = std::clamp(percent, 0.0f, 100.0f);
+    if (!m_running) {
+        return true;
+    }
+    return ledc_set_duty_and_update(SpeedMode, m_channel, toDuty(m_config.dutyPercent), 0) == ESP_OK;
+}
+
+float PwmOutput::getDuty() const {
+    if (!m_running) {
+        return m_config.dutyPercent;
+    }
+    // Reads the hardware, so the value follows a fade in progress
+    return 100.0f * static_cast<float>(ledc_get_duty(SpeedMode, m_channel)) /
+           static_cast<float>(1u << m_config.resolutionBits);
+}
+
+bool PwmOutput::setFrequency(esperto::uint32 frequencyHz) {
+    if (frequencyHz == 0) {
+        return false;
+    }
+    if (!m_running) {
+        m_config.frequencyHz = frequencyHz;
+        return true;
+    }
+
+    xSemaphoreTake(allocationLock(), portMAX_DELAY);
+    bool changed = false;
+    LedcTimerSlot& current = s_timers[m_timer];
+    if (current.users == 1) {
+        // Sole user: retune the timer in place
+        ledc_timer_config_t timerConfig = {};
+        timerConfig.speed_mode = SpeedMode;
+        timerConfig.duty_resolution = static_cast<ledc_timer_bit_t>(m_config.resolutionBits);
+        timerConfig.timer_num = m_timer;
+        timerConfig.freq_hz = frequencyHz;
+        timerConfig.clk_cfg = LEDC_AUTO_CLK;
+        changed = ledc_timer_config(&timerConfig) == ESP_OK;
+        if (changed) {
+            current.frequencyHz = frequencyHz;
+        }
+    } else {
+        ledc_timer_t timer = LEDC_TIMER_MAX;
+        if (acquireTimer(frequencyHz, m_config.resolutionBits, timer)) {
+            if (ledc_bind_channel_timer(SpeedMode, m_channel, timer) == ESP_OK) {
+                releaseTimer(m_timer);
+                m_timer = timer;
+                changed = true;
+            } else {
+                releaseTimer(timer);
+            }
+        }
+    }
+    xSemaphoreGive(allocationLock());
+
+    if (changed) {
+        m_config.frequencyHz = frequencyHz;
+    }
+    return changed;
+}
+
+esperto::uint32 PwmOutput::getFrequency() const {
+    return m_config.frequencyHz;
+}
+
+bool PwmOutput::fadeTo(float percent, esperto::uint32 durationMs, bool wait) {
+    if (!m_running || !s_fadeInstalled) {
+        return false;
+    }
+    m_config.dutyPercent = std::clamp(percent, 0.0f, 100.0f);
+    return ledc_set_fade_time_and_start(SpeedMode, m_channel, toDuty(m_config.dutyPercent), durationMs,
+                                        wait ? LEDC_FADE_WAIT_DONE : LEDC_FADE_NO_WAIT) == ESP_OK;
+}
+
+gpio_num_t PwmOutput::getPin() const {
+    return m_pin;
+}
+
+bool PwmOutput::equals(const Object& other) const {
+    auto* o = static_cast<const PwmOutput*>(&other);
+    return o && o->m_pin == m_pin;
+}
+
+esperto::uint32 PwmOutput::toDuty(float percent) const {
+    float clamped = std::clamp(percent, 0.0f, 100.0f);
+    return static_cast<esperto::uint32>(clamped * static_cast<float>(1u << m_config.resolutionBits) / 100.0f + 0.5f);
+}
+
+bool PwmOutput::acquireTimer(esperto::uint32 frequencyHz, esperto::uint32 resolutionBits, ledc_timer_t& timer) {
+    for (int i = 0; i < LEDC_TIMER_MAX; ++i) {
+        LedcTimerSlot& slot = s_timers[i];
+        if (slot.users > 0 && slot.frequencyHz == frequencyHz && slot.resolutionBits == resolutionBits) {
+            slot.users++;
+            timer = static_cast<ledc_timer_t>(i);
+            return true;
+        }
+    }
+    for (int i = 0; i < LEDC_TIMER_MAX; ++i) {
+        LedcTimerSlot& slot = s_timers[i];
+        if (slot.users != 0) {
+            continue;
+        }
+        ledc_timer_config_t timerConfig = {};
+        timerConfig.speed_mode = SpeedMode;
+        timerConfig.duty_resolution = static_cast<ledc_timer_bit_t>(resolutionBits);
+        timerConfig.timer_num = static_cast<ledc_timer_t>(i);
+        timerConfig.freq_hz = frequencyHz;
+        timerConfig.clk_cfg = LEDC_AUTO_CLK;
+        // Fails when the clock dividers cannot reach the frequency at this resolution
+        if (ledc_timer_config(&timerConfig) != ESP_OK) {
+            return false;
+        }
+        slot.frequencyHz = frequencyHz;
+        slot.resolutionBits = resolutionBits;
+        slot.users = 1;
+        timer = static_cast<ledc_timer_t>(i);
+        return true;
+    }
+    return false;
+}
+
+void PwmOutput::releaseTimer(ledc_timer_t timer) {
+    LedcTimerSlot& slot = s_timers[timer];
+    if (slot.users > 0 && --slot.users == 0) {
+        ledc_timer_pause(SpeedMode, timer);
+    }
+}
+
+} // namespace esperto
@@ -0,0 +1,287 @@
+// realtime_policy.cpp
+// Implementation of RealtimePolicy class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/realtime_policy.hpp"
+#include "../headers/task.hpp"
+#include <algorithm>
+#include <utility>
+
+extern "C" {
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "RealtimePolicy";
+
+static void updateMax(std::atomic<esperto::uint32>& value, esperto::uint32 sample) {
+    esperto::uint32 current = value.load(std::memory_order_relaxed);
+    while (sample > current && !value.compare_exchange_weak(current, sample, std::memory_order_relaxed)) {
+    }
+}
+
+static esperto::uint32 effectiveDeadlineMs(const RealtimePolicy::Parameters& parameters) {
+    return parameters.deadlineMs ? parameters.deadlineMs : parameters.periodMs;
+}
+
+RealtimePolicy::RealtimePolicy(const Config& config)
+    : m_config(config), m_admitted(0), m_rejected(0) {
+    m_lock = xSemaphoreCreateMutexStatic(&m_lockBuffer);
+}
+
+RealtimePolicy::~RealtimePolicy() {
+    vSemaphoreDelete(m_lock);
+}
+
+bool RealtimePolicy::configure(const Config& config) {
+    if (config.lowestPriority > config.highestPriority || config.highestPriority >= configMAX_PRIORITIES) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    bool idle = m_entries.empty();
+    if (idle) {
+        m_config = config;
+    }
+    xSemaphoreGive(m_lock);
+    return idle;
+}
+
+bool RealtimePolicy::isSchedulable(const Parameters& parameters) const {
+    if (!validate(parameters)) {
+        return false;
+    }
+    Entry candidate;
+    candidate.parameters = parameters;
+    std::vector<Entry*> order;
+    std::vector<esperto::uint32> bounds;
+
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    bool schedulable = analyze(&candidate, order, bounds);
+    xSemaphoreGive(m_lock);
+    return schedulable;
+}
+
+std::shared_ptr<Task> RealtimePolicy::startPeriodic(Job job, const Parameters& parameters, const esperto::string& name, esperto::uint32 stackSize) {
+    if (!job || !validate(parameters)) {
+        ESP_LOGW(TAG, "Rejected %s: invalid timing parameters", name.c_str());
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_rejected++;
+        xSemaphoreGive(m_lock);
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->name = name;
+    entry->parameters = parameters;
+    entry->periodTicks = pdMS_TO_TICKS(parameters.periodMs);
+
+    std::vector<Entry*> order;
+    std::vector<esperto::uint32> bounds;
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    if (!analyze(entry.get(), order, bounds)) {
+        m_rejected++;
+        xSemaphoreGive(m_lock);
+        ESP_LOGW(TAG, "Rejected %s: task set on core %ld would miss deadlines", name.c_str(),
+                 static_cast<long>(parameters.core));
+        return nullptr;
+    }
+
+    // Shortest deadline gets the top of the band
+    size_t position = std::find(order.begin(), order.end(), entry.get()) - order.begin();
+    auto task = std::make_shared<Task>([this, entry, job = std::move(job)](Task&) {
+        runPeriodic(*entry, job);
+        retire(entry.get());
+    }, name, stackSize, m_config.highestPriority - static_cast<UBaseType_t>(position));
+    task->setCoreAffinity(parameters.core);
+    // Started before anything is committed: the task blocks on the lock before it could retire
+    task->start();
+    if (task->getState() == Task::TaskState::Created) {
+        m_rejected++;
+        xSemaphoreGive(m_lock);
+        ESP_LOGE(TAG, "Rejected %s: task could not be created", name.c_str());
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i]->priority = m_config.highestPriority - static_cast<UBaseType_t>(i);
+        order[i]->responseBoundUs = bounds[i];
+    }
+    entry->task = task;
+    m_entries.push_back(entry);
+    m_admitted++;
+
+    for (Entry* other : order) {
+        if (other == entry.get()) {
+            continue;
+        }
+        auto otherTask = other->task.lock();
+        if (otherTask && otherTask->getPriority() != other->priority) {
+            otherTask->setPriority(other->priority);
+        }
+    }
+    xSemaphoreGive(m_lock);
+    return task;
+}
+
+bool RealtimePolicy::stop(const std::shared_ptr<Task>& task) {
+    bool found = false;
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    for (auto& entry : m_entries) {
+        if (entry->task.lock() == task) {
+            entry->stopping = true;
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(m_lock);
+    return found;
+}
+
+void RealtimePolicy::setMissHandler(MissHandler handler) {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_missHandler = std::move(handler);
+    xSemaphoreGive(m_lock);
+}
+
+RealtimePolicy::Statistics RealtimePolicy::getStatistics() const {
+    Statistics stats;
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    stats.admitted = m_admitted;
+    stats.rejected = m_rejected;
+    stats.tasks.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        const Parameters& parameters = entry->parameters;
+        stats.utilization[parameters.core] += static_cast<float>(parameters.budgetUs + m_config.overheadUs) /
+                                              (static_cast<float>(parameters.periodMs) * 1000.0f);
+        stats.tasks.push_back(snapshot(*entry));
+    }
+    xSemaphoreGive(m_lock);
+    return stats;
+}
+
+bool RealtimePolicy::validate(const Parameters& parameters) const {
+    if (parameters.periodMs == 0 || parameters.budgetUs == 0 || parameters.core < 0 ||
+        parameters.core >= portNUM_PROCESSORS) {
+        return false;
+    }
+    // Constrained deadlines only, and releases must fall on tick boundaries
+    esperto::uint32 deadlineMs = effectiveDeadlineMs(parameters);
+    if (deadlineMs > parameters.periodMs || parameters.periodMs % portTICK_PERIOD_MS != 0) {
+        return false;
+    }
+    return parameters.budgetUs + m_config.overheadUs <= deadlineMs * 1000u;
+}
+
+bool RealtimePolicy::analyze(const Entry* candidate, std::vector<Entry*>& order, std::vector<esperto::uint32>& bounds) const {
+    BaseType_t core = candidate->parameters.core;
+    order.clear();
+    for (const auto& entry : m_entries) {
+        if (entry->parameters.core == core && !entry->stopping) {
+            order.push_back(entry.get());
+        }
+    }
+    order.push_back(const_cast<Entry*>(candidate));
+
+    size_t bandSize = m_config.highestPriority - m_config.lowestPriority + 1;
+    if (order.size() > bandSize) {
+        return false;
+    }
+
+    // Deadline-monotonic order: optimal for fixed priorities with constrained deadlines
+    std::stable_sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) {
+        esperto::uint32 da = effectiveDeadlineMs(a->parameters);
+        esperto::uint32 db = effectiveDeadlineMs(b->parameters);
+        return da != db ? da < db : a->parameters.periodMs < b->parameters.periodMs;
+    });
+
+    // Response-time analysis: R = C + sum over higher priorities of ceil(R / T) * C
+    bounds.assign(order.size(), 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        esperto::uint64 cost = order[i]->parameters.budgetUs + m_config.overheadUs;
+        esperto::uint64 deadlineUs = static_cast<esperto::uint64>(effectiveDeadlineMs(order[i]->parameters)) * 1000;
+        esperto::uint64 response = cost;
+        for (;;) {
+            esperto::uint64 next = cost;
+            for (size_t j = 0; j < i; ++j) {
+                esperto::uint64 periodUs = static_cast<esperto::uint64>(order[j]->parameters.periodMs) * 1000;
+                next += ((response + periodUs - 1) / periodUs) * (order[j]->parameters.budgetUs + m_config.overheadUs);
+            }
+            if (next > deadlineUs) {
+                return false;
+            }
+            if (next == response) {
+                break;
+            }
+            response = next;
+        }
+        bounds[i] = static_cast<esperto::uint32>(response);
+    }
+    return true;
+}
+
+void RealtimePolicy::runPeriodic(Entry& entry, const Job& job) {
+    const esperto::int64 periodUs = static_cast<esperto::int64>(entry.parameters.periodMs) * 1000;
+    const esperto::int64 deadlineUs = static_cast<esperto::int64>(effectiveDeadlineMs(entry.parameters)) * 1000;
+    TickType_t lastWake = xTaskGetTickCount();
+    esperto::int64 releaseUs = esp_timer_get_time();
+
+    while (!entry.stopping) {
+        esperto::int64 startUs = esp_timer_get_time();
+        job();
+        esperto::int64 endUs = esp_timer_get_time();
+
+        esperto::uint32 executionUs = static_cast<esperto::uint32>(endUs - startUs);
+        esperto::uint32 responseUs = static_cast<esperto::uint32>(std::max<esperto::int64>(endUs - releaseUs, 0));
+        entry.jobs.fetch_add(1, std::memory_order_relaxed);
+        updateMax(entry.maxExecutionUs, executionUs);
+        updateMax(entry.maxResponseUs, responseUs);
+        if (executionUs > entry.parameters.budgetUs) {
+            entry.budgetOverruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (endUs - releaseUs > deadlineUs) {
+            entry.deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+            xSemaphoreTake(m_lock, portMAX_DELAY);
+            MissHandler handler = m_missHandler;
+            TaskStatistics stats = snapshot(entry);
+            xSemaphoreGive(m_lock);
+            if (handler) {
+                handler(stats);
+            }
+        }
+
+        releaseUs += periodUs;
+        if (xTaskDelayUntil(&lastWake, entry.periodTicks) == pdFALSE) {
+            // The next release already passed: restart the period instead of bursting to catch up
+            entry.skippedReleases.fetch_add(1, std::memory_order_relaxed);
+            lastWake = xTaskGetTickCount();
+            releaseUs = esp_timer_get_time();
+        }
+    }
+}
+
+void RealtimePolicy::retire(Entry* entry) {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+        [entry](const std::shared_ptr<Entry>& other) { return other.get() == entry; }), m_entries.end());
+    xSemaphoreGive(m_lock);
+}
+
+RealtimePolicy::TaskStatistics RealtimePolicy::snapshot(const Entry& entry) const {
+    TaskStatistics stats;
+    stats.name = entry.name;
+    stats.parameters = entry.parameters;
+    stats.priority = entry.priority;
+    stats.responseBoundUs = entry.responseBoundUs;
+    stats.jobs = entry.jobs.load(std::memory_order_relaxed);
+    stats.deadlineMisses = entry.deadlineMisses.load(std::memory_order_relaxed);
+    stats.budgetOverruns = entry.budgetOverruns.load(std::memory_order_relaxed);
+    stats.skippedReleases = entry.skippedReleases.load(std::memory_order_relaxed);
+    stats.maxExecutionUs = entry.maxExecutionUs.load(std::memory_order_relaxed);
+    stats.maxResponseUs = entry.maxResponseUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace esperto
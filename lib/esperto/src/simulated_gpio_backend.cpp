@@ -0,0 +1,296 @@
+// simulated_gpio_backend.cpp
+// Implementation of SimulatedGpioBackend class
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/simulated_gpio_backend.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace esperto {
+
+SimulatedGpioBackend::SimulatedGpioBackend() : SimulatedGpioBackend(Config()) {}
+
+SimulatedGpioBackend::SimulatedGpioBackend(const Config& config)
+    : m_config(config), m_sequence(0), m_nowNs(0) {
+    for (PinState& state : m_pins) {
+        state.mode = GPIO_MODE_DISABLE;
+        state.pull = GPIO_FLOATING;
+        state.interruptType = GPIO_INTR_DISABLE;
+        state.interruptEnabled = false;
+        state.latched = false;
+        state.input = 0;
+        state.output = 0;
+        state.handler = nullptr;
+        state.arg = nullptr;
+    }
+    m_lock = xSemaphoreCreateMutexStatic(&m_lockBuffer);
+}
+
+void SimulatedGpioBackend::injectEdges(gpio_num_t pin, const std::vector<Edge>& edges) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    for (const Edge& edge : edges) {
+        schedule(std::max(edge.timeNs, m_nowNs), EventType::Edge, pin, edge.level ? 1 : 0);
+    }
+    xSemaphoreGive(m_lock);
+}
+
+void SimulatedGpioBackend::injectSquareWave(gpio_num_t pin, esperto::uint64 startNs, esperto::uint64 halfPeriodNs, esperto::uint32 count) {
+    std::vector<Edge> edges;
+    edges.reserve(count);
+    for (esperto::uint32 i = 0; i < count; ++i) {
+        edges.push_back({startNs + i * halfPeriodNs, (i & 1) ? 0u : 1u});
+    }
+    injectEdges(pin, edges);
+}
+
+esperto::uint64 SimulatedGpioBackend::advanceTo(esperto::uint64 timeNs) {
+    esperto::uint64 calls = play(timeNs);
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_nowNs = std::max(m_nowNs, timeNs);
+    xSemaphoreGive(m_lock);
+    return calls;
+}
+
+esperto::uint64 SimulatedGpioBackend::runAll() {
+    // The clock stops at the last event
+    return play(UINT64_MAX);
+}
+
+esperto::uint64 SimulatedGpioBackend::play(esperto::uint64 timeNs) {
+    esperto::uint64 calls = 0;
+    for (;;) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        if (m_events.empty() || m_events.top().timeNs > timeNs) {
+            xSemaphoreGive(m_lock);
+            return calls;
+        }
+
+        Event event = m_events.top();
+        m_events.pop();
+        m_nowNs = std::max(m_nowNs, event.timeNs);
+        PinState& state = m_pins[event.pin];
+        gpio_isr_t handler = nullptr;
+        void* arg = nullptr;
+        if (event.type == EventType::Edge) {
+            applyEdge(state, event.pin, event.level);
+        } else {
+            state.latched = false;
+            if (state.interruptEnabled && state.handler) {
+                handler = state.handler;
+                arg = state.arg;
+            }
+        }
+        xSemaphoreGive(m_lock);
+
+        if (!handler) {
+            continue;
+        }
+        // Host time of the dispatch path: the number the benchmarks track
+        auto start = std::chrono::steady_clock::now();
+        handler(arg);
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        esperto::uint32 elapsedNs = static_cast<esperto::uint32>(std::min<long long>(elapsed, 0xFFFFFFFF));
+        calls++;
+
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_stats.dispatchMinNs = m_stats.interrupts == 0 ? elapsedNs : std::min(m_stats.dispatchMinNs, elapsedNs);
+        m_stats.dispatchMaxNs = std::max(m_stats.dispatchMaxNs, elapsedNs);
+        m_stats.dispatchTotalNs += elapsedNs;
+        m_stats.interrupts++;
+        xSemaphoreGive(m_lock);
+    }
+}
+
+esperto::uint64 SimulatedGpioBackend::now() const {
+    return m_nowNs;
+}
+
+std::vector<SimulatedGpioBackend::Sample> SimulatedGpioBackend::getWaveform() const {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    std::vector<Sample> waveform = m_waveform;
+    xSemaphoreGive(m_lock);
+    return waveform;
+}
+
+void SimulatedGpioBackend::resetStatistics() {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_stats = Statistics();
+    m_waveform.clear();
+    xSemaphoreGive(m_lock);
+}
+
+SimulatedGpioBackend::Statistics SimulatedGpioBackend::getStatistics() const {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    Statistics stats = m_stats;
+    stats.nowNs = m_nowNs;
+    xSemaphoreGive(m_lock);
+    return stats;
+}
+
+bool SimulatedGpioBackend::install() {
+    return true;
+}
+
+bool SimulatedGpioBackend::setDirection(gpio_num_t pin, gpio_mode_t mode) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].mode = mode;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::setLevel(gpio_num_t pin, esperto::uint32 level) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    level = level ? 1 : 0;
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    PinState& state = m_pins[pin];
+    if (state.output != level) {
+        state.output = level;
+        if (m_waveform.size() < m_config.maxSamples) {
+            m_waveform.push_back({m_nowNs, pin, level});
+        } else {
+            m_stats.samplesDropped++;
+        }
+    }
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+int SimulatedGpioBackend::getLevel(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return 0;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    int level = static_cast<int>(padLevel(m_pins[pin]));
+    xSemaphoreGive(m_lock);
+    return level;
+}
+
+bool SimulatedGpioBackend::setPullMode(gpio_num_t pin, gpio_pull_mode_t mode) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].pull = mode;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::setInterruptType(gpio_num_t pin, gpio_int_type_t type) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].interruptType = type;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::enableInterrupt(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].interruptEnabled = true;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::disableInterrupt(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].interruptEnabled = false;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::addHandler(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    // Like gpio_isr_handler_add, attaching a handler also enables the interrupt
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].handler = handler;
+    m_pins[pin].arg = arg;
+    m_pins[pin].interruptEnabled = true;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+bool SimulatedGpioBackend::removeHandler(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_pins[pin].handler = nullptr;
+    m_pins[pin].arg = nullptr;
+    m_pins[pin].interruptEnabled = false;
+    xSemaphoreGive(m_lock);
+    return true;
+}
+
+esperto::uint32 SimulatedGpioBackend::getTimestamp() {
+    return static_cast<esperto::uint32>(m_nowNs * m_config.cpuFrequencyMhz / 1000);
+}
+
+void SimulatedGpioBackend::schedule(esperto::uint64 timeNs, EventType type, gpio_num_t pin, esperto::uint32 level) {
+    m_events.push({timeNs, m_sequence++, type, pin, level});
+}
+
+void SimulatedGpioBackend::applyEdge(PinState& state, gpio_num_t pin, esperto::uint32 level) {
+    esperto::uint32 previous = padLevel(state);
+    if (state.input == level) {
+        return;
+    }
+    state.input = level;
+    m_stats.edges++;
+
+    esperto::uint32 current = padLevel(state);
+    if (!state.interruptEnabled || !matches(state.interruptType, previous, current)) {
+        return;
+    }
+    if (state.latched) {
+        // The status bit is already set: this edge merges into the pending interrupt
+        m_stats.droppedEdges++;
+        return;
+    }
+    state.latched = true;
+    schedule(m_nowNs + m_config.interruptLatencyNs, EventType::Service, pin, current);
+}
+
+esperto::uint32 SimulatedGpioBackend::padLevel(const PinState& state) {
+    if (!(state.mode & GPIO_MODE_DEF_INPUT)) {
+        return 0;
+    }
+    // A pin that is also an output reads back the level it drives
+    return (state.mode & GPIO_MODE_DEF_OUTPUT) ? state.output : state.input;
+}
+
+bool SimulatedGpioBackend::matches(gpio_int_type_t type, esperto::uint32 previous, esperto::uint32 level) {
+    switch (type) {
+        case GPIO_INTR_POSEDGE:
+            return previous == 0 && level == 1;
+        case GPIO_INTR_NEGEDGE:
+            return previous == 1 && level == 0;
+        case GPIO_INTR_ANYEDGE:
+            return previous != level;
+        case GPIO_INTR_LOW_LEVEL:
+            return level == 0;
+        case GPIO_INTR_HIGH_LEVEL:
+            return level == 1;
+        default:
+            return false;
+    }
+}
+
+} // namespace esperto
@@ -4,50 +4,174 @@
 // License: MIT
 
 #include "../headers/task.hpp"
+#include <algorithm>
 #include <utility>
+extern "C" {
+#include "esp_timer.h"
+}
 
 namespace esperto {
 
+thread_local Task* Task::s_current = nullptr;
+
 Task::Task(TaskFunction func, const esperto::string& name, esperto::uint32 stackSize, UBaseType_t priority)
     : m_func(std::move(func)), m_name(name), m_stackSize(stackSize), m_priority(priority), 
-      m_handle(nullptr), m_state(TaskState::Created) {}
+      m_core(tskNO_AFFINITY), m_handle(nullptr), m_state(TaskState::Created), m_arena(nullptr),
+      m_voluntarySwitches(0), m_completedAtUs(0) {
+    m_doneEvent = xEventGroupCreateStatic(&m_doneEventBuffer);
+    m_lock = xSemaphoreCreateMutexStatic(&m_lockBuffer);
+}
 
 Task::~Task() {
-    if (m_handle && m_state != TaskState::Deleted) {
+    // A completed task has already deleted itself; its handle is no longer valid
+    TaskState state = m_state;
+    bool started = m_handle != nullptr;
+    if (m_handle && state != TaskState::Deleted && state != TaskState::Completed) {
         vTaskDelete(m_handle);
         m_handle = nullptr;
         m_state = TaskState::Deleted;
     }
+    // A started static task returns its slot from the TLS deletion callback
+    if (m_arena && !started) {
+        m_arena->release(m_slot.cookie);
+    }
+    vEventGroupDelete(m_doneEvent);
+    vSemaphoreDelete(m_lock);
 }
 
 void Task::start() {
-    if (m_state == TaskState::Created && m_func) {
-        BaseType_t result = xTaskCreate(
+    // Claimed before the FreeRTOS task exists: a short task on the other core may complete,
+    // and publish Completed, before xTaskCreate* returns here
+    TaskState expected = TaskState::Created;
+    if (!m_func || !m_state.compare_exchange_strong(expected, TaskState::Running)) {
+        return;
+    }
+
+    if (m_arena) {
+        m_handle = xTaskCreateStaticPinnedToCore(
+            &Task::taskEntryPoint,
+            m_name.c_str(),
+            m_slot.stackSize,
+            this,
+            m_priority,
+            m_slot.stack,
+            m_slot.tcb,
+            m_core
+        );
+        if (m_handle) {
+#if CONFIG_FREERTOS_TLSP_DELETION_CALLBACKS
+            // Armed before the task body runs, so the slot is released however the task ends
+            vTaskSetThreadLocalStoragePointerAndDelCallback(m_handle, TaskArena::TlsIndex, m_slot.cookie,
+                                                            &TaskArena::onTaskDeleted);
+#endif
+            xEventGroupSetBits(m_doneEvent, ArmedBit);
+            return;
+        }
+    } else {
+        BaseType_t result = xTaskCreatePinnedToCore(
             &Task::taskEntryPoint,
             m_name.c_str(),
             m_stackSize,
             this,
             m_priority,
-            &m_handle
+            &m_handle,
+            m_core
         );
         if (result == pdPASS) {
-            m_state = TaskState::Running;
+            return;
         }
+        m_handle = nullptr;
     }
+    m_state = TaskState::Created;
 }
 
-void Task::wait() {
-    // Wait for task completion by monitoring its state
-    while (m_state == TaskState::Running || m_state == TaskState::Suspended) {
-        if (m_handle) {
-            eTaskState freeRTOSState = eTaskGetState(m_handle);
-            m_state = convertFreeRTOSState(freeRTOSState);
-            if (m_state == TaskState::Completed || m_state == TaskState::Deleted) {
-                break;
-            }
+bool Task::useArena(TaskArena& arena) {
+#if !CONFIG_FREERTOS_TLSP_DELETION_CALLBACKS || CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS < 2
+    // Slots can only be recycled from the TLS deletion callback (not available on every port),
+    // and its pointer must not be the one pthread uses
+    return false;
+#endif
+    if (m_state != TaskState::Created || m_arena) {
+        return false;
+    }
+    if (!arena.acquire(m_stackSize, m_slot)) {
+        return false;
+    }
+    m_arena = &arena;
+    return true;
+}
+
+bool Task::isStatic() const {
+    return m_arena != nullptr;
+}
+
+bool Task::wait(esperto::uint32 timeoutMs) {
+    TaskState state = m_state;
+    if (state == TaskState::Completed || state == TaskState::Deleted) {
+        return true;
+    }
+    if (state == TaskState::Created) {
+        return false;
+    }
+
+    if (xEventGroupGetBits(m_doneEvent) & DoneBit) {
+        return true;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(m_doneEvent, DoneBit, pdFALSE, pdTRUE,
+                                           detail::timeoutToTicks(timeoutMs));
+    Task* waiter = current();
+    if (waiter) {
+        waiter->m_voluntarySwitches++;
+        if (bits & DoneBit) {
+            esperto::int64 latency = esp_timer_get_time() - m_completedAtUs.load();
+            waiter->m_latency.record(static_cast<esperto::uint32>(std::max<esperto::int64>(latency, 0)));
         }
-        vTaskDelay(pdMS_TO_TICKS(10)); // Small delay to avoid busy waiting
     }
+    return (bits & DoneBit) != 0;
+}
+
+void Task::continueWith(Continuation continuation) {
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    if (m_state != TaskState::Completed) {
+        m_continuations.push_back(std::move(continuation));
+        xSemaphoreGive(m_lock);
+        return;
+    }
+    xSemaphoreGive(m_lock);
+    continuation(*this);
+}
+
+Future<void> Task::whenAll(const std::vector<std::shared_ptr<Task>>& tasks) {
+    std::vector<Future<void>> futures;
+    futures.reserve(tasks.size());
+    for (auto& task : tasks) {
+        Promise<void> promise;
+        futures.push_back(promise.getFuture());
+        if (task) {
+            task->continueWith([promise](Task&) { promise.setValue(); });
+        } else {
+            promise.setValue();
+        }
+    }
+    return esperto::whenAll(futures);
+}
+
+Future<size_t> Task::whenAny(const std::vector<std::shared_ptr<Task>>& tasks) {
+    Promise<size_t> promise;
+    Future<size_t> result = promise.getFuture();
+    bool waiting = false;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i]) {
+            // Promise::setValue ignores every completion after the first one
+            tasks[i]->continueWith([promise, i](Task&) { promise.setValue(i); });
+            waiting = true;
+        }
+    }
+    if (!waiting) {
+        promise.setValue(NoIndex);
+    }
+    return result;
 }
 
 void Task::suspend() {
@@ -65,12 +189,13 @@ void Task::resume() {
 }
 
 Task::TaskState Task::getState() const {
-    if (m_handle && m_state != TaskState::Created) {
+    TaskState state = m_state;
+    if (m_handle && state != TaskState::Created && state != TaskState::Completed && state != TaskState::Deleted) {
         // Update state based on FreeRTOS state
         eTaskState freeRTOSState = eTaskGetState(m_handle);
         return convertFreeRTOSState(freeRTOSState);
     }
-    return m_state;
+    return state;
 }
 
 TaskHandle_t Task::getHandle() const {
@@ -89,6 +214,42 @@ UBaseType_t Task::getPriority() const {
     return m_priority;
 }
 
+void Task::setPriority(UBaseType_t priority) {
+    m_priority = priority;
+    TaskState state = m_state;
+    if (m_handle && (state == TaskState::Running || state == TaskState::Suspended)) {
+        vTaskPrioritySet(m_handle, priority);
+    }
+}
+
+bool Task::setCoreAffinity(BaseType_t core) {
+    if (m_state != TaskState::Created || (core != tskNO_AFFINITY && (core < 0 || core >= portNUM_PROCESSORS))) {
+        return false;
+    }
+    m_core = core;
+    return true;
+}
+
+BaseType_t Task::getCoreAffinity() const {
+    return m_core;
+}
+
+bool Task::migrate(BaseType_t core) {
+#if CONFIG_FREERTOS_SMP
+    TaskState state = m_state;
+    if (!m_handle || core < 0 || core >= portNUM_PROCESSORS ||
+        (state != TaskState::Running && state != TaskState::Suspended)) {
+        return false;
+    }
+    vTaskCoreAffinitySet(m_handle, static_cast<UBaseType_t>(1) << core);
+    m_core = core;
+    return true;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
 bool Task::isRunning() const {
     return getState() == TaskState::Running;
 }
@@ -98,15 +259,46 @@ bool Task::isCompleted() const {
     return state == TaskState::Completed || state == TaskState::Deleted;
 }
 
+esperto::uint32 Task::getVoluntarySwitches() const {
+    return m_voluntarySwitches;
+}
+
+LatencyHistogram Task::getLatency() const {
+    return m_latency.snapshot();
+}
+
+Task* Task::current() {
+    return s_current;
+}
+
 void Task::delay(esperto::uint32 delayMs) {
-    vTaskDelay(pdMS_TO_TICKS(delayMs));
+    delayTicks(pdMS_TO_TICKS(delayMs));
 }
 
 void Task::delayTicks(TickType_t delayTicks) {
+    Task* self = current();
+    if (!self) {
+        vTaskDelay(delayTicks);
+        return;
+    }
+
+    esperto::int64 start = esp_timer_get_time();
     vTaskDelay(delayTicks);
+    // Overshoot past the requested time: how late the scheduler ran us after the wake-up
+    esperto::int64 late = esp_timer_get_time() - start - static_cast<esperto::int64>(delayTicks) * portTICK_PERIOD_MS * 1000;
+    self->m_voluntarySwitches++;
+    self->m_latency.record(static_cast<esperto::uint32>(std::max<esperto::int64>(late, 0)));
+}
+
+DelayAwaiter Task::delayAsync(esperto::uint32 delayMs) {
+    return DelayAwaiter(delayMs);
 }
 
 void Task::yield() {
+    Task* self = current();
+    if (self) {
+        self->m_voluntarySwitches++;
+    }
     taskYIELD();
 }
 
@@ -117,14 +309,44 @@ bool Task::equals(const Object& other) const {
 
 void Task::taskEntryPoint(void* param) {
     Task* self = static_cast<Task*>(param);
-    if (self && self->m_func) {        
+    s_current = self;
+    if (self && self->m_arena) {
+        xEventGroupWaitBits(self->m_doneEvent, ArmedBit, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    if (self && self->m_func) {
+        // Keep a shared_ptr-owned task alive until completion has been signalled, since
+        // a released waiter may drop the last reference
+        std::shared_ptr<Task> keepAlive = self->weak_from_this().lock();
         self->m_func(*self);
-        self->m_state = TaskState::Completed;      
+        self->complete();
+        keepAlive.reset();
     }
-    // Task will be automatically deleted by FreeRTOS when this function returns
+    // vTaskDelete does not return: locals must be released before this point
     vTaskDelete(nullptr);
 }
 
+void Task::complete() {
+    // Completed is published only once no continuation is left, so wait() and isCompleted()
+    // never return before they have run. Continuations added meanwhile join the next pass.
+    for (;;) {
+        std::vector<Continuation> continuations;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        continuations.swap(m_continuations);
+        if (continuations.empty()) {
+            m_completedAtUs = esp_timer_get_time();
+            m_state = TaskState::Completed;
+            xSemaphoreGive(m_lock);
+            break;
+        }
+        xSemaphoreGive(m_lock);
+
+        for (auto& continuation : continuations) {
+            continuation(*this);
+        }
+    }
+    xEventGroupSetBits(m_doneEvent, DoneBit);
+}
+
 Task::TaskState Task::convertFreeRTOSState(eTaskState freeRTOSState) const {
     switch (freeRTOSState) {
         case eRunning:
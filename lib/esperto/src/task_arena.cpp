@@ -0,0 +1,217 @@
+// task_arena.cpp
+// Implementation of TaskArena class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/task_arena.hpp"
+#include "../headers/task.hpp"
+#include <algorithm>
+#include <new>
+extern "C" {
+#include "esp_heap_caps.h"
+}
+
+namespace esperto {
+
+// Room for the shared_ptr control block that std::allocate_shared places in front of the Task
+static constexpr size_t ObjectBlockOverhead = 32;
+static constexpr esperto::uint32 ArenaCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+
+static size_t maskWords(esperto::uint32 count) {
+    return (count + 31) / 32;
+}
+
+TaskArena::TaskArena()
+    : m_lock(portMUX_INITIALIZER_UNLOCKED), m_classCount(0), m_totalBytes(0), m_failedAllocations(0),
+      m_objectFallbacks(0), m_configured(false), m_objects(nullptr), m_objectUsedMask(nullptr),
+      m_objectCount(0), m_objectBlockSize(0) {}
+
+TaskArena::~TaskArena() {
+    releaseStorage();
+}
+
+bool TaskArena::configure(const std::vector<SizeClass>& classes) {
+    if (m_configured || classes.empty() || classes.size() > MaxSizeClasses) {
+        return false;
+    }
+
+    std::vector<SizeClass> sorted(classes);
+    std::sort(sorted.begin(), sorted.end(),
+        [](const SizeClass& a, const SizeClass& b) { return a.stackSize < b.stackSize; });
+
+    esperto::uint32 totalSlots = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        ClassStorage& storage = m_classes[i];
+        storage.stackSize = sorted[i].stackSize;
+        storage.count = sorted[i].count;
+        storage.tcbs = static_cast<StaticTask_t*>(heap_caps_calloc(storage.count, sizeof(StaticTask_t), ArenaCaps));
+        storage.stacks = static_cast<StackType_t*>(
+            heap_caps_calloc(static_cast<size_t>(storage.count) * storage.stackSize, sizeof(StackType_t), ArenaCaps));
+        storage.infos = static_cast<SlotInfo*>(heap_caps_calloc(storage.count, sizeof(SlotInfo), ArenaCaps));
+        storage.usedMask = static_cast<esperto::uint32*>(
+            heap_caps_calloc(maskWords(storage.count), sizeof(esperto::uint32), ArenaCaps));
+        ++m_classCount;
+
+        if (!storage.tcbs || !storage.stacks || !storage.infos || !storage.usedMask) {
+            releaseStorage();
+            return false;
+        }
+        for (esperto::uint32 slot = 0; slot < storage.count; ++slot) {
+            storage.infos[slot] = SlotInfo{this, static_cast<esperto::uint16>(i), static_cast<esperto::uint16>(slot)};
+        }
+
+        m_totalBytes += storage.count * (sizeof(StaticTask_t) + storage.stackSize * sizeof(StackType_t));
+        totalSlots += storage.count;
+    }
+
+    m_objectCount = totalSlots;
+    m_objectBlockSize = (sizeof(Task) + ObjectBlockOverhead + alignof(std::max_align_t) - 1)
+                        & ~(alignof(std::max_align_t) - 1);
+    m_objects = static_cast<esperto::uint8*>(
+        heap_caps_aligned_alloc(alignof(std::max_align_t), m_objectCount * m_objectBlockSize, ArenaCaps));
+    m_objectUsedMask = static_cast<esperto::uint32*>(
+        heap_caps_calloc(maskWords(m_objectCount), sizeof(esperto::uint32), ArenaCaps));
+    if (!m_objects || !m_objectUsedMask) {
+        releaseStorage();
+        return false;
+    }
+    m_totalBytes += m_objectCount * m_objectBlockSize;
+
+    m_configured = true;
+    return true;
+}
+
+bool TaskArena::isConfigured() const {
+    return m_configured;
+}
+
+bool TaskArena::acquire(esperto::uint32 stackSize, Slot& slot) {
+    if (!m_configured) {
+        return false;
+    }
+
+    bool found = false;
+    portENTER_CRITICAL(&m_lock);
+    for (size_t i = 0; i < m_classCount && !found; ++i) {
+        ClassStorage& storage = m_classes[i];
+        esperto::uint32 index;
+        if (storage.stackSize < stackSize || !takeFreeBit(storage.usedMask, storage.count, index)) {
+            continue;
+        }
+        slot.tcb = &storage.tcbs[index];
+        slot.stack = &storage.stacks[static_cast<size_t>(index) * storage.stackSize];
+        slot.stackSize = storage.stackSize;
+        slot.cookie = &storage.infos[index];
+        storage.inUse++;
+        storage.highWater = std::max(storage.highWater, storage.inUse);
+        found = true;
+    }
+    if (!found) {
+        m_failedAllocations++;
+    }
+    portEXIT_CRITICAL(&m_lock);
+    return found;
+}
+
+void TaskArena::release(void* cookie) {
+    SlotInfo* info = static_cast<SlotInfo*>(cookie);
+    if (!info || info->arena != this) {
+        return;
+    }
+
+    portENTER_CRITICAL(&m_lock);
+    ClassStorage& storage = m_classes[info->classIndex];
+    storage.usedMask[info->index / 32] &= ~(1u << (info->index % 32));
+    storage.inUse--;
+    portEXIT_CRITICAL(&m_lock);
+}
+
+void TaskArena::onTaskDeleted(int index, void* cookie) {
+    SlotInfo* info = static_cast<SlotInfo*>(cookie);
+    if (index == TlsIndex && info) {
+        info->arena->release(cookie);
+    }
+}
+
+void* TaskArena::allocateObject(size_t size) {
+    if (m_configured && size <= m_objectBlockSize) {
+        esperto::uint32 index;
+        portENTER_CRITICAL(&m_lock);
+        bool found = takeFreeBit(m_objectUsedMask, m_objectCount, index);
+        portEXIT_CRITICAL(&m_lock);
+        if (found) {
+            return m_objects + static_cast<size_t>(index) * m_objectBlockSize;
+        }
+    }
+
+    portENTER_CRITICAL(&m_lock);
+    m_objectFallbacks++;
+    portEXIT_CRITICAL(&m_lock);
+    return ::operator new(size);
+}
+
+void TaskArena::deallocateObject(void* pointer) {
+    esperto::uint8* block = static_cast<esperto::uint8*>(pointer);
+    if (m_objects && block >= m_objects && block < m_objects + m_objectCount * m_objectBlockSize) {
+        size_t index = static_cast<size_t>(block - m_objects) / m_objectBlockSize;
+        portENTER_CRITICAL(&m_lock);
+        m_objectUsedMask[index / 32] &= ~(1u << (index % 32));
+        portEXIT_CRITICAL(&m_lock);
+        return;
+    }
+    ::operator delete(pointer);
+}
+
+TaskArena::Statistics TaskArena::getStatistics() const {
+    Statistics stats;
+    portENTER_CRITICAL(&m_lock);
+    stats.classCount = m_classCount;
+    for (size_t i = 0; i < m_classCount; ++i) {
+        stats.classes[i].stackSize = m_classes[i].stackSize;
+        stats.classes[i].capacity = m_classes[i].count;
+        stats.classes[i].inUse = m_classes[i].inUse;
+        stats.classes[i].highWater = m_classes[i].highWater;
+    }
+    stats.totalBytes = m_totalBytes;
+    stats.failedAllocations = m_failedAllocations;
+    stats.objectFallbacks = m_objectFallbacks;
+    portEXIT_CRITICAL(&m_lock);
+    return stats;
+}
+
+void TaskArena::releaseStorage() {
+    for (size_t i = 0; i < m_classCount; ++i) {
+        heap_caps_free(m_classes[i].tcbs);
+        heap_caps_free(m_classes[i].stacks);
+        heap_caps_free(m_classes[i].infos);
+        heap_caps_free(m_classes[i].usedMask);
+        m_classes[i] = ClassStorage();
+    }
+    heap_caps_free(m_objects);
+    heap_caps_free(m_objectUsedMask);
+    m_classCount = 0;
+    m_totalBytes = 0;
+    m_objects = nullptr;
+    m_objectUsedMask = nullptr;
+    m_objectCount = 0;
+}
+
+bool TaskArena::takeFreeBit(esperto::uint32* mask, esperto::uint32 count, esperto::uint32& index) {
+    for (size_t word = 0; word < maskWords(count); ++word) {
+        esperto::uint32 free = ~mask[word];
+        if (!free) {
+            continue;
+        }
+        esperto::uint32 bit = static_cast<esperto::uint32>(__builtin_ctz(free));
+        esperto::uint32 candidate = static_cast<esperto::uint32>(word * 32 + bit);
+        if (candidate >= count) {
+            return false;
+        }
+        mask[word] |= 1u << bit;
+        index = candidate;
+        return true;
+    }
+    return false;
+}
+
+} // namespace esperto
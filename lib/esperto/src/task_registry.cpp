@@ -0,0 +1,157 @@
+// task_registry.cpp
+// Implementation of TaskRegistry class
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/task_registry.hpp"
+#include "../headers/task.hpp"
+
+namespace esperto {
+
+TaskRegistry::TaskRegistry(size_t capacity)
+    : m_slots(std::make_unique<Slot[]>(capacity)), m_capacity(capacity), m_epoch(0), m_count(0) {
+    m_readers[0] = 0;
+    m_readers[1] = 0;
+}
+
+bool TaskRegistry::setCapacity(size_t capacity) {
+    if (capacity == 0 || m_count.load() != 0) {
+        return false;
+    }
+    // Retired slots still own a task until their grace period ends
+    for (size_t i = 0; i < m_capacity; ++i) {
+        if (m_slots[i].state.load() != Free) {
+            return false;
+        }
+    }
+    m_slots = std::make_unique<Slot[]>(capacity);
+    m_capacity = capacity;
+    return true;
+}
+
+bool TaskRegistry::insert(const std::shared_ptr<Task>& task) {
+    if (!task) {
+        return false;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            Slot& slot = m_slots[i];
+            esperto::uint32 expected = Free;
+            if (!slot.state.compare_exchange_strong(expected, Claimed)) {
+                continue;
+            }
+            slot.owner = task;
+            slot.task.store(task.get(), std::memory_order_release);
+            slot.state.store(Live, std::memory_order_release);
+            m_count.fetch_add(1);
+            return true;
+        }
+        // Full: recycle retired slots whose grace period is over, then try once more
+        reclaim();
+    }
+    return false;
+}
+
+bool TaskRegistry::remove(const std::shared_ptr<Task>& task) {
+    if (!task) {
+        return false;
+    }
+
+    bool removed = false;
+    for (size_t i = 0; i < m_capacity && !removed; ++i) {
+        if (m_slots[i].task.load(std::memory_order_acquire) == task.get()) {
+            removed = retire(i, task.get());
+        }
+    }
+    reclaim();
+    return removed;
+}
+
+TaskRegistry::Snapshot TaskRegistry::snapshot() const {
+    return Snapshot(*this);
+}
+
+std::vector<std::shared_ptr<Task>> TaskRegistry::toVector() const {
+    std::vector<std::shared_ptr<Task>> tasks;
+    tasks.reserve(m_count.load());
+    Snapshot guard(*this);
+    for (size_t i = 0; i < m_capacity; ++i) {
+        // The owner of a Live slot only changes after a grace period, which this snapshot holds off
+        if (m_slots[i].state.load(std::memory_order_acquire) == Live) {
+            tasks.push_back(m_slots[i].owner);
+        }
+    }
+    return tasks;
+}
+
+size_t TaskRegistry::size() const {
+    return m_count.load();
+}
+
+size_t TaskRegistry::capacity() const {
+    return m_capacity;
+}
+
+void TaskRegistry::reclaim() {
+    // A slot retired at epoch r is unreachable once the epoch reaches r + 2: each flip
+    // waits for the readers of the epoch before the current one to drain.
+    tryAdvanceEpoch();
+    tryAdvanceEpoch();
+
+    esperto::uint32 epoch = m_epoch.load();
+    for (size_t i = 0; i < m_capacity; ++i) {
+        Slot& slot = m_slots[i];
+        if (slot.state.load(std::memory_order_acquire) != Retired ||
+            static_cast<esperto::int32>(epoch - slot.retireEpoch) < 2) {
+            continue;
+        }
+        esperto::uint32 expected = Retired;
+        if (slot.state.compare_exchange_strong(expected, Reclaiming)) {
+            slot.owner.reset();
+            slot.state.store(Free, std::memory_order_release);
+        }
+    }
+}
+
+esperto::uint32 TaskRegistry::enterRead() const {
+    for (;;) {
+        esperto::uint32 epoch = m_epoch.load();
+        m_readers[epoch & 1].fetch_add(1);
+        if (m_epoch.load() == epoch) {
+            return epoch;
+        }
+        // The epoch flipped before we were counted: retry in the new one
+        m_readers[epoch & 1].fetch_sub(1);
+    }
+}
+
+void TaskRegistry::exitRead(esperto::uint32 epoch) const {
+    m_readers[epoch & 1].fetch_sub(1);
+}
+
+bool TaskRegistry::retire(size_t index, Task* expected) {
+    Slot& slot = m_slots[index];
+    esperto::uint32 state = Live;
+    if (!slot.state.compare_exchange_strong(state, Removing)) {
+        return false;
+    }
+    if (slot.task.load() != expected) {
+        slot.state.store(Live);
+        return false;
+    }
+    slot.task.store(nullptr);
+    slot.retireEpoch = m_epoch.load();
+    slot.state.store(Retired, std::memory_order_release);
+    m_count.fetch_sub(1);
+    return true;
+}
+
+void TaskRegistry::tryAdvanceEpoch() {
+    esperto::uint32 epoch = m_epoch.load();
+    if (m_readers[(epoch + 1) & 1].load() == 0) {
+        m_epoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+}
+
+} // namespace esperto
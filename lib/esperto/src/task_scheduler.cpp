@@ -6,41 +6,297 @@
 #include "../headers/task_scheduler.hpp"
 #include <algorithm>
 #include <cstdio>
+#include <utility>
+
+extern "C" {
+#include "esp_log.h"
+}
 
 namespace esperto {
 
+static const char* TAG = "TaskScheduler";
+
 TaskScheduler& TaskScheduler::instance() {
     static TaskScheduler scheduler;
     return scheduler;
 }
 
-std::shared_ptr<Task> TaskScheduler::startNew(Task::TaskFunction func, const esperto::string& name, esperto::uint32 stackSize, UBaseType_t priority) {
+std::shared_ptr<Task> TaskScheduler::startNew(Task::TaskFunction func, const esperto::string& name, esperto::uint32 stackSize, UBaseType_t priority, BaseType_t core) {
     auto task = std::make_shared<Task>(func, name, stackSize, priority);
+    // Registered before it runs: an untracked task would be invisible to waitForAll
+    if (!registerTask(task)) {
+        ESP_LOGE(TAG, "Registry full, task %s not started", name.c_str());
+        return nullptr;
+    }
+    bool automatic = place(*task, core);
+    task->start();
+    if (automatic) {
+        m_balancer.load()->track(task);
+    }
+    return task;
+}
+
+bool TaskScheduler::configureRegistry(size_t capacity) {
+    return m_tasks.setCapacity(capacity);
+}
+
+bool TaskScheduler::configureArena(const std::vector<TaskArena::SizeClass>& classes) {
+    return m_arena.configure(classes);
+}
+
+std::shared_ptr<Task> TaskScheduler::startNewStatic(Task::TaskFunction func, const esperto::string& name, esperto::uint32 stackSize, UBaseType_t priority, BaseType_t core) {
+    if (!m_arena.isConfigured()) {
+        return nullptr;
+    }
+    auto task = std::allocate_shared<Task>(TaskArenaAllocator<Task>(m_arena), std::move(func), name, stackSize, priority);
+    if (!task->useArena(m_arena)) {
+        return nullptr;
+    }
+    if (!registerTask(task)) {
+        ESP_LOGE(TAG, "Registry full, task %s not started", name.c_str());
+        return nullptr;
+    }
+    bool automatic = place(*task, core);
     task->start();
-    m_tasks.push_back(task);
+    if (automatic) {
+        m_balancer.load()->track(task);
+    }
     return task;
 }
 
+TaskArena::Statistics TaskScheduler::getArenaStatistics() const {
+    return m_arena.getStatistics();
+}
+
+bool TaskScheduler::configureRealtime(const RealtimePolicy::Config& config) {
+    return m_realtime.configure(config);
+}
+
+std::shared_ptr<Task> TaskScheduler::startPeriodic(RealtimePolicy::Job job, const RealtimePolicy::Parameters& parameters, const esperto::string& name, esperto::uint32 stackSize) {
+    auto task = m_realtime.startPeriodic(std::move(job), parameters, name, stackSize);
+    if (task && !registerTask(task)) {
+        // The policy starts the task itself; stop it again and give back its share of the core
+        ESP_LOGE(TAG, "Registry full, periodic task %s stopped", name.c_str());
+        m_realtime.stop(task);
+        return nullptr;
+    }
+    return task;
+}
+
+bool TaskScheduler::stopPeriodic(const std::shared_ptr<Task>& task) {
+    return m_realtime.stop(task);
+}
+
+void TaskScheduler::setDeadlineMissHandler(RealtimePolicy::MissHandler handler) {
+    m_realtime.setMissHandler(std::move(handler));
+}
+
+RealtimePolicy::Statistics TaskScheduler::getRealtimeStatistics() const {
+    return m_realtime.getStatistics();
+}
+
+bool TaskScheduler::enableBalancing(const CoreBalancer::Config& config) {
+    if (m_balancer.load()) {
+        return true;
+    }
+
+    // Sampling is cheap and never blocks for long, so it runs as a timer callback. The
+    // periodic timer owns the balancer, which is published only once sampling is scheduled
+    auto balancer = std::make_shared<CoreBalancer>(config);
+    esperto::uint32 interval = std::max<esperto::uint32>(config.sampleIntervalMs, 1);
+    TimerService::TimerId id = schedulePeriodic(interval, [balancer]() {
+        balancer->sample();
+    }, interval / 10);
+    if (id == TimerService::InvalidTimer) {
+        ESP_LOGW(TAG, "No timer for load sampling, balancing not enabled");
+        return false;
+    }
+    balancer->sample();
+
+    // Another task may have enabled balancing concurrently; keep the first one
+    CoreBalancer* expected = nullptr;
+    if (!m_balancer.compare_exchange_strong(expected, balancer.get())) {
+        cancelTimer(id);
+    }
+    return true;
+}
+
+CoreBalancer::Statistics TaskScheduler::getBalancingStatistics() const {
+    CoreBalancer* balancer = m_balancer.load();
+    return balancer ? balancer->getStatistics() : CoreBalancer::Statistics();
+}
+
+bool TaskScheduler::enablePool(const WorkerPool::Config& config) {
+    if (m_pool.load()) {
+        return true;
+    }
+
+    auto pool = std::make_unique<WorkerPool>(config);
+    if (!pool->start()) {
+        return false;
+    }
+
+    // Another task may have enabled the pool concurrently; keep the first one
+    WorkerPool* expected = nullptr;
+    if (m_pool.compare_exchange_strong(expected, pool.get())) {
+        pool.release();
+    }
+    return true;
+}
+
+void TaskScheduler::disablePool() {
+    std::unique_ptr<WorkerPool> pool(m_pool.exchange(nullptr));
+    if (pool) {
+        pool->stop();
+    }
+}
+
+bool TaskScheduler::isPoolEnabled() const {
+    return m_pool.load() != nullptr;
+}
+
+bool TaskScheduler::run(WorkerPool::WorkFunction func) {
+    WorkerPool* pool = m_pool.load();
+    if (!pool) {
+        if (!enablePool()) {
+            return false;
+        }
+        pool = m_pool.load();
+    }
+    return pool->submit(std::move(func));
+}
+
+WorkerPool::Statistics TaskScheduler::getPoolStatistics() const {
+    WorkerPool* pool = m_pool.load();
+    return pool ? pool->getStatistics() : WorkerPool::Statistics();
+}
+
+bool TaskScheduler::enableCoroutines(const CoroutineLoop::Config& config) {
+    if (m_coroutines.load()) {
+        return true;
+    }
+
+    auto loop = std::make_unique<CoroutineLoop>(config);
+    if (!loop->start()) {
+        return false;
+    }
+
+    CoroutineLoop* expected = nullptr;
+    if (m_coroutines.compare_exchange_strong(expected, loop.get())) {
+        loop.release();
+    }
+    return true;
+}
+
+bool TaskScheduler::spawn(CoTask task) {
+    if (!m_coroutines.load() && !enableCoroutines()) {
+        return false;
+    }
+    return m_coroutines.load()->spawn(std::move(task));
+}
+
+CoroutineLoop::Statistics TaskScheduler::getCoroutineStatistics() const {
+    CoroutineLoop* loop = m_coroutines.load();
+    return loop ? loop->getStatistics() : CoroutineLoop::Statistics();
+}
+
+bool TaskScheduler::enableTimers(const TimerService::Config& config) {
+    if (m_timers.load()) {
+        return true;
+    }
+
+    auto service = std::make_unique<TimerService>(config);
+    if (!service->start()) {
+        return false;
+    }
+
+    TimerService* expected = nullptr;
+    if (m_timers.compare_exchange_strong(expected, service.get())) {
+        service.release();
+    }
+    return true;
+}
+
+TimerService::TimerId TaskScheduler::scheduleAfter(esperto::uint32 delayMs, TimerService::TimerCallback callback, esperto::uint32 slackMs) {
+    TimerService* service = timers();
+    return service ? service->scheduleAfter(delayMs, std::move(callback), slackMs) : TimerService::InvalidTimer;
+}
+
+TimerService::TimerId TaskScheduler::scheduleAt(TickType_t deadline, TimerService::TimerCallback callback, esperto::uint32 slackMs) {
+    TimerService* service = timers();
+    return service ? service->scheduleAt(deadline, std::move(callback), slackMs) : TimerService::InvalidTimer;
+}
+
+TimerService::TimerId TaskScheduler::schedulePeriodic(esperto::uint32 periodMs, TimerService::TimerCallback callback, esperto::uint32 slackMs) {
+    TimerService* service = timers();
+    return service ? service->schedulePeriodic(periodMs, std::move(callback), slackMs) : TimerService::InvalidTimer;
+}
+
+bool TaskScheduler::cancelTimer(TimerService::TimerId id) {
+    TimerService* service = m_timers.load();
+    return service && service->cancel(id);
+}
+
+TimerService::Statistics TaskScheduler::getTimerStatistics() const {
+    TimerService* service = m_timers.load();
+    return service ? service->getStatistics() : TimerService::Statistics();
+}
+
+TimerService* TaskScheduler::timers() {
+    if (!m_timers.load() && !enableTimers()) {
+        return nullptr;
+    }
+    return m_timers.load();
+}
+
+bool TaskScheduler::place(Task& task, BaseType_t core) {
+    if (core != CoreBalancer::AutoCore) {
+        if (core != tskNO_AFFINITY && !task.setCoreAffinity(core)) {
+            ESP_LOGW(TAG, "Invalid core %ld for task %s", static_cast<long>(core), task.getName().c_str());
+        }
+        return false;
+    }
+    if (!enableBalancing()) {
+        // No balancer without load sampling: FreeRTOS picks the core
+        return false;
+    }
+    task.setCoreAffinity(m_balancer.load()->pickCore());
+    return true;
+}
+
+bool TaskScheduler::registerTask(const std::shared_ptr<Task>& task) {
+    if (m_tasks.insert(task)) {
+        return true;
+    }
+    // Completed tasks stay registered until someone cleans up: make room before refusing
+    cleanupCompletedTasks();
+    return m_tasks.insert(task);
+}
+
 std::vector<std::shared_ptr<Task>> TaskScheduler::getTasks() const {
-    return m_tasks;
+    return m_tasks.toVector();
+}
+
+TaskRegistry::Snapshot TaskScheduler::snapshot() const {
+    return m_tasks.snapshot();
 }
 
 void TaskScheduler::remove(const std::shared_ptr<Task>& task) {
-    m_tasks.erase(std::remove(m_tasks.begin(), m_tasks.end(), task), m_tasks.end());
+    m_tasks.remove(task);
 }
 
 void TaskScheduler::suspendAll() {
-    for (auto& task : m_tasks) {
-        if (task && task->isRunning()) {
-            task->suspend();
+    for (Task& task : m_tasks.snapshot()) {
+        if (task.isRunning()) {
+            task.suspend();
         }
     }
 }
 
 void TaskScheduler::resumeAll() {
-    for (auto& task : m_tasks) {
-        if (task && task->getState() == Task::TaskState::Suspended) {
-            task->resume();
+    for (Task& task : m_tasks.snapshot()) {
+        if (task.getState() == Task::TaskState::Suspended) {
+            task.resume();
         }
     }
 }
@@ -50,49 +306,277 @@ size_t TaskScheduler::getTaskCount() const {
 }
 
 void TaskScheduler::cleanupCompletedTasks() {
-    m_tasks.erase(
-        std::remove_if(m_tasks.begin(), m_tasks.end(), 
-            [](const std::shared_ptr<Task>& task) {
-                return task && task->isCompleted();
-            }), 
-        m_tasks.end()
-    );
+    m_tasks.removeIf([](Task& task) {
+        return task.isCompleted();
+    });
 }
 
 void TaskScheduler::waitForAll() {
-    for (auto& task : m_tasks) {
+    // Wait on owning copies: a long-lived snapshot would hold back slot reclamation
+    for (auto& task : m_tasks.toVector()) {
         if (task && !task->isCompleted()) {
             task->wait();
         }
     }
 }
 
+SchedulerStatistics TaskScheduler::getStatistics() const {
+    SchedulerStatistics stats;
+
+    struct ManagedSample {
+        TaskHandle_t handle;
+        esperto::uint32 voluntarySwitches;
+        LatencyHistogram latency;
+    };
+    std::vector<ManagedSample> managed;
+    managed.reserve(m_tasks.size());
+
+    for (const Task& task : m_tasks.snapshot()) {
+        stats.taskCount++;
+        switch (task.getState()) {
+            case Task::TaskState::Running:
+                stats.running++;
+                break;
+            case Task::TaskState::Suspended:
+                stats.suspended++;
+                break;
+            case Task::TaskState::Completed:
+            case Task::TaskState::Deleted:
+                stats.completed++;
+                break;
+            default:
+                break;
+        }
+        LatencyHistogram latency = task.getLatency();
+        stats.latency.merge(latency);
+        if (task.getHandle() && !task.isCompleted()) {
+            managed.push_back({task.getHandle(), task.getVoluntarySwitches(), latency});
+        }
+    }
+
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+    // Room for tasks created between the count and the snapshot
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    std::vector<TaskStatus_t> status(capacity);
+    configRUN_TIME_COUNTER_TYPE totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(status.data(), capacity, &totalRunTime);
+
+    std::vector<RunTimeSample> sample;
+    sample.reserve(count);
+    for (UBaseType_t i = 0; i < count; ++i) {
+        sample.push_back({status[i].xHandle, static_cast<esperto::uint64>(status[i].ulRunTimeCounter)});
+    }
+
+    // Swap in the new baseline; sample now holds the previous one
+    portENTER_CRITICAL(&m_sampleLock);
+    m_lastSample.swap(sample);
+    esperto::uint64 previousUs = m_lastSampleUs;
+    m_lastSampleUs = totalRunTime;
+    portEXIT_CRITICAL(&m_sampleLock);
+
+    stats.profilingAvailable = true;
+    stats.uptimeUs = totalRunTime;
+    stats.intervalUs = totalRunTime - previousUs;
+    // The run-time clock is wall time: both cores together provide twice as much CPU time
+    esperto::uint64 capacityUs = stats.intervalUs * portNUM_PROCESSORS;
+
+    stats.tasks.reserve(count);
+    for (UBaseType_t i = 0; i < count; ++i) {
+        TaskProfile profile;
+        profile.name = status[i].pcTaskName;
+        profile.handle = status[i].xHandle;
+        profile.state = status[i].eCurrentState;
+        profile.priority = status[i].uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID == 1
+        profile.core = status[i].xCoreID < portNUM_PROCESSORS ? static_cast<esperto::int32>(status[i].xCoreID) : -1;
+#endif
+        profile.runTimeUs = status[i].ulRunTimeCounter;
+        profile.stackHighWaterMark = status[i].usStackHighWaterMark;
+
+        esperto::uint64 previousRunTime = 0;
+        for (const RunTimeSample& previous : sample) {
+            if (previous.handle == profile.handle) {
+                previousRunTime = previous.runTimeUs;
+                break;
+            }
+        }
+        if (capacityUs > 0 && profile.runTimeUs >= previousRunTime) {
+            profile.cpuPercent = 100.0f * static_cast<float>(profile.runTimeUs - previousRunTime) / static_cast<float>(capacityUs);
+        }
+        stats.tasks.push_back(std::move(profile));
+    }
+#else
+    // Without run-time stats only the managed tasks can be profiled
+    for (const ManagedSample& task : managed) {
+        TaskProfile profile;
+        profile.name = pcTaskGetName(task.handle);
+        profile.handle = task.handle;
+        profile.state = eTaskGetState(task.handle);
+        profile.priority = uxTaskPriorityGet(task.handle);
+        profile.stackHighWaterMark = uxTaskGetStackHighWaterMark(task.handle);
+        stats.tasks.push_back(std::move(profile));
+    }
+#endif
+
+    for (TaskProfile& profile : stats.tasks) {
+        for (const ManagedSample& task : managed) {
+            if (task.handle == profile.handle) {
+                profile.managed = true;
+                profile.voluntarySwitches = task.voluntarySwitches;
+                profile.latency = task.latency;
+                break;
+            }
+        }
+    }
+    std::sort(stats.tasks.begin(), stats.tasks.end(), [](const TaskProfile& a, const TaskProfile& b) {
+        return a.cpuPercent > b.cpuPercent;
+    });
+
+    stats.arenaConfigured = m_arena.isConfigured();
+    if (stats.arenaConfigured) {
+        stats.arena = getArenaStatistics();
+    }
+    stats.poolEnabled = isPoolEnabled();
+    if (stats.poolEnabled) {
+        stats.pool = getPoolStatistics();
+    }
+    stats.timersEnabled = m_timers.load() != nullptr;
+    if (stats.timersEnabled) {
+        stats.timers = getTimerStatistics();
+    }
+    stats.realtime = getRealtimeStatistics();
+    stats.balancingEnabled = m_balancer.load() != nullptr;
+    if (stats.balancingEnabled) {
+        stats.balancing = getBalancingStatistics();
+    }
+    stats.coroutinesEnabled = m_coroutines.load() != nullptr;
+    if (stats.coroutinesEnabled) {
+        stats.coroutines = getCoroutineStatistics();
+    }
+    return stats;
+}
+
 void TaskScheduler::printTaskStatistics() const {
+    SchedulerStatistics stats = getStatistics();
+
     printf("TaskScheduler Statistics:\n");
-    printf("Total tasks: %zu\n", m_tasks.size());
-    
-    size_t running = 0, suspended = 0, completed = 0;
-    
-    for (const auto& task : m_tasks) {
-        if (task) {
-            switch (task->getState()) {
-                case Task::TaskState::Running:
-                    running++;
-                    break;
-                case Task::TaskState::Suspended:
-                    suspended++;
-                    break;
-                case Task::TaskState::Completed:
-                case Task::TaskState::Deleted:
-                    completed++;
-                    break;
-                default:
-                    break;
+    printf("Total tasks: %lu\n", static_cast<unsigned long>(stats.taskCount));
+    printf("Running: %lu, Suspended: %lu, Completed: %lu\n", static_cast<unsigned long>(stats.running),
+           static_cast<unsigned long>(stats.suspended), static_cast<unsigned long>(stats.completed));
+
+    if (stats.profilingAvailable) {
+        printf("CPU usage over the last %llu ms:\n", static_cast<unsigned long long>(stats.intervalUs / 1000));
+    }
+    printf("  %-16s %4s %4s %6s %10s %6s %8s %8s %8s %8s\n",
+           "Task", "Core", "Prio", "CPU%", "Time ms", "Stack", "Switches", "p50 us", "p99 us", "Max us");
+    for (const TaskProfile& task : stats.tasks) {
+        char core[8];
+        if (task.core < 0) {
+            snprintf(core, sizeof(core), "any");
+        } else {
+            snprintf(core, sizeof(core), "%ld", static_cast<long>(task.core));
+        }
+        printf("  %-16s %4s %4lu %6.1f %10llu %6lu", task.name.c_str(), core,
+               static_cast<unsigned long>(task.priority), static_cast<double>(task.cpuPercent),
+               static_cast<unsigned long long>(task.runTimeUs / 1000),
+               static_cast<unsigned long>(task.stackHighWaterMark));
+        if (task.managed) {
+            printf(" %8lu %8lu %8lu %8lu\n", static_cast<unsigned long>(task.voluntarySwitches),
+                   static_cast<unsigned long>(task.latency.percentileUs(50)),
+                   static_cast<unsigned long>(task.latency.percentileUs(99)),
+                   static_cast<unsigned long>(task.latency.maxUs));
+        } else {
+            printf(" %8s %8s %8s %8s\n", "-", "-", "-", "-");
+        }
+    }
+
+    if (stats.latency.samples > 0) {
+        printf("Wake-up latency: %lu samples, average %lu us\n", static_cast<unsigned long>(stats.latency.samples),
+               static_cast<unsigned long>(stats.latency.averageUs()));
+        for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i) {
+            if (stats.latency.buckets[i] == 0) {
+                continue;
+            }
+            if (i + 1 < LatencyHistogram::BucketCount) {
+                printf("  < %7lu us: %lu\n", static_cast<unsigned long>(LatencyHistogram::bucketLimitUs(i)),
+                       static_cast<unsigned long>(stats.latency.buckets[i]));
+            } else {
+                printf("  >= %6lu us: %lu\n", static_cast<unsigned long>(LatencyHistogram::bucketLimitUs(i - 1)),
+                       static_cast<unsigned long>(stats.latency.buckets[i]));
+            }
+        }
+    }
+
+    if (!stats.realtime.tasks.empty() || stats.realtime.rejected > 0) {
+        printf("Real-time: %lu admitted, %lu rejected", static_cast<unsigned long>(stats.realtime.admitted),
+               static_cast<unsigned long>(stats.realtime.rejected));
+        for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+            printf(", core %d %.1f%%", core, static_cast<double>(stats.realtime.utilization[core] * 100.0f));
+        }
+        printf("\n");
+        printf("  %-16s %4s %4s %8s %8s %8s %8s %8s %6s %6s\n",
+               "Task", "Core", "Prio", "T ms", "D ms", "C us", "Bound us", "Max us", "Miss", "Over");
+        for (const RealtimePolicy::TaskStatistics& task : stats.realtime.tasks) {
+            const RealtimePolicy::Parameters& parameters = task.parameters;
+            printf("  %-16s %4ld %4lu %8lu %8lu %8lu %8lu %8lu %6lu %6lu\n", task.name.c_str(),
+                   static_cast<long>(parameters.core), static_cast<unsigned long>(task.priority),
+                   static_cast<unsigned long>(parameters.periodMs),
+                   static_cast<unsigned long>(parameters.deadlineMs ? parameters.deadlineMs : parameters.periodMs),
+                   static_cast<unsigned long>(parameters.budgetUs), static_cast<unsigned long>(task.responseBoundUs),
+                   static_cast<unsigned long>(task.maxResponseUs), static_cast<unsigned long>(task.deadlineMisses),
+                   static_cast<unsigned long>(task.budgetOverruns));
+        }
+    }
+
+    if (stats.balancingEnabled) {
+        const CoreBalancer::Statistics& balancing = stats.balancing;
+        printf("Cores:");
+        for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+            if (balancing.loadAvailable) {
+                printf(" %d %.1f%% busy (%lu placed),", core, static_cast<double>(balancing.load[core]),
+                       static_cast<unsigned long>(balancing.placed[core]));
+            } else {
+                printf(" %d %lu placed,", core, static_cast<unsigned long>(balancing.placed[core]));
             }
         }
+        printf(" Tracked: %lu, Migrations: %lu%s\n", static_cast<unsigned long>(balancing.tracked),
+               static_cast<unsigned long>(balancing.migrations), balancing.rebalanceSupported ? "" : " (placement only)");
+    }
+
+    if (stats.arenaConfigured) {
+        const TaskArena::Statistics& arena = stats.arena;
+        printf("Arena: %zu bytes, Failed allocations: %lu\n", arena.totalBytes,
+               static_cast<unsigned long>(arena.failedAllocations));
+        for (size_t i = 0; i < arena.classCount; ++i) {
+            printf("  Stack %lu: %lu/%lu in use (peak %lu)\n",
+                   static_cast<unsigned long>(arena.classes[i].stackSize),
+                   static_cast<unsigned long>(arena.classes[i].inUse),
+                   static_cast<unsigned long>(arena.classes[i].capacity),
+                   static_cast<unsigned long>(arena.classes[i].highWater));
+        }
+    }
+
+    if (stats.poolEnabled) {
+        const WorkerPool::Statistics& pool = stats.pool;
+        printf("Pool workers: %lu, Pending: %lu, Executed: %llu, Stolen: %llu, Rejected: %llu\n",
+               static_cast<unsigned long>(pool.workers), static_cast<unsigned long>(pool.pending),
+               static_cast<unsigned long long>(pool.executed), static_cast<unsigned long long>(pool.stolen),
+               static_cast<unsigned long long>(pool.rejected));
+    }
+
+    if (stats.timersEnabled) {
+        const TimerService::Statistics& timers = stats.timers;
+        printf("Timers: %lu/%lu active, Fired: %llu, Wake-ups: %llu, Rejected: %lu, Max lateness: %lu ms\n",
+               static_cast<unsigned long>(timers.active), static_cast<unsigned long>(timers.capacity),
+               static_cast<unsigned long long>(timers.fired), static_cast<unsigned long long>(timers.wakeups),
+               static_cast<unsigned long>(timers.rejected), static_cast<unsigned long>(timers.maxLatenessMs));
+    }
+
+    if (stats.coroutinesEnabled) {
+        printf("Coroutines: %lu live, Spawned: %llu, Resumed: %llu\n", static_cast<unsigned long>(stats.coroutines.live),
+               static_cast<unsigned long long>(stats.coroutines.spawned),
+               static_cast<unsigned long long>(stats.coroutines.resumed));
     }
-    
-    printf("Running: %zu, Suspended: %zu, Completed: %zu\n", running, suspended, completed);
 }
 
 bool TaskScheduler::equals(const Object& other) const {
@@ -0,0 +1,71 @@
+// task_statistics.cpp
+// Implementation of the task profiling helpers
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/task_statistics.hpp"
+#include <algorithm>
+
+namespace esperto {
+
+size_t LatencyHistogram::bucketFor(esperto::uint32 latencyUs) {
+    if (latencyUs == 0) {
+        return 0;
+    }
+    size_t index = 32 - static_cast<size_t>(__builtin_clz(latencyUs));
+    return std::min(index, BucketCount - 1);
+}
+
+esperto::uint32 LatencyHistogram::bucketLimitUs(size_t index) {
+    return 1u << std::min(index, BucketCount - 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BucketCount; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    samples += other.samples;
+    maxUs = std::max(maxUs, other.maxUs);
+    totalUs += other.totalUs;
+}
+
+esperto::uint32 LatencyHistogram::averageUs() const {
+    return samples ? static_cast<esperto::uint32>(totalUs / samples) : 0;
+}
+
+esperto::uint32 LatencyHistogram::percentileUs(esperto::uint32 percent) const {
+    if (samples == 0) {
+        return 0;
+    }
+    esperto::uint64 target = (static_cast<esperto::uint64>(samples) * std::min<esperto::uint32>(percent, 100) + 99) / 100;
+    esperto::uint64 seen = 0;
+    for (size_t i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= target && seen > 0) {
+            return std::min(bucketLimitUs(i), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+void LatencyRecorder::record(esperto::uint32 latencyUs) {
+    m_buckets[LatencyHistogram::bucketFor(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+    m_samples.fetch_add(1, std::memory_order_relaxed);
+    m_totalUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    esperto::uint32 max = m_maxUs.load(std::memory_order_relaxed);
+    while (latencyUs > max && !m_maxUs.compare_exchange_weak(max, latencyUs, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram LatencyRecorder::snapshot() const {
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i) {
+        histogram.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    histogram.samples = m_samples.load(std::memory_order_relaxed);
+    histogram.maxUs = m_maxUs.load(std::memory_order_relaxed);
+    histogram.totalUs = m_totalUs.load(std::memory_order_relaxed);
+    return histogram;
+}
+
+} // namespace esperto
@@ -0,0 +1,361 @@
+// tcp_connection.cpp
+// Implementation of TcpConnection class for ESP32 lwIP
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/tcp_connection.hpp"
+#include <algorithm>
+
+extern "C" {
+#include "esp_log.h"
+#include "freertos/task.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "TcpConnection";
+
+// Ticks left before a deadline measured from `start`, 0 once it has passed
+static TickType_t ticksLeft(TickType_t start, TickType_t timeout) {
+    if (timeout == portMAX_DELAY) {
+        return portMAX_DELAY;
+    }
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    return elapsed < timeout ? timeout - elapsed : 0;
+}
+
+TcpConnection::TcpConnection() : TcpConnection(Config()) {}
+
+TcpConnection::TcpConnection(const Config& config)
+    : m_config(config), m_pcb(nullptr), m_state(State::Closed), m_peerClosed(false), m_endOfStream(false),
+      m_queue(nullptr), m_queuedBytes(0), m_ackedBytes(0), m_windowPending(0), m_refusedChains(0) {
+    m_signal = xSemaphoreCreateBinaryStatic(&m_signalBuffer);
+}
+
+TcpConnection::~TcpConnection() {
+    close();
+    if (m_queue) {
+        vQueueDelete(m_queue);
+    }
+}
+
+bool TcpConnection::equals(const Object& other) const {
+    auto* o = static_cast<const TcpConnection*>(&other);
+    return o && o->m_pcb == m_pcb;
+}
+
+bool TcpConnection::connect(const NetEndpoint& remote, esperto::uint32 timeoutMs) {
+    if (m_state.load() != State::Closed) {
+        return false;
+    }
+    if (!m_queue) {
+        // One extra slot for the end-of-stream marker
+        m_queue = xQueueCreate(m_config.receiveQueueLength + 1, sizeof(struct pbuf*));
+        if (!m_queue) {
+            ESP_LOGE(TAG, "Out of memory for the receive queue");
+            return false;
+        }
+    }
+
+    xSemaphoreTake(m_signal, 0);
+    m_peerClosed = false;
+    m_endOfStream = false;
+    m_queuedBytes = 0;
+    m_ackedBytes = 0;
+    m_windowPending = 0;
+    m_stats = Statistics();
+    m_refusedChains = 0;
+    m_state = State::Connecting;
+
+    err_t result = tcpipCall([this, &remote]() -> err_t {
+        struct tcp_pcb* pcb = tcp_new_ip_type(IPADDR_TYPE_V4);
+        if (!pcb) {
+            return ERR_MEM;
+        }
+        tcp_arg(pcb, this);
+        tcp_recv(pcb, receiveCallback);
+        tcp_sent(pcb, sentCallback);
+        tcp_err(pcb, errorCallback);
+        if (m_config.noDelay) {
+            tcp_nagle_disable(pcb);
+        }
+
+        ip_addr_t address;
+        ip_addr_set_ip4_u32(&address, remote.address);
+        err_t connected = tcp_connect(pcb, &address, remote.port, connectedCallback);
+        if (connected != ERR_OK) {
+            tcp_arg(pcb, nullptr);
+            tcp_err(pcb, nullptr);
+            tcp_abort(pcb);
+            return connected;
+        }
+        m_pcb = pcb;
+        return ERR_OK;
+    });
+    if (result != ERR_OK) {
+        ESP_LOGE(TAG, "Cannot connect (err %d)", result);
+        m_state = State::Closed;
+        return false;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = detail::timeoutToTicks(timeoutMs);
+    while (m_state.load() == State::Connecting) {
+        TickType_t wait = ticksLeft(start, timeout);
+        if (wait == 0 || xSemaphoreTake(m_signal, wait) != pdTRUE) {
+            break;
+        }
+    }
+
+    if (m_state.load() != State::Connected) {
+        ESP_LOGW(TAG, "Connection to port %u failed", remote.port);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TcpConnection::close() {
+    if (m_state.load() == State::Connected) {
+        // Payload memory must not be released while lwIP may still retransmit it
+        TickType_t start = xTaskGetTickCount();
+        TickType_t timeout = pdMS_TO_TICKS(m_config.closeTimeoutMs);
+        for (;;) {
+            err_t pending = tcpipCall([this]() -> err_t {
+                if (!m_pcb || m_inFlight.empty()) {
+                    return ERR_OK;
+                }
+                tcp_output(m_pcb);
+                return ERR_INPROGRESS;
+            });
+            TickType_t wait = ticksLeft(start, timeout);
+            if (pending == ERR_OK || wait == 0 || xSemaphoreTake(m_signal, wait) != pdTRUE) {
+                break;
+            }
+        }
+    }
+
+    detachPcb();
+    m_state = State::Closed;
+    if (m_queue) {
+        drainQueue();
+    }
+    m_windowPending = 0;
+}
+
+bool TcpConnection::send(const NetPayload* parts, size_t count, esperto::uint32 timeoutMs) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = detail::timeoutToTicks(timeoutMs);
+
+    for (size_t i = 0; i < count; ++i) {
+        const NetPayload& part = parts[i];
+        size_t offset = 0;
+        while (offset < part.size()) {
+            size_t written = 0;
+            bool last = i + 1 == count;
+            err_t result = tcpipCall([this, &part, offset, last, &written]() -> err_t {
+                if (!m_pcb || m_state.load() != State::Connected) {
+                    return ERR_CONN;
+                }
+                size_t space = std::min<size_t>(tcp_sndbuf(m_pcb), part.size() - offset);
+                if (space == 0 || tcp_sndqueuelen(m_pcb) >= TCP_SND_QUEUELEN) {
+                    tcp_output(m_pcb);
+                    return ERR_MEM;
+                }
+
+                bool more = offset + space < part.size() || !last;
+                // No TCP_WRITE_FLAG_COPY: lwIP references the payload until it is acknowledged
+                err_t queued = tcp_write(m_pcb, part.data() + offset, static_cast<u16_t>(space),
+                                         more ? TCP_WRITE_FLAG_MORE : 0);
+                if (queued != ERR_OK) {
+                    tcp_output(m_pcb);
+                    return queued;
+                }
+                m_queuedBytes += space;
+                m_inFlight.push_back(InFlight{part, m_queuedBytes});
+                if (!more) {
+                    tcp_output(m_pcb);
+                }
+                written = space;
+                return ERR_OK;
+            });
+
+            if (result == ERR_MEM) {
+                // Wait for an acknowledgement to free send buffer space
+                m_stats.sendStalls++;
+                TickType_t wait = ticksLeft(start, timeout);
+                if (wait == 0 || xSemaphoreTake(m_signal, wait) != pdTRUE) {
+                    return false;
+                }
+                continue;
+            }
+            if (result != ERR_OK) {
+                return false;
+            }
+            offset += written;
+            m_stats.sentBytes += written;
+        }
+    }
+    return true;
+}
+
+bool TcpConnection::send(const NetPayload& payload, esperto::uint32 timeoutMs) {
+    return send(&payload, 1, timeoutMs);
+}
+
+bool TcpConnection::receive(NetBuffer& buffer, esperto::uint32 timeoutMs) {
+    if (!m_queue || m_endOfStream) {
+        return false;
+    }
+
+    if (uxQueueMessagesWaiting(m_queue) == 0) {
+        if (m_peerClosed.load()) {
+            m_endOfStream = true;
+            return false;
+        }
+        // About to wait: let the peer send everything the application has consumed
+        updateWindow();
+    }
+
+    struct pbuf* chain = nullptr;
+    if (xQueueReceive(m_queue, &chain, detail::timeoutToTicks(timeoutMs)) != pdTRUE) {
+        return false;
+    }
+    if (!chain) {
+        m_endOfStream = true;
+        return false;
+    }
+
+    m_stats.receivedBytes += chain->tot_len;
+    m_windowPending += chain->tot_len;
+    buffer = NetBuffer(chain);
+    if (m_windowPending >= m_config.windowUpdateBytes) {
+        updateWindow();
+    }
+    return true;
+}
+
+bool TcpConnection::isConnected() const {
+    return m_state.load() == State::Connected;
+}
+
+bool TcpConnection::isPeerClosed() const {
+    return m_peerClosed.load();
+}
+
+TcpConnection::Statistics TcpConnection::getStatistics() const {
+    Statistics stats = m_stats;
+    stats.refusedChains = m_refusedChains.load();
+    esperto::uint64 acked = 0;
+    tcpipCall([this, &acked]() -> err_t {
+        acked = m_ackedBytes;
+        return ERR_OK;
+    });
+    stats.ackedBytes = acked;
+    return stats;
+}
+
+err_t TcpConnection::connectedCallback(void* arg, struct tcp_pcb* pcb, err_t err) {
+    auto* connection = static_cast<TcpConnection*>(arg);
+    connection->m_state = State::Connected;
+    xSemaphoreGive(connection->m_signal);
+    return ERR_OK;
+}
+
+err_t TcpConnection::receiveCallback(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+    auto* connection = static_cast<TcpConnection*>(arg);
+    if (!p) {
+        // The peer sent FIN; the marker wakes a waiting receive()
+        connection->m_peerClosed = true;
+        struct pbuf* marker = nullptr;
+        xQueueSend(connection->m_queue, &marker, 0);
+        return ERR_OK;
+    }
+    if (err != ERR_OK) {
+        pbuf_free(p);
+        return err;
+    }
+    if (xQueueSend(connection->m_queue, &p, 0) != pdTRUE) {
+        // lwIP keeps the chain and offers it again later
+        connection->m_refusedChains++;
+        return ERR_MEM;
+    }
+    return ERR_OK;
+}
+
+err_t TcpConnection::sentCallback(void* arg, struct tcp_pcb* pcb, u16_t length) {
+    auto* connection = static_cast<TcpConnection*>(arg);
+    connection->m_ackedBytes += length;
+    std::deque<InFlight>& inFlight = connection->m_inFlight;
+    while (!inFlight.empty() && inFlight.front().end <= connection->m_ackedBytes) {
+        inFlight.pop_front();
+    }
+    xSemaphoreGive(connection->m_signal);
+    return ERR_OK;
+}
+
+void TcpConnection::errorCallback(void* arg, err_t err) {
+    // lwIP has already freed the pcb and the segments that referenced our payloads
+    auto* connection = static_cast<TcpConnection*>(arg);
+    ESP_LOGW(TAG, "Connection lost (err %d)", err);
+    connection->m_pcb = nullptr;
+    connection->releaseInFlight();
+    connection->m_state = State::Failed;
+    connection->m_peerClosed = true;
+    struct pbuf* marker = nullptr;
+    xQueueSend(connection->m_queue, &marker, 0);
+    xSemaphoreGive(connection->m_signal);
+}
+
+void TcpConnection::detachPcb() {
+    tcpipCall([this]() -> err_t {
+        if (m_pcb) {
+            tcp_arg(m_pcb, nullptr);
+            tcp_recv(m_pcb, nullptr);
+            tcp_sent(m_pcb, nullptr);
+            tcp_err(m_pcb, nullptr);
+            // A graceful close would keep retransmitting payloads we are about to release
+            if (!m_inFlight.empty() || tcp_close(m_pcb) != ERR_OK) {
+                tcp_abort(m_pcb);
+            }
+            m_pcb = nullptr;
+        }
+        releaseInFlight();
+        return ERR_OK;
+    });
+}
+
+void TcpConnection::releaseInFlight() {
+    m_inFlight.clear();
+}
+
+void TcpConnection::updateWindow() {
+    esperto::uint32 pending = m_windowPending;
+    if (pending == 0) {
+        return;
+    }
+    m_windowPending = 0;
+    tcpipCall([this, pending]() -> err_t {
+        if (!m_pcb) {
+            return ERR_CONN;
+        }
+        esperto::uint32 left = pending;
+        while (left > 0) {
+            u16_t chunk = static_cast<u16_t>(std::min<esperto::uint32>(left, 0xFFFF));
+            tcp_recved(m_pcb, chunk);
+            left -= chunk;
+        }
+        return ERR_OK;
+    });
+}
+
+void TcpConnection::drainQueue() {
+    struct pbuf* chain = nullptr;
+    while (xQueueReceive(m_queue, &chain, 0) == pdTRUE) {
+        if (chain) {
+            pbuf_free(chain);
+        }
+    }
+}
+
+} // namespace esperto
@@ -0,0 +1,465 @@
+// timer_service.cpp
+// Implementation of TimerService class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/timer_service.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace esperto {
+
+static constexpr esperto::uint64 NoExpiry = ~0ull;
+// Sleep at most half the tick range, so tick count wrap-around is always observed
+static constexpr TickType_t MaxSleepTicks = 0x7FFFFFFF;
+// Wheel rotations processed per critical section; after a long idle the service task
+// catches up in several passes instead of holding interrupts off for all of them
+static constexpr esperto::uint32 MaxRotationsPerPass = 4;
+
+TimerService::TimerService(const Config& config)
+    : m_config(config), m_ticksPerSlot(std::max<TickType_t>(1, pdMS_TO_TICKS(config.resolutionMs))),
+      m_nodes(std::make_unique<Node[]>(config.capacity)), m_freeList(nullptr), m_occupied{}, m_now(0),
+      m_nextWake(NoExpiry), m_tickBase(0), m_lastTick(0), m_lock(portMUX_INITIALIZER_UNLOCKED),
+      m_handle(nullptr), m_exited(nullptr), m_running(false), m_stopping(false) {
+    for (esperto::uint32 i = config.capacity; i > 0; --i) {
+        m_nodes[i - 1].next = m_freeList;
+        m_freeList = &m_nodes[i - 1];
+    }
+    m_stats.capacity = config.capacity;
+}
+
+TimerService::~TimerService() {
+    stop();
+}
+
+bool TimerService::start() {
+    if (m_running) {
+        return true;
+    }
+
+    m_exited = xSemaphoreCreateBinary();
+    if (!m_exited) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&m_lock);
+    m_now = currentTick() / m_ticksPerSlot;
+    portEXIT_CRITICAL(&m_lock);
+
+    m_stopping = false;
+    m_running = true;
+    BaseType_t result = xTaskCreate(
+        &TimerService::serviceEntryPoint,
+        "TimerService",
+        m_config.stackSize,
+        this,
+        m_config.priority,
+        &m_handle
+    );
+    if (result != pdPASS) {
+        m_running = false;
+        m_handle = nullptr;
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void TimerService::stop() {
+    if (!m_running || xTaskGetCurrentTaskHandle() == m_handle) {
+        return;
+    }
+
+    m_stopping = true;
+    xTaskNotifyGive(m_handle);
+    xSemaphoreTake(m_exited, portMAX_DELAY);
+    vSemaphoreDelete(m_exited);
+    m_exited = nullptr;
+    m_handle = nullptr;
+    m_running = false;
+
+    // The service task is gone: drop whatever is still pending
+    for (esperto::uint32 i = 0; i < m_config.capacity; ++i) {
+        Node* node = &m_nodes[i];
+        if (node->state == NodeState::Free) {
+            continue;
+        }
+        portENTER_CRITICAL(&m_lock);
+        if (node->state == NodeState::Pending) {
+            unlink(node);
+        }
+        portEXIT_CRITICAL(&m_lock);
+        node->callback = nullptr;
+        portENTER_CRITICAL(&m_lock);
+        release(node);
+        portEXIT_CRITICAL(&m_lock);
+    }
+}
+
+TimerService::TimerId TimerService::scheduleAfter(esperto::uint32 delayMs, TimerCallback callback, esperto::uint32 slackMs) {
+    return schedule(pdMS_TO_TICKS(delayMs), 0, std::move(callback), slackMs);
+}
+
+TimerService::TimerId TimerService::scheduleAt(TickType_t deadline, TimerCallback callback, esperto::uint32 slackMs) {
+    esperto::int32 delta = static_cast<esperto::int32>(deadline - xTaskGetTickCount());
+    return schedule(delta > 0 ? static_cast<esperto::uint64>(delta) : 0, 0, std::move(callback), slackMs);
+}
+
+TimerService::TimerId TimerService::schedulePeriodic(esperto::uint32 periodMs, TimerCallback callback, esperto::uint32 slackMs) {
+    TickType_t period = std::max<TickType_t>(1, pdMS_TO_TICKS(periodMs));
+    return schedule(period, period, std::move(callback), slackMs);
+}
+
+bool TimerService::cancel(TimerId id) {
+    Node* node = nodeFromId(id);
+    if (!node) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&m_lock);
+    if (idFromNode(node) != id || node->state == NodeState::Free || node->state == NodeState::Cancelled) {
+        portEXIT_CRITICAL(&m_lock);
+        return false;
+    }
+    if (node->state == NodeState::Firing) {
+        // The service task releases the node once the callback returns
+        node->state = NodeState::Cancelled;
+        portEXIT_CRITICAL(&m_lock);
+        return true;
+    }
+    unlink(node);
+    node->state = NodeState::Cancelled;
+    portEXIT_CRITICAL(&m_lock);
+
+    // Destroying the callback may free memory: keep it out of the critical section
+    node->callback = nullptr;
+    portENTER_CRITICAL(&m_lock);
+    release(node);
+    portEXIT_CRITICAL(&m_lock);
+    return true;
+}
+
+bool TimerService::isRunning() const {
+    return m_running;
+}
+
+TimerService::Statistics TimerService::getStatistics() const {
+    portENTER_CRITICAL(&m_lock);
+    Statistics stats = m_stats;
+    portEXIT_CRITICAL(&m_lock);
+    return stats;
+}
+
+void TimerService::serviceEntryPoint(void* param) {
+    TimerService* self = static_cast<TimerService*>(param);
+    self->serviceLoop();
+    xSemaphoreGive(self->m_exited);
+    vTaskDelete(nullptr);
+}
+
+void TimerService::serviceLoop() {
+    while (!m_stopping) {
+        portENTER_CRITICAL(&m_lock);
+        esperto::uint64 now = currentTick();
+        esperto::uint64 target = now / m_ticksPerSlot;
+        Node* expired = collectExpired(target);
+        bool behind = m_now <= target;
+        m_nextWake = nextExpiry();
+        if (expired) {
+            m_stats.wakeups++;
+        }
+        portEXIT_CRITICAL(&m_lock);
+
+        if (expired) {
+            while (expired) {
+                Node* node = expired;
+                expired = expired->next;
+
+                esperto::uint64 deadline = node->expires * m_ticksPerSlot;
+                esperto::uint32 latenessMs = now > deadline ? static_cast<esperto::uint32>((now - deadline) * portTICK_PERIOD_MS) : 0;
+                node->callback();
+
+                bool rearmed = false;
+                portENTER_CRITICAL(&m_lock);
+                m_stats.fired++;
+                m_stats.maxLatenessMs = std::max(m_stats.maxLatenessMs, latenessMs);
+                if (node->state == NodeState::Firing && node->period) {
+                    // Drift-free: advance from the previous deadline, skipping missed periods
+                    do {
+                        node->expires += node->period;
+                    } while (node->expires < m_now);
+                    node->expires = ((node->expires + node->granularity - 1) / node->granularity) * node->granularity;
+                    node->state = NodeState::Pending;
+                    place(node);
+                    rearmed = true;
+                }
+                portEXIT_CRITICAL(&m_lock);
+
+                if (!rearmed) {
+                    node->callback = nullptr;
+                    portENTER_CRITICAL(&m_lock);
+                    release(node);
+                    portEXIT_CRITICAL(&m_lock);
+                }
+            }
+            continue;
+        }
+        if (behind) {
+            continue;
+        }
+
+        esperto::uint64 wakeTick = m_nextWake == NoExpiry ? NoExpiry : m_nextWake * m_ticksPerSlot;
+        TickType_t sleep = MaxSleepTicks;
+        if (wakeTick != NoExpiry) {
+            sleep = wakeTick > now ? static_cast<TickType_t>(std::min<esperto::uint64>(wakeTick - now, MaxSleepTicks)) : 0;
+        }
+        if (sleep > 0) {
+            ulTaskNotifyTake(pdTRUE, sleep);
+        }
+    }
+}
+
+TimerService::TimerId TimerService::schedule(esperto::uint64 delayTicks, esperto::uint32 periodTicks, TimerCallback callback, esperto::uint32 slackMs) {
+    if (!callback) {
+        return InvalidTimer;
+    }
+
+    // Power-of-two granularity: timers with different slack still share slot boundaries
+    esperto::uint32 slackSlots = pdMS_TO_TICKS(slackMs) / m_ticksPerSlot;
+    esperto::uint32 granularity = 1;
+    while (granularity * 2 <= slackSlots) {
+        granularity *= 2;
+    }
+
+    portENTER_CRITICAL(&m_lock);
+    Node* node = m_freeList;
+    if (!node) {
+        m_stats.rejected++;
+        portEXIT_CRITICAL(&m_lock);
+        return InvalidTimer;
+    }
+    m_freeList = node->next;
+    node->state = NodeState::Cancelled;
+    portEXIT_CRITICAL(&m_lock);
+
+    node->callback = std::move(callback);
+
+    portENTER_CRITICAL(&m_lock);
+    // An idle wheel may lag far behind: catch up before filing, not in the service task
+    skipIdle(currentTick() / m_ticksPerSlot);
+    node->granularity = granularity;
+    node->period = periodTicks ? std::max<esperto::uint32>(1, (periodTicks + m_ticksPerSlot - 1) / m_ticksPerSlot) : 0;
+    node->expires = roundToSlot(currentTick() + delayTicks, granularity);
+    node->state = NodeState::Pending;
+    place(node);
+    m_stats.active++;
+    bool wake = node->expires < m_nextWake;
+    if (wake) {
+        m_nextWake = node->expires;
+    }
+    TimerId id = idFromNode(node);
+    portEXIT_CRITICAL(&m_lock);
+
+    if (wake && m_handle) {
+        xTaskNotifyGive(m_handle);
+    }
+    return id;
+}
+
+esperto::uint64 TimerService::currentTick() {
+    TickType_t tick = xTaskGetTickCount();
+    if (tick < m_lastTick) {
+        m_tickBase += 1ull << 32;
+    }
+    m_lastTick = tick;
+    return m_tickBase | tick;
+}
+
+esperto::uint64 TimerService::roundToSlot(esperto::uint64 tick, esperto::uint32 granularity) const {
+    esperto::uint64 slot = (tick + m_ticksPerSlot - 1) / m_ticksPerSlot;
+    return ((slot + granularity - 1) / granularity) * granularity;
+}
+
+void TimerService::place(Node* node) {
+    if (node->expires < m_now) {
+        node->expires = m_now;
+    }
+
+    esperto::uint64 delta = node->expires - m_now;
+    esperto::uint32 level = 0;
+    while (level < Levels - 1 && delta >= (1ull << (LevelBits * (level + 1)))) {
+        ++level;
+    }
+    // Beyond the wheel range: park in the farthest slot, cascading re-files it later
+    esperto::uint64 expires = std::min<esperto::uint64>(node->expires, m_now + (1ull << (LevelBits * Levels)) - 1);
+    esperto::uint32 slot = static_cast<esperto::uint32>((expires >> (LevelBits * level)) & SlotMask);
+
+    Bucket& bucket = m_wheel[level][slot];
+    node->prev = nullptr;
+    node->next = bucket.head;
+    if (bucket.head) {
+        bucket.head->prev = node;
+    }
+    bucket.head = node;
+    node->level = static_cast<esperto::uint8>(level);
+    node->slot = static_cast<esperto::uint8>(slot);
+    m_occupied[level] |= 1ull << slot;
+}
+
+void TimerService::unlink(Node* node) {
+    Bucket& bucket = m_wheel[node->level][node->slot];
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        bucket.head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    if (!bucket.head) {
+        m_occupied[node->level] &= ~(1ull << node->slot);
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+TimerService::Node* TimerService::collectExpired(esperto::uint64 target) {
+    Node* expired = nullptr;
+    Node* tail = nullptr;
+
+    if (skipIdle(target + 1)) {
+        return nullptr;
+    }
+
+    esperto::uint32 rotations = 0;
+    while (m_now <= target) {
+        esperto::uint32 index = static_cast<esperto::uint32>(m_now & SlotMask);
+        if (index == 0) {
+            // The caller comes back for the rest with interrupts enabled in between
+            if (rotations++ == MaxRotationsPerPass) {
+                break;
+            }
+            cascade(1);
+        }
+
+        // Jump straight to the next occupied level-0 slot, or to the next rotation
+        esperto::uint64 pending = m_occupied[0] & (~0ull << index);
+        if (!pending) {
+            esperto::uint64 boundary = (m_now | SlotMask) + 1;
+            m_now = std::min<esperto::uint64>(boundary, target + 1);
+            continue;
+        }
+        esperto::uint64 next = (m_now & ~static_cast<esperto::uint64>(SlotMask)) + __builtin_ctzll(pending);
+        if (next > target) {
+            m_now = target + 1;
+            break;
+        }
+        m_now = next;
+
+        Bucket& bucket = m_wheel[0][m_now & SlotMask];
+        for (Node* node = bucket.head; node; node = node->next) {
+            node->state = NodeState::Firing;
+        }
+        if (tail) {
+            tail->next = bucket.head;
+        } else {
+            expired = bucket.head;
+        }
+        for (tail = bucket.head; tail->next; tail = tail->next) {
+        }
+        bucket.head = nullptr;
+        m_occupied[0] &= ~(1ull << (m_now & SlotMask));
+        ++m_now;
+    }
+    return expired;
+}
+
+bool TimerService::skipIdle(esperto::uint64 slot) {
+    for (esperto::uint32 level = 0; level < Levels; ++level) {
+        if (m_occupied[level]) {
+            return false;
+        }
+    }
+    // Nothing to fire or cascade on the way
+    m_now = std::max(m_now, slot);
+    return true;
+}
+
+void TimerService::cascade(esperto::uint32 level) {
+    if (level >= Levels) {
+        return;
+    }
+
+    esperto::uint32 index = static_cast<esperto::uint32>((m_now >> (LevelBits * level)) & SlotMask);
+    Bucket& bucket = m_wheel[level][index];
+    Node* list = bucket.head;
+    bucket.head = nullptr;
+    m_occupied[level] &= ~(1ull << index);
+    while (list) {
+        Node* node = list;
+        list = list->next;
+        place(node);
+    }
+
+    if (index == 0) {
+        cascade(level + 1);
+    }
+}
+
+esperto::uint64 TimerService::nextExpiry() const {
+    esperto::uint64 best = NoExpiry;
+
+    esperto::uint32 index = static_cast<esperto::uint32>(m_now & SlotMask);
+    esperto::uint64 pending = m_occupied[0] & (~0ull << index);
+    if (pending) {
+        best = (m_now & ~static_cast<esperto::uint64>(SlotMask)) + __builtin_ctzll(pending);
+    } else if (m_occupied[0]) {
+        best = (m_now | SlotMask) + 1;
+    }
+
+    // Higher levels: the moment their next occupied slot gets cascaded
+    for (esperto::uint32 level = 1; level < Levels; ++level) {
+        if (!m_occupied[level]) {
+            continue;
+        }
+        esperto::uint32 shift = LevelBits * level;
+        esperto::uint64 base = (m_now >> shift) << shift;
+        esperto::uint32 current = static_cast<esperto::uint32>((m_now >> shift) & SlotMask);
+        // The current slot is still due if m_now sits exactly on its boundary
+        esperto::uint32 first = (base == m_now) ? current : current + 1;
+        esperto::uint64 ahead = first < SlotsPerLevel ? (m_occupied[level] & (~0ull << first)) : 0;
+        esperto::uint64 when;
+        if (ahead) {
+            when = base + (static_cast<esperto::uint64>(__builtin_ctzll(ahead) - current) << shift);
+        } else {
+            when = base + (static_cast<esperto::uint64>(SlotsPerLevel - current + __builtin_ctzll(m_occupied[level])) << shift);
+        }
+        best = std::min<esperto::uint64>(best, when);
+    }
+    return best;
+}
+
+void TimerService::release(Node* node) {
+    node->state = NodeState::Free;
+    node->generation++;
+    node->prev = nullptr;
+    node->next = m_freeList;
+    m_freeList = node;
+    m_stats.active--;
+}
+
+TimerService::Node* TimerService::nodeFromId(TimerId id) const {
+    esperto::uint32 index = (id & 0xFFFF);
+    if (index == 0 || index > m_config.capacity) {
+        return nullptr;
+    }
+    return &m_nodes[index - 1];
+}
+
+TimerService::TimerId TimerService::idFromNode(const Node* node) const {
+    esperto::uint32 index = static_cast<esperto::uint32>(node - m_nodes.get()) + 1;
+    return (static_cast<TimerId>(node->generation) << 16) | index;
+}
+
+} // namespace esperto
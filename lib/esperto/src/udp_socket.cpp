@@ -0,0 +1,213 @@
+// udp_socket.cpp
+// Implementation of UdpSocket class for ESP32 lwIP
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/udp_socket.hpp"
+
+extern "C" {
+#include "esp_log.h"
+}
+
+namespace esperto {
+
+static const char* TAG = "UdpSocket";
+
+UdpSocket::UdpSocket() : UdpSocket(Config()) {}
+
+UdpSocket::UdpSocket(const Config& config)
+    : m_config(config), m_pcb(nullptr), m_queue(nullptr), m_connected(false), m_dropped(0) {}
+
+UdpSocket::~UdpSocket() {
+    close();
+}
+
+bool UdpSocket::equals(const Object& other) const {
+    auto* o = static_cast<const UdpSocket*>(&other);
+    return o && o->m_pcb == m_pcb;
+}
+
+bool UdpSocket::bind(esperto::uint16 port) {
+    if (m_pcb) {
+        return false;
+    }
+    if (!m_queue) {
+        m_queue = xQueueCreate(m_config.receiveQueueLength, sizeof(Datagram));
+        if (!m_queue) {
+            ESP_LOGE(TAG, "Out of memory for the receive queue");
+            return false;
+        }
+    }
+
+    err_t result = tcpipCall([this, port]() -> err_t {
+        struct udp_pcb* pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+        if (!pcb) {
+            return ERR_MEM;
+        }
+        err_t bound = udp_bind(pcb, IP_ANY_TYPE, port);
+        if (bound != ERR_OK) {
+            udp_remove(pcb);
+            return bound;
+        }
+        udp_recv(pcb, receiveCallback, this);
+        m_pcb = pcb;
+        return ERR_OK;
+    });
+    if (result != ERR_OK) {
+        ESP_LOGE(TAG, "Cannot bind port %u (err %d)", port, result);
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::connect(const NetEndpoint& remote) {
+    if (!m_pcb && !bind(0)) {
+        return false;
+    }
+
+    err_t result = tcpipCall([this, &remote]() -> err_t {
+        ip_addr_t address;
+        ip_addr_set_ip4_u32(&address, remote.address);
+        return udp_connect(m_pcb, &address, remote.port);
+    });
+    if (result != ERR_OK) {
+        return false;
+    }
+    m_remote = remote;
+    m_connected = true;
+    return true;
+}
+
+void UdpSocket::close() {
+    if (m_pcb) {
+        // After this no receive callback can run for this socket
+        tcpipCall([this]() -> err_t {
+            udp_remove(m_pcb);
+            m_pcb = nullptr;
+            return ERR_OK;
+        });
+    }
+    m_connected = false;
+
+    if (m_queue) {
+        drainQueue();
+        vQueueDelete(m_queue);
+        m_queue = nullptr;
+    }
+}
+
+bool UdpSocket::send(const NetPayload* parts, size_t count) {
+    return m_connected && sendTo(m_remote, parts, count);
+}
+
+bool UdpSocket::send(const NetPayload& payload) {
+    return send(&payload, 1);
+}
+
+bool UdpSocket::sendTo(const NetEndpoint& remote, const NetPayload* parts, size_t count) {
+    if (!m_pcb) {
+        return false;
+    }
+
+    struct pbuf* chain = buildChain(parts, count);
+    if (!chain) {
+        m_stats.sendErrors++;
+        return false;
+    }
+    size_t length = chain->tot_len;
+
+    // lwIP prepends its headers in a pbuf of its own; the payload parts are only referenced
+    err_t result = tcpipCall([this, &remote, chain]() -> err_t {
+        ip_addr_t address;
+        ip_addr_set_ip4_u32(&address, remote.address);
+        return udp_sendto(m_pcb, chain, &address, remote.port);
+    });
+    // Drops our reference; the payloads stay alive while the driver still holds the chain
+    pbuf_free(chain);
+
+    if (result != ERR_OK) {
+        m_stats.sendErrors++;
+        return false;
+    }
+    m_stats.sent++;
+    m_stats.sentBytes += length;
+    return true;
+}
+
+bool UdpSocket::receive(NetBuffer& buffer, NetEndpoint* from, esperto::uint32 timeoutMs) {
+    if (!m_queue) {
+        return false;
+    }
+
+    Datagram datagram;
+    if (xQueueReceive(m_queue, &datagram, detail::timeoutToTicks(timeoutMs)) != pdTRUE) {
+        return false;
+    }
+    if (from) {
+        *from = datagram.from;
+    }
+    m_stats.received++;
+    m_stats.receivedBytes += datagram.chain->tot_len;
+    buffer = NetBuffer(datagram.chain);
+    return true;
+}
+
+esperto::uint16 UdpSocket::localPort() const {
+    return m_pcb ? m_pcb->local_port : 0;
+}
+
+bool UdpSocket::isOpen() const {
+    return m_pcb != nullptr;
+}
+
+UdpSocket::Statistics UdpSocket::getStatistics() const {
+    Statistics stats = m_stats;
+    stats.dropped = m_dropped.load();
+    return stats;
+}
+
+void UdpSocket::receiveCallback(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* address, u16_t port) {
+    // tcpip thread: queue the chain as is, never wait
+    auto* socket = static_cast<UdpSocket*>(arg);
+    Datagram datagram;
+    datagram.chain = p;
+    datagram.from.address = ip_addr_get_ip4_u32(address);
+    datagram.from.port = port;
+    if (xQueueSend(socket->m_queue, &datagram, 0) != pdTRUE) {
+        pbuf_free(p);
+        socket->m_dropped++;
+    }
+}
+
+struct pbuf* UdpSocket::buildChain(const NetPayload* parts, size_t count) {
+    struct pbuf* chain = nullptr;
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (parts[i].size() == 0) {
+            continue;
+        }
+        total += parts[i].size();
+        struct pbuf* p = total <= 0xFFFF ? parts[i].toPbuf() : nullptr;
+        if (!p) {
+            if (chain) {
+                pbuf_free(chain);
+            }
+            return nullptr;
+        }
+        if (chain) {
+            pbuf_cat(chain, p);
+        } else {
+            chain = p;
+        }
+    }
+    return chain;
+}
+
+void UdpSocket::drainQueue() {
+    Datagram datagram;
+    while (xQueueReceive(m_queue, &datagram, 0) == pdTRUE) {
+        pbuf_free(datagram.chain);
+    }
+}
+
+} // namespace esperto
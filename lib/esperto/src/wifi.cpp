@@ -1,21 +1,120 @@
 #include "../headers/wifi.hpp"
+#include "../headers/task_scheduler.hpp"
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_pm.h"
+#include "ping/ping_sock.h"
+#include "freertos/semphr.h"
 }
 
 namespace esperto {
 
 static const char* TAG = "WiFi";
 
+static const char* FAST_CONNECT_NAMESPACE = "esperto";
+static const char* FAST_CONNECT_KEY = "wifi_fast";
+static constexpr esperto::uint32 FAST_CONNECT_MAGIC = 0x45574631;  // "EWF1"
+
+// Last successful connection, as cached for fast reconnect
+struct FastConnectCache {
+    esperto::uint32 magic;
+    uint8_t ssid[32];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t gateway;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t dns;
+};
+
+// Survives deep sleep, so a wake does not need to read flash
+static RTC_DATA_ATTR FastConnectCache s_rtcCache;
+
+static bool loadFastConnectCache(FastConnectCache& cache) {
+    if (s_rtcCache.magic == FAST_CONNECT_MAGIC) {
+        cache = s_rtcCache;
+        return true;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(FAST_CONNECT_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(cache);
+    esp_err_t ret = nvs_get_blob(handle, FAST_CONNECT_KEY, &cache, &size);
+    nvs_close(handle);
+    if (ret != ESP_OK || size != sizeof(cache) || cache.magic != FAST_CONNECT_MAGIC) {
+        return false;
+    }
+    s_rtcCache = cache;
+    return true;
+}
+
+static void storeFastConnectCache(const FastConnectCache& cache) {
+    // NVS is only written when the AP or the lease changed, to spare the flash
+    bool changed = memcmp(&s_rtcCache, &cache, sizeof(cache)) != 0;
+    s_rtcCache = cache;
+    if (!changed) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(FAST_CONNECT_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot open NVS to store the fast connect cache");
+        return;
+    }
+    if (nvs_set_blob(handle, FAST_CONNECT_KEY, &cache, sizeof(cache)) != ESP_OK || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot store the fast connect cache");
+    }
+    nvs_close(handle);
+}
+
+// Reasons a retry cannot fix while the credentials stay the same
+static bool isCredentialFailure(uint8_t reason) {
+    switch (reason) {
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_802_1X_AUTH_FAILED:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void eraseFastConnectCache() {
+    memset(&s_rtcCache, 0, sizeof(s_rtcCache));
+    nvs_handle_t handle;
+    if (nvs_open(FAST_CONNECT_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        nvs_erase_key(handle, FAST_CONNECT_KEY);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
 WiFi::WiFi() 
     : m_mode(Mode::Station), m_status(Status::Disconnected), m_netifSta(nullptr), 
-      m_netifAp(nullptr), m_initialized(false) {
+      m_netifAp(nullptr), m_initialized(false), m_statusWaiters(nullptr),
+      m_waiterLock(portMUX_INITIALIZER_UNLOCKED), m_connectStartUs(0), m_fastAttempt(false),
+      m_bssidPinned(false), m_leaseApplied(false), m_bssid{}, m_channel(0), m_reconnectAllowed(false),
+      m_pendingReconnect(false), m_attempts(0), m_credentialFailures(0), m_disconnectReason(0),
+      m_retryTimer(TimerService::InvalidTimer), m_retryGeneration(0),
+      m_powerProfile(PowerProfile::Balanced), m_listenInterval(10), m_lightSleepEnabled(false),
+      m_nextSubscription(InvalidSubscription), m_droppedEvents(0) {
+    m_subscriberLock = xSemaphoreCreateRecursiveMutexStatic(&m_subscriberLockBuffer);
     
     // Initialize NVS if not already done
     esp_err_t ret = nvs_flash_init();
@@ -73,6 +172,7 @@ bool WiFi::begin(Mode mode) {
     ESP_ERROR_CHECK(esp_wifi_start());
 
     m_initialized = true;
+    applyPowerProfile();
     return true;
 }
 
@@ -81,6 +181,8 @@ void WiFi::end() {
         return;
     }
 
+    m_reconnectAllowed = false;
+    cancelRetry();
     esp_wifi_stop();
     esp_wifi_deinit();
     
@@ -91,6 +193,9 @@ void WiFi::end() {
     
     m_initialized = false;
     m_status = Status::Disconnected;
+    m_fastAttempt = false;
+    m_bssidPinned = false;
+    m_leaseApplied = false;
 }
 
 bool WiFi::beginStation(const esperto::string& ssid, const esperto::string& password) {
@@ -104,10 +209,18 @@ bool WiFi::beginStation(const esperto::string& ssid, const esperto::string& pass
     wifi_config_t wifiConfig = {};
     strncpy((char*)wifiConfig.sta.ssid, ssid.c_str(), sizeof(wifiConfig.sta.ssid) - 1);
     strncpy((char*)wifiConfig.sta.password, password.c_str(), sizeof(wifiConfig.sta.password) - 1);
+    if (m_powerProfile == PowerProfile::MaxSaving) {
+        wifiConfig.sta.listen_interval = m_listenInterval;
+    }
+
+    m_fastAttempt = applyFastConnect(wifiConfig);
+    m_bssidPinned = m_fastAttempt;
     
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifiConfig));
     
-    return connect();
+    bool connected = connect();
+    m_timing.fastPath = m_fastAttempt;
+    return connected;
 }
 
 bool WiFi::connect() {
@@ -115,9 +228,11 @@ bool WiFi::connect() {
         return false;
     }
     
-    m_status = Status::Connecting;
-    esp_err_t result = esp_wifi_connect();
-    return result == ESP_OK;
+    cancelRetry();
+    m_reconnectAllowed = true;
+    m_attempts = 0;
+    m_credentialFailures = 0;
+    return startConnect();
 }
 
 bool WiFi::disconnect() {
@@ -125,6 +240,10 @@ bool WiFi::disconnect() {
         return false;
     }
     
+    m_reconnectAllowed = false;
+    m_pendingReconnect = false;
+    m_fastAttempt = false;
+    cancelRetry();
     esp_err_t result = esp_wifi_disconnect();
     if (result == ESP_OK) {
         m_status = Status::Disconnected;
@@ -134,9 +253,20 @@ bool WiFi::disconnect() {
 }
 
 bool WiFi::reconnect() {
-    disconnect();
-    vTaskDelay(pdMS_TO_TICKS(100));
-    return connect();
+    if (m_mode == Mode::AccessPoint) {
+        return false;
+    }
+
+    cancelRetry();
+    m_reconnectAllowed = true;
+    m_attempts = 0;
+    m_credentialFailures = 0;
+    if (m_status == Status::Connected) {
+        // Does not wait: the connection restarts when the disconnect event arrives
+        m_pendingReconnect = true;
+        return esp_wifi_disconnect() == ESP_OK;
+    }
+    return startConnect();
 }
 
 bool WiFi::beginAccessPoint(const esperto::string& ssid, const esperto::string& password, 
@@ -178,6 +308,124 @@ bool WiFi::stopAccessPoint() {
     return true;
 }
 
+void WiFi::setFastConnect(const FastConnectConfig& config) {
+    m_fastConnect = config;
+}
+
+WiFi::FastConnectConfig WiFi::getFastConnect() const {
+    return m_fastConnect;
+}
+
+void WiFi::clearFastConnectCache() {
+    eraseFastConnectCache();
+}
+
+WiFi::ConnectTiming WiFi::getConnectTiming() const {
+    return m_timing;
+}
+
+bool WiFi::setPowerProfile(PowerProfile profile, uint16_t listenInterval) {
+    m_powerProfile = profile;
+    m_listenInterval = listenInterval;
+    if (!m_initialized) {
+        // Applied by begin()
+        return true;
+    }
+    return applyPowerProfile();
+}
+
+WiFi::PowerProfile WiFi::getPowerProfile() const {
+    return m_powerProfile;
+}
+
+// Collects ping replies; the ping task writes it, measureRoundTrip reads it after the end callback
+struct RoundTripProbe {
+    WiFi::RoundTripStats stats;
+    esperto::uint64 totalMs = 0;
+    SemaphoreHandle_t done = nullptr;
+};
+
+static void onPingSuccess(esp_ping_handle_t handle, void* arg) {
+    auto* probe = static_cast<RoundTripProbe*>(arg);
+    esperto::uint32 elapsedMs = 0;
+    esp_ping_get_profile(handle, ESP_PING_PROF_TIMEGAP, &elapsedMs, sizeof(elapsedMs));
+    WiFi::RoundTripStats& stats = probe->stats;
+    stats.minMs = stats.received == 0 ? elapsedMs : std::min(stats.minMs, elapsedMs);
+    stats.maxMs = std::max(stats.maxMs, elapsedMs);
+    stats.received++;
+    probe->totalMs += elapsedMs;
+}
+
+static void onPingEnd(esp_ping_handle_t handle, void* arg) {
+    auto* probe = static_cast<RoundTripProbe*>(arg);
+    esperto::uint32 sent = 0;
+    esp_ping_get_profile(handle, ESP_PING_PROF_REQUEST, &sent, sizeof(sent));
+    probe->stats.sent = sent;
+    xSemaphoreGive(probe->done);
+}
+
+bool WiFi::measureRoundTrip(RoundTripStats& stats, const esperto::string& host, 
+                            esperto::uint32 count, esperto::uint32 intervalMs) {
+    if (!isConnected() || !m_netifSta || count == 0) {
+        return false;
+    }
+
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    config.count = count;
+    config.interval_ms = intervalMs;
+    if (host.empty()) {
+        esp_netif_ip_info_t ipInfo;
+        if (esp_netif_get_ip_info(m_netifSta, &ipInfo) != ESP_OK) {
+            return false;
+        }
+        ip_addr_set_ip4_u32(&config.target_addr, ipInfo.gw.addr);
+    } else if (!ipaddr_aton(host.c_str(), &config.target_addr)) {
+        ESP_LOGE(TAG, "Invalid ping target %s", host.c_str());
+        return false;
+    }
+
+    StaticSemaphore_t doneBuffer;
+    RoundTripProbe probe;
+    probe.done = xSemaphoreCreateBinaryStatic(&doneBuffer);
+
+    esp_ping_callbacks_t callbacks = {};
+    callbacks.cb_args = &probe;
+    callbacks.on_ping_success = onPingSuccess;
+    callbacks.on_ping_end = onPingEnd;
+
+    esp_ping_handle_t session;
+    if (esp_ping_new_session(&config, &callbacks, &session) != ESP_OK) {
+        vSemaphoreDelete(probe.done);
+        return false;
+    }
+    esp_ping_start(session);
+    xSemaphoreTake(probe.done, portMAX_DELAY);
+    esp_ping_delete_session(session);
+    vSemaphoreDelete(probe.done);
+
+    if (probe.stats.received != 0) {
+        probe.stats.avgMs = static_cast<esperto::uint32>(probe.totalMs / probe.stats.received);
+    }
+    stats = probe.stats;
+    return stats.received != 0;
+}
+
+void WiFi::setReconnectPolicy(const ReconnectPolicy& policy) {
+    m_reconnect = policy;
+}
+
+WiFi::ReconnectPolicy WiFi::getReconnectPolicy() const {
+    return m_reconnect;
+}
+
+esperto::uint32 WiFi::getReconnectAttempts() const {
+    return m_attempts;
+}
+
+uint8_t WiFi::getDisconnectReason() const {
+    return m_disconnectReason;
+}
+
 WiFi::Status WiFi::getStatus() const {
     return m_status;
 }
@@ -237,6 +485,63 @@ int32_t WiFi::getRSSI() const {
     return 0;
 }
 
+WiFi::SubscriptionId WiFi::subscribe(EventListener listener) {
+    return listener ? addSubscriber(std::move(listener), nullptr) : InvalidSubscription;
+}
+
+WiFi::SubscriptionId WiFi::subscribe(QueueHandle_t queue) {
+    return queue ? addSubscriber(nullptr, queue) : InvalidSubscription;
+}
+
+WiFi::SubscriptionId WiFi::addSubscriber(EventListener listener, QueueHandle_t queue) {
+    SubscriptionId id = InvalidSubscription;
+    xSemaphoreTakeRecursive(m_subscriberLock, portMAX_DELAY);
+    for (Subscriber& subscriber : m_subscribers) {
+        if (subscriber.id == InvalidSubscription && !subscriber.busy) {
+            if (++m_nextSubscription == InvalidSubscription) {
+                ++m_nextSubscription;
+            }
+            id = m_nextSubscription;
+            subscriber.id = id;
+            subscriber.listener = std::move(listener);
+            subscriber.queue = queue;
+            break;
+        }
+    }
+    xSemaphoreGiveRecursive(m_subscriberLock);
+
+    if (id == InvalidSubscription) {
+        ESP_LOGE(TAG, "No free subscriber slot (max %lu)", (unsigned long)MaxSubscribers);
+    }
+    return id;
+}
+
+bool WiFi::unsubscribe(SubscriptionId id) {
+    if (id == InvalidSubscription) {
+        return false;
+    }
+
+    bool found = false;
+    xSemaphoreTakeRecursive(m_subscriberLock, portMAX_DELAY);
+    for (Subscriber& subscriber : m_subscribers) {
+        if (subscriber.id == id) {
+            subscriber.id = InvalidSubscription;
+            subscriber.queue = nullptr;
+            if (!subscriber.busy) {
+                subscriber.listener = nullptr;
+            }
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGiveRecursive(m_subscriberLock);
+    return found;
+}
+
+esperto::uint32 WiFi::getDroppedEvents() const {
+    return m_droppedEvents.load();
+}
+
 void WiFi::setEventCallback(EventCallback callback) {
     m_eventCallback = callback;
 }
@@ -298,6 +603,234 @@ void WiFi::cleanupNetif() {
     }
 }
 
+bool WiFi::applyFastConnect(wifi_config_t& wifiConfig) {
+    if (m_fastConnect.useStaticIp) {
+        applyStaticIp(m_fastConnect.staticIp);
+    }
+
+    FastConnectCache cache;
+    if (!m_fastConnect.enabled || !loadFastConnectCache(cache) ||
+        memcmp(cache.ssid, wifiConfig.sta.ssid, sizeof(cache.ssid)) != 0) {
+        return false;
+    }
+
+    // Only the cached channel is scanned, and only the cached AP is accepted
+    wifiConfig.sta.bssid_set = true;
+    memcpy(wifiConfig.sta.bssid, cache.bssid, sizeof(cache.bssid));
+    wifiConfig.sta.channel = cache.channel;
+    wifiConfig.sta.scan_method = WIFI_FAST_SCAN;
+
+    if (!m_fastConnect.useStaticIp && m_fastConnect.reuseLease && cache.ip.addr != 0) {
+        StaticIp lease;
+        lease.ip = cache.ip;
+        lease.gateway = cache.gateway;
+        lease.netmask = cache.netmask;
+        lease.dns = cache.dns;
+        applyStaticIp(lease);
+        m_leaseApplied = true;
+    }
+
+    ESP_LOGI(TAG, "Fast connect to %02X:%02X:%02X:%02X:%02X:%02X on channel %u",
+             cache.bssid[0], cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4], cache.bssid[5],
+             cache.channel);
+    return true;
+}
+
+void WiFi::applyStaticIp(const StaticIp& staticIp) {
+    if (!m_netifSta) {
+        return;
+    }
+
+    esp_netif_dhcpc_stop(m_netifSta);
+    esp_netif_ip_info_t ipInfo = {};
+    ipInfo.ip = staticIp.ip;
+    ipInfo.gw = staticIp.gateway;
+    ipInfo.netmask = staticIp.netmask;
+    if (esp_netif_set_ip_info(m_netifSta, &ipInfo) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot set the static IP, using DHCP");
+        esp_netif_dhcpc_start(m_netifSta);
+        return;
+    }
+
+    if (staticIp.dns.addr != 0) {
+        esp_netif_dns_info_t dns = {};
+        dns.ip.type = ESP_IPADDR_TYPE_V4;
+        dns.ip.u_addr.ip4 = staticIp.dns;
+        esp_netif_set_dns_info(m_netifSta, ESP_NETIF_DNS_MAIN, &dns);
+    }
+}
+
+void WiFi::restoreDhcp() {
+    if (!m_leaseApplied) {
+        return;
+    }
+    m_leaseApplied = false;
+    if (m_netifSta) {
+        esp_netif_dhcpc_start(m_netifSta);
+    }
+}
+
+void WiFi::unpinBssid() {
+    if (!m_bssidPinned) {
+        return;
+    }
+    m_bssidPinned = false;
+
+    // Later connections scan for the SSID again, so roaming and AP changes keep working
+    wifi_config_t wifiConfig;
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifiConfig) == ESP_OK) {
+        wifiConfig.sta.bssid_set = false;
+        wifiConfig.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &wifiConfig);
+    }
+}
+
+void WiFi::fallBackToScan() {
+    ESP_LOGW(TAG, "Cached AP not reachable, falling back to a full scan");
+    m_fastAttempt = false;
+    m_timing.fellBack = true;
+    unpinBssid();
+    restoreDhcp();
+    eraseFastConnectCache();
+    esp_wifi_connect();
+}
+
+void WiFi::saveFastConnect(const esp_netif_ip_info_t& ipInfo) {
+    if (!m_fastConnect.enabled) {
+        return;
+    }
+
+    FastConnectCache cache = {};
+    cache.magic = FAST_CONNECT_MAGIC;
+    strncpy((char*)cache.ssid, m_ssid.c_str(), sizeof(cache.ssid));
+    memcpy(cache.bssid, m_bssid, sizeof(cache.bssid));
+    cache.channel = m_channel;
+    cache.ip = ipInfo.ip;
+    cache.gateway = ipInfo.gw;
+    cache.netmask = ipInfo.netmask;
+    esp_netif_dns_info_t dns;
+    if (m_netifSta && esp_netif_get_dns_info(m_netifSta, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK) {
+        cache.dns = dns.ip.u_addr.ip4;
+    }
+    storeFastConnectCache(cache);
+}
+
+bool WiFi::applyPowerProfile() {
+    wifi_ps_type_t powerSave = WIFI_PS_MIN_MODEM;
+    switch (m_powerProfile) {
+        case PowerProfile::LowLatency:
+            powerSave = WIFI_PS_NONE;
+            break;
+        case PowerProfile::Balanced:
+            powerSave = WIFI_PS_MIN_MODEM;
+            break;
+        case PowerProfile::MaxSaving:
+            powerSave = WIFI_PS_MAX_MODEM;
+            break;
+    }
+    if (esp_wifi_set_ps(powerSave) != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot set the power save mode");
+        return false;
+    }
+
+    if (m_mode != Mode::AccessPoint) {
+        // Only read at association: takes effect on the next connection
+        wifi_config_t wifiConfig;
+        if (esp_wifi_get_config(WIFI_IF_STA, &wifiConfig) == ESP_OK) {
+            wifiConfig.sta.listen_interval = m_powerProfile == PowerProfile::MaxSaving ? m_listenInterval : 0;
+            esp_wifi_set_config(WIFI_IF_STA, &wifiConfig);
+        }
+    }
+
+#if CONFIG_PM_ENABLE
+    // Keeps the frequency limits chosen by the application, and only turns off the light
+    // sleep MaxSaving turned on
+    bool lightSleep = m_powerProfile == PowerProfile::MaxSaving;
+    esp_pm_config_t pmConfig;
+    if (lightSleep != m_lightSleepEnabled && esp_pm_get_configuration(&pmConfig) == ESP_OK) {
+        pmConfig.light_sleep_enable = lightSleep;
+        if (esp_pm_configure(&pmConfig) == ESP_OK) {
+            m_lightSleepEnabled = lightSleep;
+        } else {
+            ESP_LOGW(TAG, "Cannot configure automatic light sleep");
+        }
+    }
+#else
+    if (m_powerProfile == PowerProfile::MaxSaving) {
+        ESP_LOGW(TAG, "Automatic light sleep needs CONFIG_PM_ENABLE");
+    }
+#endif
+    return true;
+}
+
+bool WiFi::startConnect() {
+    m_status = Status::Connecting;
+    m_timing = ConnectTiming();
+    m_connectStartUs = esp_timer_get_time();
+    esp_err_t result = esp_wifi_connect();
+    return result == ESP_OK;
+}
+
+bool WiFi::scheduleRetry(uint8_t reason) {
+    if (isCredentialFailure(reason)) {
+        if (++m_credentialFailures >= m_reconnect.maxCredentialFailures) {
+            ESP_LOGE(TAG, "Authentication failed %lu times, giving up", (unsigned long)m_credentialFailures);
+            return false;
+        }
+    } else {
+        m_credentialFailures = 0;
+    }
+
+    if (m_reconnect.maxRetries != 0 && m_attempts >= m_reconnect.maxRetries) {
+        ESP_LOGE(TAG, "No connection after %lu retries, giving up", (unsigned long)m_attempts);
+        return false;
+    }
+
+    esperto::uint32 delayMs = backoffDelayMs(m_attempts++);
+    esperto::uint32 generation = ++m_retryGeneration;
+    m_retryTimer = TaskScheduler::instance().scheduleAfter(delayMs, [this, generation]() {
+        retryConnect(generation);
+    });
+    if (m_retryTimer == TimerService::InvalidTimer) {
+        ESP_LOGE(TAG, "Cannot schedule the reconnect timer");
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Reconnect attempt %lu in %lu ms", (unsigned long)m_attempts, (unsigned long)delayMs);
+    return true;
+}
+
+void WiFi::retryConnect(esperto::uint32 generation) {
+    // Runs on the timer service task; a disconnect(), reconnect() or end() since scheduling wins
+    if (generation != m_retryGeneration.load() || !m_reconnectAllowed) {
+        return;
+    }
+    m_retryTimer = TimerService::InvalidTimer;
+    Status previous = m_status;
+    startConnect();
+    if (m_status != previous) {
+        notifyStatusWaiters();
+    }
+}
+
+void WiFi::cancelRetry() {
+    m_retryGeneration++;
+    if (m_retryTimer != TimerService::InvalidTimer) {
+        TaskScheduler::instance().cancelTimer(m_retryTimer);
+        m_retryTimer = TimerService::InvalidTimer;
+    }
+}
+
+esperto::uint32 WiFi::backoffDelayMs(esperto::uint32 attempt) const {
+    esperto::uint64 delay = static_cast<esperto::uint64>(m_reconnect.initialDelayMs) << std::min<esperto::uint32>(attempt, 20);
+    delay = std::min<esperto::uint64>(delay, m_reconnect.maxDelayMs);
+    esperto::uint64 jitter = delay * std::min<esperto::uint8>(m_reconnect.jitterPercent, 100) / 100;
+    if (jitter != 0) {
+        delay -= esp_random() % (jitter + 1);
+    }
+    return static_cast<esperto::uint32>(std::max<esperto::uint64>(delay, 1));
+}
+
 void WiFi::wifiEventHandler(void* arg, esp_event_base_t eventBase, 
                            int32_t eventId, void* eventData) {
     WiFi* wifi = static_cast<WiFi*>(arg);
@@ -310,41 +843,179 @@ void WiFi::ipEventHandler(void* arg, esp_event_base_t eventBase,
     wifi->handleEvent(eventBase, eventId, eventData);
 }
 
+WiFiStatusAwaiter WiFi::statusChangeAsync() {
+    return WiFiStatusAwaiter(*this);
+}
+
 void WiFi::handleEvent(esp_event_base_t eventBase, int32_t eventId, void* eventData) {
+    Status previous = m_status;
+    Event event = {};
+    bool publishEvent = false;
     if (eventBase == WIFI_EVENT) {
         switch (eventId) {
             case WIFI_EVENT_STA_START:
                 ESP_LOGI(TAG, "WiFi station started");
+                event.type = Event::Type::StationStarted;
+                publishEvent = true;
                 break;
-            case WIFI_EVENT_STA_CONNECTED:
-                ESP_LOGI(TAG, "Connected to WiFi");
+            case WIFI_EVENT_STA_CONNECTED: {
+                auto* connected = static_cast<wifi_event_sta_connected_t*>(eventData);
+                memcpy(m_bssid, connected->bssid, sizeof(m_bssid));
+                m_channel = connected->channel;
+                m_fastAttempt = false;
+                m_timing.associationMs = static_cast<esperto::uint32>((esp_timer_get_time() - m_connectStartUs) / 1000);
+                ESP_LOGI(TAG, "Connected to WiFi in %lu ms", (unsigned long)m_timing.associationMs);
+                event.type = Event::Type::Associated;
+                event.channel = m_channel;
+                memcpy(event.bssid, m_bssid, sizeof(event.bssid));
+                publishEvent = true;
                 break;
-            case WIFI_EVENT_STA_DISCONNECTED:
-                ESP_LOGI(TAG, "Disconnected from WiFi");
-                m_status = Status::Disconnected;
-                if (m_eventCallback) {
-                    m_eventCallback(m_status, "Disconnected");
+            }
+            case WIFI_EVENT_STA_DISCONNECTED: {
+                auto* disconnected = static_cast<wifi_event_sta_disconnected_t*>(eventData);
+                m_disconnectReason = disconnected->reason;
+                if (m_fastAttempt && m_status == Status::Connecting) {
+                    fallBackToScan();
+                    break;
+                }
+                ESP_LOGI(TAG, "Disconnected from WiFi (reason %u)", m_disconnectReason);
+                unpinBssid();
+                restoreDhcp();
+                if (m_pendingReconnect) {
+                    m_pendingReconnect = false;
+                    startConnect();
+                    break;
                 }
+
+                if (m_reconnectAllowed && m_reconnect.enabled && !scheduleRetry(m_disconnectReason)) {
+                    m_reconnectAllowed = false;
+                    m_status = Status::Failed;
+                } else {
+                    m_status = Status::Disconnected;
+                }
+                event.type = Event::Type::Disconnected;
+                event.reason = disconnected->reason;
+                event.rssi = disconnected->rssi;
+                memcpy(event.bssid, disconnected->bssid, sizeof(event.bssid));
+                publishEvent = true;
                 break;
+            }
             case WIFI_EVENT_AP_START:
                 ESP_LOGI(TAG, "WiFi AP started");
                 m_status = Status::APStarted;
-                if (m_eventCallback) {
-                    m_eventCallback(m_status, "AP Started");
-                }
+                event.type = Event::Type::APStarted;
+                publishEvent = true;
                 break;
         }
     } else if (eventBase == IP_EVENT) {
         switch (eventId) {
-            case IP_EVENT_STA_GOT_IP:
-                ESP_LOGI(TAG, "Got IP address");
+            case IP_EVENT_STA_GOT_IP: {
+                auto* gotIp = static_cast<ip_event_got_ip_t*>(eventData);
+                m_timing.ipMs = static_cast<esperto::uint32>((esp_timer_get_time() - m_connectStartUs) / 1000);
+                m_attempts = 0;
+                m_credentialFailures = 0;
+                ESP_LOGI(TAG, "Got IP address in %lu ms%s", (unsigned long)m_timing.ipMs,
+                         m_timing.fastPath && !m_timing.fellBack ? " (fast connect)" : "");
+                saveFastConnect(gotIp->ip_info);
                 m_status = Status::Connected;
-                if (m_eventCallback) {
-                    m_eventCallback(m_status, "Connected with IP: " + getIPAddress());
+                event.type = Event::Type::GotIp;
+                event.ip = gotIp->ip_info.ip;
+                event.gateway = gotIp->ip_info.gw;
+                event.netmask = gotIp->ip_info.netmask;
+                event.channel = m_channel;
+                memcpy(event.bssid, m_bssid, sizeof(event.bssid));
+                wifi_ap_record_t apInfo;
+                if (esp_wifi_sta_get_ap_info(&apInfo) == ESP_OK) {
+                    event.rssi = apInfo.rssi;
                 }
+                publishEvent = true;
                 break;
+            }
         }
     }
+
+    if (publishEvent) {
+        publish(event);
+    }
+    if (m_status != previous) {
+        notifyStatusWaiters();
+    }
+}
+
+void WiFi::publish(Event& event) {
+    event.status = m_status;
+    event.timestampUs = esp_timer_get_time();
+
+    xSemaphoreTakeRecursive(m_subscriberLock, portMAX_DELAY);
+    for (Subscriber& subscriber : m_subscribers) {
+        if (subscriber.id == InvalidSubscription) {
+            continue;
+        }
+        if (subscriber.queue) {
+            if (xQueueSend(subscriber.queue, &event, 0) != pdTRUE) {
+                m_droppedEvents++;
+            }
+        } else {
+            subscriber.busy = true;
+            subscriber.listener(event);
+            subscriber.busy = false;
+            if (subscriber.id == InvalidSubscription) {
+                // Unsubscribed from inside the call
+                subscriber.listener = nullptr;
+            }
+        }
+    }
+    xSemaphoreGiveRecursive(m_subscriberLock);
+
+    if (!m_eventCallback) {
+        return;
+    }
+    // Legacy info strings, only built for the legacy callback
+    switch (event.type) {
+        case Event::Type::Disconnected:
+            m_eventCallback(m_status, m_status == Status::Failed ? "Failed" : "Disconnected");
+            break;
+        case Event::Type::APStarted:
+            m_eventCallback(m_status, "AP Started");
+            break;
+        case Event::Type::GotIp: {
+            char info[40];
+            snprintf(info, sizeof(info), "Connected with IP: " IPSTR, IP2STR(&event.ip));
+            m_eventCallback(m_status, info);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void WiFi::notifyStatusWaiters() {
+    portENTER_CRITICAL(&m_waiterLock);
+    WiFiStatusAwaiter* waiters = m_statusWaiters;
+    m_statusWaiters = nullptr;
+    portEXIT_CRITICAL(&m_waiterLock);
+
+    while (waiters) {
+        // The awaiter lives in the coroutine frame: read the link before resuming it
+        WiFiStatusAwaiter* waiter = waiters;
+        waiters = waiter->m_next;
+        waiter->m_node.loop->schedule(waiter->m_node);
+    }
+}
+
+bool WiFiStatusAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    CoroutineLoop* loop = CoroutineLoop::current();
+    if (!loop) {
+        return false;
+    }
+
+    m_node.handle = handle;
+    m_node.loop = loop;
+    portENTER_CRITICAL(&m_wifi.m_waiterLock);
+    m_next = m_wifi.m_statusWaiters;
+    m_wifi.m_statusWaiters = this;
+    portEXIT_CRITICAL(&m_wifi.m_waiterLock);
+    return true;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+// worker_pool.cpp
+// Implementation of WorkerPool class for ESP32 FreeRTOS
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "../headers/worker_pool.hpp"
+#include <cstdio>
+#include <utility>
+
+namespace esperto {
+
+static esperto::uint32 roundUpToPowerOfTwo(esperto::uint32 value) {
+    esperto::uint32 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+WorkerPool::WorkerPool(const Config& config)
+    : m_config(config), m_mask(roundUpToPowerOfTwo(config.queueCapacity ? config.queueCapacity : 1) - 1),
+      m_running(false), m_stopping(false), m_nextWorker(0), m_rejected(0), m_exited(nullptr) {
+    if (m_config.workersPerCore == 0) {
+        m_config.workersPerCore = 1;
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::start() {
+    if (m_running) {
+        return true;
+    }
+
+    esperto::uint32 total = m_config.workersPerCore * portNUM_PROCESSORS;
+    m_exited = xSemaphoreCreateCounting(total, 0);
+    if (!m_exited) {
+        return false;
+    }
+
+    m_stopping = false;
+    m_workers.clear();
+    m_workers.reserve(total);
+    for (esperto::uint32 i = 0; i < total; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->pool = this;
+        worker->index = i;
+        worker->core = static_cast<BaseType_t>(i / m_config.workersPerCore);
+        worker->items = std::make_unique<WorkFunction[]>(m_mask + 1);
+        m_workers.push_back(std::move(worker));
+    }
+
+    // Workers only start running once every deque exists, so stealing never sees a partial vector
+    m_running = true;
+    esperto::uint32 created = 0;
+    for (auto& worker : m_workers) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "Worker%lu", static_cast<unsigned long>(worker->index));
+        BaseType_t result = xTaskCreatePinnedToCore(
+            &WorkerPool::workerEntryPoint,
+            name,
+            m_config.stackSize,
+            worker.get(),
+            m_config.priority,
+            &worker->handle,
+            worker->core
+        );
+        if (result != pdPASS) {
+            break;
+        }
+        ++created;
+    }
+
+    if (created != m_workers.size()) {
+        m_stopping = true;
+        for (esperto::uint32 i = 0; i < created; ++i) {
+            xTaskNotifyGive(m_workers[i]->handle);
+        }
+        for (esperto::uint32 i = 0; i < created; ++i) {
+            xSemaphoreTake(m_exited, portMAX_DELAY);
+        }
+        m_running = false;
+        m_workers.clear();
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void WorkerPool::stop() {
+    if (!m_running || currentWorker()) {
+        return;
+    }
+
+    m_stopping = true;
+    for (auto& worker : m_workers) {
+        xTaskNotifyGive(worker->handle);
+    }
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        xSemaphoreTake(m_exited, portMAX_DELAY);
+    }
+
+    m_running = false;
+    m_workers.clear();
+    vSemaphoreDelete(m_exited);
+    m_exited = nullptr;
+}
+
+bool WorkerPool::submit(WorkFunction func) {
+    if (!m_running || m_stopping || !func) {
+        return false;
+    }
+
+    // Jobs spawned by a job stay on the spawning worker's deque; others go round-robin
+    // among the workers of the caller's core.
+    Worker* target = currentWorker();
+    if (!target) {
+        esperto::uint32 core = static_cast<esperto::uint32>(xPortGetCoreID());
+        esperto::uint32 slot = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_config.workersPerCore;
+        target = m_workers[core * m_config.workersPerCore + slot].get();
+    }
+
+    if (!pushBottom(*target, func)) {
+        // Target deque full: spill to any worker with room
+        Worker* spill = nullptr;
+        for (auto& worker : m_workers) {
+            if (worker.get() != target && pushBottom(*worker, func)) {
+                spill = worker.get();
+                break;
+            }
+        }
+        if (!spill) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        target = spill;
+    }
+
+    wake(*target);
+    return true;
+}
+
+bool WorkerPool::isRunning() const {
+    return m_running;
+}
+
+size_t WorkerPool::getWorkerCount() const {
+    return m_workers.size();
+}
+
+WorkerPool::Statistics WorkerPool::getStatistics() const {
+    Statistics stats;
+    stats.workers = static_cast<esperto::uint32>(m_workers.size());
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    for (auto& worker : m_workers) {
+        stats.executed += worker->executed.load(std::memory_order_relaxed);
+        stats.stolen += worker->stolen.load(std::memory_order_relaxed);
+        portENTER_CRITICAL(&worker->lock);
+        stats.pending += worker->bottom - worker->top;
+        portEXIT_CRITICAL(&worker->lock);
+    }
+    return stats;
+}
+
+void WorkerPool::workerEntryPoint(void* param) {
+    Worker* worker = static_cast<Worker*>(param);
+    WorkerPool* pool = worker->pool;
+    pool->workerLoop(*worker);
+    xSemaphoreGive(pool->m_exited);
+    vTaskDelete(nullptr);
+}
+
+void WorkerPool::workerLoop(Worker& worker) {
+    WorkFunction job;
+    while (!m_stopping) {
+        if (popBottom(worker, job)) {
+            job();
+            job = nullptr;
+            worker.executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (steal(worker, job)) {
+            job();
+            job = nullptr;
+            worker.executed.fetch_add(1, std::memory_order_relaxed);
+            worker.stolen.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Publish the sleeping flag before the last look at the deques, so a producer
+        // either sees the flag and notifies, or its item is seen here.
+        worker.sleeping.store(true);
+        if (popBottom(worker, job) || steal(worker, job)) {
+            worker.sleeping.store(false);
+            job();
+            job = nullptr;
+            worker.executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        worker.sleeping.store(false);
+    }
+}
+
+WorkerPool::Worker* WorkerPool::currentWorker() const {
+    if (!m_running) {
+        return nullptr;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (auto& worker : m_workers) {
+        if (worker->handle == self) {
+            return worker.get();
+        }
+    }
+    return nullptr;
+}
+
+bool WorkerPool::pushBottom(Worker& worker, WorkFunction& func) {
+    bool pushed = false;
+    portENTER_CRITICAL(&worker.lock);
+    if (worker.bottom - worker.top <= m_mask) {
+        worker.items[worker.bottom & m_mask] = std::move(func);
+        ++worker.bottom;
+        pushed = true;
+    }
+    portEXIT_CRITICAL(&worker.lock);
+    return pushed;
+}
+
+bool WorkerPool::popBottom(Worker& worker, WorkFunction& func) {
+    bool popped = false;
+    portENTER_CRITICAL(&worker.lock);
+    if (worker.bottom != worker.top) {
+        --worker.bottom;
+        func = std::move(worker.items[worker.bottom & m_mask]);
+        popped = true;
+    }
+    portEXIT_CRITICAL(&worker.lock);
+    return popped;
+}
+
+bool WorkerPool::stealTop(Worker& victim, WorkFunction& func) {
+    bool stolen = false;
+    portENTER_CRITICAL(&victim.lock);
+    if (victim.bottom != victim.top) {
+        func = std::move(victim.items[victim.top & m_mask]);
+        ++victim.top;
+        stolen = true;
+    }
+    portEXIT_CRITICAL(&victim.lock);
+    return stolen;
+}
+
+bool WorkerPool::steal(Worker& thief, WorkFunction& func) {
+    // Visit victims starting with the next worker, so thieves spread over the deques
+    size_t count = m_workers.size();
+    for (size_t i = 1; i < count; ++i) {
+        Worker& victim = *m_workers[(thief.index + i) % count];
+        if (stealTop(victim, func)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::wake(Worker& target) {
+    if (target.sleeping.load()) {
+        xTaskNotifyGive(target.handle);
+        return;
+    }
+    // Target is busy: hand the item to an idle worker so it gets stolen right away
+    for (auto& worker : m_workers) {
+        if (worker.get() != &target && worker->sleeping.load()) {
+            xTaskNotifyGive(worker->handle);
+            return;
+        }
+    }
+}
+
+} // namespace esperto
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# net_sink.py
+# 📡 Traffic sink and source for the ESPerto socket benchmarks (benchmarks/net)
+#
+# SYNOPSIS
+#     Discards UDP datagrams and TCP streams on PORT and streams data to every TCP client of
+#     PORT + 1 until it disconnects. Prints the throughput the host saw for each transfer, to
+#     compare with the BENCH lines printed by the board.
+#
+# NOTES
+#     Example usage:
+#         python3 ./scripts/bench/net_sink.py --port 5201
+#
+import argparse
+import socket
+import threading
+import time
+
+CHUNK = 64 * 1024
+
+
+def report(kind, peer, size, elapsed):
+    mbps = size * 8 / elapsed / 1e6 if elapsed > 0 else 0.0
+    print(f"{kind:<8} {peer[0]}:{peer[1]:<6} {size:>10} bytes {mbps:8.2f} Mbit/s", flush=True)
+
+
+def udp_sink(port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+    sock.bind(("", port))
+    peer, size, first, last = None, 0, 0.0, 0.0
+    while True:
+        # A gap of one second ends a run
+        sock.settimeout(1.0 if peer else None)
+        try:
+            data, sender = sock.recvfrom(CHUNK)
+        except socket.timeout:
+            report("udp rx", peer, size, last - first)
+            peer, size = None, 0
+            continue
+        now = time.monotonic()
+        if peer is None:
+            peer, first = sender, now
+        size += len(data)
+        last = now
+
+
+def tcp_sink_client(conn, peer):
+    size, start = 0, time.monotonic()
+    with conn:
+        while True:
+            data = conn.recv(CHUNK)
+            if not data:
+                break
+            size += len(data)
+    report("tcp rx", peer, size, time.monotonic() - start)
+
+
+def tcp_source_client(conn, peer):
+    payload = bytes(i & 0xFF for i in range(CHUNK))
+    size, start = 0, time.monotonic()
+    with conn:
+        try:
+            while True:
+                conn.sendall(payload)
+                size += len(payload)
+        except OSError:
+            pass
+    report("tcp tx", peer, size, time.monotonic() - start)
+
+
+def tcp_server(port, handler):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("", port))
+    server.listen()
+    while True:
+        conn, peer = server.accept()
+        threading.Thread(target=handler, args=(conn, peer), daemon=True).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Sink and source for benchmarks/net")
+    parser.add_argument("--port", type=int, default=5201, help="UDP/TCP discard port; the TCP source uses port + 1")
+    args = parser.parse_args()
+
+    threading.Thread(target=udp_sink, args=(args.port,), daemon=True).start()
+    threading.Thread(target=tcp_server, args=(args.port, tcp_sink_client), daemon=True).start()
+    threading.Thread(target=tcp_server, args=(args.port + 1, tcp_source_client), daemon=True).start()
+    print(f"📡 Sink on UDP/TCP {args.port}, source on TCP {args.port + 1}. Ctrl+C to stop.", flush=True)
+    try:
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,52 @@
+# run-bench.ps1
+<#+
+.SYNOPSIS
+    Build and run the ESPerto micro-benchmarks on the ESP-IDF linux target.
+.DESCRIPTION
+    This script builds benchmarks/<suite> (scheduler, gpio or mqtt, default scheduler) for the linux (POSIX FreeRTOS)
+    target and runs it on the host. The output is saved to benchmarks/results/<git short sha>-<suite>.txt so runs
+    can be compared between commits.
+    The linux target needs a POSIX host: on Windows, run it from WSL.
+.NOTES
+    Requires ESP-IDF 5.x with the environment exported (IDF_PATH set). The mqtt suite also needs a broker
+    on 127.0.0.1:1883, for example mosquitto.
+    Example usage:
+        ./scripts/bench/run-bench.ps1
+        ./scripts/bench/run-bench.ps1 -Suite gpio
+#>
+
+param(
+    [ValidateSet("scheduler", "gpio", "mqtt")]
+    [string]$Suite = "scheduler"
+)
+
+$rootDir = Resolve-Path (Join-Path $PSScriptRoot "..\..")
+$benchDir = Join-Path $rootDir "benchmarks\$Suite"
+$resultsDir = Join-Path $rootDir "benchmarks\results"
+
+if (-not $env:IDF_PATH) {
+    Write-Host "❌ IDF_PATH is not set. Run the ESP-IDF export script first."
+    exit 1
+}
+
+Push-Location $benchDir
+try {
+    if (-not (Test-Path "sdkconfig")) {
+        Write-Host "[1/3] 🐧 Selecting the linux target..."
+        idf.py --preview set-target linux
+    }
+
+    Write-Host "[2/3] 🔨 Building the benchmarks..."
+    idf.py build
+    if ($LASTEXITCODE -ne 0) { exit $LASTEXITCODE }
+
+    $revision = git -C $rootDir rev-parse --short HEAD 2>$null
+    if (-not $revision) { $revision = "local" }
+    New-Item -ItemType Directory -Force -Path $resultsDir | Out-Null
+
+    Write-Host "[3/3] ⏱️ Running the benchmarks..."
+    & "./build/esperto_${Suite}_bench.elf" | Tee-Object -FilePath (Join-Path $resultsDir "$revision-$Suite.txt")
+}
+finally {
+    Pop-Location
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# run-bench.sh
+# ⏱️ Build and run the ESPerto micro-benchmarks on the ESP-IDF linux target
+#
+# SYNOPSIS
+#     Builds benchmarks/<suite> (scheduler, gpio or mqtt, default scheduler) for the linux (POSIX FreeRTOS)
+#     target and runs it on the host. The output is saved to benchmarks/results/<git short sha>-<suite>.txt
+#     so runs can be compared between commits, for example with: diff <(grep ^BENCH a.txt) <(grep ^BENCH b.txt)
+#
+# NOTES
+#     Requires ESP-IDF 5.x with export.sh sourced (IDF_PATH set). The mqtt suite also needs a broker on
+#     127.0.0.1:1883, for example mosquitto.
+#     Example usage:
+#         ./scripts/bench/run-bench.sh
+#         ./scripts/bench/run-bench.sh gpio
+#
+set -e
+
+suite="${1:-scheduler}"
+root_dir="$(realpath "$(dirname "$0")/../..")"
+bench_dir="$root_dir/benchmarks/$suite"
+results_dir="$root_dir/benchmarks/results"
+
+if [ -z "$IDF_PATH" ]; then
+    echo "❌ IDF_PATH is not set. Source \$IDF_PATH/export.sh first."
+    exit 1
+fi
+
+if [ ! -f "$bench_dir/CMakeLists.txt" ]; then
+    echo "❌ Unknown benchmark suite '$suite' (expected scheduler, gpio or mqtt)."
+    exit 1
+fi
+
+cd "$bench_dir"
+
+if [ ! -f sdkconfig ]; then
+    echo "[1/3] 🐧 Selecting the linux target..."
+    idf.py --preview set-target linux
+fi
+
+echo "[2/3] 🔨 Building the benchmarks..."
+idf.py build
+
+revision="$(git -C "$root_dir" rev-parse --short HEAD 2>/dev/null || echo local)"
+mkdir -p "$results_dir"
+
+echo "[3/3] ⏱️ Running the benchmarks..."
+"./build/esperto_${suite}_bench.elf" | tee "$results_dir/$revision-$suite.txt"
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# compress_image.py
+# 🗜️ Compress a firmware image for OtaUpdater (lib/esperto/headers/ota_updater.hpp)
+#
+# SYNOPSIS
+#     Writes a zlib stream of the app image. OtaUpdater recognises it by its first byte and
+#     inflates it while writing, so the device downloads fewer bytes for the same image.
+#
+# NOTES
+#     Example usage:
+#         python3 ./scripts/ota/compress_image.py .pio/build/esp32dev/firmware.bin
+#         python3 ./scripts/ota/compress_image.py firmware.bin -o firmware.bin.zz
+#
+import argparse
+import sys
+import zlib
+
+IMAGE_MAGIC = 0xE9
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compress an app image for OtaUpdater")
+    parser.add_argument("image", help="App image (.bin) built by PlatformIO or ESP-IDF")
+    parser.add_argument("-o", "--output", help="Output file (default: <image>.zz)")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as source:
+        image = source.read()
+    if not image or image[0] != IMAGE_MAGIC:
+        print(f"❌ {args.image} is not an app image (first byte must be 0x{IMAGE_MAGIC:02x}).")
+        return 1
+
+    # Window size 15 matches the 32 KiB dictionary of the ROM inflater
+    compressor = zlib.compressobj(9, zlib.DEFLATED, 15)
+    compressed = compressor.compress(image) + compressor.flush()
+    output = args.output or args.image + ".zz"
+    with open(output, "wb") as target:
+        target.write(compressed)
+
+    ratio = len(compressed) / len(image)
+    print(f"✅ {output}: {len(image)} -> {len(compressed)} bytes ({ratio:.0%} of the image)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
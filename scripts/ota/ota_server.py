@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# ota_server.py
+# 🔄 Serve firmware images to OtaUpdater over HTTP or HTTPS, with range requests
+#
+# SYNOPSIS
+#     Serves the files of a directory with Range/If-Range and ETag support, so interrupted
+#     downloads resume where they stopped. With --cert and --key (see scripts/cert) it serves
+#     HTTPS. --drop-after closes every response after that many bytes, to test resuming.
+#
+# NOTES
+#     Example usage:
+#         python3 ./scripts/ota/ota_server.py --dir .pio/build/esp32dev --port 8070
+#         python3 ./scripts/ota/ota_server.py --dir . --cert certs/server.crt --key certs/server.key
+#
+import argparse
+import hashlib
+import http.server
+import os
+import re
+import ssl
+
+CHUNK = 16 * 1024
+
+
+class ImageHandler(http.server.BaseHTTPRequestHandler):
+    directory = "."
+    drop_after = 0
+    protocol_version = "HTTP/1.1"
+
+    def do_HEAD(self):
+        self.serve(send_body=False)
+
+    def do_GET(self):
+        self.serve(send_body=True)
+
+    def serve(self, send_body):
+        path = os.path.realpath(os.path.join(self.directory, self.path.split("?")[0].lstrip("/")))
+        if not path.startswith(os.path.realpath(self.directory)) or not os.path.isfile(path):
+            self.send_error(404)
+            return
+        with open(path, "rb") as source:
+            data = source.read()
+        etag = '"' + hashlib.sha256(data).hexdigest()[:16] + '"'
+
+        start, end = 0, len(data) - 1
+        ranged = False
+        match = re.fullmatch(r"bytes=(\d+)-(\d*)", self.headers.get("Range", ""))
+        if_range = self.headers.get("If-Range")
+        if match and (if_range is None or if_range == etag):
+            start = int(match.group(1))
+            end = int(match.group(2)) if match.group(2) else end
+            if start >= len(data) or end < start:
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{len(data)}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            end = min(end, len(data) - 1)
+            ranged = True
+
+        self.send_response(206 if ranged else 200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(end - start + 1))
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("ETag", etag)
+        if ranged:
+            self.send_header("Content-Range", f"bytes {start}-{end}/{len(data)}")
+        self.end_headers()
+        if not send_body:
+            return
+
+        sent = 0
+        offset = start
+        while offset <= end:
+            piece = data[offset:min(offset + CHUNK, end + 1)]
+            if self.drop_after and sent + len(piece) > self.drop_after:
+                piece = piece[:self.drop_after - sent]
+                self.wfile.write(piece)
+                self.log_message("dropped the connection after %d bytes", sent + len(piece))
+                self.close_connection = True
+                self.connection.shutdown(2)
+                return
+            self.wfile.write(piece)
+            sent += len(piece)
+            offset += len(piece)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Firmware server for OtaUpdater")
+    parser.add_argument("--dir", default=".", help="Directory with the images")
+    parser.add_argument("--port", type=int, default=8070)
+    parser.add_argument("--cert", help="Server certificate (PEM) to serve HTTPS")
+    parser.add_argument("--key", help="Private key of the certificate")
+    parser.add_argument("--drop-after", type=int, default=0, help="Close each response after this many bytes")
+    args = parser.parse_args()
+
+    ImageHandler.directory = args.dir
+    ImageHandler.drop_after = args.drop_after
+    server = http.server.ThreadingHTTPServer(("", args.port), ImageHandler)
+    scheme = "http"
+    if args.cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        scheme = "https"
+    print(f"🔄 Serving {os.path.abspath(args.dir)} on {scheme}://0.0.0.0:{args.port}/ Ctrl+C to stop.", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
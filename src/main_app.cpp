@@ -17,7 +17,7 @@ extern "C" {
 }
 #include <cstdio>
 #include "driver/gpio.h"
-#include "gpio.hpp"
+#include "pwm_output.hpp"
 #include "task_scheduler.hpp"
 
 #define BLINK_GPIO GPIO_NUM_2
@@ -27,29 +27,19 @@ extern "C" void app_main(void)
     printf("Hello world!\n");
     fflush(stdout);
     
-    // Create blink task using TaskScheduler and Gpio classes
-    auto& scheduler = esperto::TaskScheduler::instance();
-    auto blinkTask = scheduler.startNew([](esperto::Task& task) {
-        esperto::Gpio led(BLINK_GPIO);
-        led.setDirection(GPIO_MODE_OUTPUT);
-        
-        printf("Blink task started on GPIO %d\n", led.getPin());
-        
-        while (true) {
-            led.setLevel(1);
-            esperto::Task::delay(500); // Use Task::delay instead of vTaskDelay
-            led.setLevel(0);
-            esperto::Task::delay(500);
-        }
-    }, "BlinkTask", 2048, 5);
+    // Blink in hardware: the LEDC peripheral toggles the pin, no task wakes up per edge
+    esperto::PwmOutput::Config blinkConfig;
+    blinkConfig.frequencyHz = 1;
+    blinkConfig.dutyPercent = 50.0f;
+    static esperto::PwmOutput blink(BLINK_GPIO, blinkConfig);
+    if (blink.start()) {
+        printf("Blinking GPIO %d at 1 Hz on LEDC\n", BLINK_GPIO);
+    }
     
-    printf("Blink task started with TaskScheduler\n");
+    auto& scheduler = esperto::TaskScheduler::instance();
     
-    // Print task statistics every 5 seconds
-    scheduler.startNew([](esperto::Task& task) {
-        while (true) {
-            esperto::Task::delay(5000);
-            esperto::TaskScheduler::instance().printTaskStatistics();
-        }
-    }, "StatsTask", 2048, 3);
+    // Print task statistics every 5 seconds from the shared timer service
+    scheduler.schedulePeriodic(5000, []() {
+        esperto::TaskScheduler::instance().printTaskStatistics();
+    }, 100);
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+// test_gpio_debouncer.cpp
+// GpioDebouncer state machine tests: bursts, glitches, edge filter, minimum pulse and detach
+// Author: ESPerto Contributors
+// License: MIT
+//
+// The test pin is an input and an output at once, so Gpio::setLevel produces real edges
+// on its own interrupt.
+
+#include "unity.h"
+#include "gpio.hpp"
+#include "gpio_debouncer.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+}
+
+using namespace esperto;
+
+static constexpr gpio_num_t TestPin = static_cast<gpio_num_t>(CONFIG_TEST_GPIO);
+
+struct Recorder {
+    std::atomic<esperto::uint32> calls{0};
+    std::atomic<int> level{-1};
+    std::atomic<esperto::int64> lastUs{0};
+
+    Gpio::InterruptCallback callback() {
+        return [this](Gpio& gpio) {
+            level = gpio.getDebouncedLevel();
+            lastUs = esp_timer_get_time();
+            calls++;
+        };
+    }
+};
+
+static void preparePin(Gpio& gpio) {
+    gpio.setDirection(GPIO_MODE_INPUT_OUTPUT);
+    gpio.setLevel(0);
+    vTaskDelay(pdMS_TO_TICKS(5));
+}
+
+// Toggles `edges` times, 100 us apart, starting from the opposite of `last` and ending on it
+static void bounce(Gpio& gpio, esperto::uint32 last, int edges) {
+    for (int i = edges - 1; i >= 0; --i) {
+        gpio.setLevel(i % 2 == 0 ? last : 1 - last);
+        esp_rom_delay_us(100);
+    }
+}
+
+static GpioDebounce timing(esperto::uint32 stableUs, esperto::uint32 minPulseUs = 0) {
+    GpioDebounce debounce;
+    debounce.stableUs = stableUs;
+    debounce.minPulseUs = minPulseUs;
+    return debounce;
+}
+
+TEST_CASE("a bouncing edge is reported once, after it settles", "[debounce]")
+{
+    Gpio gpio(TestPin);
+    preparePin(gpio);
+    Recorder recorder;
+    GpioDebouncer::Statistics before = GpioDebouncer::instance().getStatistics();
+    gpio.enableInterrupt(GPIO_INTR_ANYEDGE, recorder.callback(), timing(2000));
+
+    bounce(gpio, 1, 7);
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.calls.load());
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.calls.load());
+    TEST_ASSERT_EQUAL(1, recorder.level.load());
+    TEST_ASSERT_EQUAL(1, gpio.getDebouncedLevel());
+
+    bounce(gpio, 0, 5);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL_UINT32(2, recorder.calls.load());
+    TEST_ASSERT_EQUAL(0, recorder.level.load());
+
+    GpioDebouncer::Statistics after = GpioDebouncer::instance().getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(2, after.transitions - before.transitions);
+    TEST_ASSERT_GREATER_OR_EQUAL(4, after.edges - before.edges);
+    TEST_ASSERT_EQUAL_UINT32(0, after.pending);
+    gpio.disableInterrupt();
+}
+
+TEST_CASE("a burst that settles on the previous level is a glitch", "[debounce]")
+{
+    Gpio gpio(TestPin);
+    preparePin(gpio);
+    Recorder recorder;
+    GpioDebouncer::Statistics before = GpioDebouncer::instance().getStatistics();
+    gpio.enableInterrupt(GPIO_INTR_ANYEDGE, recorder.callback(), timing(2000));
+
+    bounce(gpio, 0, 6);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.calls.load());
+    TEST_ASSERT_EQUAL(0, gpio.getDebouncedLevel());
+
+    GpioDebouncer::Statistics after = GpioDebouncer::instance().getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(1, after.glitches - before.glitches);
+    TEST_ASSERT_EQUAL_UINT64(0, after.transitions - before.transitions);
+    gpio.disableInterrupt();
+}
+
+TEST_CASE("only transitions matching the requested edge run the callback", "[debounce]")
+{
+    Gpio gpio(TestPin);
+    preparePin(gpio);
+    Recorder recorder;
+    GpioDebouncer::Statistics before = GpioDebouncer::instance().getStatistics();
+    gpio.enableInterrupt(GPIO_INTR_POSEDGE, recorder.callback(), timing(2000));
+
+    bounce(gpio, 1, 3);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    bounce(gpio, 0, 3);
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.calls.load());
+    TEST_ASSERT_EQUAL(1, recorder.level.load());
+    GpioDebouncer::Statistics after = GpioDebouncer::instance().getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(2, after.transitions - before.transitions);
+    TEST_ASSERT_EQUAL_UINT64(1, after.callbacks - before.callbacks);
+    gpio.disableInterrupt();
+}
+
+TEST_CASE("pulses shorter than minPulseUs are rejected", "[debounce]")
+{
+    Gpio gpio(TestPin);
+    preparePin(gpio);
+    Recorder recorder;
+    gpio.enableInterrupt(GPIO_INTR_ANYEDGE, recorder.callback(), timing(1000, 20000));
+
+    // Quiet for longer than stableUs, but back low before minPulseUs
+    gpio.setLevel(1);
+    vTaskDelay(pdMS_TO_TICKS(5));
+    gpio.setLevel(0);
+    vTaskDelay(pdMS_TO_TICKS(40));
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.calls.load());
+
+    esperto::int64 risingUs = esp_timer_get_time();
+    gpio.setLevel(1);
+    vTaskDelay(pdMS_TO_TICKS(40));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.calls.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(20000, recorder.lastUs.load() - risingUs);
+    gpio.disableInterrupt();
+}
+
+TEST_CASE("no callback runs after the interrupt is disabled", "[debounce]")
+{
+    Gpio gpio(TestPin);
+    preparePin(gpio);
+    Recorder recorder;
+    gpio.enableInterrupt(GPIO_INTR_ANYEDGE, recorder.callback(), timing(2000));
+    TEST_ASSERT_EQUAL(0, GpioDebouncer::instance().getStableLevel(TestPin));
+
+    // Disabled in the middle of a burst: its pending deadline must not reach the callback
+    bounce(gpio, 1, 3);
+    gpio.disableInterrupt();
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.calls.load());
+    TEST_ASSERT_EQUAL(-1, GpioDebouncer::instance().getStableLevel(TestPin));
+    TEST_ASSERT_EQUAL(1, gpio.getDebouncedLevel());
+}
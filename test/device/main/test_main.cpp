@@ -0,0 +1,11 @@
+// test_main.cpp
+// Unity menu for the on-chip tests; test/test_device.py runs every case from it
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+
+extern "C" void app_main(void)
+{
+    unity_run_menu();
+}
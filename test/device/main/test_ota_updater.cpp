@@ -0,0 +1,281 @@
+// test_ota_updater.cpp
+// OtaUpdater tests: raw and zlib images, resume after a dropped connection, restart
+// when the server ignores Range
+// Author: ESPerto Contributors
+// License: MIT
+//
+// An esp_http_server on the loopback interface serves the running app image, read
+// straight from its partition, so no network or host server is needed. The zlib variant
+// is produced on the fly with stored (uncompressed) deflate blocks: the transfer does not
+// shrink, but the updater goes through the whole inflate path. The boot partition is
+// never changed.
+
+#include "unity.h"
+#include "ota_updater.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_http_server.h"
+#include "esp_image_format.h"
+#include "esp_netif.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+}
+
+using namespace esperto;
+
+static constexpr esperto::uint16 ServerPort = 8070;
+static constexpr size_t BlockSize = 4096;       ///< Image bytes per stored deflate block
+static constexpr size_t BlockHeader = 5;        ///< BFINAL/BTYPE byte, LEN, NLEN
+
+// Served files and the behaviour of the next requests
+struct ImageServer {
+    httpd_handle_t handle = nullptr;
+    const esp_partition_t* running = nullptr;
+    size_t imageLength = 0;
+    size_t blocks = 0;
+    esperto::uint32 adler = 0;
+    bool rangeSupport = true;
+    size_t dropAt = 0;                          ///< Close the connection once at this offset, 0 never
+    std::atomic<esperto::uint32> requests{0};
+    std::atomic<esperto::uint32> rangeRequests{0};
+    esperto::uint8 buffer[1024];
+
+    size_t zlibLength() const {
+        return 2 + blocks * BlockHeader + imageLength + 4;
+    }
+
+    // Byte range of the raw image
+    bool readImage(size_t offset, esperto::uint8* out, size_t length) const {
+        return esp_partition_read(running, offset, out, length) == ESP_OK;
+    }
+
+    // Byte range of the zlib stream: header, stored blocks of the image, Adler-32
+    bool readZlib(size_t offset, esperto::uint8* out, size_t length) const {
+        size_t bodyEnd = 2 + blocks * BlockHeader + imageLength;
+        size_t produced = 0;
+        while (produced < length) {
+            size_t position = offset + produced;
+            if (position < 2) {
+                out[produced++] = position == 0 ? 0x78 : 0x01;
+                continue;
+            }
+            if (position >= bodyEnd) {
+                out[produced++] = static_cast<esperto::uint8>(adler >> (8 * (3 - (position - bodyEnd))));
+                continue;
+            }
+            size_t block = (position - 2) / (BlockHeader + BlockSize);
+            size_t inBlock = (position - 2) % (BlockHeader + BlockSize);
+            size_t blockLength = std::min(BlockSize, imageLength - block * BlockSize);
+            if (inBlock < BlockHeader) {
+                esperto::uint16 len = static_cast<esperto::uint16>(blockLength);
+                const esperto::uint8 header[BlockHeader] = {
+                    static_cast<esperto::uint8>(block + 1 == blocks ? 1 : 0),
+                    static_cast<esperto::uint8>(len & 0xFF), static_cast<esperto::uint8>(len >> 8),
+                    static_cast<esperto::uint8>(~len & 0xFF), static_cast<esperto::uint8>((~len >> 8) & 0xFF)};
+                out[produced++] = header[inBlock];
+                continue;
+            }
+            size_t data = inBlock - BlockHeader;
+            size_t count = std::min(blockLength - data, length - produced);
+            if (!readImage(block * BlockSize + data, out + produced, count)) {
+                return false;
+            }
+            produced += count;
+        }
+        return true;
+    }
+
+    static esp_err_t serve(httpd_req_t* request) {
+        ImageServer& server = *s_server;
+        bool zlib = request->user_ctx != nullptr;
+        unsigned total = static_cast<unsigned>(zlib ? server.zlibLength() : server.imageLength);
+        server.requests++;
+
+        unsigned start = 0;
+        char range[48];
+        bool partial = server.rangeSupport &&
+                       httpd_req_get_hdr_value_str(request, "Range", range, sizeof(range)) == ESP_OK &&
+                       sscanf(range, "bytes=%u-", &start) == 1 && start < total;
+        if (partial) {
+            server.rangeRequests++;
+        } else {
+            start = 0;
+        }
+
+        // Raw response, so Content-Length is set instead of chunked encoding
+        char header[192];
+        int headerLength = partial
+            ? snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\nContent-Length: %u\r\n"
+                       "Content-Range: bytes %u-%u/%u\r\nETag: \"esperto\"\r\n\r\n",
+                       total - start, start, total - 1, total)
+            : snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nETag: \"esperto\"\r\n\r\n",
+                       total);
+        if (httpd_send(request, header, headerLength) != headerLength) {
+            return ESP_FAIL;
+        }
+
+        for (size_t offset = start; offset < total;) {
+            size_t length = std::min<size_t>(sizeof(server.buffer), total - offset);
+            bool drop = server.dropAt > offset && server.dropAt <= offset + length;
+            if (drop) {
+                length = server.dropAt - offset;
+            }
+            bool read = zlib ? server.readZlib(offset, server.buffer, length)
+                             : server.readImage(offset, server.buffer, length);
+            if (!read || httpd_send(request, reinterpret_cast<const char*>(server.buffer), length) != static_cast<int>(length)) {
+                return ESP_FAIL;
+            }
+            offset += length;
+            if (drop) {
+                // Failing the handler closes the socket in the middle of the body
+                server.dropAt = 0;
+                return ESP_FAIL;
+            }
+        }
+        return ESP_OK;
+    }
+
+    static ImageServer* s_server;
+};
+
+ImageServer* ImageServer::s_server = nullptr;
+
+static ImageServer& imageServer() {
+    static ImageServer server;
+    if (server.handle) {
+        server.rangeSupport = true;
+        server.dropAt = 0;
+        server.requests = 0;
+        server.rangeRequests = 0;
+        return server;
+    }
+
+    server.running = esp_ota_get_running_partition();
+    esp_partition_pos_t position = {server.running->address, server.running->size};
+    esp_image_metadata_t metadata = {};
+    TEST_ASSERT_EQUAL(ESP_OK, esp_image_get_metadata(&position, &metadata));
+    server.imageLength = metadata.image_len;
+    server.blocks = (server.imageLength + BlockSize - 1) / BlockSize;
+
+    esperto::uint32 a = 1;
+    esperto::uint32 b = 0;
+    for (size_t offset = 0; offset < server.imageLength; offset += sizeof(server.buffer)) {
+        size_t length = std::min(sizeof(server.buffer), server.imageLength - offset);
+        TEST_ASSERT_TRUE(server.readImage(offset, server.buffer, length));
+        for (size_t i = 0; i < length; ++i) {
+            a = (a + server.buffer[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    server.adler = (b << 16) | a;
+
+    // Only the loopback interface is used, but it needs the TCP/IP stack
+    TEST_ASSERT_EQUAL(ESP_OK, esp_netif_init());
+    esp_err_t loop = esp_event_loop_create_default();
+    TEST_ASSERT_TRUE(loop == ESP_OK || loop == ESP_ERR_INVALID_STATE);
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = ServerPort;
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&server.handle, &config));
+    ImageServer::s_server = &server;
+    // A non-null user context selects the zlib stream
+    static char zlibMarker;
+    httpd_uri_t uri = {};
+    uri.method = HTTP_GET;
+    uri.handler = &ImageServer::serve;
+    uri.uri = "/image.bin";
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(server.handle, &uri));
+    uri.uri = "/image.zz";
+    uri.user_ctx = &zlibMarker;
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(server.handle, &uri));
+    return server;
+}
+
+static OtaUpdater::Config updaterConfig(const char* path) {
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u%s", static_cast<unsigned>(ServerPort), path);
+    OtaUpdater::Config config;
+    config.url = url;
+    config.bufferSize = 4096;
+    config.retryDelayMs = 50;
+    config.setBootPartition = false;
+    return config;
+}
+
+// The written image hashes the same as the running one
+static void assertCopyOfRunningImage() {
+    esperto::uint8 running[32];
+    esperto::uint8 written[32];
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_get_sha256(esp_ota_get_running_partition(), running));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_get_sha256(esp_ota_get_next_update_partition(nullptr), written));
+    TEST_ASSERT_EQUAL_MEMORY(running, written, sizeof(running));
+}
+
+TEST_CASE("a raw image is written and verified", "[ota]")
+{
+    ImageServer& server = imageServer();
+    OtaUpdater updater(updaterConfig("/image.bin"));
+    TEST_ASSERT_TRUE(updater.update());
+    TEST_ASSERT_TRUE(updater.getState() == OtaUpdater::State::Done);
+
+    OtaUpdater::Statistics stats = updater.getStatistics();
+    TEST_ASSERT_FALSE(stats.compressed);
+    TEST_ASSERT_EQUAL_UINT64(server.imageLength, stats.imageBytes);
+    TEST_ASSERT_EQUAL_UINT64(server.imageLength, stats.downloadedBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.resumes);
+    TEST_ASSERT_EQUAL_UINT32(esp_ota_get_running_partition()->address,
+                             esp_ota_get_boot_partition()->address);
+    assertCopyOfRunningImage();
+}
+
+TEST_CASE("a zlib image is inflated while it is written", "[ota]")
+{
+    ImageServer& server = imageServer();
+    OtaUpdater updater(updaterConfig("/image.zz"));
+    TEST_ASSERT_TRUE(updater.update());
+
+    OtaUpdater::Statistics stats = updater.getStatistics();
+    TEST_ASSERT_TRUE(stats.compressed);
+    TEST_ASSERT_EQUAL_UINT64(server.zlibLength(), stats.downloadedBytes);
+    TEST_ASSERT_EQUAL_UINT64(server.imageLength, stats.imageBytes);
+    assertCopyOfRunningImage();
+}
+
+TEST_CASE("a dropped download resumes with a Range request", "[ota]")
+{
+    ImageServer& server = imageServer();
+    // Not on a block or buffer boundary, so the inflater stops in the middle of a block
+    server.dropAt = server.zlibLength() / 3 + 7;
+    OtaUpdater updater(updaterConfig("/image.zz"));
+    TEST_ASSERT_TRUE(updater.update());
+
+    OtaUpdater::Statistics stats = updater.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.resumes);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.restarts);
+    TEST_ASSERT_EQUAL_UINT32(1, server.rangeRequests.load());
+    TEST_ASSERT_EQUAL_UINT64(server.zlibLength(), stats.downloadedBytes);
+    TEST_ASSERT_EQUAL_UINT64(server.imageLength, stats.imageBytes);
+    assertCopyOfRunningImage();
+}
+
+TEST_CASE("a server ignoring Range makes the image start over", "[ota]")
+{
+    ImageServer& server = imageServer();
+    server.rangeSupport = false;
+    server.dropAt = server.zlibLength() / 2 + 3;
+    OtaUpdater updater(updaterConfig("/image.zz"));
+    TEST_ASSERT_TRUE(updater.update());
+
+    OtaUpdater::Statistics stats = updater.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.resumes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.restarts);
+    TEST_ASSERT_EQUAL_UINT32(2, server.requests.load());
+    TEST_ASSERT_EQUAL_UINT64(server.imageLength, stats.imageBytes);
+    assertCopyOfRunningImage();
+}
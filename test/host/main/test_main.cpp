@@ -0,0 +1,15 @@
+// test_main.cpp
+// Runs every host unit test and exits with the number of failures
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include <cstdlib>
+
+extern "C" void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    // The linux target keeps the scheduler running after app_main returns
+    exit(UNITY_END());
+}
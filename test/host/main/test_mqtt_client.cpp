@@ -0,0 +1,375 @@
+// test_mqtt_client.cpp
+// MqttClient tests against an in-process broker: offline spool, QoS0 while the spool
+// drains, the spool cap and flush
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "mqtt_client.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+using namespace esperto;
+
+static const char* SpoolPath = "/tmp/esperto_test_mqtt.spool";
+
+// Accepts one connection at a time, records PUBLISH packets and holds back PUBACKs until
+// they are granted
+class FakeBroker {
+public:
+    struct Publish {
+        std::string payload;
+        esperto::uint8 qos;
+        bool duplicate;
+    };
+
+    FakeBroker() : m_listener(-1), m_client(-1), m_credit(INT_MAX), m_stopping(false), m_exited(nullptr) {
+        // Reserve a port nobody listens on until start()
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = loopback(0);
+        socklen_t length = sizeof(address);
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+        close(fd);
+    }
+
+    ~FakeBroker() {
+        stop();
+    }
+
+    esperto::uint16 port() const {
+        return m_port;
+    }
+
+    bool start() {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = loopback(m_port);
+        if (bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(m_listener, 1) != 0) {
+            return false;
+        }
+        m_stopping = false;
+        m_exited = xSemaphoreCreateBinary();
+        return xTaskCreate(&FakeBroker::entryPoint, "FakeBroker", 8192, this, 5, nullptr) == pdPASS;
+    }
+
+    void stop() {
+        if (!m_exited) {
+            return;
+        }
+        m_stopping = true;
+        xSemaphoreTake(m_exited, portMAX_DELAY);
+        vSemaphoreDelete(m_exited);
+        m_exited = nullptr;
+        close(m_listener);
+        m_listener = -1;
+    }
+
+    // PUBACKs sent from now on; INT_MAX acknowledges everything
+    void grantAcks(int count) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_credit = count;
+    }
+
+    std::vector<Publish> publishes() {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_publishes;
+    }
+
+    bool waitForPublishes(size_t count, esperto::uint32 timeoutMs) {
+        for (esperto::uint32 waited = 0; waited < timeoutMs; waited += 10) {
+            if (publishes().size() >= count) {
+                return true;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        return false;
+    }
+
+private:
+    esperto::uint16 m_port;
+    int m_listener;
+    int m_client;
+    int m_credit;
+    std::atomic<bool> m_stopping;
+    SemaphoreHandle_t m_exited;
+    std::mutex m_lock;
+    std::vector<Publish> m_publishes;
+    std::deque<esperto::uint16> m_unacked;
+    std::vector<esperto::uint8> m_rx;
+
+    static sockaddr_in loopback(esperto::uint16 port) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        return address;
+    }
+
+    static void entryPoint(void* param) {
+        FakeBroker* self = static_cast<FakeBroker*>(param);
+        self->run();
+        xSemaphoreGive(self->m_exited);
+        vTaskDelete(nullptr);
+    }
+
+    void run() {
+        while (!m_stopping) {
+            int fd = m_client >= 0 ? m_client : m_listener;
+            fd_set set;
+            FD_ZERO(&set);
+            FD_SET(fd, &set);
+            timeval timeout = {0, 5000};
+            int ready = select(fd + 1, &set, nullptr, nullptr, &timeout);
+            if (ready > 0 && m_client < 0) {
+                m_client = accept(m_listener, nullptr, nullptr);
+                m_rx.clear();
+            } else if (ready > 0) {
+                esperto::uint8 chunk[512];
+                ssize_t length = recv(m_client, chunk, sizeof(chunk), 0);
+                if (length <= 0 && !(length < 0 && errno == EINTR)) {
+                    close(m_client);
+                    m_client = -1;
+                    continue;
+                }
+                if (length > 0) {
+                    m_rx.insert(m_rx.end(), chunk, chunk + length);
+                    parse();
+                }
+            }
+            sendAcks();
+        }
+        if (m_client >= 0) {
+            close(m_client);
+            m_client = -1;
+        }
+    }
+
+    void parse() {
+        for (;;) {
+            size_t length = 0;
+            size_t multiplier = 1;
+            size_t header = 1;
+            while (header < m_rx.size()) {
+                length += (m_rx[header] & 0x7F) * multiplier;
+                multiplier *= 128;
+                if ((m_rx[header++] & 0x80) == 0) {
+                    break;
+                }
+            }
+            if (m_rx.size() < 2 || (m_rx[header - 1] & 0x80) != 0 || m_rx.size() < header + length) {
+                return;
+            }
+            handle(m_rx[0], m_rx.data() + header, length);
+            m_rx.erase(m_rx.begin(), m_rx.begin() + header + length);
+        }
+    }
+
+    void handle(esperto::uint8 type, const esperto::uint8* body, size_t length) {
+        if ((type & 0xF0) == 0x10) {
+            const esperto::uint8 connAck[] = {0x20, 2, 0, 0};
+            send(m_client, connAck, sizeof(connAck), 0);
+        } else if ((type & 0xF0) == 0x30) {
+            Publish publish;
+            publish.qos = (type >> 1) & 0x03;
+            publish.duplicate = (type & 0x08) != 0;
+            size_t offset = 2 + ((body[0] << 8) | body[1]);
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (publish.qos > 0) {
+                m_unacked.push_back(static_cast<esperto::uint16>((body[offset] << 8) | body[offset + 1]));
+                offset += 2;
+            }
+            publish.payload.assign(reinterpret_cast<const char*>(body) + offset, length - offset);
+            m_publishes.push_back(publish);
+        } else if ((type & 0xF0) == 0xC0) {
+            const esperto::uint8 pingResp[] = {0xD0, 0};
+            send(m_client, pingResp, sizeof(pingResp), 0);
+        }
+    }
+
+    void sendAcks() {
+        std::lock_guard<std::mutex> guard(m_lock);
+        while (m_client >= 0 && m_credit > 0 && !m_unacked.empty()) {
+            const esperto::uint8 pubAck[] = {0x40, 2, static_cast<esperto::uint8>(m_unacked.front() >> 8),
+                                             static_cast<esperto::uint8>(m_unacked.front() & 0xFF)};
+            send(m_client, pubAck, sizeof(pubAck), 0);
+            m_unacked.pop_front();
+            if (m_credit != INT_MAX) {
+                m_credit--;
+            }
+        }
+    }
+};
+
+static MqttClient::Config testConfig(esperto::uint16 port) {
+    MqttClient::Config config;
+    config.port = port;
+    config.reconnectMinMs = 20;
+    config.reconnectMaxMs = 50;
+    config.connectTimeoutMs = 500;
+    config.spoolPath = SpoolPath;
+    return config;
+}
+
+static bool waitForSpooled(MqttClient& client, esperto::uint64 count) {
+    for (int i = 0; i < 100; ++i) {
+        if (client.getStatistics().spooled >= count) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+static bool spoolExists() {
+    struct stat info;
+    return stat(SpoolPath, &info) == 0;
+}
+
+TEST_CASE("messages published offline are spooled and delivered in order on connect", "[mqtt]")
+{
+    remove(SpoolPath);
+    FakeBroker broker;
+    MqttClient client(testConfig(broker.port()));
+    TEST_ASSERT_TRUE(client.start());
+
+    const char* payloads[] = {"one", "two", "three", "four"};
+    for (const char* payload : payloads) {
+        TEST_ASSERT_TRUE(client.publish("test/spool", payload, MqttClient::QoS::AtLeastOnce));
+    }
+    // QoS0 is not spooled by default
+    TEST_ASSERT_TRUE(client.publish("test/spool", "lost", MqttClient::QoS::AtMostOnce));
+    TEST_ASSERT_TRUE(waitForSpooled(client, 4));
+    TEST_ASSERT_TRUE(spoolExists());
+    TEST_ASSERT_FALSE(client.flush(50));
+
+    TEST_ASSERT_TRUE(broker.start());
+    TEST_ASSERT_TRUE(client.flush(5000));
+    std::vector<FakeBroker::Publish> received = broker.publishes();
+    TEST_ASSERT_EQUAL(4, received.size());
+    for (size_t i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL_STRING(payloads[i], received[i].payload.c_str());
+    }
+
+    MqttClient::Statistics stats = client.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(4, stats.unspooled);
+    TEST_ASSERT_EQUAL_UINT64(4, stats.acknowledged);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.spoolBytes);
+    TEST_ASSERT_FALSE(spoolExists());
+    client.stop();
+}
+
+TEST_CASE("QoS0 goes out while spooled QoS1 messages await their PUBACK", "[mqtt]")
+{
+    remove(SpoolPath);
+    FakeBroker broker;
+    MqttClient client(testConfig(broker.port()));
+    TEST_ASSERT_TRUE(client.start());
+    TEST_ASSERT_TRUE(client.publish("test/spool", "spooled", MqttClient::QoS::AtLeastOnce));
+    TEST_ASSERT_TRUE(waitForSpooled(client, 1));
+
+    // The spooled message is sent but not acknowledged, so the spool is not empty yet
+    broker.grantAcks(0);
+    TEST_ASSERT_TRUE(broker.start());
+    TEST_ASSERT_TRUE(broker.waitForPublishes(1, 2000));
+    TEST_ASSERT_GREATER_THAN(0, client.getStatistics().spoolBytes);
+
+    TEST_ASSERT_TRUE(client.publish("test/live", "live", MqttClient::QoS::AtMostOnce));
+    TEST_ASSERT_TRUE(broker.waitForPublishes(2, 2000));
+    TEST_ASSERT_EQUAL_STRING("live", broker.publishes()[1].payload.c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, client.getStatistics().dropped);
+
+    broker.grantAcks(INT_MAX);
+    TEST_ASSERT_TRUE(client.flush(5000));
+    TEST_ASSERT_EQUAL_UINT32(0, client.getStatistics().dropped);
+    client.stop();
+}
+
+TEST_CASE("delivered spool records do not count against spoolMaxBytes", "[mqtt]")
+{
+    remove(SpoolPath);
+    FakeBroker broker;
+    MqttClient::Config config = testConfig(broker.port());
+    // Records are 8 bytes of header, a 1 byte topic and a 7 byte payload: four fit
+    config.spoolMaxBytes = 64;
+    config.maxInFlight = 1;
+    MqttClient client(config);
+    TEST_ASSERT_TRUE(client.start());
+
+    const char* payloads[] = {"spool-0", "spool-1", "spool-2", "spool-3", "after-0"};
+    for (size_t i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(client.publish("t", payloads[i], MqttClient::QoS::AtLeastOnce));
+    }
+    TEST_ASSERT_TRUE(waitForSpooled(client, 4));
+    TEST_ASSERT_TRUE(client.publish("t", "overflow", MqttClient::QoS::AtLeastOnce));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL_UINT32(1, client.getStatistics().dropped);
+
+    // The first record goes out and fills the window; the next message waits in the queue
+    broker.grantAcks(0);
+    TEST_ASSERT_TRUE(broker.start());
+    TEST_ASSERT_TRUE(broker.waitForPublishes(1, 2000));
+    TEST_ASSERT_TRUE(client.publish("t", payloads[4], MqttClient::QoS::AtLeastOnce));
+
+    // Once the first record is acknowledged the full file has room again
+    broker.grantAcks(1);
+    TEST_ASSERT_TRUE(waitForSpooled(client, 5));
+    broker.grantAcks(INT_MAX);
+    TEST_ASSERT_TRUE(client.flush(5000));
+
+    std::vector<FakeBroker::Publish> received = broker.publishes();
+    TEST_ASSERT_EQUAL(5, received.size());
+    for (size_t i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL_STRING(payloads[i], received[i].payload.c_str());
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, client.getStatistics().dropped);
+    TEST_ASSERT_FALSE(spoolExists());
+    client.stop();
+}
+
+TEST_CASE("flush waits for QoS1 acknowledgements and fails once the client stops", "[mqtt]")
+{
+    remove(SpoolPath);
+    FakeBroker broker;
+    TEST_ASSERT_TRUE(broker.start());
+    MqttClient::Config config = testConfig(broker.port());
+    config.spoolPath.clear();
+    MqttClient client(config);
+    TEST_ASSERT_TRUE(client.start());
+
+    broker.grantAcks(0);
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_TRUE(client.publish("test/flush", std::to_string(i), MqttClient::QoS::AtLeastOnce, false, 1000));
+    }
+    TEST_ASSERT_TRUE(broker.waitForPublishes(10, 2000));
+    TEST_ASSERT_FALSE(client.flush(100));
+
+    broker.grantAcks(INT_MAX);
+    TEST_ASSERT_TRUE(client.flush(2000));
+    MqttClient::Statistics stats = client.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(10, stats.published);
+    TEST_ASSERT_EQUAL_UINT64(10, stats.acknowledged);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.inFlight);
+
+    client.stop();
+    TEST_ASSERT_FALSE(client.publish("test/flush", "late"));
+}
@@ -0,0 +1,93 @@
+// test_realtime_policy.cpp
+// RealtimePolicy tests: admission control, deadline-monotonic priorities and stop
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "realtime_policy.hpp"
+#include "task.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+using namespace esperto;
+
+static RealtimePolicy::Parameters timing(esperto::uint32 periodMs, esperto::uint32 budgetUs,
+                                         esperto::uint32 deadlineMs = 0) {
+    RealtimePolicy::Parameters parameters;
+    parameters.periodMs = periodMs;
+    parameters.deadlineMs = deadlineMs;
+    parameters.budgetUs = budgetUs;
+    parameters.core = 0;
+    return parameters;
+}
+
+static void waitRetired(RealtimePolicy& policy, size_t remaining) {
+    for (int i = 0; i < 100 && policy.getStatistics().tasks.size() > remaining; ++i) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+TEST_CASE("invalid timing parameters are rejected", "[realtime]")
+{
+    RealtimePolicy policy{RealtimePolicy::Config()};
+    TEST_ASSERT_FALSE(policy.isSchedulable(timing(0, 100)));
+    // Deadline beyond the period
+    TEST_ASSERT_FALSE(policy.isSchedulable(timing(10, 100, 20)));
+    TEST_ASSERT_NULL(policy.startPeriodic([]() {}, timing(10, 100, 20), "bad", 2048).get());
+    TEST_ASSERT_EQUAL(1, policy.getStatistics().rejected);
+}
+
+TEST_CASE("admission stops once worst-case response times miss deadlines", "[realtime]")
+{
+    RealtimePolicy policy{RealtimePolicy::Config()};
+    // 10 ms period, 4 ms budget (+ overhead): two fit on one core, a third does not
+    TEST_ASSERT_TRUE(policy.isSchedulable(timing(10, 4000)));
+    auto first = policy.startPeriodic([]() {}, timing(10, 4000), "rt_a", 2048);
+    auto second = policy.startPeriodic([]() {}, timing(10, 4000), "rt_b", 2048);
+    TEST_ASSERT_NOT_NULL(first.get());
+    TEST_ASSERT_NOT_NULL(second.get());
+    TEST_ASSERT_FALSE(policy.isSchedulable(timing(10, 4000)));
+    TEST_ASSERT_NULL(policy.startPeriodic([]() {}, timing(10, 4000), "rt_c", 2048).get());
+
+    RealtimePolicy::Statistics stats = policy.getStatistics();
+    TEST_ASSERT_EQUAL(2, stats.admitted);
+    TEST_ASSERT_EQUAL(1, stats.rejected);
+    TEST_ASSERT_EQUAL(2, stats.tasks.size());
+    for (const auto& task : stats.tasks) {
+        TEST_ASSERT_LESS_OR_EQUAL(task.parameters.periodMs * 1000, task.responseBoundUs);
+    }
+
+    TEST_ASSERT_TRUE(policy.stop(first));
+    TEST_ASSERT_TRUE(policy.stop(second));
+    waitRetired(policy, 0);
+    TEST_ASSERT_EQUAL(0, policy.getStatistics().tasks.size());
+    // The budget is free again once the tasks have retired
+    TEST_ASSERT_TRUE(policy.isSchedulable(timing(10, 4000)));
+}
+
+TEST_CASE("shorter deadlines get higher priorities and jobs run every period", "[realtime]")
+{
+    RealtimePolicy::Config config;
+    RealtimePolicy policy(config);
+    std::atomic<int> slowJobs{0};
+    std::atomic<int> fastJobs{0};
+    auto slow = policy.startPeriodic([&]() { slowJobs++; }, timing(40, 500), "rt_slow", 2048);
+    auto fast = policy.startPeriodic([&]() { fastJobs++; }, timing(10, 500), "rt_fast", 2048);
+    TEST_ASSERT_NOT_NULL(slow.get());
+    TEST_ASSERT_NOT_NULL(fast.get());
+
+    // The later, shorter-deadline task took the top of the band and pushed the other one down
+    TEST_ASSERT_EQUAL(config.highestPriority, fast->getPriority());
+    TEST_ASSERT_EQUAL(config.highestPriority - 1, slow->getPriority());
+
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_INT_WITHIN(5, 20, fastJobs.load());
+    TEST_ASSERT_INT_WITHIN(3, 5, slowJobs.load());
+
+    policy.stop(slow);
+    policy.stop(fast);
+    waitRetired(policy, 0);
+}
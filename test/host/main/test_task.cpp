@@ -0,0 +1,129 @@
+// test_task.cpp
+// Task join, continuation, whenAll and whenAny tests, and the Future helpers they use
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "task.hpp"
+#include "future.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+using namespace esperto;
+
+static std::shared_ptr<Task> delayedTask(esperto::uint32 delayMs, std::atomic<esperto::uint32>* finished = nullptr) {
+    auto task = std::make_shared<Task>([delayMs, finished](Task&) {
+        vTaskDelay(pdMS_TO_TICKS(delayMs));
+        if (finished) {
+            (*finished)++;
+        }
+    }, "TestTask");
+    return task;
+}
+
+TEST_CASE("wait returns once the task function has returned", "[task]")
+{
+    std::atomic<esperto::uint32> finished{0};
+    auto task = delayedTask(50, &finished);
+    TEST_ASSERT_FALSE(task->wait(10));
+
+    task->start();
+    TEST_ASSERT_FALSE(task->wait(10));
+    TEST_ASSERT_TRUE(task->wait(1000));
+    TEST_ASSERT_EQUAL_UINT32(1, finished.load());
+    TEST_ASSERT_TRUE(task->isCompleted());
+    // Joining again does not block
+    TEST_ASSERT_TRUE(task->wait(0));
+}
+
+TEST_CASE("continuations run before waiters wake, or at once after completion", "[task]")
+{
+    std::atomic<bool> continued{false};
+    auto task = delayedTask(20);
+    task->continueWith([&continued](Task& completed) {
+        vTaskDelay(pdMS_TO_TICKS(30));
+        continued = completed.getName() == "TestTask";
+    });
+    task->start();
+    // Joins while the continuation is still running (from 20 to 50 ms)
+    vTaskDelay(pdMS_TO_TICKS(35));
+    TEST_ASSERT_FALSE(continued.load());
+    TEST_ASSERT_FALSE(task->isCompleted());
+    TEST_ASSERT_TRUE(task->wait(1000));
+    TEST_ASSERT_TRUE(continued.load());
+    TEST_ASSERT_TRUE(task->isCompleted());
+
+    bool late = false;
+    task->continueWith([&late](Task&) { late = true; });
+    TEST_ASSERT_TRUE(late);
+}
+
+TEST_CASE("Task::whenAll completes after the slowest task", "[task]")
+{
+    std::atomic<esperto::uint32> finished{0};
+    std::vector<std::shared_ptr<Task>> tasks = {delayedTask(10, &finished), delayedTask(80, &finished),
+                                                delayedTask(40, &finished)};
+    Future<void> all = Task::whenAll(tasks);
+    for (auto& task : tasks) {
+        task->start();
+    }
+
+    TEST_ASSERT_FALSE(all.wait(30));
+    TEST_ASSERT_TRUE(all.wait(1000));
+    TEST_ASSERT_EQUAL_UINT32(3, finished.load());
+    TEST_ASSERT_TRUE(Task::whenAll({}).isReady());
+}
+
+TEST_CASE("Task::whenAny reports the first task to complete", "[task]")
+{
+    std::vector<std::shared_ptr<Task>> tasks = {delayedTask(100), delayedTask(10), delayedTask(60)};
+    Future<size_t> any = Task::whenAny(tasks);
+    for (auto& task : tasks) {
+        task->start();
+    }
+
+    TEST_ASSERT_TRUE(any.wait(1000));
+    TEST_ASSERT_EQUAL(1, any.get());
+    TEST_ASSERT_FALSE(tasks[0]->isCompleted());
+    for (auto& task : tasks) {
+        TEST_ASSERT_TRUE(task->wait(1000));
+    }
+    TEST_ASSERT_EQUAL(1, any.get());
+
+    Future<size_t> none = Task::whenAny({});
+    TEST_ASSERT_TRUE(none.isReady());
+    TEST_ASSERT_EQUAL(NoIndex, none.get());
+}
+
+TEST_CASE("future whenAll keeps input order, whenAny keeps the first value", "[task]")
+{
+    std::vector<Promise<int>> promises(3);
+    std::vector<Future<int>> futures;
+    for (auto& promise : promises) {
+        futures.push_back(promise.getFuture());
+    }
+    Future<std::vector<int>> all = whenAll(futures);
+    Future<size_t> any = whenAny(futures);
+    Future<int> doubled = futures[0].continueWith([](const int& value) { return value * 2; });
+
+    promises[2].setValue(30);
+    TEST_ASSERT_TRUE(any.isReady());
+    TEST_ASSERT_EQUAL(2, any.get());
+    TEST_ASSERT_FALSE(all.isReady());
+
+    promises[0].setValue(10);
+    TEST_ASSERT_FALSE(promises[0].setValue(11));
+    promises[1].setValue(20);
+    TEST_ASSERT_TRUE(all.wait(0));
+    TEST_ASSERT_EQUAL(3, all.get().size());
+    TEST_ASSERT_EQUAL(10, all.get()[0]);
+    TEST_ASSERT_EQUAL(20, all.get()[1]);
+    TEST_ASSERT_EQUAL(30, all.get()[2]);
+    TEST_ASSERT_EQUAL(2, any.get());
+    TEST_ASSERT_EQUAL(20, doubled.get());
+}
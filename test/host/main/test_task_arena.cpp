@@ -0,0 +1,60 @@
+// test_task_arena.cpp
+// TaskArena tests: static tasks give their slot back once FreeRTOS has deleted them
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "task_arena.hpp"
+#include "task_scheduler.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+using namespace esperto;
+
+// The slot is released by the TLS deletion callback, shortly after wait() returns
+static bool waitForFreeSlots(esperto::uint32 timeoutMs) {
+    for (esperto::uint32 waited = 0; waited <= timeoutMs; waited += 5) {
+        TaskArena::Statistics stats = TaskScheduler::instance().getArenaStatistics();
+        esperto::uint32 inUse = 0;
+        for (size_t i = 0; i < stats.classCount; ++i) {
+            inUse += stats.classes[i].inUse;
+        }
+        if (inUse == 0) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    return false;
+}
+
+TEST_CASE("static tasks recycle their arena slot after they are deleted", "[arena]")
+{
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    TEST_ASSERT_TRUE(scheduler.configureArena({{2048, 1}, {4096, 1}}));
+
+    // Four rounds per size class on a one-slot class: each start needs the previous slot back
+    static constexpr int Rounds = 4;
+    std::atomic<esperto::uint32> runs{0};
+    const esperto::uint32 stackSizes[] = {2048, 4096};
+    for (esperto::uint32 stackSize : stackSizes) {
+        for (int round = 0; round < Rounds; ++round) {
+            auto task = scheduler.startNewStatic([&runs](Task&) { runs++; }, "Recycled", stackSize);
+            TEST_ASSERT_NOT_NULL(task.get());
+            TEST_ASSERT_TRUE(task->isStatic());
+            TEST_ASSERT_TRUE(task->wait(1000));
+            TEST_ASSERT_TRUE(waitForFreeSlots(1000));
+        }
+    }
+    scheduler.cleanupCompletedTasks();
+
+    TEST_ASSERT_EQUAL_UINT32(2 * Rounds, runs.load());
+    TaskArena::Statistics stats = scheduler.getArenaStatistics();
+    TEST_ASSERT_EQUAL(2, stats.classCount);
+    for (size_t i = 0; i < stats.classCount; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(1, stats.classes[i].highWater);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, stats.failedAllocations);
+}
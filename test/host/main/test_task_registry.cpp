@@ -0,0 +1,207 @@
+// test_task_registry.cpp
+// TaskRegistry tests: capacity, snapshot lifetime guarantees and concurrent updates
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "task_registry.hpp"
+#include "task.hpp"
+#include "task_scheduler.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+using namespace esperto;
+
+static std::shared_ptr<Task> idleTask(const char* name = "Registered") {
+    // Never started: the registry only stores it
+    return std::make_shared<Task>([](Task&) {}, name);
+}
+
+TEST_CASE("registry refuses inserts beyond its capacity and unknown removes", "[registry]")
+{
+    TaskRegistry registry(2);
+    auto a = idleTask();
+    auto b = idleTask();
+    auto c = idleTask();
+    TEST_ASSERT_TRUE(registry.insert(a));
+    TEST_ASSERT_TRUE(registry.insert(b));
+    TEST_ASSERT_FALSE(registry.insert(c));
+    TEST_ASSERT_EQUAL(2, registry.size());
+
+    TEST_ASSERT_FALSE(registry.remove(c));
+    TEST_ASSERT_TRUE(registry.remove(a));
+    TEST_ASSERT_FALSE(registry.remove(a));
+    TEST_ASSERT_EQUAL(1, registry.size());
+    // The freed slot is recycled on the next insert
+    TEST_ASSERT_TRUE(registry.insert(c));
+
+    std::vector<std::shared_ptr<Task>> tasks = registry.toVector();
+    TEST_ASSERT_EQUAL(2, tasks.size());
+    TEST_ASSERT_TRUE((tasks[0] == b && tasks[1] == c) || (tasks[0] == c && tasks[1] == b));
+}
+
+TEST_CASE("an open snapshot keeps removed tasks alive and their slots unused", "[registry]")
+{
+    TaskRegistry registry(1);
+    auto task = idleTask("Snapshotted");
+    std::weak_ptr<Task> watch = task;
+    TEST_ASSERT_TRUE(registry.insert(task));
+
+    {
+        TaskRegistry::Snapshot snapshot = registry.snapshot();
+        auto it = snapshot.begin();
+        TEST_ASSERT_TRUE(it != snapshot.end());
+        Task& seen = *it;
+
+        TEST_ASSERT_TRUE(registry.remove(task));
+        task.reset();
+        registry.reclaim();
+        TEST_ASSERT_FALSE(watch.expired());
+        TEST_ASSERT_EQUAL_STRING("Snapshotted", seen.getName().c_str());
+        // The only slot is retired, not free, while the reader may still look at it
+        TEST_ASSERT_FALSE(registry.insert(idleTask()));
+        TEST_ASSERT_EQUAL(0, registry.size());
+    }
+
+    registry.reclaim();
+    TEST_ASSERT_TRUE(watch.expired());
+    TEST_ASSERT_TRUE(registry.insert(idleTask()));
+}
+
+TEST_CASE("removeIf removes the matching tasks and snapshots skip them", "[registry]")
+{
+    TaskRegistry registry(8);
+    for (int i = 0; i < 6; ++i) {
+        TEST_ASSERT_TRUE(registry.insert(idleTask(i % 2 == 0 ? "Even" : "Odd")));
+    }
+    TEST_ASSERT_EQUAL(3, registry.removeIf([](Task& task) { return task.getName() == "Odd"; }));
+    TEST_ASSERT_EQUAL(3, registry.size());
+
+    size_t seen = 0;
+    for (Task& task : registry.snapshot()) {
+        TEST_ASSERT_EQUAL_STRING("Even", task.getName().c_str());
+        ++seen;
+    }
+    TEST_ASSERT_EQUAL(3, seen);
+}
+
+struct RegistryStress {
+    TaskRegistry registry{16};
+    std::atomic<bool> stop{false};
+    std::atomic<esperto::uint32> visits{0};
+    std::atomic<esperto::uint32> corrupt{0};
+    SemaphoreHandle_t finished = xSemaphoreCreateCounting(8, 0);
+};
+
+static void writerTask(void* param) {
+    RegistryStress* stress = static_cast<RegistryStress*>(param);
+    std::vector<std::shared_ptr<Task>> mine;
+    while (!stress->stop) {
+        if (mine.size() < 4) {
+            auto task = idleTask("Stress");
+            if (stress->registry.insert(task)) {
+                mine.push_back(task);
+            }
+        } else {
+            stress->registry.remove(mine.front());
+            // Drop the only other owner: readers rely on the registry alone
+            mine.erase(mine.begin());
+        }
+        taskYIELD();
+    }
+    for (auto& task : mine) {
+        stress->registry.remove(task);
+    }
+    xSemaphoreGive(stress->finished);
+    vTaskDelete(nullptr);
+}
+
+static void readerTask(void* param) {
+    RegistryStress* stress = static_cast<RegistryStress*>(param);
+    while (!stress->stop) {
+        for (Task& task : stress->registry.snapshot()) {
+            if (task.getName() != "Stress") {
+                stress->corrupt++;
+            }
+            stress->visits++;
+        }
+        taskYIELD();
+    }
+    xSemaphoreGive(stress->finished);
+    vTaskDelete(nullptr);
+}
+
+TEST_CASE("snapshots stay valid while other tasks insert and remove", "[registry]")
+{
+    RegistryStress stress;
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(writerTask, "RegWriter", 4096, &stress, 5, nullptr));
+    }
+    for (int i = 0; i < 2; ++i) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(readerTask, "RegReader", 4096, &stress, 5, nullptr));
+    }
+    vTaskDelay(pdMS_TO_TICKS(300));
+    stress.stop = true;
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(stress.finished, pdMS_TO_TICKS(2000)));
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, stress.visits.load());
+    TEST_ASSERT_EQUAL_UINT32(0, stress.corrupt.load());
+    TEST_ASSERT_EQUAL(0, stress.registry.size());
+    stress.registry.reclaim();
+    vSemaphoreDelete(stress.finished);
+}
+
+TEST_CASE("TaskScheduler snapshot lists started tasks until cleanup", "[registry]")
+{
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    scheduler.cleanupCompletedTasks();
+    size_t before = scheduler.getTaskCount();
+
+    auto task = scheduler.startNew([](Task&) {}, "Listed");
+    TEST_ASSERT_NOT_NULL(task.get());
+    TEST_ASSERT_TRUE(task->wait(1000));
+    TEST_ASSERT_EQUAL(before + 1, scheduler.getTaskCount());
+    bool listed = false;
+    for (Task& entry : scheduler.snapshot()) {
+        listed = listed || &entry == task.get();
+    }
+    TEST_ASSERT_TRUE(listed);
+
+    scheduler.cleanupCompletedTasks();
+    TEST_ASSERT_EQUAL(before, scheduler.getTaskCount());
+}
+
+TEST_CASE("registry capacity can only change while it is empty", "[registry]")
+{
+    TaskRegistry registry(2);
+    TEST_ASSERT_TRUE(registry.setCapacity(3));
+    TEST_ASSERT_EQUAL(3, registry.capacity());
+    auto task = idleTask();
+    TEST_ASSERT_TRUE(registry.insert(task));
+    TEST_ASSERT_FALSE(registry.setCapacity(8));
+    TEST_ASSERT_TRUE(registry.remove(task));
+    TEST_ASSERT_TRUE(registry.setCapacity(8));
+    TEST_ASSERT_EQUAL(8, registry.capacity());
+}
+
+TEST_CASE("TaskScheduler drops completed tasks once its registry is full", "[registry]")
+{
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    // More short jobs over its lifetime than the registry holds, without cleanup calls
+    const size_t jobs = 2 * TaskRegistry::DefaultCapacity + 1;
+    for (size_t i = 0; i < jobs; ++i) {
+        auto task = scheduler.startNew([](Task&) {}, "ShortJob");
+        TEST_ASSERT_NOT_NULL(task.get());
+        TEST_ASSERT_TRUE(task->wait(1000));
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(TaskRegistry::DefaultCapacity, scheduler.getTaskCount());
+    scheduler.cleanupCompletedTasks();
+}
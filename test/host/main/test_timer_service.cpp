@@ -0,0 +1,137 @@
+// test_timer_service.cpp
+// TimerService tests: deadlines across wheel levels, periodic timers, cancel and capacity
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "timer_service.hpp"
+#include <atomic>
+#include <mutex>
+#include <vector>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+}
+
+using namespace esperto;
+
+// Deadlines count whole ticks from the current one, so against a microsecond clock read
+// in the middle of a tick a timer may appear up to one tick early
+static constexpr esperto::int64 TickUs = portTICK_PERIOD_MS * 1000;
+
+static TimerService::Config testConfig(esperto::uint32 capacity = 16) {
+    TimerService::Config config;
+    config.capacity = capacity;
+    config.resolutionMs = 10;
+    return config;
+}
+
+TEST_CASE("one-shot timer fires once, not before its deadline", "[timer]")
+{
+    TimerService service(testConfig());
+    TEST_ASSERT_TRUE(service.start());
+
+    SemaphoreHandle_t fired = xSemaphoreCreateCounting(4, 0);
+    esperto::int64 start = esp_timer_get_time();
+    esperto::int64 firedAt = 0;
+    TEST_ASSERT_NOT_EQUAL(TimerService::InvalidTimer, service.scheduleAfter(50, [&]() {
+        firedAt = esp_timer_get_time();
+        xSemaphoreGive(fired);
+    }));
+
+    TEST_ASSERT_TRUE(xSemaphoreTake(fired, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_GREATER_OR_EQUAL(50000 - TickUs, firedAt - start);
+    TEST_ASSERT_FALSE(xSemaphoreTake(fired, pdMS_TO_TICKS(100)));
+
+    TimerService::Statistics stats = service.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(1, stats.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.active);
+    service.stop();
+    vSemaphoreDelete(fired);
+}
+
+TEST_CASE("timers beyond the first wheel level cascade down and fire in order", "[timer]")
+{
+    TimerService service(testConfig());
+    TEST_ASSERT_TRUE(service.start());
+
+    // 10 ms slots: 64 slots cover 640 ms, so 700 and 1500 ms start on level 1
+    const esperto::uint32 delays[] = {1500, 50, 700};
+    std::mutex lock;
+    std::vector<esperto::uint32> order;
+    std::vector<esperto::int64> lateness;
+    SemaphoreHandle_t fired = xSemaphoreCreateCounting(4, 0);
+    esperto::int64 start = esp_timer_get_time();
+    for (esperto::uint32 delay : delays) {
+        service.scheduleAfter(delay, [&, delay]() {
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(delay);
+            lateness.push_back(esp_timer_get_time() - start - static_cast<esperto::int64>(delay) * 1000);
+            xSemaphoreGive(fired);
+        });
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(fired, pdMS_TO_TICKS(3000)));
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    TEST_ASSERT_EQUAL_UINT32(50, order[0]);
+    TEST_ASSERT_EQUAL_UINT32(700, order[1]);
+    TEST_ASSERT_EQUAL_UINT32(1500, order[2]);
+    for (esperto::int64 late : lateness) {
+        TEST_ASSERT_GREATER_OR_EQUAL(-TickUs, late);
+        TEST_ASSERT_LESS_OR_EQUAL(100000, late);
+    }
+    service.stop();
+    vSemaphoreDelete(fired);
+}
+
+TEST_CASE("periodic timer keeps its period until cancelled", "[timer]")
+{
+    TimerService service(testConfig());
+    TEST_ASSERT_TRUE(service.start());
+
+    std::atomic<esperto::uint32> count{0};
+    TimerService::TimerId id = service.schedulePeriodic(20, [&]() { count++; });
+    TEST_ASSERT_NOT_EQUAL(TimerService::InvalidTimer, id);
+
+    vTaskDelay(pdMS_TO_TICKS(210));
+    TEST_ASSERT_TRUE(service.cancel(id));
+    esperto::uint32 fired = count.load();
+    TEST_ASSERT_UINT32_WITHIN(2, 10, fired);
+
+    vTaskDelay(pdMS_TO_TICKS(60));
+    TEST_ASSERT_EQUAL_UINT32(fired, count.load());
+    TEST_ASSERT_FALSE(service.cancel(id));
+    service.stop();
+}
+
+TEST_CASE("cancelled timer never fires and its node is reused", "[timer]")
+{
+    TimerService service(testConfig(2));
+    TEST_ASSERT_TRUE(service.start());
+
+    std::atomic<esperto::uint32> count{0};
+    TimerService::TimerId first = service.scheduleAfter(30, [&]() { count++; });
+    TimerService::TimerId second = service.scheduleAfter(30, [&]() { count++; });
+    TEST_ASSERT_NOT_EQUAL(TimerService::InvalidTimer, first);
+    TEST_ASSERT_NOT_EQUAL(TimerService::InvalidTimer, second);
+
+    // Every node is taken
+    TEST_ASSERT_EQUAL_UINT32(TimerService::InvalidTimer, service.scheduleAfter(30, [&]() { count++; }));
+    TEST_ASSERT_EQUAL_UINT32(1, service.getStatistics().rejected);
+
+    TEST_ASSERT_TRUE(service.cancel(first));
+    TEST_ASSERT_FALSE(service.cancel(first));
+    TimerService::TimerId third = service.scheduleAfter(30, [&]() { count++; });
+    TEST_ASSERT_NOT_EQUAL(TimerService::InvalidTimer, third);
+    // The recycled node gets a new generation: the old id stays invalid
+    TEST_ASSERT_NOT_EQUAL(first, third);
+    TEST_ASSERT_FALSE(service.cancel(first));
+
+    vTaskDelay(pdMS_TO_TICKS(150));
+    TEST_ASSERT_EQUAL_UINT32(2, count.load());
+    service.stop();
+}
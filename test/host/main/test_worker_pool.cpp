@@ -0,0 +1,137 @@
+// test_worker_pool.cpp
+// WorkerPool and TaskScheduler::run tests: execution, stealing, capacity and stop
+// Author: ESPerto Contributors
+// License: MIT
+
+#include "unity.h"
+#include "worker_pool.hpp"
+#include "task_scheduler.hpp"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+}
+
+using namespace esperto;
+
+static WorkerPool::Config testConfig(esperto::uint32 workersPerCore, esperto::uint32 queueCapacity = 64) {
+    WorkerPool::Config config;
+    config.workersPerCore = workersPerCore;
+    config.queueCapacity = queueCapacity;
+    return config;
+}
+
+static bool waitFor(const std::atomic<esperto::uint32>& value, esperto::uint32 expected, esperto::uint32 timeoutMs) {
+    for (esperto::uint32 waited = 0; waited < timeoutMs; waited += 5) {
+        if (value.load() >= expected) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    return value.load() >= expected;
+}
+
+TEST_CASE("every submitted work item runs exactly once", "[pool]")
+{
+    WorkerPool pool(testConfig(2));
+    TEST_ASSERT_TRUE(pool.start());
+    TEST_ASSERT_EQUAL(2 * portNUM_PROCESSORS, pool.getWorkerCount());
+
+    static constexpr esperto::uint32 Items = 100;
+    std::atomic<esperto::uint32> runs[Items];
+    std::atomic<esperto::uint32> done{0};
+    for (esperto::uint32 i = 0; i < Items; ++i) {
+        runs[i] = 0;
+        TEST_ASSERT_TRUE(pool.submit([&runs, &done, i]() {
+            runs[i]++;
+            done++;
+        }));
+    }
+
+    TEST_ASSERT_TRUE(waitFor(done, Items, 2000));
+    for (esperto::uint32 i = 0; i < Items; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(1, runs[i].load());
+    }
+    WorkerPool::Statistics stats = pool.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(Items, stats.executed);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.pending);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.rejected);
+    pool.stop();
+    TEST_ASSERT_FALSE(pool.submit([]() {}));
+}
+
+TEST_CASE("an idle worker steals items spawned by a busy one", "[pool]")
+{
+    WorkerPool pool(testConfig(2));
+    TEST_ASSERT_TRUE(pool.start());
+
+    // The parent keeps its worker busy after queueing its children there; only a thief
+    // can run them before it returns
+    static constexpr esperto::uint32 Children = 8;
+    std::atomic<esperto::uint32> done{0};
+    std::atomic<esperto::uint32> doneWhileParentBusy{0};
+    std::atomic<bool> parentBusy{true};
+    TEST_ASSERT_TRUE(pool.submit([&]() {
+        for (esperto::uint32 i = 0; i < Children; ++i) {
+            pool.submit([&]() {
+                if (parentBusy) {
+                    doneWhileParentBusy++;
+                }
+                done++;
+            });
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+        parentBusy = false;
+    }));
+
+    TEST_ASSERT_TRUE(waitFor(done, Children, 2000));
+    TEST_ASSERT_EQUAL_UINT32(Children, doneWhileParentBusy.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(Children, pool.getStatistics().stolen);
+    pool.stop();
+}
+
+TEST_CASE("submit fails once every deque is full", "[pool]")
+{
+    WorkerPool pool(testConfig(1, 4));
+    TEST_ASSERT_TRUE(pool.start());
+
+    // Block every worker, then fill the deques behind them
+    SemaphoreHandle_t release = xSemaphoreCreateCounting(8, 0);
+    std::atomic<esperto::uint32> blocked{0};
+    for (size_t i = 0; i < pool.getWorkerCount(); ++i) {
+        TEST_ASSERT_TRUE(pool.submit([&]() {
+            blocked++;
+            xSemaphoreTake(release, portMAX_DELAY);
+        }));
+    }
+    TEST_ASSERT_TRUE(waitFor(blocked, pool.getWorkerCount(), 1000));
+
+    esperto::uint32 accepted = 0;
+    while (pool.submit([]() {}) && accepted < 100) {
+        accepted++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(4 * pool.getWorkerCount(), accepted);
+    TEST_ASSERT_EQUAL_UINT64(1, pool.getStatistics().rejected);
+    TEST_ASSERT_EQUAL_UINT32(accepted, pool.getStatistics().pending);
+
+    for (size_t i = 0; i < pool.getWorkerCount(); ++i) {
+        xSemaphoreGive(release);
+    }
+    pool.stop();
+    vSemaphoreDelete(release);
+}
+
+TEST_CASE("TaskScheduler::run executes on the pool once it is enabled", "[pool]")
+{
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    TEST_ASSERT_TRUE(scheduler.enablePool(testConfig(1)));
+
+    SemaphoreHandle_t finished = xSemaphoreCreateBinary();
+    TEST_ASSERT_TRUE(scheduler.run([finished]() { xSemaphoreGive(finished); }));
+    TEST_ASSERT_TRUE(xSemaphoreTake(finished, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_GREATER_OR_EQUAL(1, scheduler.getPoolStatistics().executed);
+
+    scheduler.disablePool();
+    vSemaphoreDelete(finished);
+}
@@ -0,0 +1,17 @@
+from pathlib import Path
+
+import pytest
+
+pytest_plugins = ["pytest_embedded"]
+
+DEVICE_DIR = Path(__file__).parent / "device"
+
+
+@pytest.mark.esp32
+@pytest.mark.skipif(not (DEVICE_DIR / "build").exists(),
+                    reason="build test/device with idf.py build and attach a board first")
+@pytest.mark.parametrize("app_path", [str(DEVICE_DIR)], indirect=True)
+@pytest.mark.parametrize("target", ["esp32"], indirect=True)
+def test_device_unit_tests(dut):
+    # Flashes test/device and runs every Unity case of its menu
+    dut.run_all_single_board_cases(timeout=300)
@@ -0,0 +1,21 @@
+import os
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+HOST_DIR = Path(__file__).parent / "host"
+
+
+@pytest.mark.skipif(not os.environ.get("IDF_PATH") or not shutil.which("idf.py"),
+                    reason="needs ESP-IDF 5.x with export.sh sourced")
+def test_host_unit_tests():
+    # Builds test/host for the linux target and runs every Unity test case in it
+    if not (HOST_DIR / "sdkconfig").exists():
+        subprocess.run(["idf.py", "--preview", "set-target", "linux"], cwd=HOST_DIR, check=True)
+    subprocess.run(["idf.py", "build"], cwd=HOST_DIR, check=True)
+    result = subprocess.run([str(HOST_DIR / "build" / "esperto_host_tests.elf")], cwd=HOST_DIR,
+                            capture_output=True, text=True, timeout=600)
+    print(result.stdout)
+    assert result.returncode == 0, result.stdout[-4000:]